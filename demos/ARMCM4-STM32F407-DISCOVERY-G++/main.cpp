@@ -19,8 +19,10 @@
 #include "fs.hpp"
 #include "fatfs_fsimpl.hpp"
 #include "test.h"
+#include "chprintf.h"
 
 using namespace chibios_rt;
+using namespace chibios_fs;
 using namespace chibios_fatfs;
 
 /*
@@ -140,14 +142,129 @@ public:
   }
 };
 
+/*
+ * Mailbox benchmark thread class. The same post/fetch cycle is performed
+ * using the C mailbox API and the typed mailbox template, the elapsed times
+ * are printed on SD2. The thread has no virtual body, its stack size and
+ * priority are fixed at compile time.
+ */
+#define BENCH_CYCLES    100000
+
+static msg_t c_mb_buf[4];
+static ::Mailbox c_mb = _MAILBOX_DATA(c_mb, c_mb_buf, 4);
+static TypedMailbox<const seqop_t *, 4> typed_mb;
+
+class BenchThread : public StaticThread<BenchThread, 256, NORMALPRIO> {
+public:
+  msg_t main(void) {
+    BaseSequentialStream *chp = (BaseSequentialStream *)&SD2;
+    const seqop_t *sp;
+    systime_t start;
+    msg_t msg;
+    unsigned i;
+
+    setName("bench");
+
+    start = chTimeNow();
+    for (i = 0; i < BENCH_CYCLES; i++) {
+      (void)chMBPost(&c_mb, (msg_t)LED3_sequence, TIME_INFINITE);
+      (void)chMBFetch(&c_mb, &msg, TIME_INFINITE);
+    }
+    chprintf(chp, "C API mailbox : %lu ticks\r\n",
+             (unsigned long)(chTimeNow() - start));
+
+    start = chTimeNow();
+    for (i = 0; i < BENCH_CYCLES; i++) {
+      (void)typed_mb.post(LED3_sequence, TIME_INFINITE);
+      (void)typed_mb.fetch(&sp, TIME_INFINITE);
+    }
+    chprintf(chp, "Typed mailbox : %lu ticks\r\n",
+             (unsigned long)(chTimeNow() - start));
+    return 0;
+  }
+};
+
 /* Static threads instances.*/
 static TesterThread tester;
+static BenchThread bench;
 static SequencerThread blinker1(LED3_sequence);
 static SequencerThread blinker2(LED4_sequence);
 static SequencerThread blinker3(LED5_sequence);
 static SequencerThread blinker4(LED6_sequence);
 
+/*
+ * File system test, a file is written in small records through the FatFS
+ * wrapper then it is read back and verified, the elapsed times are printed
+ * on SD2.
+ */
+#define FS_FILE_SIZE    (64 * 1024)
+#define FS_RECORD_SIZE  100
+
 static FatFSWrapper fs;
+static uint8_t fs_record[FS_RECORD_SIZE];
+
+static uint8_t fs_pattern(uint32_t offset) {
+
+  return (uint8_t)(offset * 7 + (offset >> 9));
+}
+
+static void fs_test(BaseSequentialStream *chp) {
+  BaseFileStreamInterface *fp;
+  systime_t start;
+  uint32_t offset;
+  size_t i, n;
+
+  if (sdcConnect(&SDCD1)) {
+    chprintf(chp, "FS: no card\r\n");
+    return;
+  }
+  fs.mount();
+
+  start = chTimeNow();
+  fp = fs.create("test.bin");
+  if (fp == NULL) {
+    chprintf(chp, "FS: create failed, error %lu\r\n",
+             (unsigned long)fs.getAndClearLastError());
+    fs.unmount();
+    sdcDisconnect(&SDCD1);
+    return;
+  }
+  for (offset = 0; offset < FS_FILE_SIZE; offset += n) {
+    n = FS_FILE_SIZE - offset;
+    if (n > FS_RECORD_SIZE)
+      n = FS_RECORD_SIZE;
+    for (i = 0; i < n; i++)
+      fs_record[i] = fs_pattern(offset + i);
+    if (fp->write(fs_record, n) != n)
+      break;
+  }
+  fs.close(fp);
+  chprintf(chp, "FS write      : %lu bytes, %lu ticks\r\n",
+           (unsigned long)offset, (unsigned long)(chTimeNow() - start));
+
+  start = chTimeNow();
+  fp = fs.openForRead("test.bin");
+  offset = 0;
+  if (fp != NULL) {
+    while ((n = fp->read(fs_record, FS_RECORD_SIZE)) > 0) {
+      for (i = 0; i < n; i++) {
+        if (fs_record[i] != fs_pattern(offset + i))
+          break;
+      }
+      if (i < n)
+        break;
+      offset += n;
+    }
+    fs.close(fp);
+  }
+  chprintf(chp, "FS read       : %lu bytes, %lu ticks, %s\r\n",
+           (unsigned long)offset, (unsigned long)(chTimeNow() - start),
+           offset == FS_FILE_SIZE ? "verified" : "FAILED");
+
+  fs.remove("test.bin");
+  fs.unmount();
+  sdcDisconnect(&SDCD1);
+}
 
 /*
  * Application entry point.
@@ -164,9 +281,6 @@ int main(void) {
   halInit();
   System::init();
 
-  fs.mount();
-  fs.unmount();
-
   /*
    * Activates the serial driver 2 using the driver default configuration.
    * PA2(TX) and PA3(RX) are routed to USART2.
@@ -175,6 +289,15 @@ int main(void) {
   palSetPadMode(GPIOA, 2, PAL_MODE_ALTERNATE(7));
   palSetPadMode(GPIOA, 3, PAL_MODE_ALTERNATE(7));
 
+  /*
+   * Activates the SDC driver, the card is connected to the SDIO pins
+   * PC8-PC11(D0-D3), PC12(CK) and PD2(CMD), the board has no card slot.
+   */
+  palSetGroupMode(GPIOC, PAL_GROUP_MASK(5), 8,
+                  PAL_MODE_ALTERNATE(12) | PAL_STM32_OSPEED_HIGHEST);
+  palSetPadMode(GPIOD, 2, PAL_MODE_ALTERNATE(12) | PAL_STM32_OSPEED_HIGHEST);
+  sdcStart(&SDCD1, NULL);
+
   /*
    * Starts several instances of the SequencerThread class, each one operating
    * on a different LED.
@@ -191,6 +314,9 @@ int main(void) {
     if (palReadPad(GPIOA, GPIOA_BUTTON)) {
       tester.start(NORMALPRIO);
       tester.wait();
+      bench.start();
+      bench.wait();
+      fs_test((BaseSequentialStream *)&SD2);
     };
     BaseThread::sleep(MS2ST(500));
   }
@@ -1778,53 +1778,63 @@
    ---------- Checksum options ----------
    --------------------------------------
 */
+/**
+ * CHECKSUM_BY_HARDWARE==1: Checksums generated and verified by the MAC, this
+ * requires STM32_MAC_IP_CHECKSUM_OFFLOAD set to 3 in mcuconf.h. The frames
+ * not verified by the MAC are verified by the lwIP thread except the payload
+ * of IP fragments.
+ */
+#ifndef CHECKSUM_BY_HARDWARE
+#define CHECKSUM_BY_HARDWARE            0
+#endif
+
 /**
  * CHECKSUM_GEN_IP==1: Generate checksums in software for outgoing IP packets.
  */
 #ifndef CHECKSUM_GEN_IP
-#define CHECKSUM_GEN_IP                 1
+#define CHECKSUM_GEN_IP                 (!CHECKSUM_BY_HARDWARE)
 #endif
  
 /**
  * CHECKSUM_GEN_UDP==1: Generate checksums in software for outgoing UDP packets.
  */
 #ifndef CHECKSUM_GEN_UDP
-#define CHECKSUM_GEN_UDP                1
+#define CHECKSUM_GEN_UDP                (!CHECKSUM_BY_HARDWARE)
 #endif
  
 /**
  * CHECKSUM_GEN_TCP==1: Generate checksums in software for outgoing TCP packets.
  */
 #ifndef CHECKSUM_GEN_TCP
-#define CHECKSUM_GEN_TCP                1
+#define CHECKSUM_GEN_TCP                (!CHECKSUM_BY_HARDWARE)
 #endif
 
 /**
  * CHECKSUM_GEN_ICMP==1: Generate checksums in software for outgoing ICMP packets.
  */
 #ifndef CHECKSUM_GEN_ICMP
-#define CHECKSUM_GEN_ICMP               1
+#define CHECKSUM_GEN_ICMP               (!CHECKSUM_BY_HARDWARE)
 #endif
  
 /**
  * CHECKSUM_CHECK_IP==1: Check checksums in software for incoming IP packets.
  */
 #ifndef CHECKSUM_CHECK_IP
-#define CHECKSUM_CHECK_IP               1
+#define CHECKSUM_CHECK_IP               (!CHECKSUM_BY_HARDWARE)
 #endif
  
 /**
  * CHECKSUM_CHECK_UDP==1: Check checksums in software for incoming UDP packets.
  */
 #ifndef CHECKSUM_CHECK_UDP
-#define CHECKSUM_CHECK_UDP              1
+#define CHECKSUM_CHECK_UDP              (!CHECKSUM_BY_HARDWARE)
 #endif
 
 /**
  * CHECKSUM_CHECK_TCP==1: Check checksums in software for incoming TCP packets.
  */
 #ifndef CHECKSUM_CHECK_TCP
-#define CHECKSUM_CHECK_TCP              1
+#define CHECKSUM_CHECK_TCP              (!CHECKSUM_BY_HARDWARE)
 #endif
 
 /**
@@ -0,0 +1,238 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "ff.h"
+#include "fatfs_diskio.h"
+#include "blkimage.h"
+#include "wrapper.h"
+
+/* Image size, 8MB.*/
+#define IMAGE_BLOCKS        16384
+
+/* Sequential test file size and size of each read or write.*/
+#define FILE_SIZE           (1024 * 1024)
+#define CHUNK_SIZE          4096
+
+/* Small files test, number and size of the files.*/
+#define SMALL_FILES         32
+#define SMALL_SIZE          1000
+
+/*
+ * Disk image simulating a card with 100us read latency, 1ms write latency
+ * and 10MB/s bandwidth.
+ */
+static BlockImage image;
+static const BlockImageConfig image_cfg = {
+  "fatfs.img",
+  IMAGE_BLOCKS,
+  FALSE,
+  100,
+  1000,
+  10000000
+};
+
+static FATFS fs;
+static FIL file;
+static uint32_t buf[CHUNK_SIZE / sizeof (uint32_t)];
+
+/*===========================================================================*/
+/* Benchmarks.                                                               */
+/*===========================================================================*/
+
+/*
+ * Prints the statistics of a test, the throughput is computed both on the
+ * elapsed time, file system overhead included, and on the modeled device
+ * busy time.
+ */
+void report(const char *test, uint32_t bytes, systime_t time) {
+  BlockImageStats *sp = biGetStats(&image);
+  uint32_t ms = (uint32_t)(time * 1000 / CH_FREQUENCY);
+  uint32_t us = (uint32_t)sp->busy;
+
+  printf("%-16s %7u bytes %6u ms %6u KB/s, device %7u us %6u KB/s, "
+         "%4u commands %5u blocks\n",
+         test, bytes, ms, (uint32_t)((uint64_t)bytes * 1000 / 1024 /
+                                     (ms > 0 ? ms : 1)),
+         us, (uint32_t)((uint64_t)bytes * 1000000 / 1024 /
+                        (us > 0 ? us : 1)),
+         sp->reads + sp->writes, sp->rdblocks + sp->wrblocks);
+}
+
+/*
+ * Fills the buffer with a pattern depending on the file offset.
+ */
+static void fill(uint32_t offset) {
+  unsigned i;
+
+  for (i = 0; i < CHUNK_SIZE / sizeof (uint32_t); i++)
+    buf[i] = offset / sizeof (uint32_t) + i;
+}
+
+/*
+ * Sequential write of a file.
+ */
+static bool_t seq_write(void) {
+  systime_t start;
+  uint32_t offset;
+  UINT n;
+
+  biResetStats(&image);
+  start = chTimeNow();
+  if (f_open(&file, "seq.bin", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return FALSE;
+  for (offset = 0; offset < FILE_SIZE; offset += CHUNK_SIZE) {
+    fill(offset);
+    if ((f_write(&file, buf, CHUNK_SIZE, &n) != FR_OK) || (n != CHUNK_SIZE)) {
+      f_close(&file);
+      return FALSE;
+    }
+  }
+  if (f_close(&file) != FR_OK)
+    return FALSE;
+  report("sequential write", FILE_SIZE, chTimeNow() - start);
+  return TRUE;
+}
+
+/*
+ * Sequential read of the file written by seq_write(), the content is
+ * verified.
+ */
+static bool_t seq_read(void) {
+  static uint32_t ref[CHUNK_SIZE / sizeof (uint32_t)];
+  systime_t start;
+  uint32_t offset;
+  UINT n;
+
+  biResetStats(&image);
+  start = chTimeNow();
+  if (f_open(&file, "seq.bin", FA_READ) != FR_OK)
+    return FALSE;
+  for (offset = 0; offset < FILE_SIZE; offset += CHUNK_SIZE) {
+    if ((f_read(&file, ref, CHUNK_SIZE, &n) != FR_OK) || (n != CHUNK_SIZE))
+      break;
+    fill(offset);
+    if (memcmp(buf, ref, CHUNK_SIZE) != 0) {
+      printf("data mismatch at offset %u\n", offset);
+      break;
+    }
+  }
+  f_close(&file);
+  if (offset < FILE_SIZE)
+    return FALSE;
+  report("sequential read", FILE_SIZE, chTimeNow() - start);
+  return TRUE;
+}
+
+/*
+ * Creation of small files, the directory and FAT updates dominate.
+ */
+static bool_t small_files(void) {
+  char name[16];
+  systime_t start;
+  unsigned i;
+  UINT n;
+
+  biResetStats(&image);
+  start = chTimeNow();
+  if (f_mkdir("small") != FR_OK)
+    return FALSE;
+  fill(0);
+  for (i = 0; i < SMALL_FILES; i++) {
+    sprintf(name, "small/f%02u.txt", i);
+    if (f_open(&file, name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+      return FALSE;
+    if ((f_write(&file, buf, SMALL_SIZE, &n) != FR_OK) || (n != SMALL_SIZE)) {
+      f_close(&file);
+      return FALSE;
+    }
+    if (f_close(&file) != FR_OK)
+      return FALSE;
+  }
+  report("small files", SMALL_FILES * SMALL_SIZE, chTimeNow() - start);
+  return TRUE;
+}
+
+/*
+ * Formats the image and runs the benchmarks.
+ */
+static bool_t benchmark(void) {
+  FRESULT err;
+
+  if (f_mount(0, &fs) != FR_OK)
+    return FALSE;
+  biResetStats(&image);
+  if ((err = f_mkfs(0, 0, 0)) != FR_OK) {
+    printf("f_mkfs() failed, error %d\n", err);
+    return FALSE;
+  }
+  if (!seq_write()) {
+    printf("sequential write failed\n");
+    return FALSE;
+  }
+  if (!seq_read()) {
+    printf("sequential read failed\n");
+    return FALSE;
+  }
+  if (!small_files()) {
+    printf("small files test failed\n");
+    return FALSE;
+  }
+  f_mount(0, NULL);
+  if (!wrapper_test(&image)) {
+    printf("C++ wrapper test failed\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  bool_t ok;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * The disk image is opened and assigned to the FatFs drive 0.
+   */
+  biObjectInit(&image);
+  if (biOpen(&image, &image_cfg) || blkConnect(&image)) {
+    printf("cannot open %s\n", image_cfg.path);
+    exit(1);
+  }
+  fatfsRegisterDrive(0, (BaseBlockDevice *)&image, FALSE);
+
+  ok = benchmark();
+  fatfsDisconnectDrive(0);
+  biClose(&image);
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  exit(ok ? 0 : 1);
+}
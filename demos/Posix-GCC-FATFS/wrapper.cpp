@@ -0,0 +1,138 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.hpp"
+#include "hal.h"
+#include "fs.hpp"
+#include "fatfs_fsimpl.hpp"
+#include "wrapper.h"
+
+using namespace chibios_rt;
+using namespace chibios_fs;
+using namespace chibios_fatfs;
+
+/* Test file size, size of the written records and of the reads.*/
+#define WRAPPER_FILE_SIZE   (256 * 1024)
+#define RECORD_SIZE         100
+#define READ_SIZE           512
+
+/* Simulated processing, 1ms every 4KB read.*/
+#define PROCESS_READS       8
+
+static FatFSWrapper fs;
+static uint8_t data[READ_SIZE];
+
+/*
+ * Pattern byte at the specified file offset.
+ */
+static uint8_t pattern(uint32_t offset) {
+
+  return (uint8_t)(offset * 7 + (offset >> 9));
+}
+
+/*
+ * Writes the test file in small records, the records are batched in the
+ * file buffer by the wrapper.
+ */
+static bool_t wrapper_write(BlockImage *bip) {
+  BaseFileStreamInterface *fp;
+  systime_t start;
+  uint32_t offset;
+  size_t i, n;
+
+  biResetStats(bip);
+  start = chTimeNow();
+  fp = fs.create("wrapper.bin");
+  if (fp == NULL)
+    return FALSE;
+  for (offset = 0; offset < WRAPPER_FILE_SIZE; offset += n) {
+    n = WRAPPER_FILE_SIZE - offset;
+    if (n > RECORD_SIZE)
+      n = RECORD_SIZE;
+    for (i = 0; i < n; i++)
+      data[i] = pattern(offset + i);
+    if (fp->write(data, n) != n) {
+      fs.close(fp);
+      return FALSE;
+    }
+  }
+  fs.close(fp);
+  if (fs.getAndClearLastError() != FR_OK)
+    return FALSE;
+  report("wrapper write", WRAPPER_FILE_SIZE, chTimeNow() - start);
+  return TRUE;
+}
+
+/*
+ * Reads back and verifies the test file, optionally simulating some
+ * processing of the data, the read-ahead overlaps the device transfers
+ * with the processing.
+ */
+static bool_t wrapper_read(BlockImage *bip, bool_t process) {
+  BaseFileStreamInterface *fp;
+  systime_t start;
+  uint32_t offset;
+  size_t i, n;
+
+  biResetStats(bip);
+  start = chTimeNow();
+  fp = fs.openForRead("wrapper.bin");
+  if (fp == NULL)
+    return FALSE;
+  if (fp->getSize() != WRAPPER_FILE_SIZE) {
+    fs.close(fp);
+    return FALSE;
+  }
+  for (offset = 0; offset < WRAPPER_FILE_SIZE; offset += n) {
+    n = fp->read(data, READ_SIZE);
+    if (n == 0)
+      break;
+    for (i = 0; i < n; i++) {
+      if (data[i] != pattern(offset + i)) {
+        printf("data mismatch at offset %u\n", (unsigned)(offset + i));
+        fs.close(fp);
+        return FALSE;
+      }
+    }
+    if (process && ((offset / READ_SIZE) % PROCESS_READS == 0))
+      BaseThread::sleep(MS2ST(1));
+  }
+  fs.close(fp);
+  if (offset != WRAPPER_FILE_SIZE)
+    return FALSE;
+  report(process ? "wrapper process" : "wrapper read", WRAPPER_FILE_SIZE,
+         chTimeNow() - start);
+  return TRUE;
+}
+
+/*
+ * Exercises the FatFS C++ wrapper on the already formatted image, the
+ * volume must not be mounted by the caller.
+ */
+bool_t wrapper_test(BlockImage *bip) {
+  bool_t ok;
+
+  fs.mount();
+  ok = wrapper_write(bip) && wrapper_read(bip, FALSE) &&
+       wrapper_read(bip, TRUE);
+  fs.remove("wrapper.bin");
+  if (fs.getAndClearLastError() != FR_OK)
+    ok = FALSE;
+  fs.unmount();
+  return ok;
+}
@@ -0,0 +1,36 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    wrapper.h
+ * @brief   FatFS C++ wrapper test.
+ */
+
+#ifndef _WRAPPER_H_
+#define _WRAPPER_H_
+
+#include "blkimage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void report(const char *test, uint32_t bytes, systime_t time);
+  bool_t wrapper_test(BlockImage *bip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WRAPPER_H_ */
@@ -0,0 +1,303 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "macqueues.h"
+
+#define ETH_TYPE_IP         0x0800
+#define ETH_TYPE_ARP        0x0806
+#define ETH_TYPE_VLAN       0x8100
+
+#define IP_PROTO_UDP        17
+#define IP_FLAG_MF          0x2000
+
+#define PTP_EVENT_PORT      319
+#define PTP_PRIO            5
+
+#define UNTAGGED            -1
+#define SETTLE_TIME         MS2ST(50)
+
+/* The limits test fills the spare buffers using two queues.*/
+#if SIM_MAC_RECEIVE_SPARE_BUFFERS != 4
+#error "the demo requires SIM_MAC_RECEIVE_SPARE_BUFFERS set to 4"
+#endif
+
+static uint8_t ethaddr[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x48};
+static const uint8_t peer_ethaddr[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x49};
+static MACConfig mac_config = {ethaddr, NULL};
+
+/*
+ * Queues in classification order, there is no catch-all queue so the
+ * frames not matched by any rule are counted and discarded. The sum of
+ * the limits exceeds the spare buffers of the driver on purpose.
+ */
+static MACClassifier classifier;
+static MACQueue qprio, qudp, qip;
+static msg_t qprio_buf[4], qudp_buf[4], qip_buf[4];
+
+/* Host side of the virtual LAN, the frames are injected from here.*/
+static int sock;
+static struct sockaddr_un dest;
+
+static bool_t ok = TRUE;
+
+/*
+ * Frames injected by the classification test. The frames sent to an IPv4
+ * EtherType carry an UDP header right after the IP header.
+ */
+typedef struct {
+  const char    *name;
+  int           prio;       /* VLAN priority or UNTAGGED.                   */
+  uint16_t      type;       /* Encapsulated EtherType.                      */
+  unsigned      ihl;        /* IP header length in 32 bits words.           */
+  uint16_t      frag;       /* IP flags and fragment offset.                */
+  uint16_t      port;       /* UDP destination port.                        */
+  MACQueue      *qp;        /* Expected queue or NULL if unmatched.         */
+} test_frame_t;
+
+static const test_frame_t test_frames[] = {
+  {"tagged ARP, high priority",   6,        ETH_TYPE_ARP, 0, 0, 0, &qprio},
+  {"tagged UDP, high priority",   7,        ETH_TYPE_IP,  5, 0,
+   PTP_EVENT_PORT, &qprio},
+  {"tagged UDP, low priority",    2,        ETH_TYPE_IP,  5, 0,
+   PTP_EVENT_PORT, &qudp},
+  {"tagged ARP, low priority",    2,        ETH_TYPE_ARP, 0, 0, 0, NULL},
+  {"untagged UDP",                UNTAGGED, ETH_TYPE_IP,  5, 0,
+   PTP_EVENT_PORT, &qudp},
+  {"untagged UDP, other port",    UNTAGGED, ETH_TYPE_IP,  5, 0, 320, &qip},
+  {"untagged UDP, IP options",    UNTAGGED, ETH_TYPE_IP,  7, 0,
+   PTP_EVENT_PORT, &qudp},
+  {"first fragment",              UNTAGGED, ETH_TYPE_IP,  5, IP_FLAG_MF,
+   PTP_EVENT_PORT, &qudp},
+  {"following fragment",          UNTAGGED, ETH_TYPE_IP,  5, 185,
+   PTP_EVENT_PORT, &qip},
+  {"last fragment",               UNTAGGED, ETH_TYPE_IP,  5, 370,
+   PTP_EVENT_PORT, &qip},
+  {"malformed IP header length",  UNTAGGED, ETH_TYPE_IP,  4, 0,
+   PTP_EVENT_PORT, &qip},
+  {"untagged ARP",                UNTAGGED, ETH_TYPE_ARP, 0, 0, 0, NULL}
+};
+
+#define N_FRAMES            (sizeof test_frames / sizeof test_frames[0])
+
+static void put16(uint8_t *p, uint16_t v) {
+
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static const char *queue_name(MACQueue *qp) {
+
+  if (qp == &qprio)
+    return "qprio";
+  if (qp == &qudp)
+    return "qudp";
+  if (qp == &qip)
+    return "qip";
+  return "none";
+}
+
+static void check(const char *what, bool_t result) {
+
+  printf("%-40s %s\n", what, result ? "OK" : "FAILED");
+  if (!result)
+    ok = FALSE;
+}
+
+/*
+ * Builds a frame addressed to the simulated interface and sends it on the
+ * virtual LAN, the frame size is returned.
+ */
+static size_t inject(const test_frame_t *tfp, size_t size) {
+  uint8_t f[128];
+  size_t l3 = 14;
+
+  memset(f, 0, sizeof f);
+  memcpy(&f[0], ethaddr, 6);
+  memcpy(&f[6], peer_ethaddr, 6);
+  if (tfp->prio != UNTAGGED) {
+    put16(&f[12], ETH_TYPE_VLAN);
+    put16(&f[14], (uint16_t)(tfp->prio << 13) | 1);
+    l3 += 4;
+  }
+  put16(&f[l3 - 2], tfp->type);
+  if (tfp->type == ETH_TYPE_IP) {
+    f[l3]     = (uint8_t)(0x40 | tfp->ihl);
+    put16(&f[l3 + 2], (uint16_t)(size - l3));
+    put16(&f[l3 + 6], tfp->frag);
+    f[l3 + 8] = 64;
+    f[l3 + 9] = IP_PROTO_UDP;
+    put16(&f[l3 + tfp->ihl * 4], 7000);
+    put16(&f[l3 + tfp->ihl * 4 + 2], tfp->port);
+  }
+  if (sendto(sock, f, size, 0, (struct sockaddr *)&dest,
+             sizeof dest) != (ssize_t)size) {
+    printf("Error sending to %s\n", dest.sun_path);
+    exit(1);
+  }
+  return size;
+}
+
+/*
+ * Each frame is injected alone and must be the only frame queued by the
+ * classifier, in the expected queue.
+ */
+static void test_classification(void) {
+  static MACQueue *const queues[] = {&qprio, &qudp, &qip};
+  MACQueueFrame fr;
+  MACQueue *got;
+  uint32_t unmatched;
+  unsigned i, j, n;
+  size_t size;
+  char msg[80];
+
+  for (i = 0; i < N_FRAMES; i++) {
+    unmatched = classifier.unmatched;
+    size = inject(&test_frames[i], 64 + i);
+    chThdSleep(SETTLE_TIME);
+
+    got = NULL;
+    n = 0;
+    for (j = 0; j < sizeof queues / sizeof queues[0]; j++) {
+      while (macqGetFrame(queues[j], &fr, TIME_IMMEDIATE) == RDY_OK) {
+        if (fr.size == size)
+          got = queues[j];
+        n++;
+        macqReleaseFrame(queues[j], &fr);
+      }
+    }
+    if (classifier.unmatched != unmatched)
+      n++;
+
+    snprintf(msg, sizeof msg, "%s -> %s", test_frames[i].name,
+             queue_name(got));
+    check(msg, (n == 1) && (got == test_frames[i].qp) &&
+               ((got != NULL) || (classifier.unmatched == unmatched + 1)));
+  }
+}
+
+/*
+ * The frames are not consumed, the queues keep the buffers loaned until
+ * their limits are reached and the spare buffers run out.
+ */
+static void test_limits(void) {
+  static const test_frame_t ip = {"", UNTAGGED, ETH_TYPE_IP, 5, 0, 320,
+                                  &qip};
+  static const test_frame_t udp = {"", UNTAGGED, ETH_TYPE_IP, 5, 0,
+                                   PTP_EVENT_PORT, &qudp};
+  static const test_frame_t prio = {"", 6, ETH_TYPE_ARP, 0, 0, 0, &qprio};
+  uint32_t frames, drops, nobufs;
+  MACQueueFrame fr;
+  msg_t msg;
+  unsigned i;
+
+  /* The queue limit is reached before the spare buffers run out.*/
+  frames = qip.frames;
+  drops  = qip.drops;
+  for (i = 0; i < 3; i++)
+    inject(&ip, 64);
+  chThdSleep(SETTLE_TIME);
+  check("qip limit", (qip.frames == frames + 2) &&
+                     (qip.drops == drops + 1) && (qip.loaned == 2));
+
+  /* The second queue takes the remaining spare buffers, there are
+     SIM_MAC_RECEIVE_SPARE_BUFFERS of them.*/
+  frames = qudp.frames;
+  nobufs = classifier.nobufs;
+  for (i = 0; i < 3; i++)
+    inject(&udp, 64);
+  chThdSleep(SETTLE_TIME);
+  check("spare buffers exhausted", (qudp.frames == frames + 2) &&
+                                   (qudp.loaned == 2) &&
+                                   (classifier.nobufs == nobufs + 1));
+
+  /* The oversubscribed limits starve the high priority queue.*/
+  frames = qprio.frames;
+  inject(&prio, 64);
+  chThdSleep(SETTLE_TIME);
+  check("qprio starved", (qprio.frames == frames) &&
+                         (classifier.nobufs == nobufs + 2));
+
+  /* Consuming the frames gives the buffers back.*/
+  while (macqGetFrame(&qip, &fr, TIME_IMMEDIATE) == RDY_OK)
+    macqReleaseFrame(&qip, &fr);
+  while (macqGetFrame(&qudp, &fr, TIME_IMMEDIATE) == RDY_OK)
+    macqReleaseFrame(&qudp, &fr);
+  inject(&prio, 64);
+  msg = macqGetFrame(&qprio, &fr, SETTLE_TIME);
+  check("qprio after release", (msg == RDY_OK) &&
+                               (qprio.frames == frames + 1) &&
+                               (qip.loaned == 0) && (qudp.loaned == 0));
+  if (msg == RDY_OK)
+    macqReleaseFrame(&qprio, &fr);
+}
+
+/*
+ * Simulator main.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  macStart(&ETHD1, &mac_config);
+  macclsObjectInit(&classifier);
+  macqObjectInit(&qprio, MACQ_MATCH_VLAN_PRIO, PTP_PRIO, qprio_buf, 4, 2);
+  macqObjectInit(&qudp, MACQ_MATCH_UDP_PORT, PTP_EVENT_PORT, qudp_buf, 4, 2);
+  macqObjectInit(&qip, MACQ_MATCH_ETHERTYPE, ETH_TYPE_IP, qip_buf, 4, 2);
+  macclsAddQueue(&classifier, &qprio);
+  macclsAddQueue(&classifier, &qudp);
+  macclsAddQueue(&classifier, &qip);
+  macclsStart(&classifier, &ETHD1, NORMALPRIO + 1);
+
+  sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    printf("Error creating the injection socket\n");
+    exit(1);
+  }
+  memset(&dest, 0, sizeof dest);
+  dest.sun_family = AF_UNIX;
+  snprintf(dest.sun_path, sizeof dest.sun_path,
+           "%s/%02x%02x%02x%02x%02x%02x", SIM_MAC_VLAN_PATH,
+           ethaddr[0], ethaddr[1], ethaddr[2],
+           ethaddr[3], ethaddr[4], ethaddr[5]);
+
+  test_classification();
+  test_limits();
+  printf("%u frames received, %u unmatched, %u without buffers\n",
+         (unsigned)ETHD1.rxframes, (unsigned)classifier.unmatched,
+         (unsigned)classifier.nobufs);
+  printf("Final result: %s\n", ok ? "PASSED" : "FAILED");
+
+  close(sock);
+  macStop(&ETHD1);
+  exit(ok ? 0 : 1);
+}
@@ -0,0 +1,221 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "ptp.h"
+
+#include "trace.h"
+
+#define TRACE_SAMPLES       (sizeof trace / sizeof trace[0])
+
+/* Samples needed for the servo to converge, the following ones must be
+   within MAX_OFFSET nanoseconds from the master.*/
+#define SETTLE_SAMPLES      30
+#define MAX_OFFSET          1000
+#define MAX_DELAY_ERROR     100
+
+/* Residence times reported by a transparent clock in the correction
+   fields.*/
+#define SYNC_CORRECTION     120
+#define RESP_CORRECTION     40
+
+static const uint8_t master_port[10] = {0x00, 0x1B, 0x19, 0xFF,
+                                        0xFE, 0x00, 0x00, 0x01, 0x00, 0x01};
+static const uint8_t rogue_port[10]  = {0x00, 0x1B, 0x19, 0xFF,
+                                        0xFE, 0x00, 0x00, 0x02, 0x00, 0x01};
+static const uint8_t clockid[8]      = {0xC2, 0xAF, 0x51, 0xFF,
+                                        0xFE, 0x03, 0xCF, 0x46};
+
+/*===========================================================================*/
+/* Slave clock model.                                                        */
+/*===========================================================================*/
+
+/* The adjusted slave clock is a linear function of the free running clock
+   of the trace, the servo callbacks change the function from the current
+   free running time on.*/
+static ptptime_t raw_now;
+static ptptime_t raw_base;
+static ptptime_t adj_base;
+static int32_t adj_ppb;
+
+static ptptime_t clock_time(ptptime_t raw) {
+  ptptime_t elapsed = raw - raw_base;
+
+  return adj_base + elapsed + elapsed * adj_ppb / 1000000000;
+}
+
+static void clock_step(void *arg, ptptime_t offset) {
+
+  (void)arg;
+  adj_base += offset;
+}
+
+static void clock_tune(void *arg, int32_t ppb) {
+
+  (void)arg;
+  adj_base = clock_time(raw_now);
+  raw_base = raw_now;
+  adj_ppb  = ppb;
+}
+
+static const PTPServoConfig servo_config = {
+  45875,                            /* kp = 0.7.                            */
+  19661,                            /* ki = 0.3.                            */
+  500000,                           /* 500ppm range.                        */
+  100000,                           /* Clock stepped beyond 100us.          */
+  clock_step,
+  clock_tune,
+  NULL
+};
+
+/*===========================================================================*/
+/* Master messages.                                                          */
+/*===========================================================================*/
+
+static void put_header(uint8_t *p, uint8_t type, uint16_t len,
+                       const uint8_t *port, uint16_t seq,
+                       ptptime_t correction) {
+  uint64_t corr = (uint64_t)(correction * 65536);
+  unsigned i;
+
+  memset(p, 0, len);
+  p[0] = type;
+  p[1] = 2;
+  p[2] = (uint8_t)(len >> 8);
+  p[3] = (uint8_t)len;
+  for (i = 0; i < 8; i++)
+    p[8 + i] = (uint8_t)(corr >> (56 - i * 8));
+  memcpy(&p[20], port, 10);
+  p[30] = (uint8_t)(seq >> 8);
+  p[31] = (uint8_t)seq;
+}
+
+static void put_timestamp(uint8_t *p, ptptime_t t) {
+  uint64_t sec = (uint64_t)(t / 1000000000);
+  uint32_t ns  = (uint32_t)(t % 1000000000);
+  unsigned i;
+
+  for (i = 0; i < 6; i++)
+    p[i] = (uint8_t)(sec >> (40 - i * 8));
+  for (i = 0; i < 4; i++)
+    p[6 + i] = (uint8_t)(ns >> (24 - i * 8));
+}
+
+/*===========================================================================*/
+/* Trace replay.                                                             */
+/*===========================================================================*/
+
+/*
+ * Replays the trace through the PTP slave, the master messages are built
+ * from the trace timestamps and the slave timestamps are adjusted by the
+ * clock model.
+ */
+static bool_t replay(void) {
+  static PTPSlave slave;
+  PTPServo *sp = ptpslvGetServo(&slave);
+  uint8_t msg[PTP_DELAY_RESP_SIZE], req[PTP_DELAY_REQ_SIZE];
+  ptptime_t offset, max_offset = 0, sum_offset = 0;
+  unsigned i;
+
+  raw_now  = trace[0].t2;
+  raw_base = trace[0].t2;
+  adj_base = trace[0].t2;
+  adj_ppb  = 0;
+  ptpslvObjectInit(&slave, &servo_config, clockid, 0);
+
+  for (i = 0; i < TRACE_SAMPLES; i++) {
+    /* Two-step Sync and its Follow_Up.*/
+    raw_now = trace[i].t2;
+    put_header(msg, PTP_MSG_SYNC, PTP_HEADER_SIZE + 10, master_port,
+               (uint16_t)i, 0);
+    msg[6] = 0x02;
+    ptpslvInput(&slave, msg, PTP_HEADER_SIZE + 10, clock_time(trace[i].t2));
+    put_header(msg, PTP_MSG_FOLLOW_UP, PTP_HEADER_SIZE + 10, master_port,
+               (uint16_t)i, SYNC_CORRECTION);
+    put_timestamp(&msg[34], trace[i].t1 - SYNC_CORRECTION);
+    ptpslvInput(&slave, msg, PTP_HEADER_SIZE + 10, 0);
+
+    /* One-step Sync from another master, it must be ignored.*/
+    put_header(msg, PTP_MSG_SYNC, PTP_HEADER_SIZE + 10, rogue_port,
+               (uint16_t)i, 0);
+    put_timestamp(&msg[34], trace[i].t1 + 1000000);
+    ptpslvInput(&slave, msg, PTP_HEADER_SIZE + 10, clock_time(trace[i].t2));
+
+    /* Delay_Req and Delay_Resp exchange.*/
+    if (ptpslvBuildDelayReq(&slave, req) != PTP_DELAY_REQ_SIZE) {
+      printf("Delay_Req size mismatch\n");
+      return FALSE;
+    }
+    raw_now = trace[i].t3;
+    ptpslvDelayReqSent(&slave, clock_time(trace[i].t3));
+    put_header(msg, PTP_MSG_DELAY_RESP, PTP_DELAY_RESP_SIZE, master_port,
+               (uint16_t)((req[30] << 8) | req[31]), RESP_CORRECTION);
+    put_timestamp(&msg[34], trace[i].t4 + RESP_CORRECTION);
+    memcpy(&msg[44], &req[20], 10);
+    ptpslvInput(&slave, msg, PTP_DELAY_RESP_SIZE, 0);
+
+    if (i < SETTLE_SAMPLES)
+      continue;
+    if (ptpsrvGetState(sp) != PTP_LOCKED) {
+      printf("servo not locked at sample %u\n", i);
+      return FALSE;
+    }
+    offset = ptpsrvGetOffset(sp);
+    if (offset < 0)
+      offset = -offset;
+    if (offset > max_offset)
+      max_offset = offset;
+    sum_offset += offset;
+  }
+
+  printf("Samples:             %u\n", (unsigned)TRACE_SAMPLES);
+  printf("Clock steps:         %u\n", (unsigned)sp->steps);
+  printf("Frequency:           %d ppb\n", (int)sp->ppb);
+  printf("Path delay:          %d ns\n", (int)sp->delay);
+  printf("Max offset:          %d ns\n", (int)max_offset);
+  printf("Mean offset:         %d ns\n",
+         (int)(sum_offset / (ptptime_t)(TRACE_SAMPLES - SETTLE_SAMPLES)));
+
+  return (sp->steps == 1) && (max_offset < MAX_OFFSET) &&
+         (sp->delay >= TRACE_PATH_DELAY) &&
+         (sp->delay < TRACE_PATH_DELAY + MAX_DELAY_ERROR);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  bool_t ok;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  ok = replay();
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  exit(ok ? 0 : 1);
+}
@@ -0,0 +1,337 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Timestamp trace of a Sync and Delay_Req exchange every second, produced
+ * by a clock model of the link:
+ * - Master timestamps with 8ns resolution.
+ * - Slave timestamps read from a free running clock, never adjusted, with
+ *   the resolution of the STM32F407 PTP clock (about 12.1ns). The slave
+ *   oscillator is 37ppm fast with a 2ppm wander over a 900s period.
+ * - 1500ns path delay in both directions plus a queuing jitter
+ *   exponentially distributed with 30ns mean.
+ * The replay applies the servo corrections to the slave timestamps.
+ */
+
+#define TRACE_PATH_DELAY    1500
+
+static const struct {
+  ptptime_t             t1;
+  ptptime_t             t2;
+  ptptime_t             t3;
+  ptptime_t             t4;
+} trace[] = {
+  {1381000000000600672LL, 12346281089LL, 12598753290LL, 1381000000253066528LL},
+  {1381000001000173704LL, 13345891141LL, 13603806410LL, 1381000001258082488LL},
+  {1381000002000653736LL, 14346408204LL, 14596654122LL, 1381000002250893416LL},
+  {1381000003000339296LL, 15346130805LL, 15596273509LL, 1381000003250475816LL},
+  {1381000004000551496LL, 16346380044LL, 16600951209LL, 1381000004255116240LL},
+  {1381000005000715128LL, 17346580758LL, 17604618528LL, 1381000005258746392LL},
+  {1381000006000162672LL, 18346065332LL, 18597491944LL, 1381000006251582984LL},
+  {1381000007000993800LL, 19346933637LL, 19599429059LL, 1381000007253482928LL},
+  {1381000008000023448LL, 20346000354LL, 20598224734LL, 1381000008252241576LL},
+  {1381000009000993792LL, 21347007795LL, 21606447117LL, 1381000009260426528LL},
+  {1381000010000386864LL, 22346438007LL, 22598618135LL, 1381000010252560680LL},
+  {1381000011000674944LL, 23346763219LL, 23599403372LL, 1381000011253308816LL},
+  {1381000012000971536LL, 24347097004LL, 24601229428LL, 1381000012255097600LL},
+  {1381000013000893856LL, 25347056470LL, 25600999877LL, 1381000013254830880LL},
+  {1381000014000790848LL, 26346990680LL, 26600496787LL, 1381000014254290576LL},
+  {1381000015000596600LL, 27346833626LL, 27603561264LL, 1381000015257317768LL},
+  {1381000016000064320LL, 28346338528LL, 28597164684LL, 1381000016250884240LL},
+  {1381000017000370200LL, 29346681659LL, 29599424964LL, 1381000017253107200LL},
+  {1381000018000895568LL, 30347244293LL, 30605100128LL, 1381000018258744832LL},
+  {1381000019000544520LL, 31346930463LL, 31599714280LL, 1381000019253321952LL},
+  {1381000020000097304LL, 32346520503LL, 32598788189LL, 1381000020252358664LL},
+  {1381000021000120064LL, 33346580567LL, 33600956262LL, 1381000021254489304LL},
+  {1381000022000815440LL, 34347313247LL, 34600144512LL, 1381000022253640304LL},
+  {1381000023000714272LL, 35347249443LL, 35597842039LL, 1381000023251300816LL},
+  {1381000024000434760LL, 36347007216LL, 36600445293LL, 1381000024253866472LL},
+  {1381000025000777208LL, 37347387092LL, 37600033831LL, 1381000025253417656LL},
+  {1381000026000151576LL, 38346798695LL, 38600952780LL, 1381000026254299184LL},
+  {1381000027000863504LL, 39347548023LL, 39597556882LL, 1381000027250866040LL},
+  {1381000028000138160LL, 40346860044LL, 40600794165LL, 1381000028254065880LL},
+  {1381000029000726480LL, 41347485818LL, 41600097639LL, 1381000029253331936LL},
+  {1381000030000200560LL, 42346997245LL, 42598552690LL, 1381000030251749656LL},
+  {1381000031000643944LL, 43347478059LL, 43601344888LL, 1381000031254504368LL},
+  {1381000032000374400LL, 44347245953LL, 44600107207LL, 1381000032253229224LL},
+  {1381000033000297440LL, 45347206424LL, 45604537593LL, 1381000033257621976LL},
+  {1381000034000378760LL, 46347325208LL, 46599150764LL, 1381000034252197888LL},
+  {1381000035000580080LL, 47347564012LL, 47600177867LL, 1381000035253187480LL},
+  {1381000036000029896LL, 48347051370LL, 48600588810LL, 1381000036253560904LL},
+  {1381000037000222736LL, 49347281649LL, 49600753324LL, 1381000037253687952LL},
+  {1381000038000398120LL, 50347494555LL, 50599287725LL, 1381000038252184944LL},
+  {1381000039000115976LL, 51347249955LL, 51605786032LL, 1381000039258645384LL},
+  {1381000040000093976LL, 52347265501LL, 52599417903LL, 1381000040252239952LL},
+  {1381000041000622032LL, 53347831126LL, 53605038548LL, 1381000041257822960LL},
+  {1381000042000612296LL, 54347858949LL, 54605431076LL, 1381000042258177760LL},
+  {1381000043000179120LL, 55347463396LL, 55598205213LL, 1381000043250914584LL},
+  {1381000044000249408LL, 56347571284LL, 56600801553LL, 1381000044253473216LL},
+  {1381000045000446360LL, 57347805801LL, 57606148502LL, 1381000045258782360LL},
+  {1381000046000719608LL, 58348116691LL, 58599425197LL, 1381000046252021728LL},
+  {1381000047000187200LL, 59347621895LL, 59598284676LL, 1381000047250843560LL},
+  {1381000048000911224LL, 60348383632LL, 60601393054LL, 1381000048253914224LL},
+  {1381000049000415040LL, 61347925073LL, 61600928102LL, 1381000049253411576LL},
+  {1381000050000602000LL, 62348149711LL, 62603892501LL, 1381000050256338200LL},
+  {1381000051000472176LL, 63348057673LL, 63599879428LL, 1381000051252287552LL},
+  {1381000052000879608LL, 64348502722LL, 64605205443LL, 1381000052257575656LL},
+  {1381000053000809808LL, 65348470627LL, 65606564041LL, 1381000053258896552LL},
+  {1381000054000388488LL, 66348087036LL, 66604661917LL, 1381000054256956720LL},
+  {1381000055000939824LL, 67348676124LL, 67606304319LL, 1381000055258561312LL},
+  {1381000056000176840LL, 68347950868LL, 68606446677LL, 1381000056258665912LL},
+  {1381000057000735936LL, 69348547754LL, 69599322296LL, 1381000057251504008LL},
+  {1381000058000458952LL, 70348308541LL, 70606768282LL, 1381000058258911944LL},
+  {1381000059000659080LL, 71348546496LL, 71601929558LL, 1381000059254035696LL},
+  {1381000060000435648LL, 72348360833LL, 72600280269LL, 1381000060252348576LL},
+  {1381000061000693528LL, 73348656637LL, 73605927525LL, 1381000061257957792LL},
+  {1381000062000154016LL, 74348154843LL, 74606165577LL, 1381000062258158048LL},
+  {1381000063000616736LL, 75348655428LL, 75606016599LL, 1381000063257971272LL},
+  {1381000064000569248LL, 76348645816LL, 76607637959LL, 1381000064259554632LL},
+  {1381000065000899736LL, 77349014166LL, 77601707203LL, 1381000065253586208LL},
+  {1381000066000014000LL, 78348166313LL, 78605448169LL, 1381000066257289176LL},
+  {1381000067000399768LL, 79348589981LL, 79606973132LL, 1381000067258776160LL},
+  {1381000068000619624LL, 80348847756LL, 80607804074LL, 1381000068259569152LL},
+  {1381000069000648856LL, 81348914879LL, 81601505319LL, 1381000069253232744LL},
+  {1381000070000120240LL, 82348424236LL, 82599772333LL, 1381000070251461864LL},
+  {1381000071000806216LL, 83349148126LL, 83609080937LL, 1381000071260732224LL},
+  {1381000072000557648LL, 84348937547LL, 84608738765LL, 1381000072260352056LL},
+  {1381000073000909224LL, 85349327084LL, 85604576712LL, 1381000073256152216LL},
+  {1381000074000597952LL, 86349053765LL, 86600698840LL, 1381000074252236504LL},
+  {1381000075000557856LL, 87349051672LL, 87600294872LL, 1381000075251794544LL},
+  {1381000076000217112LL, 88348748944LL, 88604489337LL, 1381000076255950856LL},
+  {1381000077000372544LL, 89348942479LL, 89599389728LL, 1381000077250813440LL},
+  {1381000078000526160LL, 90349134028LL, 90605228374LL, 1381000078256613784LL},
+  {1381000079000964880LL, 91349610846LL, 91600624978LL, 1381000079251972536LL},
+  {1381000080000008704LL, 92348692638LL, 92605097255LL, 1381000080256406624LL},
+  {1381000081000051528LL, 93348773539LL, 93602150184LL, 1381000081253421544LL},
+  {1381000082000208440LL, 94348968562LL, 94607365673LL, 1381000082258598752LL},
+  {1381000083000287016LL, 95349085192LL, 95600506707LL, 1381000083251702000LL},
+  {1381000084000798864LL, 96349635162LL, 96606779844LL, 1381000084257936768LL},
+  {1381000085000806392LL, 97349680868LL, 97602978610LL, 1381000085254097576LL},
+  {1381000086000719432LL, 98349631968LL, 98600913620LL, 1381000086251994536LL},
+  {1381000087000402656LL, 99349353358LL, 99607443285LL, 1381000087258485784LL},
+  {1381000088000007800LL, 100348996596LL, 100602814088LL, 1381000088253818624LL},
+  {1381000089000255112LL, 101349282097LL, 101606118566LL, 1381000089257084816LL},
+  {1381000090000310168LL, 102349375323LL, 102605123356LL, 1381000090256051480LL},
+  {1381000091000794696LL, 103349898064LL, 103600775518LL, 1381000091251665632LL},
+  {1381000092000244760LL, 104349386355LL, 104600465962LL, 1381000092251317928LL},
+  {1381000093000503648LL, 105349683369LL, 105607590005LL, 1381000093258403448LL},
+  {1381000094000012656LL, 106349230561LL, 106608393440LL, 1381000094259168656LL},
+  {1381000095000427000LL, 107349683153LL, 107607439842LL, 1381000095258176864LL},
+  {1381000096000991976LL, 108350286383LL, 108607340903LL, 1381000096258039928LL},
+  {1381000097000617368LL, 109349950094LL, 109600527641LL, 1381000097251188456LL},
+  {1381000098000979624LL, 110350350553LL, 110608819592LL, 1381000098259441792LL},
+  {1381000099000497120LL, 111349906305LL, 111601673722LL, 1381000099252257976LL},
+  {1381000100000938648LL, 112350386138LL, 112608369715LL, 1381000100258915416LL},
+  {1381000101000593968LL, 113350079730LL, 113601920275LL, 1381000101252427920LL},
+  {1381000102000546584LL, 114350070626LL, 114608360092LL, 1381000102258829168LL},
+  {1381000103000421416LL, 115349983782LL, 115606321375LL, 1381000103256752240LL},
+  {1381000104000966432LL, 116350567180LL, 116605849885LL, 1381000104256242416LL},
+  {1381000105000616784LL, 117350255833LL, 117608507899LL, 1381000105258862016LL},
+  {1381000106000314368LL, 118349991800LL, 118604954221LL, 1381000106255270120LL},
+  {1381000107000952408LL, 119350668121LL, 119609516031LL, 1381000107259793424LL},
+  {1381000108000254072LL, 120350008183LL, 120603442337LL, 1381000108253681592LL},
+  {1381000109000181872LL, 121349974308LL, 121604091962LL, 1381000109254292792LL},
+  {1381000110000834248LL, 122350665085LL, 122604976514LL, 1381000110255138936LL},
+  {1381000111000804768LL, 123350674009LL, 123603524136LL, 1381000111253648208LL},
+  {1381000112000702248LL, 124350609878LL, 124606421691LL, 1381000112256507280LL},
+  {1381000113000993376LL, 125350939461LL, 125601306100LL, 1381000113251353472LL},
+  {1381000114000034176LL, 126350018625LL, 126603250553LL, 1381000114253259432LL},
+  {1381000115000924880LL, 127350947780LL, 127608229576LL, 1381000115258199792LL},
+  {1381000116000123944LL, 128350185355LL, 128608475789LL, 1381000116258407616LL},
+  {1381000117000313848LL, 129350413637LL, 129607969274LL, 1381000117257862592LL},
+  {1381000118000931672LL, 130351069969LL, 130605614716LL, 1381000118255469664LL},
+  {1381000119000803184LL, 131350979965LL, 131604167968LL, 1381000119253984496LL},
+  {1381000120000755112LL, 132350970341LL, 132604686060LL, 1381000120254464136LL},
+  {1381000121000177888LL, 133350431596LL, 133605765611LL, 1381000121255505144LL},
+  {1381000122000134744LL, 134350426972LL, 134609786544LL, 1381000122259487384LL},
+  {1381000123000860736LL, 135351191505LL, 135602039030LL, 1381000123251701672LL},
+  {1381000124000598416LL, 136350967669LL, 136608496742LL, 1381000124258120624LL},
+  {1381000125000881208LL, 137351288982LL, 137601893020LL, 1381000125251478608LL},
+  {1381000126000011816LL, 138350458103LL, 138609003721LL, 1381000126258550560LL},
+  {1381000127000400008LL, 139350884870LL, 139608612938LL, 1381000127258121176LL},
+  {1381000128000834888LL, 140351358359LL, 140605095327LL, 1381000128254565200LL},
+  {1381000129000456536LL, 141351018536LL, 141607248737LL, 1381000129256679912LL},
+  {1381000130000715632LL, 142351316192LL, 142607796770LL, 1381000130257189352LL},
+  {1381000131000116328LL, 143350755497LL, 143606606973LL, 1381000131255961016LL},
+  {1381000132000749376LL, 144351427084LL, 144609909296LL, 1381000132259224624LL},
+  {1381000133000715096LL, 145351431431LL, 145609317098LL, 1381000133258593856LL},
+  {1381000134000506176LL, 146351261084LL, 146604280276LL, 1381000134253518688LL},
+  {1381000135000892976LL, 147351686531LL, 147611036769LL, 1381000135260236248LL},
+  {1381000136000347544LL, 148351179677LL, 148608299636LL, 1381000136257460592LL},
+  {1381000137000120648LL, 149350991447LL, 149602467553LL, 1381000137251590120LL},
+  {1381000138000266336LL, 150351175877LL, 150604066576LL, 1381000138253150472LL},
+  {1381000139000265520LL, 151351213580LL, 151603832327LL, 1381000139252877520LL},
+  {1381000140000387728LL, 152351374449LL, 152608255715LL, 1381000140257262144LL},
+  {1381000141000500904LL, 153351526383LL, 153605733775LL, 1381000141254701632LL},
+  {1381000142000075952LL, 154351139971LL, 154607662731LL, 1381000142256591832LL},
+  {1381000143000927144LL, 155352029899LL, 155606568181LL, 1381000143255458608LL},
+  {1381000144000818496LL, 156351960005LL, 156603428338LL, 1381000144252280352LL},
+  {1381000145000390712LL, 157351570869LL, 157610595737LL, 1381000145259408656LL},
+  {1381000146000510024LL, 158351728868LL, 158608387350LL, 1381000146257161648LL},
+  {1381000147000605944LL, 159351863453LL, 159607319738LL, 1381000147256055360LL},
+  {1381000148000570680LL, 160351866904LL, 160607949531LL, 1381000148256646440LL},
+  {1381000149000285040LL, 161351619991LL, 161602516296LL, 1381000149251174664LL},
+  {1381000150000683264LL, 162352056989LL, 162604901596LL, 1381000150253521184LL},
+  {1381000151000114240LL, 163351526634LL, 163603516207LL, 1381000151252097072LL},
+  {1381000152000641888LL, 164352093131LL, 164608372730LL, 1381000152256914784LL},
+  {1381000153000121904LL, 165351611871LL, 165601723036LL, 1381000153250226480LL},
+  {1381000154000351144LL, 166351879792LL, 166607138234LL, 1381000154255602712LL},
+  {1381000155000608912LL, 167352176322LL, 167610960766LL, 1381000155259386368LL},
+  {1381000156000792656LL, 168352398841LL, 168607728013LL, 1381000156256114936LL},
+  {1381000157000716120LL, 169352361153LL, 169607445541LL, 1381000157255793744LL},
+  {1381000158000061192LL, 170351744922LL, 170605725534LL, 1381000158254035016LL},
+  {1381000159000789336LL, 171352511889LL, 171606148439LL, 1381000159254419104LL},
+  {1381000160000957792LL, 172352719141LL, 172604209667LL, 1381000160252441704LL},
+  {1381000161000219976LL, 173352020109LL, 173607355250LL, 1381000161255548296LL},
+  {1381000162000697592LL, 174352536530LL, 174610302008LL, 1381000162258456136LL},
+  {1381000163000645336LL, 175352523116LL, 175605637616LL, 1381000163253753064LL},
+  {1381000164000914760LL, 176352831415LL, 176605619662LL, 1381000164253696368LL},
+  {1381000165000982864LL, 177352938274LL, 177605955347LL, 1381000165253993144LL},
+  {1381000166000251760LL, 178352245973LL, 178611603463LL, 1381000166259602240LL},
+  {1381000167000550224LL, 179352583280LL, 179608634429LL, 1381000167256594480LL},
+  {1381000168000984576LL, 180353056515LL, 180610559800LL, 1381000168258480928LL},
+  {1381000169000673960LL, 181352784722LL, 181608057511LL, 1381000169255939872LL},
+  {1381000170000137184LL, 182352286778LL, 182605793212LL, 1381000170253636824LL},
+  {1381000171000019152LL, 183352207586LL, 183609839922LL, 1381000171257644560LL},
+  {1381000172000992408LL, 184353219809LL, 184608102455LL, 1381000172255868312LL},
+  {1381000173000856608LL, 185353122879LL, 185610947538LL, 1381000173258674352LL},
+  {1381000174000723536LL, 186353028590LL, 186609936673LL, 1381000174257624672LL},
+  {1381000175000926200LL, 187353270141LL, 187608781091LL, 1381000175256430232LL},
+  {1381000176000760888LL, 188353143755LL, 188607614503LL, 1381000176255224848LL},
+  {1381000177000672448LL, 189353094153LL, 189612005892LL, 1381000177259577184LL},
+  {1381000178000288728LL, 190352749317LL, 190602810346LL, 1381000178250343120LL},
+  {1381000179000384608LL, 191352884180LL, 191606220011LL, 1381000179253713736LL},
+  {1381000180000700024LL, 192353238449LL, 192610557753LL, 1381000180258012376LL},
+  {1381000181000611672LL, 193353188992LL, 193606668512LL, 1381000181254084368LL},
+  {1381000182000697064LL, 194353313261LL, 194609183988LL, 1381000182256560848LL},
+  {1381000183000482296LL, 195353137405LL, 195609704913LL, 1381000183257042896LL},
+  {1381000184000999136LL, 196353693163LL, 196609973270LL, 1381000184257272280LL},
+  {1381000185000518104LL, 197353251106LL, 197608421093LL, 1381000185255681240LL},
+  {1381000186000921600LL, 198353693504LL, 198607073006LL, 1381000186254294280LL},
+  {1381000187000728936LL, 199353539743LL, 199607473271LL, 1381000187254655616LL},
+  {1381000188000763048LL, 200353612787LL, 200606832305LL, 1381000188253975736LL},
+  {1381000189000215824LL, 201353104467LL, 201611051057LL, 1381000189258155376LL},
+  {1381000190000648088LL, 202353575704LL, 202610854449LL, 1381000190257919872LL},
+  {1381000191000766280LL, 203353732820LL, 203604373906LL, 1381000191251400616LL},
+  {1381000192000637888LL, 204353643446LL, 204608213085LL, 1381000192255200696LL},
+  {1381000193000292504LL, 205353336953LL, 205608070742LL, 1381000193255019488LL},
+  {1381000194000657096LL, 206353740523LL, 206606210969LL, 1381000194253120760LL},
+  {1381000195000819728LL, 207353942085LL, 207613332857LL, 1381000195260203424LL},
+  {1381000196000883568LL, 208354044876LL, 208612684336LL, 1381000196259515976LL},
+  {1381000197000629144LL, 209353829441LL, 209604702864LL, 1381000197251495928LL},
+  {1381000198000762576LL, 210354001824LL, 210611520365LL, 1381000198258274120LL},
+  {1381000199000255672LL, 211353533858LL, 211606819881LL, 1381000199253534904LL},
+  {1381000200000982472LL, 212354299663LL, 212609021575LL, 1381000200255697488LL},
+  {1381000201000487040LL, 213353843175LL, 213609217434LL, 1381000201255854408LL},
+  {1381000202000960128LL, 214354355358LL, 214608145343LL, 1381000202254743352LL},
+  {1381000203000434352LL, 215353868541LL, 215604424101LL, 1381000203250983296LL},
+  {1381000204000092344LL, 216353565390LL, 216604574728LL, 1381000204251094912LL},
+  {1381000205000907448LL, 217354419505LL, 217607424132LL, 1381000205253905232LL},
+  {1381000206000998024LL, 218354549053LL, 218613949281LL, 1381000206260391144LL},
+  {1381000207000183032LL, 219353773031LL, 219606992622LL, 1381000207253395768LL},
+  {1381000208000900696LL, 220354529707LL, 220614117318LL, 1381000208260481224LL},
+  {1381000209000062528LL, 221353730488LL, 221610693926LL, 1381000209257019072LL},
+  {1381000210000601352LL, 222354308329LL, 222613172051LL, 1381000210259458040LL},
+  {1381000211000449368LL, 223354195358LL, 223607500425LL, 1381000211253747608LL},
+  {1381000212000521800LL, 224354306733LL, 224604580074LL, 1381000212250788400LL},
+  {1381000213000649560LL, 225354473571LL, 225605514278LL, 1381000213251683568LL},
+  {1381000214000289168LL, 226354152078LL, 226605943370LL, 1381000214252073656LL},
+  {1381000215000084192LL, 227353986089LL, 227611929131LL, 1381000215258020208LL},
+  {1381000216000037440LL, 228353978377LL, 228609073675LL, 1381000216255125872LL},
+  {1381000217000721072LL, 229354701008LL, 229609012644LL, 1381000217255025848LL},
+  {1381000218000498328LL, 230354517246LL, 230606029892LL, 1381000218252004200LL},
+  {1381000219000891384LL, 231354949317LL, 231613129430LL, 1381000219259064464LL},
+  {1381000220000653440LL, 232354750360LL, 232610754036LL, 1381000220256650208LL},
+  {1381000221000381128LL, 233354517043LL, 233612233827LL, 1381000221258090904LL},
+  {1381000222000457800LL, 234354632704LL, 234605566166LL, 1381000222251384496LL},
+  {1381000223000256592LL, 235354470493LL, 235610536424LL, 1381000223256315560LL},
+  {1381000224000544944LL, 236354797860LL, 236611120077LL, 1381000224256860216LL},
+  {1381000225000604168LL, 237354896111LL, 237613542618LL, 1381000225259243672LL},
+  {1381000226000673688LL, 238355004665LL, 238607397589LL, 1381000226253059888LL},
+  {1381000227000411872LL, 239354781785LL, 239608200950LL, 1381000227253824200LL},
+  {1381000228000470096LL, 240354879019LL, 240609944278LL, 1381000228255528440LL},
+  {1381000229000467136LL, 241354915026LL, 241606827912LL, 1381000229252373248LL},
+  {1381000230000733152LL, 242355220068LL, 242606665434LL, 1381000230252171736LL},
+  {1381000231000702848LL, 243355228798LL, 243614096951LL, 1381000231259563984LL},
+  {1381000232000772744LL, 244355337655LL, 244611962817LL, 1381000232257391008LL},
+  {1381000233000340376LL, 245354944305LL, 245613729004LL, 1381000233259118056LL},
+  {1381000234000245872LL, 246354888855LL, 246605040640LL, 1381000234250391040LL},
+  {1381000235000460640LL, 247355142526LL, 247613666593LL, 1381000235258977656LL},
+  {1381000236000735960LL, 248355456927LL, 248606316426LL, 1381000236251588776LL},
+  {1381000237000063384LL, 249354823273LL, 249614064377LL, 1381000237259297416LL},
+  {1381000238000592544LL, 250355391416LL, 250611401654LL, 1381000238256595824LL},
+  {1381000239000835088LL, 251355673006LL, 251608101126LL, 1381000239253256456LL},
+  {1381000240000246544LL, 252355123389LL, 252613409828LL, 1381000240258525960LL},
+  {1381000241000747088LL, 253355663032LL, 253608073874LL, 1381000241253151208LL},
+  {1381000242000046200LL, 254355001012LL, 254613055695LL, 1381000242258093856LL},
+  {1381000243000736104LL, 255355729938LL, 255609998617LL, 1381000243254998032LL},
+  {1381000244000675608LL, 256355708437LL, 256611349781LL, 1381000244256310048LL},
+  {1381000245000548120LL, 257355619898LL, 257611320930LL, 1381000245256242216LL},
+  {1381000246000895456LL, 258356006227LL, 258608914251LL, 1381000246253796736LL},
+  {1381000247000099424LL, 259355249177LL, 259612579862LL, 1381000247257423200LL},
+  {1381000248000530104LL, 260355718828LL, 260615311755LL, 1381000248260115952LL},
+  {1381000249000170504LL, 261355398170LL, 261611132231LL, 1381000249255897616LL},
+  {1381000250000123848LL, 262355390556LL, 262605404040LL, 1381000250250130704LL},
+  {1381000251000921208LL, 263356226849LL, 263608200355LL, 1381000251252887920LL},
+  {1381000252000488960LL, 264355833572LL, 264613528962LL, 1381000252258177376LL},
+  {1381000253000205888LL, 265355589419LL, 265605801196LL, 1381000253250410928LL},
+  {1381000254000142088LL, 266355564588LL, 266609016601LL, 1381000254253587288LL},
+  {1381000255000993416LL, 267356454928LL, 267612212416LL, 1381000255256743976LL},
+  {1381000256000502944LL, 268356003415LL, 268615621634LL, 1381000256260114184LL},
+  {1381000257000374448LL, 269355913811LL, 269613893417LL, 1381000257258347072LL},
+  {1381000258000096776LL, 270355675119LL, 270613878417LL, 1381000258258293088LL},
+  {1381000259000606424LL, 271356223697LL, 271610158992LL, 1381000259254534888LL},
+  {1381000260000463064LL, 272356119297LL, 272612021115LL, 1381000260256358008LL},
+  {1381000261000010128LL, 273355705305LL, 273613408552LL, 1381000261257706400LL},
+  {1381000262000375960LL, 274356110073LL, 274609410818LL, 1381000262253669896LL},
+  {1381000263000173576LL, 275355946591LL, 275610604915LL, 1381000263254825016LL},
+  {1381000264000227944LL, 276356039890LL, 276607576350LL, 1381000264251757688LL},
+  {1381000265000768728LL, 277356619607LL, 277606957698LL, 1381000265251100096LL},
+  {1381000266000912880LL, 278356802681LL, 278608609689LL, 1381000266252713104LL},
+  {1381000267000079416LL, 279356008135LL, 279608549929LL, 1381000267252614432LL},
+  {1381000268000153328LL, 280356120975LL, 280607433792LL, 1381000268251459448LL},
+  {1381000269000300872LL, 281356307415LL, 281614486172LL, 1381000269258472680LL},
+  {1381000270000702496LL, 282356747948LL, 282616491585LL, 1381000270260439064LL},
+  {1381000271000127856LL, 283356212182LL, 283615666408LL, 1381000271259575016LL},
+  {1381000272000471544LL, 284356594818LL, 284611799177LL, 1381000272255669056LL},
+  {1381000273000783952LL, 285356946085LL, 285607339106LL, 1381000273251170256LL},
+  {1381000274000686496LL, 286356887512LL, 286609217587LL, 1381000274253009776LL},
+  {1381000275000779840LL, 287357019735LL, 287613194195LL, 1381000275256947424LL},
+  {1381000276000939296LL, 288357218064LL, 288614633972LL, 1381000276258348200LL},
+  {1381000277000992024LL, 289357309704LL, 289608279464LL, 1381000277251955064LL},
+  {1381000278000265944LL, 290356622440LL, 290612040600LL, 1381000278255677272LL},
+  {1381000279000408144LL, 291356803504LL, 291607123325LL, 1381000279250721240LL},
+  {1381000280000574840LL, 292357009073LL, 292616242755LL, 1381000280259801464LL},
+  {1381000281000022856LL, 293356495923LL, 293615749400LL, 1381000281259269304LL},
+  {1381000282000963904LL, 294357475917LL, 294610702299LL, 1381000282254183528LL},
+  {1381000283000086216LL, 295356636986LL, 295615720950LL, 1381000283259163200LL},
+  {1381000284000122784LL, 296356712366LL, 296611578244LL, 1381000284254981840LL},
+  {1381000285000915552LL, 297357543998LL, 297611878346LL, 1381000285255243040LL},
+  {1381000286000202024LL, 298356869338LL, 298615580485LL, 1381000286258906224LL},
+  {1381000287000351496LL, 299357057569LL, 299613748256LL, 1381000287257035288LL},
+  {1381000288000027192LL, 300356772131LL, 300616650763LL, 1381000288259898880LL},
+  {1381000289000538872LL, 301357322585LL, 301612353000LL, 1381000289255562424LL},
+  {1381000290000588376LL, 302357410908LL, 302616922474LL, 1381000290260092936LL},
+  {1381000291000203208LL, 303357064595LL, 303616261640LL, 1381000291259393368LL},
+  {1381000292000511576LL, 304357411709LL, 304610535241LL, 1381000292253628376LL},
+  {1381000293000399888LL, 305357338728LL, 305611197082LL, 1381000293254251448LL},
+  {1381000294000379912LL, 306357357544LL, 306608100874LL, 1381000294251116552LL},
+  {1381000295000499464LL, 307357515895LL, 307617292293LL, 1381000295260268904LL},
+  {1381000296000227744LL, 308357282929LL, 308613324186LL, 1381000296256262192LL},
+  {1381000297000982208LL, 309358076157LL, 309615541934LL, 1381000297258441048LL},
+  {1381000298000879144LL, 310358011868LL, 310611941885LL, 1381000298254802432LL},
+  {1381000299000289584LL, 311357461053LL, 311609332725LL, 1381000299252154592LL},
+};
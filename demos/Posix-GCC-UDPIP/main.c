@@ -0,0 +1,238 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if !defined(BENCH_USE_LWIP)
+#define BENCH_USE_LWIP      FALSE
+#endif
+
+#if BENCH_USE_LWIP
+#include "lwipthread.h"
+#include "lwip/api.h"
+#else
+#include "udpip.h"
+#endif
+
+#define ECHO_PORT           7
+#define CLIENT_PORT         7000
+#define DEFAULT_ROUNDS      10000
+#define REPLY_TIMEOUT       100
+
+#define ADDR(a, b, c, d)                                                    \
+  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) |                          \
+   ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+#define SERVER_ADDR         ADDR(192, 168, 1, 20)
+#define CLIENT_ADDR         ADDR(192, 168, 1, 21)
+#define NETMASK             ADDR(255, 255, 255, 0)
+#define GATEWAY             ADDR(192, 168, 1, 1)
+
+static uint8_t server_ethaddr[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x46};
+static uint8_t client_ethaddr[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x47};
+
+static uint8_t payload[1024];
+
+#if BENCH_USE_LWIP
+/*===========================================================================*/
+/* lwIP netconn API.                                                         */
+/*===========================================================================*/
+
+#define STACK_NAME          "lwIP"
+
+static struct netconn *conn;
+
+static void net_start(bool_t server) {
+  static struct lwipthread_opts opts;
+
+  opts.macaddress = server ? server_ethaddr : client_ethaddr;
+  opts.address    = PP_HTONL(server ? SERVER_ADDR : CLIENT_ADDR);
+  opts.netmask    = PP_HTONL(NETMASK);
+  opts.gateway    = PP_HTONL(GATEWAY);
+  chThdCreateStatic(wa_lwip_thread, LWIP_THREAD_STACK_SIZE, NORMALPRIO + 1,
+                    lwip_thread, &opts);
+
+  conn = netconn_new(NETCONN_UDP);
+  netconn_bind(conn, NULL, server ? ECHO_PORT : CLIENT_PORT);
+  netconn_set_recvtimeout(conn, REPLY_TIMEOUT);
+}
+
+static void net_serve(void) {
+  struct netbuf *nb;
+
+  while (TRUE) {
+    if (netconn_recv(conn, &nb) == ERR_OK) {
+      netconn_sendto(conn, nb, netbuf_fromaddr(nb), netbuf_fromport(nb));
+      netbuf_delete(nb);
+    }
+  }
+}
+
+static bool_t net_roundtrip(const uint8_t *buf, size_t n) {
+  struct netbuf *nb;
+  ip_addr_t addr;
+  err_t err;
+  bool_t ok;
+
+  nb = netbuf_new();
+  if (nb == NULL)
+    return FALSE;
+  netbuf_ref(nb, buf, n);
+  addr.addr = PP_HTONL(SERVER_ADDR);
+  err = netconn_sendto(conn, nb, &addr, ECHO_PORT);
+  netbuf_delete(nb);
+  if (err != ERR_OK)
+    return FALSE;
+
+  if (netconn_recv(conn, &nb) != ERR_OK)
+    return FALSE;
+  ok = netbuf_len(nb) == n;
+  netbuf_delete(nb);
+  return ok;
+}
+
+#else /* !BENCH_USE_LWIP */
+/*===========================================================================*/
+/* Native UDP/IP stack.                                                      */
+/*===========================================================================*/
+
+#define STACK_NAME          "native UDP/IP"
+
+static UdpIpStack ipstack;
+static UdpSocket sock;
+static UdpDatagram ring[8];
+static MACConfig mac_config;
+static UdpIpConfig ip_config;
+
+static void net_start(bool_t server) {
+
+  mac_config.mac_address = server ? server_ethaddr : client_ethaddr;
+  ip_config.macp         = &ETHD1;
+  ip_config.mac_config   = &mac_config;
+  ip_config.address      = server ? SERVER_ADDR : CLIENT_ADDR;
+  ip_config.netmask      = NETMASK;
+  ip_config.gateway      = GATEWAY;
+  udpipObjectInit(&ipstack);
+  udpipStart(&ipstack, &ip_config);
+
+  udpObjectInit(&sock, ring, sizeof ring / sizeof ring[0]);
+  udpBind(&ipstack, &sock, server ? ECHO_PORT : CLIENT_PORT);
+}
+
+static void net_serve(void) {
+  UdpDatagram *dp;
+
+  while (TRUE) {
+    dp = udpGetDatagram(&sock, TIME_INFINITE);
+    udpSendTo(&sock, dp->address, dp->port, dp->data, dp->size,
+              MS2ST(REPLY_TIMEOUT));
+    udpReleaseDatagram(&sock);
+  }
+}
+
+static bool_t net_roundtrip(const uint8_t *buf, size_t n) {
+  UdpDatagram *dp;
+  bool_t ok;
+
+  if (udpSendTo(&sock, SERVER_ADDR, ECHO_PORT, buf, n,
+                MS2ST(REPLY_TIMEOUT)) != RDY_OK)
+    return FALSE;
+
+  dp = udpGetDatagram(&sock, MS2ST(REPLY_TIMEOUT));
+  if (dp == NULL)
+    return FALSE;
+  ok = dp->size == n;
+  udpReleaseDatagram(&sock);
+  return ok;
+}
+#endif /* !BENCH_USE_LWIP */
+
+/*===========================================================================*/
+/* Benchmark.                                                                */
+/*===========================================================================*/
+
+static void bench(size_t n, unsigned rounds) {
+  systime_t start, elapsed;
+  unsigned i, lost = 0;
+
+  start = chTimeNow();
+  for (i = 0; i < rounds; i++)
+    if (!net_roundtrip(payload, n))
+      lost++;
+  elapsed = chTimeNow() - start;
+
+  printf("%4u bytes: %u round trips in %lu ms, %lu us each, %u lost\n",
+         (unsigned)n, rounds,
+         (unsigned long)((uint64_t)elapsed * 1000 / CH_FREQUENCY),
+         (unsigned long)((uint64_t)elapsed * 1000000 / CH_FREQUENCY / rounds),
+         lost);
+}
+
+/*
+ * Simulator main.
+ */
+int main(int argc, char *argv[]) {
+  bool_t server;
+  unsigned i, rounds = DEFAULT_ROUNDS;
+
+  if ((argc < 2) ||
+      ((strcmp(argv[1], "server") != 0) && (strcmp(argv[1], "client") != 0))) {
+    printf("Usage: %s server|client [rounds]\n", argv[0]);
+    return 1;
+  }
+  server = strcmp(argv[1], "server") == 0;
+  if (argc > 2)
+    rounds = (unsigned)atoi(argv[2]);
+  if (rounds == 0)
+    rounds = DEFAULT_ROUNDS;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  net_start(server);
+  if (server) {
+    printf("%s echo server on port %u\n", STACK_NAME, ECHO_PORT);
+    net_serve();
+  }
+
+  /* Waits for the server, the first exchanges also resolve the addresses.*/
+  for (i = 0; i < 50; i++)
+    if (net_roundtrip(payload, 1))
+      break;
+  if (i >= 50) {
+    printf("The server is not responding\n");
+    exit(1);
+  }
+
+  for (i = 0; i < sizeof payload; i++)
+    payload[i] = (uint8_t)i;
+  printf("%s echo client\n", STACK_NAME);
+  bench(64, rounds);
+  bench(1024, rounds);
+  exit(0);
+}
@@ -15,12 +15,17 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "ch.h"
 #include "hal.h"
 #include "test.h"
 #include "shell.h"
 #include "chprintf.h"
+#include "blkimage.h"
+#include "ramflash.h"
+#include "flashkv.h"
 
 #define SHELL_WA_SIZE       THD_WA_SIZE(4096)
 #define CONSOLE_WA_SIZE     THD_WA_SIZE(4096)
@@ -83,10 +88,383 @@ static void cmd_test(BaseSequentialStream *chp, int argc, char *argv[]) {
   chThdWait(tp);
 }
 
+#if HAL_USE_SDC && SDC_USE_ASYNC
+/*
+ * Asynchronous SDC requests exercised on the simulated card. Consecutive
+ * requests are merged by the driver so the transfers count is lower than
+ * the requests count.
+ */
+#define SDC_TEST_REQUESTS   3
+#define SDC_TEST_BLOCKS     4
+
+static uint8_t sdc_txbuf[SDC_TEST_REQUESTS * SDC_TEST_BLOCKS *
+                         MMCSD_BLOCK_SIZE];
+static uint8_t sdc_rxbuf[SDC_TEST_REQUESTS * SDC_TEST_BLOCKS *
+                         MMCSD_BLOCK_SIZE];
+static SDCRequest sdc_requests[SDC_TEST_REQUESTS + 1];
+static unsigned sdc_completed;
+
+static void sdc_callback(SDCDriver *sdcp, SDCRequest *rqp) {
+
+  (void)sdcp;
+  (void)rqp;
+  sdc_completed++;
+}
+
+static bool_t sdc_run(BaseSequentialStream *chp, bool_t write) {
+  uint32_t transfers;
+  unsigned i;
+
+  sdc_completed = 0;
+  transfers = write ? SDCD1.sim_writes : SDCD1.sim_reads;
+  for (i = 0; i < SDC_TEST_REQUESTS; i++) {
+    uint32_t offset = i * SDC_TEST_BLOCKS * MMCSD_BLOCK_SIZE;
+    bool_t err;
+
+    if (write)
+      err = sdcStartWrite(&SDCD1, &sdc_requests[i], i * SDC_TEST_BLOCKS,
+                          sdc_txbuf + offset, SDC_TEST_BLOCKS, sdc_callback);
+    else
+      err = sdcStartRead(&SDCD1, &sdc_requests[i], i * SDC_TEST_BLOCKS,
+                         sdc_rxbuf + offset, SDC_TEST_BLOCKS, sdc_callback);
+    if (err) {
+      chprintf(chp, "request %u rejected, queue full\r\n", i);
+      return CH_FAILED;
+    }
+  }
+  if (sdcStartSync(&SDCD1, &sdc_requests[i], NULL)) {
+    chprintf(chp, "sync request rejected, queue full\r\n");
+    return CH_FAILED;
+  }
+  /* Synchronous operations are serialized with the pending requests.*/
+  if (sdcSync(&SDCD1)) {
+    chprintf(chp, "synchronous operation failed\r\n");
+    return CH_FAILED;
+  }
+  /* The requests with a callback cannot be waited, the sync request has no
+     callback and completes after all the previous ones.*/
+  sdcWaitRequest(&sdc_requests[SDC_TEST_REQUESTS], TIME_INFINITE);
+  for (i = 0; i <= SDC_TEST_REQUESTS; i++) {
+    if (sdcGetRequestResult(&sdc_requests[i]) != CH_SUCCESS) {
+      chprintf(chp, "request %u failed\r\n", i);
+      return CH_FAILED;
+    }
+  }
+  transfers = (write ? SDCD1.sim_writes : SDCD1.sim_reads) - transfers;
+  chprintf(chp, "%s: %u requests, %u callbacks, %u transfers\r\n",
+           write ? "write" : "read ", SDC_TEST_REQUESTS, sdc_completed,
+           transfers);
+  return CH_SUCCESS;
+}
+
+static void cmd_sdc(BaseSequentialStream *chp, int argc, char *argv[]) {
+  unsigned i;
+
+  (void)argv;
+  if (argc > 0) {
+    chprintf(chp, "Usage: sdc\r\n");
+    return;
+  }
+  if ((blkGetDriverState(&SDCD1) != BLK_READY) && sdcConnect(&SDCD1)) {
+    chprintf(chp, "card connection failed\r\n");
+    return;
+  }
+  chprintf(chp, "capacity: %u blocks, %s speed\r\n",
+           mmcsdGetCardCapacity(&SDCD1),
+           SDCD1.cardmode & SDC_MODE_HIGH_SPEED ? "high" : "default");
+  for (i = 0; i < sizeof sdc_txbuf; i++)
+    sdc_txbuf[i] = (uint8_t)(i * 7 + (i >> 9));
+  memset(sdc_rxbuf, 0, sizeof sdc_rxbuf);
+  if (sdc_run(chp, TRUE) || sdc_run(chp, FALSE))
+    return;
+  if (memcmp(sdc_txbuf, sdc_rxbuf, sizeof sdc_txbuf) != 0)
+    chprintf(chp, "data mismatch\r\n");
+  else
+    chprintf(chp, "data verified\r\n");
+}
+#endif /* HAL_USE_SDC && SDC_USE_ASYNC */
+
+/*
+ * Disk image simulating a card with 1ms write latency and 10MB/s bandwidth.
+ */
+#define IMAGE_TEST_CHUNK    8
+#define IMAGE_TEST_BLOCKS   256
+
+static BlockImage image;
+static const BlockImageConfig image_cfg = {
+  "ch.img",
+  8192,
+  FALSE,
+  100,
+  1000,
+  10000000
+};
+static uint8_t image_buf[IMAGE_TEST_CHUNK * BLOCK_IMAGE_BLOCK_SIZE];
+
+static void image_report(BaseSequentialStream *chp, const char *op,
+                         systime_t time) {
+  BlockImageStats *sp = biGetStats(&image);
+
+  chprintf(chp, "%s: %u blocks in %u ms, modeled %u us, %u KB/s\r\n",
+           op, IMAGE_TEST_BLOCKS, (uint32_t)(time * 1000 / CH_FREQUENCY),
+           (uint32_t)sp->busy,
+           (uint32_t)((uint64_t)IMAGE_TEST_BLOCKS * BLOCK_IMAGE_BLOCK_SIZE *
+                      1000 / (sp->busy > 0 ? sp->busy : 1)));
+}
+
+static void cmd_image(BaseSequentialStream *chp, int argc, char *argv[]) {
+  systime_t start;
+  unsigned i;
+
+  (void)argv;
+  if (argc > 0) {
+    chprintf(chp, "Usage: image\r\n");
+    return;
+  }
+  if (blkGetDriverState(&image) == BLK_STOP) {
+    if (biOpen(&image, &image_cfg) || blkConnect(&image)) {
+      chprintf(chp, "cannot open %s\r\n", image_cfg.path);
+      return;
+    }
+  }
+  chprintf(chp, "%s: %u blocks\r\n", image_cfg.path, image.blk_num);
+  memset(image_buf, 0x55, sizeof image_buf);
+  biResetStats(&image);
+  start = chTimeNow();
+  for (i = 0; i < IMAGE_TEST_BLOCKS; i += IMAGE_TEST_CHUNK) {
+    if (blkWrite(&image, i, image_buf, IMAGE_TEST_CHUNK)) {
+      chprintf(chp, "write failed\r\n");
+      return;
+    }
+  }
+  image_report(chp, "write", chTimeNow() - start);
+  biResetStats(&image);
+  start = chTimeNow();
+  for (i = 0; i < IMAGE_TEST_BLOCKS; i += IMAGE_TEST_CHUNK) {
+    if (blkRead(&image, i, image_buf, IMAGE_TEST_CHUNK)) {
+      chprintf(chp, "read failed\r\n");
+      return;
+    }
+  }
+  image_report(chp, "read ", chTimeNow() - start);
+  blkSync(&image);
+}
+
+/*
+ * Key-value store on an emulated flash made of 8 sectors of 2KB.
+ */
+#define KV_SECTORS          8
+#define KV_SECTOR_SIZE      2048
+#define KV_COUNTER          1
+#define KV_CONFIG_A         2
+#define KV_CONFIG_B         3
+
+static uint8_t kv_flash[KV_SECTORS * KV_SECTOR_SIZE];
+static uint32_t kv_wear[KV_SECTORS];
+static const RamFlashConfig kv_flash_cfg = {
+  kv_flash,
+  KV_SECTOR_SIZE,
+  KV_SECTORS,
+  8,
+  kv_wear
+};
+static RamFlash kv_rf;
+static FlashKV kv;
+
+/*
+ * Mounts the store on the blank emulated flash the first time.
+ */
+static bool_t kv_start(BaseSequentialStream *chp) {
+
+  if (kv.flp == NULL) {
+    memset(kv_flash, FLASH_ERASED, sizeof kv_flash);
+    rfObjectInit(&kv_rf, &kv_flash_cfg);
+    fkvObjectInit(&kv, (BaseFlash *)&kv_rf);
+    if (fkvMount(&kv)) {
+      chprintf(chp, "mount failed\r\n");
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static void cmd_kv(BaseSequentialStream *chp, int argc, char *argv[]) {
+  FlashKVStats *sp;
+  systime_t start;
+  uint32_t counter, cfg[4], wmin, wmax;
+  size_t n;
+  int i, updates;
+
+  if (argc > 1) {
+    chprintf(chp, "Usage: kv [updates]\r\n");
+    return;
+  }
+  updates = argc > 0 ? atoi(argv[0]) : 1000;
+  if (!kv_start(chp))
+    return;
+
+  /* Counter updates, every tenth update the two configuration keys are
+     also updated together in a transaction.*/
+  fkvResetStats(&kv);
+  start = chTimeNow();
+  for (i = 0; i < updates; i++) {
+    n = sizeof counter;
+    if (fkvGet(&kv, KV_COUNTER, &counter, &n))
+      counter = 0;
+    counter++;
+    if (fkvPut(&kv, KV_COUNTER, &counter, sizeof counter)) {
+      chprintf(chp, "put failed\r\n");
+      return;
+    }
+    if ((i % 10) == 0) {
+      cfg[0] = cfg[1] = cfg[2] = cfg[3] = counter;
+      fkvBegin(&kv);
+      fkvTxPut(&kv, KV_CONFIG_A, cfg, sizeof cfg);
+      fkvTxPut(&kv, KV_CONFIG_B, cfg, sizeof cfg / 2);
+      if (fkvCommit(&kv)) {
+        chprintf(chp, "commit failed\r\n");
+        return;
+      }
+    }
+  }
+  chprintf(chp, "%d updates in %u ms\r\n", updates,
+           (uint32_t)((chTimeNow() - start) * 1000 / CH_FREQUENCY));
+
+  /* The store is mounted again in order to verify the persistence.*/
+  n = sizeof counter;
+  if (fkvMount(&kv) || fkvGet(&kv, KV_COUNTER, &counter, &n)) {
+    chprintf(chp, "remount failed\r\n");
+    return;
+  }
+  sp = fkvGetStats(&kv);
+  wmin = wmax = kv_wear[0];
+  for (i = 1; i < KV_SECTORS; i++) {
+    if (kv_wear[i] < wmin)
+      wmin = kv_wear[i];
+    if (kv_wear[i] > wmax)
+      wmax = kv_wear[i];
+  }
+  chprintf(chp, "counter %u, %u keys\r\n", counter, fkvGetKeys(&kv));
+  chprintf(chp, "commits %u, compactions %u, stalls %u, copied %u bytes\r\n",
+           sp->commits, sp->compactions, sp->stalls, sp->copied);
+  chprintf(chp, "sector erases min %u max %u\r\n", wmin, wmax);
+}
+
+/*
+ * Power failure test. Each transaction writes KV_FAIL_KEYS keys with the
+ * transaction number as value and a variable size plus one of KV_HIST
+ * history keys, the last KV_HIST committed transactions are so recorded
+ * in the store.
+ */
+#define KV_FAIL_KEYS        4
+#define KV_FAIL_BASE        16
+#define KV_HIST             32
+#define KV_HIST_BASE        32
+
+/* The power fails at a random point within this amount of programmed or
+   erased bytes, so it hits commits, compaction copies and erases.*/
+#define KV_FAIL_SPAN        (3 * KV_SECTOR_SIZE)
+
+static uint32_t kv_hist[KV_HIST];
+
+#define kv_fail_size(t, i) (4 * (1 + ((t) + (i)) % 8))
+
+/*
+ * Checks that the store content matches the transactions committed up to
+ * the transaction @p t.
+ */
+static bool_t kv_check(uint32_t t) {
+  uint32_t buf[8], i, j;
+  size_t n;
+
+  for (i = 0; i < KV_FAIL_KEYS; i++) {
+    n = sizeof buf;
+    if (fkvGet(&kv, KV_FAIL_BASE + i, buf, &n))
+      n = 0;
+    if (t == 0) {
+      if (n != 0)
+        return FALSE;
+      continue;
+    }
+    if (n != kv_fail_size(t, i))
+      return FALSE;
+    for (j = 0; j < n / 4; j++)
+      if (buf[j] != t)
+        return FALSE;
+  }
+  for (i = 0; i < KV_HIST; i++) {
+    n = sizeof buf[0];
+    if (fkvGet(&kv, KV_HIST_BASE + i, buf, &n))
+      buf[0] = 0;
+    if (buf[0] != kv_hist[i])
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void cmd_kvfail(BaseSequentialStream *chp, int argc, char *argv[]) {
+  uint32_t buf[8], t, committed, i, j;
+  int cycle, cycles;
+
+  if (argc > 1) {
+    chprintf(chp, "Usage: kvfail [cycles]\r\n");
+    return;
+  }
+  cycles = argc > 0 ? atoi(argv[0]) : 1000;
+  if (!kv_start(chp))
+    return;
+  if (fkvFormat(&kv)) {
+    chprintf(chp, "format failed\r\n");
+    return;
+  }
+  memset(kv_hist, 0, sizeof kv_hist);
+
+  /* The compaction thread has a lower priority and this loop never
+     blocks, the power failures only hit the operations started here.*/
+  committed = 0;
+  for (cycle = 0; cycle < cycles; cycle++) {
+    rfSetPowerFail(&kv_rf, (uint32_t)rand() % KV_FAIL_SPAN);
+    for (t = committed + 1; ; t++) {
+      fkvBegin(&kv);
+      for (i = 0; i < KV_FAIL_KEYS; i++) {
+        for (j = 0; j < kv_fail_size(t, i) / 4; j++)
+          buf[j] = t;
+        fkvTxPut(&kv, KV_FAIL_BASE + i, buf, kv_fail_size(t, i));
+      }
+      fkvTxPut(&kv, KV_HIST_BASE + t % KV_HIST, &t, sizeof t);
+      if (fkvCommit(&kv))
+        break;
+      committed = t;
+      kv_hist[t % KV_HIST] = t;
+    }
+
+    /* Power restored, the store is mounted again and must contain all
+       the committed transactions and nothing of the interrupted one.*/
+    rfSetPowerFail(&kv_rf, RF_NO_FAIL);
+    if (fkvMount(&kv)) {
+      chprintf(chp, "mount failed at cycle %d\r\n", cycle);
+      return;
+    }
+    if (!kv_check(committed)) {
+      chprintf(chp, "check failed at cycle %d, transaction %u\r\n",
+               cycle, committed);
+      return;
+    }
+  }
+  chprintf(chp, "%d power failures, %u transactions committed\r\n",
+           cycles, committed);
+}
+
 static const ShellCommand commands[] = {
   {"mem", cmd_mem},
   {"threads", cmd_threads},
   {"test", cmd_test},
+  {"image", cmd_image},
+  {"kv", cmd_kv},
+  {"kvfail", cmd_kvfail},
+#if HAL_USE_SDC && SDC_USE_ASYNC
+  {"sdc", cmd_sdc},
+#endif
   {NULL, NULL}
 };
 
@@ -218,6 +596,10 @@ int main(void) {
    */
   sdStart(&SD1, NULL);
   sdStart(&SD2, NULL);
+  biObjectInit(&image);
+#if HAL_USE_SDC
+  sdcStart(&SDCD1, NULL);
+#endif
 
   /*
    * Shell manager initialization.
@@ -251,5 +633,6 @@ int main(void) {
    */
   chEvtUnregister(chnGetEventSource(&SD1), &sd1fel);
   chEvtUnregister(chnGetEventSource(&SD2), &sd2fel);
+  biClose(&image);
   return 0;
 }
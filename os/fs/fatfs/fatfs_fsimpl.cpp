@@ -25,17 +25,30 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.hpp"
+#include "hal.h"
 #include "fs.hpp"
 #include "fatfs_fsimpl.hpp"
-#include "hal.h"
 
 #define MSG_TERMINATE                   (msg_t)0
 
+#define MSG_OPEN                        1
+#define MSG_CLOSE                       2
+#define MSG_READ                        3
+#define MSG_WRITE                       4
+#define MSG_SYNC                        5
+#define MSG_REMOVE                      6
+#define MSG_PREFETCH                    7
+
 #define ERR_OK                          (msg_t)0
 #define ERR_TERMINATING                 (msg_t)1
 #define ERR_UNKNOWN_MSG                 (msg_t)2
 
+/* Read-ahead unit, half of the file buffer.*/
+#define FATFS_CHUNK_SIZE                (FATFS_BUFFER_SIZE / 2)
+
 using namespace chibios_rt;
 using namespace chibios_fs;
 
@@ -46,10 +59,25 @@ namespace chibios_fatfs {
 
   typedef struct {
     uint32_t            msg_code;
+    FatFSFileWrapper    *file;
+    FRESULT             result;
     union {
       struct {
-
-      };
+        FatFSWrapper    *fs;
+        const char      *fname;
+        BYTE            mode;
+      } open;
+      struct {
+        const char      *fname;
+      } remove;
+      struct {
+        uint8_t         *bp;
+        size_t          n;
+      } read;
+      struct {
+        const uint8_t   *bp;
+        size_t          n;
+      } write;
     } op;
   } wmsg_t;
 
@@ -58,57 +86,362 @@ namespace chibios_fatfs {
    *------------------------------------------------------------------------*/
   FatFSFileWrapper::FatFSFileWrapper(void) : fs(NULL) {
 
+    reset(NULL);
   }
 
   FatFSFileWrapper::FatFSFileWrapper(FatFSWrapper *fsref) : fs(fsref) {
 
+    reset(fsref);
   }
 
-  size_t FatFSFileWrapper::write(const uint8_t *bp, size_t n) {
+  void FatFSFileWrapper::reset(FatFSWrapper *fsref) {
+
+    fs       = fsref;
+    buffer   = NULL;
+    bufpos   = 0;
+    buflen   = 0;
+    dirty    = false;
+    ahead    = false;
+    position = 0;
+    error    = FR_OK;
+  }
+
+  /* Moves the FatFS file pointer to the logical position, server side.*/
+  FRESULT FatFSFileWrapper::seek(void) {
+
+    if (f_tell(&file) == position)
+      return FR_OK;
+    return f_lseek(&file, position);
+  }
+
+  /* Writes the pending data, server side with the mutex locked.*/
+  FRESULT FatFSFileWrapper::flush(void) {
+    FRESULT res;
+    UINT bw;
+
+    if (!dirty)
+      return FR_OK;
+    dirty  = false;
+    res = f_lseek(&file, bufpos);
+    if (res == FR_OK) {
+      res = f_write(&file, buffer->data, buflen, &bw);
+      if ((res == FR_OK) && (bw < buflen))
+        res = FR_DENIED;
+    }
+    buflen = 0;
+    return res;
+  }
+
+  /* Reads the chunk containing the logical position into its half of the
+     buffer, server side with the mutex locked.*/
+  FRESULT FatFSFileWrapper::fill(void) {
+    FRESULT res;
+    UINT br;
+
+    buflen = 0;
+    bufpos = position - (position % FATFS_CHUNK_SIZE);
+    res = f_lseek(&file, bufpos);
+    if (res != FR_OK)
+      return res;
+    res = f_read(&file, buffer->data + (bufpos % FATFS_BUFFER_SIZE),
+                 FATFS_CHUNK_SIZE, &br);
+    buflen = br;
+    return res;
+  }
+
+  /* Copies the buffered read data starting at the logical position, the
+     data may wrap around the end of the buffer. Mutex locked.*/
+  size_t FatFSFileWrapper::copyBuffered(uint8_t *bp, size_t n) {
+    size_t i, k;
+
+    if ((buffer == NULL) || dirty || (position < bufpos) ||
+        (position >= bufpos + buflen))
+      return 0;
+    if (n > bufpos + buflen - position)
+      n = bufpos + buflen - position;
+    i = position % FATFS_BUFFER_SIZE;
+    k = FATFS_BUFFER_SIZE - i;
+    if (k > n)
+      k = n;
+    memcpy(bp, buffer->data + i, k);
+    memcpy(bp + k, buffer->data, n - k);
+    position += n;
+    return n;
+  }
+
+  /* Checks if the client entered the last buffered chunk and the next one
+     should be read ahead. Mutex locked.*/
+  bool FatFSFileWrapper::aheadNeeded(void) {
+
+    return (buffer != NULL) && !dirty && !ahead && (buflen > 0) &&
+           (position >= bufpos) &&
+           (bufpos + buflen - position <= FATFS_CHUNK_SIZE) &&
+           (bufpos + buflen < f_size(&file));
+  }
+
+  size_t FatFSFileWrapper::serverRead(uint8_t *bp, size_t n) {
+    FRESULT res;
+    size_t done = 0;
+
+    mtx.lock();
+    res = flush();
+    if (buffer == NULL)
+      buffer = (FatFSBuffer *)fs->server.buffers.alloc();
+    while ((res == FR_OK) && (n > 0)) {
+      size_t k = copyBuffered(bp, n);
+
+      if (k > 0) {
+        /* Buffer hit.*/
+        bp       += k;
+        n        -= k;
+        done     += k;
+      }
+      else if ((buffer != NULL) && (n < FATFS_BUFFER_SIZE)) {
+        /* Small transfer, the buffer is filled first.*/
+        res = fill();
+        if (position >= bufpos + buflen)
+          break;
+      }
+      else {
+        /* Large transfer, performed directly.*/
+        UINT br;
+
+        res = seek();
+        if (res == FR_OK) {
+          res = f_read(&file, bp, n, &br);
+          position += br;
+          done     += br;
+        }
+        break;
+      }
+    }
+    error = res;
+    BaseThread::unlockMutex();
+    return done;
+  }
+
+  size_t FatFSFileWrapper::serverWrite(const uint8_t *bp, size_t n) {
+    FRESULT res = FR_OK;
+    size_t done = 0;
+
+    if (!(file.flag & FA_WRITE)) {
+      error = FR_DENIED;
+      return 0;
+    }
+
+    mtx.lock();
+    /* Read-ahead data is discarded, it could become stale.*/
+    if (!dirty)
+      buflen = 0;
+    else if ((position != bufpos + buflen) ||
+             (buflen + n > FATFS_BUFFER_SIZE))
+      res = flush();
+    if (buffer == NULL)
+      buffer = (FatFSBuffer *)fs->server.buffers.alloc();
+    if (res == FR_OK) {
+      if ((buffer != NULL) && (n < FATFS_BUFFER_SIZE)) {
+        /* Small transfer, batched into the buffer.*/
+        if (!dirty) {
+          bufpos = position;
+          dirty  = true;
+        }
+        memcpy(buffer->data + buflen, bp, n);
+        buflen   += n;
+        position += n;
+        done      = n;
+      }
+      else {
+        /* Large transfer, performed directly.*/
+        UINT bw;
+
+        res = seek();
+        if (res == FR_OK) {
+          res = f_write(&file, bp, n, &bw);
+          position += bw;
+          done      = bw;
+        }
+      }
+    }
+    error = res;
+    BaseThread::unlockMutex();
+    return done;
+  }
+
+  /* Reads ahead the chunk following the buffered one into the other half of
+     the buffer, server side after the client has been released. The mutex
+     is not held during the transfer so the client can keep consuming the
+     buffered chunk meanwhile.*/
+  void FatFSFileWrapper::prefetch(void) {
+    fileoffset_t next;
+    FRESULT res;
+    UINT br = 0;
+
+    mtx.lock();
+    if ((buffer == NULL) || dirty || (position < bufpos) ||
+        (position > bufpos + buflen)) {
+      ahead = false;
+      BaseThread::unlockMutex();
+      return;
+    }
+
+    /* The chunks before the one containing the logical position have been
+       consumed and are dropped.*/
+    next = position - (position % FATFS_CHUNK_SIZE);
+    if (next > bufpos) {
+      buflen -= next - bufpos;
+      bufpos  = next;
+    }
+    next = bufpos + buflen;
+    if ((buflen % FATFS_CHUNK_SIZE != 0) || (buflen >= FATFS_BUFFER_SIZE) ||
+        (next >= f_size(&file))) {
+      ahead = false;
+      BaseThread::unlockMutex();
+      return;
+    }
+    ahead = true;
+    BaseThread::unlockMutex();
+
+    /* The target half is outside the valid data, the client does not
+       access it and only the server changes the buffer bounds.*/
+    res = f_lseek(&file, next);
+    if (res == FR_OK)
+      res = f_read(&file, buffer->data + (next % FATFS_BUFFER_SIZE),
+                   FATFS_CHUNK_SIZE, &br);
+
+    mtx.lock();
+    if (res == FR_OK)
+      buflen += br;
+    ahead = false;
+    BaseThread::unlockMutex();
+  }
 
-    return 0;
+  size_t FatFSFileWrapper::write(const uint8_t *bp, size_t n) {
+    wmsg_t wmsg;
+
+    /* Appending to the pending data does not involve the server.*/
+    mtx.lock();
+    if ((buffer != NULL) && dirty && (position == bufpos + buflen) &&
+        (n <= FATFS_BUFFER_SIZE - buflen)) {
+      memcpy(buffer->data + buflen, bp, n);
+      buflen   += n;
+      position += n;
+      BaseThread::unlockMutex();
+      return n;
+    }
+    BaseThread::unlockMutex();
+
+    wmsg.msg_code   = MSG_WRITE;
+    wmsg.file       = this;
+    wmsg.op.write.bp = bp;
+    wmsg.op.write.n  = n;
+    fs->server.sendMessage((msg_t)&wmsg);
+    return wmsg.op.write.n;
   }
 
   size_t FatFSFileWrapper::read(uint8_t *bp, size_t n) {
+    wmsg_t wmsg;
+    size_t done;
+    bool request = false;
+
+    /* Data already read ahead does not involve the server, when the last
+       buffered chunk is entered the server is asked to read ahead the next
+       one so that it is in memory before it is needed.*/
+    mtx.lock();
+    done = copyBuffered(bp, n);
+    if ((done == n) && aheadNeeded()) {
+      ahead   = true;
+      request = true;
+    }
+    BaseThread::unlockMutex();
+    if (done == n) {
+      if (request) {
+        wmsg.msg_code = MSG_PREFETCH;
+        wmsg.file     = this;
+        fs->server.sendMessage((msg_t)&wmsg);
+      }
+      return done;
+    }
 
-    return 0;
+    wmsg.msg_code   = MSG_READ;
+    wmsg.file       = this;
+    wmsg.op.read.bp = bp + done;
+    wmsg.op.read.n  = n - done;
+    fs->server.sendMessage((msg_t)&wmsg);
+    return done + wmsg.op.read.n;
   }
 
   msg_t FatFSFileWrapper::put(uint8_t b) {
 
-    return 0;
+    return write(&b, 1) == 1 ? Q_OK : Q_RESET;
   }
 
   msg_t FatFSFileWrapper::get(void) {
+    uint8_t b;
 
-    return 0;
+    return read(&b, 1) == 1 ? (msg_t)b : Q_RESET;
   }
 
   uint32_t FatFSFileWrapper::getAndClearLastError(void) {
+    uint32_t err = error;
 
-    return 0;
+    error = FR_OK;
+    return err;
   }
 
   fileoffset_t FatFSFileWrapper::getSize(void) {
-
-    return 0;
+    fileoffset_t size;
+
+    mtx.lock();
+    size = f_size(&file);
+    if (dirty && (bufpos + buflen > size))
+      size = bufpos + buflen;
+    BaseThread::unlockMutex();
+    return size;
   }
 
   fileoffset_t FatFSFileWrapper::getPosition(void) {
 
-    return 0;
+    return position;
   }
 
   uint32_t FatFSFileWrapper::setPosition(fileoffset_t offset) {
 
-    return 0;
+    /* The FatFS file pointer is moved by the next server operation.*/
+    mtx.lock();
+    position = offset;
+    BaseThread::unlockMutex();
+    return FILE_OK;
   }
 
   /*------------------------------------------------------------------------*
    * chibios_fatfs::FatFSFilesPool                                          *
    *------------------------------------------------------------------------*/
-  FatFSFilesPool::FatFSFilesPool(void) : ObjectsPool<FatFSFileWrapper,
-                                                     FATFS_MAX_FILES>() {
+  FatFSFilesPool::FatFSFilesPool(void) {
+
+  }
+
+  FatFSFileWrapper *FatFSFilesPool::alloc(FatFSWrapper *fsref) {
+    unsigned i;
+
+    for (i = 0; i < FATFS_MAX_FILES; i++) {
+      if (files[i].fs == NULL) {
+        files[i].reset(fsref);
+        return &files[i];
+      }
+    }
+    return NULL;
+  }
+
+  void FatFSFilesPool::free(FatFSFileWrapper *fp) {
+
+    fp->fs = NULL;
+  }
+
+  /*------------------------------------------------------------------------*
+   * chibios_fatfs::FatFSBuffersPool                                        *
+   *------------------------------------------------------------------------*/
+  FatFSBuffersPool::FatFSBuffersPool(void) : ObjectsPool<FatFSBuffer,
+                                                         FATFS_BUFFERS>() {
 
   }
 
@@ -119,24 +452,116 @@ namespace chibios_fatfs {
       BaseStaticThread<FATFS_THREAD_STACK_SIZE>() {
   }
 
+  void FatFSServerThread::closeFile(FatFSFileWrapper *fp) {
+    FRESULT res;
+
+    fp->mtx.lock();
+    res = fp->flush();
+    if (f_close(&fp->file) != FR_OK)
+      res = FR_INVALID_OBJECT;
+    if (fp->buffer != NULL)
+      buffers.free(fp->buffer);
+    fp->buffer = NULL;
+    fp->error  = res;
+    BaseThread::unlockMutex();
+    files.free(fp);
+  }
+
+  FRESULT FatFSServerThread::syncFiles(void) {
+    FRESULT res = FR_OK;
+    unsigned i;
+
+    for (i = 0; i < FATFS_MAX_FILES; i++) {
+      FatFSFileWrapper *fp = &files.files[i];
+
+      if ((fp->fs != NULL) && (fp->file.flag & FA_WRITE)) {
+        FRESULT r;
+
+        fp->mtx.lock();
+        r = fp->flush();
+        if (r == FR_OK)
+          r = f_sync(&fp->file);
+        BaseThread::unlockMutex();
+        if (r != FR_OK)
+          res = r;
+      }
+    }
+    return res;
+  }
+
   msg_t FatFSServerThread::main() {
     msg_t sts;
+    unsigned i;
 
     setName("fatfs");
 
+    (void)f_mount(0, &fatfs);
+
     /* Synchronous messages processing loop.*/
     while (true) {
+      FatFSFileWrapper *ahead = NULL;
       ThreadReference tr = waitMessage();
       msg_t msg = tr.getMessage();
-      switch (msg) {
-      case MSG_TERMINATE:
-        /* The server object is being destroyed, terminating.*/
+      wmsg_t *wmsgp = (wmsg_t *)msg;
+
+      if (msg == MSG_TERMINATE) {
+        /* The server object is being destroyed, the open files are closed
+           and the volume unmounted.*/
+        for (i = 0; i < FATFS_MAX_FILES; i++) {
+          if (files.files[i].fs != NULL)
+            closeFile(&files.files[i]);
+        }
+        (void)f_mount(0, NULL);
         tr.releaseMessage(ERR_TERMINATING);
         return 0;
+      }
+
+      sts = ERR_OK;
+      switch (wmsgp->msg_code) {
+      case MSG_OPEN:
+        wmsgp->file = files.alloc(wmsgp->op.open.fs);
+        if (wmsgp->file == NULL) {
+          wmsgp->result = FR_TOO_MANY_OPEN_FILES;
+          break;
+        }
+        wmsgp->result = f_open(&wmsgp->file->file, wmsgp->op.open.fname,
+                               wmsgp->op.open.mode);
+        if (wmsgp->result != FR_OK) {
+          files.free(wmsgp->file);
+          wmsgp->file = NULL;
+        }
+        break;
+      case MSG_CLOSE:
+        closeFile(wmsgp->file);
+        wmsgp->result = (FRESULT)wmsgp->file->error;
+        break;
+      case MSG_READ:
+        wmsgp->op.read.n = wmsgp->file->serverRead(wmsgp->op.read.bp,
+                                                   wmsgp->op.read.n);
+        ahead = wmsgp->file;
+        break;
+      case MSG_PREFETCH:
+        ahead = wmsgp->file;
+        break;
+      case MSG_WRITE:
+        wmsgp->op.write.n = wmsgp->file->serverWrite(wmsgp->op.write.bp,
+                                                     wmsgp->op.write.n);
+        break;
+      case MSG_SYNC:
+        wmsgp->result = syncFiles();
+        break;
+      case MSG_REMOVE:
+        wmsgp->result = f_unlink(wmsgp->op.remove.fname);
+        break;
       default:
         sts = ERR_UNKNOWN_MSG;
       }
       tr.releaseMessage(sts);
+
+      /* The read-ahead is performed after releasing the client so that it
+         overlaps with the client processing the data.*/
+      if (ahead != NULL)
+        ahead->prefetch();
     }
   }
 
@@ -149,7 +574,7 @@ namespace chibios_fatfs {
   /*------------------------------------------------------------------------*
    * chibios_fatfs::FatFSWrapper                                            *
    *------------------------------------------------------------------------*/
-  FatFSWrapper::FatFSWrapper(void) {
+  FatFSWrapper::FatFSWrapper(void) : error(FR_OK) {
 
   }
 
@@ -163,47 +588,71 @@ namespace chibios_fatfs {
     server.stop();
   }
 
+  /* Opens a file using the server thread.*/
+  BaseFileStreamInterface *FatFSWrapper::openFile(const char *fname,
+                                                  uint8_t mode) {
+    wmsg_t wmsg;
+
+    wmsg.msg_code         = MSG_OPEN;
+    wmsg.op.open.fs       = this;
+    wmsg.op.open.fname    = fname;
+    wmsg.op.open.mode     = mode;
+    server.sendMessage((msg_t)&wmsg);
+    error = wmsg.result;
+    return wmsg.file;
+  }
+
   uint32_t FatFSWrapper::getAndClearLastError(void) {
+    uint32_t err = error;
 
-    return 0;
+    error = FR_OK;
+    return err;
   }
 
   void FatFSWrapper::synchronize(void) {
+    wmsg_t wmsg;
 
+    wmsg.msg_code = MSG_SYNC;
+    server.sendMessage((msg_t)&wmsg);
+    error = wmsg.result;
   }
 
   void FatFSWrapper::remove(const char *fname) {
+    wmsg_t wmsg;
 
-    (void)fname;
+    wmsg.msg_code        = MSG_REMOVE;
+    wmsg.op.remove.fname = fname;
+    server.sendMessage((msg_t)&wmsg);
+    error = wmsg.result;
   }
 
   BaseFileStreamInterface *FatFSWrapper::open(const char *fname) {
 
-    (void)fname;
-    return NULL;
+    return openFile(fname, FA_OPEN_EXISTING | FA_READ | FA_WRITE);
   }
 
   BaseFileStreamInterface *FatFSWrapper::openForRead(const char *fname) {
 
-    (void)fname;
-    return NULL;
+    return openFile(fname, FA_OPEN_EXISTING | FA_READ);
   }
 
   BaseFileStreamInterface *FatFSWrapper::openForWrite(const char *fname) {
 
-    (void)fname;
-    return NULL;
+    return openFile(fname, FA_OPEN_EXISTING | FA_WRITE);
   }
 
   BaseFileStreamInterface *FatFSWrapper::create(const char *fname) {
 
-    (void)fname;
-    return NULL;
+    return openFile(fname, FA_CREATE_ALWAYS | FA_WRITE);
   }
 
   void FatFSWrapper::close(BaseFileStreamInterface *file) {
+    wmsg_t wmsg;
 
-    (void)file;
+    wmsg.msg_code = MSG_CLOSE;
+    wmsg.file     = static_cast<FatFSFileWrapper *>(file);
+    server.sendMessage((msg_t)&wmsg);
+    error = wmsg.result;
   }
 }
 
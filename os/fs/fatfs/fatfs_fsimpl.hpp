@@ -28,6 +28,7 @@
 
 #include "ch.hpp"
 #include "fs.hpp"
+#include "ff.h"
 
 #ifndef _FS_FATFS_IMPL_HPP_
 #define _FS_FATFS_IMPL_HPP_
@@ -53,6 +54,34 @@
 #define FATFS_MAX_FILES                 16
 #endif
 
+/**
+ * @brief   Number of file buffers.
+ * @details The buffers are shared among the open files and are used for
+ *          read-ahead and for batching writes. A buffer is assigned to a
+ *          file on its first read or write and it is held until the file
+ *          is closed, files unable to get a buffer perform direct
+ *          unbuffered transfers and try again on the next operation.
+ * @note    In order to have all the files buffered this value must be
+ *          equal to the maximum number of files open at the same time.
+ */
+#if !defined(FATFS_BUFFERS) || defined(__DOXYGEN__)
+#define FATFS_BUFFERS                   2
+#endif
+
+/**
+ * @brief   Size of the file buffers.
+ * @details When reading the buffer is split in two halves, the client
+ *          reads from one half while the server reads ahead the next
+ *          chunk of the file into the other half.
+ */
+#if !defined(FATFS_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define FATFS_BUFFER_SIZE               4096
+#endif
+
+#if (FATFS_BUFFER_SIZE % (2 * _MAX_SS)) != 0
+#error "FATFS_BUFFER_SIZE must be a multiple of twice the sector size"
+#endif
+
 using namespace chibios_rt;
 using namespace chibios_fs;
 
@@ -63,14 +92,83 @@ namespace chibios_fatfs {
 
   class FatFSWrapper;
 
+  /**
+   * @brief   Type of a file buffer.
+   */
+  typedef struct {
+    uint8_t             data[FATFS_BUFFER_SIZE];
+  } FatFSBuffer;
+
   /*------------------------------------------------------------------------*
    * chibios_fatfs::FatFSFileWrapper                                        *
    *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class of a FatFS file.
+   * @details Reads and writes hitting the file buffer are served in the
+   *          caller context, the other operations are forwarded to the
+   *          server thread.
+   * @note    A file object must not be used by multiple threads at the
+   *          same time.
+   */
   class FatFSFileWrapper : public BaseFileStreamInterface {
     friend class FatFSWrapper;
+    friend class FatFSServerThread;
+    friend class FatFSFilesPool;
 
   protected:
+    /**
+     * @brief   Owner file system or @p NULL if the object is free.
+     */
     FatFSWrapper *fs;
+    /**
+     * @brief   FatFS file object.
+     */
+    FIL                 file;
+    /**
+     * @brief   Mutex protecting the buffer state.
+     */
+    chibios_rt::Mutex   mtx;
+    /**
+     * @brief   File buffer or @p NULL if not yet assigned.
+     */
+    FatFSBuffer         *buffer;
+    /**
+     * @brief   File offset of the first buffered byte.
+     */
+    fileoffset_t        bufpos;
+    /**
+     * @brief   Number of valid bytes in the buffer.
+     * @details Pending writes are stored from the start of the buffer,
+     *          read data is stored at the file offset modulo the buffer
+     *          size.
+     */
+    size_t              buflen;
+    /**
+     * @brief   The buffer contains data not yet written.
+     */
+    bool                dirty;
+    /**
+     * @brief   A read-ahead has been requested or is in progress.
+     */
+    bool                ahead;
+    /**
+     * @brief   Logical file pointer.
+     */
+    fileoffset_t        position;
+    /**
+     * @brief   Last error.
+     */
+    uint32_t            error;
+
+    void reset(FatFSWrapper *fsref);
+    FRESULT seek(void);
+    FRESULT flush(void);
+    FRESULT fill(void);
+    size_t copyBuffered(uint8_t *bp, size_t n);
+    bool aheadNeeded(void);
+    size_t serverRead(uint8_t *bp, size_t n);
+    size_t serverWrite(const uint8_t *bp, size_t n);
+    void prefetch(void);
 
   public:
     FatFSFileWrapper(void);
@@ -90,12 +188,30 @@ namespace chibios_fatfs {
    * chibios_fatfs::FatFSFilesPool                                          *
    *------------------------------------------------------------------------*/
   /**
-   * @brief   Class of memory pool of @p FatFSFileWrapper objects.
+   * @brief   Class of a fixed pool of @p FatFSFileWrapper objects.
+   * @note    The pool is only accessed by the server thread.
    */
-  class FatFSFilesPool : public ObjectsPool<FatFSFileWrapper,
-                                            FATFS_MAX_FILES> {
+  class FatFSFilesPool {
   public:
+    /**
+     * @brief   The file objects, free objects have a @p NULL owner.
+     */
+    FatFSFileWrapper    files[FATFS_MAX_FILES];
+
     FatFSFilesPool(void);
+    FatFSFileWrapper *alloc(FatFSWrapper *fsref);
+    void free(FatFSFileWrapper *fp);
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_fatfs::FatFSBuffersPool                                        *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class of memory pool of file buffers.
+   */
+  class FatFSBuffersPool : public ObjectsPool<FatFSBuffer, FATFS_BUFFERS> {
+  public:
+    FatFSBuffersPool(void);
   };
 
   /*------------------------------------------------------------------------*
@@ -105,8 +221,15 @@ namespace chibios_fatfs {
    * @brief   Class of the internal server thread.
    */
   class FatFSServerThread : public BaseStaticThread<FATFS_THREAD_STACK_SIZE> {
+    friend class FatFSFileWrapper;
+
   private:
+    FATFS fatfs;
     FatFSFilesPool files;
+    FatFSBuffersPool buffers;
+
+    void closeFile(FatFSFileWrapper *fp);
+    FRESULT syncFiles(void);
   protected:
     virtual msg_t main(void);
   public:
@@ -125,6 +248,9 @@ namespace chibios_fatfs {
 
   protected:
     FatFSServerThread server;
+    uint32_t error;
+
+    BaseFileStreamInterface *openFile(const char *fname, uint8_t mode);
 
   public:
     FatFSWrapper(void);
@@ -34,6 +34,24 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Receive checksum status flags
+ * @{
+ */
+/**
+ * @brief   No checksum has been verified by the hardware.
+ */
+#define MAC_CHECKSUM_NONE           0
+/**
+ * @brief   The IPv4 header checksum has been verified by the hardware.
+ */
+#define MAC_CHECKSUM_IP             1
+/**
+ * @brief   The TCP, UDP or ICMP checksum has been verified by the hardware.
+ */
+#define MAC_CHECKSUM_PAYLOAD        2
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -55,6 +73,17 @@
 #if !defined(MAC_USE_EVENTS) || defined(__DOXYGEN__)
 #define MAC_USE_EVENTS              TRUE
 #endif
+
+/**
+ * @brief   Space reserved in front of each receive buffer.
+ * @details Upper layers can use this area in order to store their own
+ *          buffer header in front of a loaned receive buffer.
+ * @note    This setting is only meaningful when @p MAC_USE_ZERO_COPY is
+ *          enabled, it must be a multiple of four.
+ */
+#if !defined(MAC_RECEIVE_HEADROOM) || defined(__DOXYGEN__)
+#define MAC_RECEIVE_HEADROOM        32
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -69,6 +98,10 @@
 #error "the MAC driver requires CH_USE_EVENTS"
 #endif
 
+#if (MAC_RECEIVE_HEADROOM % 4) != 0
+#error "MAC_RECEIVE_HEADROOM must be a multiple of four"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -87,8 +120,76 @@ typedef enum {
  */
 typedef struct MACDriver MACDriver;
 
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a transmit segment.
+ * @details A frame transmitted using @p macTransmitSegments() is described
+ *          by an array of segments, the segments are transmitted in place
+ *          unless copying is requested.
+ */
+typedef struct {
+  /**
+   * @brief Pointer to the segment data.
+   */
+  const uint8_t         *buf;
+  /**
+   * @brief Segment size in bytes.
+   */
+  size_t                size;
+  /**
+   * @brief The segment is copied into the driver buffers.
+   * @details The segment memory can be modified as soon as
+   *          @p macTransmitSegments() returns, it must fit a single
+   *          driver buffer.
+   */
+  bool_t                copy;
+} MACTransmitSegment;
+
+/**
+ * @brief   Transmitted segments release callback type.
+ * @details The callback is invoked, in thread context, once the memory of
+ *          a frame sent with @p macTransmitSegments() is no more in use by
+ *          the driver.
+ *
+ * @param[in] arg       the argument specified on transmission
+ */
+typedef void (*macreleasecb_t)(void *arg);
+#endif /* MAC_USE_ZERO_COPY */
+
+/**
+ * @brief   Type of a hardware time stamp.
+ * @details Time stamps are expressed in the time base of the MAC clock,
+ *          normally the PTP time scale.
+ */
+typedef struct {
+  uint32_t              seconds;    /**< @brief Seconds.                    */
+  uint32_t              nanoseconds;/**< @brief Nanoseconds, always less
+                                                than one second.            */
+} MACTimestamp;
+
 #include "mac_lld.h"
 
+/**
+ * @brief   The low level driver does not offload the checksums by default.
+ */
+#if !defined(MAC_SUPPORTS_CHECKSUM_OFFLOAD) || defined(__DOXYGEN__)
+#define MAC_SUPPORTS_CHECKSUM_OFFLOAD   FALSE
+#endif
+
+/**
+ * @brief   The low level driver does not handle a PHY interrupt by default.
+ */
+#if !defined(MAC_SUPPORTS_LINK_INTERRUPT) || defined(__DOXYGEN__)
+#define MAC_SUPPORTS_LINK_INTERRUPT     FALSE
+#endif
+
+/**
+ * @brief   The low level driver does not time stamp the frames by default.
+ */
+#if !defined(MAC_SUPPORTS_TIMESTAMPS) || defined(__DOXYGEN__)
+#define MAC_SUPPORTS_TIMESTAMPS         FALSE
+#endif
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -109,6 +210,53 @@ typedef struct MACDriver MACDriver;
 #define macGetReceiveEventSource(macp)  (&(macp)->rdevent)
 #endif
 
+/**
+ * @brief   Returns the transmit event source.
+ * @details The event is broadcast when frames have been transmitted, the
+ *          frames sent using @p macTransmitSegments() can then be released
+ *          using @p macReclaimTransmitSegments().
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The pointer to the @p EventSource structure.
+ *
+ * @api
+ */
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+#define macGetTransmitEventSource(macp) (&(macp)->tdevent)
+#endif
+
+/**
+ * @brief   Returns the link status change event source.
+ * @details The event is broadcast by @p macLinkChangedI().
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The pointer to the @p EventSource structure.
+ *
+ * @api
+ */
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+#define macGetLinkEventSource(macp)     (&(macp)->lsevent)
+#endif
+
+/**
+ * @brief   Reports if the link status changes are signaled by the PHY.
+ * @details If the PHY interrupt is not configured the link status must be
+ *          polled periodically using @p macPollLinkStatus().
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The link interrupt state.
+ * @retval TRUE         if the link changes are signaled by the PHY.
+ * @retval FALSE        if the link status must be polled.
+ *
+ * @api
+ */
+#if MAC_SUPPORTS_LINK_INTERRUPT || defined(__DOXYGEN__)
+#define macIsLinkInterruptEnabled(macp)                                     \
+    mac_lld_is_link_interrupt_enabled(macp)
+#else
+#define macIsLinkInterruptEnabled(macp) FALSE
+#endif
+
 /**
  * @brief   Writes to a transmit descriptor's stream.
  *
@@ -140,6 +288,68 @@ typedef struct MACDriver MACDriver;
 #define macReadReceiveDescriptor(rdp, buf, size)                            \
     mac_lld_read_receive_descriptor(rdp, buf, size)
 
+/**
+ * @brief   Returns the checksums verified by the hardware on a received
+ *          frame.
+ * @details The frames with checksum errors are discarded by the driver,
+ *          the checksums not verified by the hardware must be verified by
+ *          the upper layers. Without hardware offload nothing is verified.
+ * @note    The status must be read before releasing the descriptor or
+ *          loaning its buffer.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @return              The verified checksums as a combination of the
+ *                      @p MAC_CHECKSUM_IP and @p MAC_CHECKSUM_PAYLOAD flags.
+ *
+ * @api
+ */
+#if MAC_SUPPORTS_CHECKSUM_OFFLOAD || defined(__DOXYGEN__)
+#define macGetReceiveChecksumStatus(rdp)                                    \
+    mac_lld_get_receive_checksum_status(rdp)
+#else
+#define macGetReceiveChecksumStatus(rdp) MAC_CHECKSUM_NONE
+#endif
+
+#if MAC_SUPPORTS_TIMESTAMPS || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the reception time stamp of a frame.
+ * @note    The time stamp must be read before releasing the descriptor or
+ *          loaning its buffer.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ * @return              The time stamp availability.
+ * @retval TRUE         if the time stamp has been stored in @p tsp.
+ * @retval FALSE        if the frame has not been time stamped.
+ *
+ * @api
+ */
+#define macGetReceiveTimestamp(rdp, tsp)                                    \
+    mac_lld_get_receive_timestamp(rdp, tsp)
+
+/**
+ * @brief   Returns the transmission time stamp of a frame.
+ * @details The time stamp becomes available once the frame released with
+ *          @p macReleaseTransmitDescriptor() has been transmitted, the
+ *          function can be polled until it succeeds.
+ * @note    The descriptor structure is still valid after the release but
+ *          the physical descriptor is reused by the following frames, the
+ *          time stamp must be read before the driver cycles through all
+ *          the transmit descriptors.
+ *
+ * @param[in] tdp       pointer to a released @p MACTransmitDescriptor
+ *                      structure
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ * @return              The time stamp availability.
+ * @retval TRUE         if the time stamp has been stored in @p tsp.
+ * @retval FALSE        if the frame has not been transmitted yet.
+ *
+ * @api
+ */
+#define macGetTransmitTimestamp(tdp, tsp)                                   \
+    mac_lld_get_transmit_timestamp(tdp, tsp)
+#endif /* MAC_SUPPORTS_TIMESTAMPS */
+
 #if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
 /**
  * @brief   Returns a pointer to the next transmit buffer in the descriptor
@@ -179,6 +389,42 @@ typedef struct MACDriver MACDriver;
  */
 #define macGetNextReceiveBuffer(rdp, sizep)                                 \
   mac_lld_get_next_receive_buffer(rdp, sizep)
+
+/**
+ * @brief   Takes ownership of the buffer of a received frame.
+ * @details The frame buffer is detached from the descriptor and replaced
+ *          with a spare buffer, this way the frame can be processed in
+ *          place while the descriptor is released immediately. The buffer
+ *          must be given back using @p macReturnReceiveBuffer() once the
+ *          frame has been consumed.
+ * @note    The buffer is preceded by @p MAC_RECEIVE_HEADROOM bytes that
+ *          the caller can use freely until the buffer is returned.
+ * @note    The API guarantees that the descriptor chain contains a whole
+ *          frame, the frame is contained in a single buffer.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the frame size
+ * @return              Pointer to the loaned buffer.
+ * @retval NULL         if no spare buffers are available, in this case the
+ *                      descriptor is left untouched and its content must
+ *                      be read normally.
+ *
+ * @api
+ */
+#define macLoanReceiveBuffer(rdp, sizep)                                    \
+  mac_lld_loan_receive_buffer(rdp, sizep)
+
+/**
+ * @brief   Gives back a buffer obtained using @p macLoanReceiveBuffer().
+ * @details The buffer becomes a spare buffer again.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the loaned buffer
+ *
+ * @api
+ */
+#define macReturnReceiveBuffer(macp, buf)                                   \
+  mac_lld_return_receive_buffer(macp, buf)
 #endif /* MAC_USE_ZERO_COPY */
 /** @} */
 
@@ -203,6 +449,24 @@ extern "C" {
                                  systime_t time);
   void macReleaseReceiveDescriptor(MACReceiveDescriptor *rdp);
   bool_t macPollLinkStatus(MACDriver *macp);
+#if MAC_USE_EVENTS
+  void macLinkChangedI(MACDriver *macp);
+#endif
+#if MAC_SUPPORTS_TIMESTAMPS
+  void macGetClockTime(MACDriver *macp, MACTimestamp *tsp);
+  bool_t macSetClockTime(MACDriver *macp, const MACTimestamp *tsp);
+  bool_t macAdjustClockTime(MACDriver *macp, int64_t offset);
+  bool_t macAdjustClockFrequency(MACDriver *macp, int32_t ppb);
+#endif
+#if MAC_USE_ZERO_COPY
+  msg_t macTransmitSegments(MACDriver *macp,
+                            const MACTransmitSegment *segp,
+                            unsigned n,
+                            macreleasecb_t cb,
+                            void *arg,
+                            systime_t time);
+  void macReclaimTransmitSegments(MACDriver *macp);
+#endif
 #ifdef __cplusplus
 }
 #endif
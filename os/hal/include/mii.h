@@ -157,6 +157,23 @@
 #define MII_DP83848I_ID   0x20005C90
 #define MII_LAN8710A_ID   0x0007C0F1
 
+/*
+ * KS8721 interrupt control/status register, the status bits are cleared
+ * on read.
+ */
+#define MII_KS8721_ICSR         0x1b    /**< Interrupt control/status.      */
+#define KS8721_ICSR_LINKDOWN_IE 0x0400  /**< Link down interrupt enable.    */
+#define KS8721_ICSR_LINKUP_IE   0x0100  /**< Link up interrupt enable.      */
+
+/*
+ * LAN8710A interrupt source and mask registers, the source register is
+ * cleared on read.
+ */
+#define MII_LAN8710A_ISR        0x1d    /**< Interrupt source flags.        */
+#define MII_LAN8710A_IMR        0x1e    /**< Interrupt mask.                */
+#define LAN8710A_INT_ANCOMPLETE 0x0040  /**< Auto-negotiation complete.     */
+#define LAN8710A_INT_LINKDOWN   0x0010  /**< Link down.                     */
+
 #endif /* _MII_H_ */
 
 /** @} */
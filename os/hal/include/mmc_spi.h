@@ -125,6 +125,10 @@ typedef struct {
    * @brief Addresses use blocks instead of bytes.
    */
   bool_t                block_addresses;
+  /**
+   * @brief The card accepts the ACMD23 pre-erase command.
+   */
+  bool_t                pre_erase;
 } MMCDriver;
 
 /*===========================================================================*/
@@ -181,6 +185,7 @@ extern "C" {
   bool_t mmcSequentialRead(MMCDriver *mmcp, uint8_t *buffer);
   bool_t mmcStopSequentialRead(MMCDriver *mmcp);
   bool_t mmcStartSequentialWrite(MMCDriver *mmcp, uint32_t startblk);
+  bool_t mmcStartMultipleWrite(MMCDriver *mmcp, uint32_t startblk, uint32_t n);
   bool_t mmcSequentialWrite(MMCDriver *mmcp, const uint8_t *buffer);
   bool_t mmcStopSequentialWrite(MMCDriver *mmcp);
   bool_t mmcSync(MMCDriver *mmcp);
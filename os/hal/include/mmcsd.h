@@ -52,6 +52,16 @@
  */
 #define MMCSD_CMD8_PATTERN              0x000001AA
 
+/**
+ * @brief   Size of the SD SCR register in bytes.
+ */
+#define MMCSD_SCR_SIZE                  8
+
+/**
+ * @brief   Size of the SD CMD6 switch status block in bytes.
+ */
+#define MMCSD_SWITCH_STATUS_SIZE        64
+
 /**
  * @name    SD/MMC status conditions
  * @{
@@ -76,6 +86,7 @@
 #define MMCSD_CMD_ALL_SEND_CID          2
 #define MMCSD_CMD_SEND_RELATIVE_ADDR    3
 #define MMCSD_CMD_SET_BUS_WIDTH         6
+#define MMCSD_CMD_SWITCH                6
 #define MMCSD_CMD_SEL_DESEL_CARD        7
 #define MMCSD_CMD_SEND_IF_COND          8
 #define MMCSD_CMD_SEND_CSD              9
@@ -86,6 +97,7 @@
 #define MMCSD_CMD_READ_SINGLE_BLOCK     17
 #define MMCSD_CMD_READ_MULTIPLE_BLOCK   18
 #define MMCSD_CMD_SET_BLOCK_COUNT       23
+#define MMCSD_CMD_SET_WR_BLK_ERASE_COUNT 23
 #define MMCSD_CMD_WRITE_BLOCK           24
 #define MMCSD_CMD_WRITE_MULTIPLE_BLOCK  25
 #define MMCSD_CMD_ERASE_RW_BLK_START    32
@@ -93,6 +105,7 @@
 #define MMCSD_CMD_ERASE                 38
 #define MMCSD_CMD_APP_OP_COND           41
 #define MMCSD_CMD_LOCK_UNLOCK           42
+#define MMCSD_CMD_SEND_SCR              51
 #define MMCSD_CMD_APP_CMD               55
 #define MMCSD_CMD_READ_OCR              58
 /** @} */
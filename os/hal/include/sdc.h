@@ -44,6 +44,7 @@
 #define SDC_MODE_CARDTYPE_SDV20         1       /**< @brief Card is SD V2.0.*/
 #define SDC_MODE_CARDTYPE_MMC           2       /**< @brief Card is MMC.    */
 #define SDC_MODE_HIGH_CAPACITY          0x10    /**< @brief High cap.card.  */
+#define SDC_MODE_HIGH_SPEED             0x20    /**< @brief High speed mode.*/
 /** @} */
 
 /**
@@ -62,6 +63,15 @@
 #define SDC_UNHANDLED_ERROR   0xFFFFFFFF
 /** @} */
 
+/**
+ * @name    Asynchronous request types
+ * @{
+ */
+#define SDC_REQ_READ                    0   /**< @brief Blocks read.        */
+#define SDC_REQ_WRITE                   1   /**< @brief Blocks write.       */
+#define SDC_REQ_SYNC                    2   /**< @brief Card idle wait.     */
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -96,18 +106,151 @@
 #if !defined(SDC_NICE_WAITING) || defined(__DOXYGEN__)
 #define SDC_NICE_WAITING                TRUE
 #endif
+
+/**
+ * @brief   Enables the asynchronous requests API.
+ * @details If enabled the driver spawns a worker thread that serves the
+ *          queued requests, the submitting threads are not blocked during
+ *          the transfers.
+ */
+#if !defined(SDC_USE_ASYNC) || defined(__DOXYGEN__)
+#define SDC_USE_ASYNC                   FALSE
+#endif
+
+/**
+ * @brief   Maximum number of queued asynchronous requests.
+ */
+#if !defined(SDC_ASYNC_QUEUE_SIZE) || defined(__DOXYGEN__)
+#define SDC_ASYNC_QUEUE_SIZE            4
+#endif
+
+/**
+ * @brief   Stack size of the asynchronous requests worker thread.
+ * @details The worker thread needs about 128-256 bytes for the driver
+ *          call chain, depending on the architecture and on the low level
+ *          driver, plus the space required by the port for interrupts
+ *          handling.
+ * @note    The completion callbacks are executed on this stack, the
+ *          default leaves about 256 bytes to them, the size must be
+ *          increased by the stack usage of the deepest callback beyond
+ *          that budget.
+ */
+#if !defined(SDC_ASYNC_STACK_SIZE) || defined(__DOXYGEN__)
+#define SDC_ASYNC_STACK_SIZE            512
+#endif
+
+/**
+ * @brief   Priority of the asynchronous requests worker thread.
+ */
+#if !defined(SDC_ASYNC_PRIORITY) || defined(__DOXYGEN__)
+#define SDC_ASYNC_PRIORITY              NORMALPRIO
+#endif
 /** @} */
 
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if SDC_USE_ASYNC &&                                                        \
+    (!CH_USE_MAILBOXES || !CH_USE_SEMAPHORES || !CH_USE_MUTEXES)
+#error "SDC_USE_ASYNC requires CH_USE_MAILBOXES, CH_USE_SEMAPHORES and "    \
+       "CH_USE_MUTEXES"
+#endif
+
+#if SDC_USE_ASYNC && (SDC_ASYNC_QUEUE_SIZE < 1)
+#error "invalid SDC_ASYNC_QUEUE_SIZE value"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   @p SDCDriver data common to all the implementations.
+ * @note    The low level drivers must place this macro right after the
+ *          virtual methods table pointer in the @p SDCDriver structure.
+ */
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+#define _sdc_driver_data                                                    \
+  _mmcsd_block_device_data                                                  \
+  /* Driver lock, serializes the synchronous APIs and the worker thread.*/  \
+  Mutex                     mutex;                                          \
+  /* Asynchronous requests queue.*/                                         \
+  Mailbox                   async_queue;                                    \
+  /* Asynchronous requests queue buffer.*/                                  \
+  msg_t                     async_buffer[SDC_ASYNC_QUEUE_SIZE];             \
+  /* Asynchronous requests worker thread.*/                                 \
+  Thread                    *async_thread;                                  \
+  /* Worker thread working area.*/                                          \
+  WORKING_AREA(async_wa, SDC_ASYNC_STACK_SIZE);
+#else
+#define _sdc_driver_data                                                    \
+  _mmcsd_block_device_data
+#endif
+
 #include "sdc_lld.h"
 
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Type of an asynchronous request.
+ */
+typedef struct SDCRequest SDCRequest;
+
+/**
+ * @brief   Asynchronous request completion callback type.
+ * @note    The callback is invoked from the context of the driver worker
+ *          thread, the synchronous APIs can be used but the queued
+ *          requests are not served until the callback returns.
+ * @note    The request semaphore is not signaled when a callback is
+ *          specified, the request belongs to the callback which can reuse
+ *          or resubmit it.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] rqp       pointer to the completed @p SDCRequest object
+ */
+typedef void (*sdccallback_t)(SDCDriver *sdcp, SDCRequest *rqp);
+
+/**
+ * @brief   Structure representing an asynchronous request.
+ * @note    The request object is owned by the driver from submission until
+ *          completion, it must not be modified or reused meanwhile.
+ */
+struct SDCRequest {
+  /**
+   * @brief Request type.
+   */
+  uint8_t                   type;
+  /**
+   * @brief Operation result, @p CH_SUCCESS or @p CH_FAILED.
+   */
+  bool_t                    result;
+  /**
+   * @brief First block of the transfer.
+   */
+  uint32_t                  startblk;
+  /**
+   * @brief Transfer buffer.
+   */
+  uint8_t                   *buf;
+  /**
+   * @brief Number of blocks to transfer.
+   */
+  uint32_t                  n;
+  /**
+   * @brief Errors mask collected during the operation.
+   */
+  sdcflags_t                errors;
+  /**
+   * @brief Completion callback or @p NULL.
+   */
+  sdccallback_t             callback;
+  /**
+   * @brief Completion semaphore, only signaled if there is no callback.
+   */
+  BinarySemaphore           done;
+};
+#endif /* SDC_USE_ASYNC */
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -147,6 +290,20 @@
  * @api
  */
 #define sdcIsWriteProtected(sdcp) (sdc_lld_is_write_protected(sdcp))
+
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the result of a completed asynchronous request.
+ *
+ * @param[in] rqp       pointer to the @p SDCRequest object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+#define sdcGetRequestResult(rqp) ((rqp)->result)
+#endif /* SDC_USE_ASYNC */
 /** @} */
 
 /*===========================================================================*/
@@ -171,6 +328,15 @@ extern "C" {
   bool_t sdcGetInfo(SDCDriver *sdcp, BlockDeviceInfo *bdip);
   bool_t sdcErase(SDCDriver *mmcp, uint32_t startblk, uint32_t endblk);
   bool_t _sdc_wait_for_transfer_state(SDCDriver *sdcp);
+#if SDC_USE_ASYNC
+  bool_t sdcStartRead(SDCDriver *sdcp, SDCRequest *rqp, uint32_t startblk,
+                      uint8_t *buf, uint32_t n, sdccallback_t callback);
+  bool_t sdcStartWrite(SDCDriver *sdcp, SDCRequest *rqp, uint32_t startblk,
+                       const uint8_t *buf, uint32_t n, sdccallback_t callback);
+  bool_t sdcStartSync(SDCDriver *sdcp, SDCRequest *rqp,
+                      sdccallback_t callback);
+  msg_t sdcWaitRequest(SDCRequest *rqp, systime_t time);
+#endif
 #ifdef __cplusplus
 }
 #endif
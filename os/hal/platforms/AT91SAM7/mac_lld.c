@@ -109,6 +109,9 @@ static void serve_interrupt(void) {
     if (tsr & AT91C_EMAC_COMP) {
       chSysLockFromIsr();
       chSemResetI(&ETHD1.tdsem, 0);
+#if MAC_USE_EVENTS
+      chEvtBroadcastI(&ETHD1.tdevent);
+#endif
       chSysUnlockFromIsr();
     }
     AT91C_BASE_EMAC->EMAC_TSR = TSR_BITS;
@@ -164,6 +164,14 @@ struct MACDriver {
    * @brief Receive event.
    */
   EventSource           rdevent;
+  /**
+   * @brief Transmit event.
+   */
+  EventSource           tdevent;
+  /**
+   * @brief Link status change event.
+   */
+  EventSource           lsevent;
 #endif
   /* End of the mandatory fields.*/
   /**
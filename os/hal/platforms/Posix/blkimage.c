@@ -0,0 +1,307 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/blkimage.c
+ * @brief   Posix disk image block device code.
+ * @details The block device is backed by a memory mapped image file on the
+ *          host, the access timings of a real medium can be modeled in
+ *          order to exercise and profile the block device users. The
+ *          object is a @p BaseBlockDevice so it can be assigned to a FatFs
+ *          drive using @p fatfsRegisterDrive().
+ *
+ * @addtogroup POSIX_BLKIMAGE
+ * @{
+ */
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "blkimage.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the mapped image in bytes.
+ */
+#define image_size(bip) ((size_t)(bip)->blk_num * BLOCK_IMAGE_BLOCK_SIZE)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Checks a transfer range.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ * @param[in] startblk  first block
+ * @param[in] n         number of blocks
+ * @return              The operation status.
+ * @retval CH_SUCCESS   valid range.
+ * @retval CH_FAILED    invalid range or image not ready.
+ */
+static bool_t check(BlockImage *bip, uint32_t startblk, uint32_t n) {
+
+  if ((bip->state != BLK_READY) ||
+      (startblk >= bip->blk_num) || (n > bip->blk_num - startblk))
+    return CH_FAILED;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Waits for the modeled duration of an operation.
+ * @details Durations shorter than a system tick are accumulated and slept
+ *          later so the average throughput follows the model.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ * @param[in] latency   command latency in microseconds
+ * @param[in] n         number of transferred blocks
+ */
+static void model(BlockImage *bip, uint32_t latency, uint32_t n) {
+  uint64_t us = latency;
+  systime_t ticks;
+
+  if (bip->config->bandwidth > 0)
+    us += (uint64_t)n * BLOCK_IMAGE_BLOCK_SIZE * 1000000 /
+          bip->config->bandwidth;
+  bip->stats.busy += us;
+  bip->debt += us;
+  ticks = (systime_t)(bip->debt * CH_FREQUENCY / 1000000);
+  if (ticks > 0) {
+    bip->debt -= (uint64_t)ticks * 1000000 / CH_FREQUENCY;
+    chThdSleep(ticks);
+  }
+}
+
+/**
+ * @brief   Sizes and maps an open image file.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ * @param[in] config    pointer to the @p BlockImageConfig object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ */
+static bool_t map(BlockImage *bip, const BlockImageConfig *config) {
+  struct stat st;
+  void *p;
+
+  if (fstat(bip->fd, &st) < 0)
+    return CH_FAILED;
+  bip->blk_num = config->blk_num;
+  if (bip->blk_num == 0)
+    bip->blk_num = (uint32_t)(st.st_size / BLOCK_IMAGE_BLOCK_SIZE);
+  if (bip->blk_num == 0)
+    return CH_FAILED;
+  if ((off_t)image_size(bip) > st.st_size) {
+    if (config->read_only || (ftruncate(bip->fd, image_size(bip)) < 0))
+      return CH_FAILED;
+  }
+  p = mmap(NULL, image_size(bip),
+           config->read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+           MAP_SHARED, bip->fd, 0);
+  if (p == MAP_FAILED)
+    return CH_FAILED;
+  bip->image = p;
+  return CH_SUCCESS;
+}
+
+static bool_t bi_is_inserted(void *instance) {
+
+  return ((BlockImage *)instance)->image != NULL;
+}
+
+static bool_t bi_is_protected(void *instance) {
+  BlockImage *bip = instance;
+
+  return (bip->config != NULL) && bip->config->read_only;
+}
+
+static bool_t bi_connect(void *instance) {
+  BlockImage *bip = instance;
+
+  if (bip->image == NULL)
+    return CH_FAILED;
+  bip->state = BLK_READY;
+  return CH_SUCCESS;
+}
+
+static bool_t bi_disconnect(void *instance) {
+  BlockImage *bip = instance;
+
+  if (bip->state == BLK_READY)
+    bip->state = BLK_ACTIVE;
+  return CH_SUCCESS;
+}
+
+static bool_t bi_read(void *instance, uint32_t startblk,
+                      uint8_t *buffer, uint32_t n) {
+  BlockImage *bip = instance;
+
+  if (check(bip, startblk, n))
+    return CH_FAILED;
+  memcpy(buffer, bip->image + (size_t)startblk * BLOCK_IMAGE_BLOCK_SIZE,
+         (size_t)n * BLOCK_IMAGE_BLOCK_SIZE);
+  bip->stats.reads++;
+  bip->stats.rdblocks += n;
+  model(bip, bip->config->rd_latency, n);
+  return CH_SUCCESS;
+}
+
+static bool_t bi_write(void *instance, uint32_t startblk,
+                       const uint8_t *buffer, uint32_t n) {
+  BlockImage *bip = instance;
+
+  if (check(bip, startblk, n) || bip->config->read_only)
+    return CH_FAILED;
+  memcpy(bip->image + (size_t)startblk * BLOCK_IMAGE_BLOCK_SIZE, buffer,
+         (size_t)n * BLOCK_IMAGE_BLOCK_SIZE);
+  bip->stats.writes++;
+  bip->stats.wrblocks += n;
+  model(bip, bip->config->wr_latency, n);
+  return CH_SUCCESS;
+}
+
+static bool_t bi_sync(void *instance) {
+  BlockImage *bip = instance;
+
+  if (bip->state != BLK_READY)
+    return CH_FAILED;
+  if (!bip->config->read_only &&
+      (msync(bip->image, image_size(bip), MS_SYNC) < 0))
+    return CH_FAILED;
+  return CH_SUCCESS;
+}
+
+static bool_t bi_get_info(void *instance, BlockDeviceInfo *bdip) {
+  BlockImage *bip = instance;
+
+  if (bip->image == NULL)
+    return CH_FAILED;
+  bdip->blk_size = BLOCK_IMAGE_BLOCK_SIZE;
+  bdip->blk_num  = bip->blk_num;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Virtual methods table.
+ */
+static const struct BlockImageVMT vmt = {
+  bi_is_inserted, bi_is_protected, bi_connect, bi_disconnect,
+  bi_read, bi_write, bi_sync, bi_get_info
+};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Disk image object initialization.
+ * @note    The object is not thread safe, the accesses must be serialized
+ *          by the caller as for the other block devices.
+ *
+ * @param[out] bip      pointer to the @p BlockImage object to be initialized
+ *
+ * @init
+ */
+void biObjectInit(BlockImage *bip) {
+
+  chDbgCheck(bip != NULL, "biObjectInit");
+
+  bip->vmt     = &vmt;
+  bip->state   = BLK_STOP;
+  bip->config  = NULL;
+  bip->fd      = -1;
+  bip->image   = NULL;
+  bip->blk_num = 0;
+  bip->debt    = 0;
+  biResetStats(bip);
+}
+
+/**
+ * @brief   Opens and maps a disk image.
+ * @details The image file is created or extended to the configured size
+ *          if necessary, the device is left in the @p BLK_ACTIVE state and
+ *          must be connected using @p blkConnect() before use.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ * @param[in] config    pointer to the @p BlockImageConfig object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    the image could not be opened or mapped.
+ *
+ * @api
+ */
+bool_t biOpen(BlockImage *bip, const BlockImageConfig *config) {
+
+  chDbgCheck((bip != NULL) && (config != NULL) && (config->path != NULL),
+             "biOpen");
+  chDbgAssert(bip->state == BLK_STOP, "biOpen(), #1", "invalid state");
+
+  bip->fd = open(config->path,
+                 config->read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+  if (bip->fd < 0)
+    return CH_FAILED;
+  if (map(bip, config)) {
+    close(bip->fd);
+    bip->fd = -1;
+    return CH_FAILED;
+  }
+  bip->config = config;
+  bip->debt   = 0;
+  bip->state  = BLK_ACTIVE;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Writes back and unmaps a disk image.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ *
+ * @api
+ */
+void biClose(BlockImage *bip) {
+
+  chDbgCheck(bip != NULL, "biClose");
+
+  if (bip->image != NULL) {
+    if (!bip->config->read_only)
+      msync(bip->image, image_size(bip), MS_SYNC);
+    munmap(bip->image, image_size(bip));
+    close(bip->fd);
+  }
+  bip->state  = BLK_STOP;
+  bip->config = NULL;
+  bip->fd     = -1;
+  bip->image  = NULL;
+}
+
+/** @} */
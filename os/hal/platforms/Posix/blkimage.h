@@ -0,0 +1,187 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/blkimage.h
+ * @brief   Posix disk image block device header.
+ *
+ * @addtogroup POSIX_BLKIMAGE
+ * @{
+ */
+
+#ifndef _BLKIMAGE_H_
+#define _BLKIMAGE_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the image blocks.
+ */
+#if !defined(BLOCK_IMAGE_BLOCK_SIZE) || defined(__DOXYGEN__)
+#define BLOCK_IMAGE_BLOCK_SIZE  512
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Disk image configuration.
+ * @details The timings model the simulated medium, each operation takes
+ *          the command latency plus the time required to move the data
+ *          at the specified bandwidth. The calling thread sleeps for the
+ *          modeled time so other threads can run meanwhile as they would
+ *          during a DMA transfer.
+ */
+typedef struct {
+  /**
+   * @brief Path of the image file.
+   */
+  const char            *path;
+  /**
+   * @brief Size of the image in blocks.
+   * @details The file is created or extended to this size, zero means
+   *          to use the size of an existing file.
+   */
+  uint32_t              blk_num;
+  /**
+   * @brief Image write protected.
+   */
+  bool_t                read_only;
+  /**
+   * @brief Read command latency in microseconds.
+   */
+  uint32_t              rd_latency;
+  /**
+   * @brief Write command latency in microseconds.
+   */
+  uint32_t              wr_latency;
+  /**
+   * @brief Data transfer bandwidth in bytes per second, zero means an
+   *        infinitely fast transfer.
+   */
+  uint32_t              bandwidth;
+} BlockImageConfig;
+
+/**
+ * @brief   Disk image statistics.
+ */
+typedef struct {
+  uint32_t              reads;      /**< @brief Read operations.            */
+  uint32_t              writes;     /**< @brief Write operations.           */
+  uint32_t              rdblocks;   /**< @brief Blocks read.                */
+  uint32_t              wrblocks;   /**< @brief Blocks written.             */
+  uint64_t              busy;       /**< @brief Modeled busy time in
+                                                microseconds.               */
+} BlockImageStats;
+
+/**
+ * @brief   @p BlockImage specific data.
+ */
+#define _block_image_data                                                   \
+  _base_block_device_data                                                   \
+  /* Current configuration or NULL if the image is closed.*/                \
+  const BlockImageConfig *config;                                           \
+  /* Image file descriptor.*/                                               \
+  int                   fd;                                                 \
+  /* Mapped image.*/                                                        \
+  uint8_t               *image;                                             \
+  /* Size of the image in blocks.*/                                         \
+  uint32_t              blk_num;                                            \
+  /* Modeled time not yet slept, in microseconds.*/                         \
+  uint64_t              debt;                                               \
+  /* Statistics.*/                                                          \
+  BlockImageStats       stats;
+
+/**
+ * @brief   @p BlockImage virtual methods table.
+ */
+struct BlockImageVMT {
+  _base_block_device_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   Disk image block device object.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct BlockImageVMT *vmt;
+  _block_image_data
+} BlockImage;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns a pointer to the image statistics.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ * @return              Pointer to a @p BlockImageStats structure.
+ *
+ * @api
+ */
+#define biGetStats(bip) (&(bip)->stats)
+
+/**
+ * @brief   Clears the image statistics.
+ *
+ * @param[in] bip       pointer to the @p BlockImage object
+ *
+ * @api
+ */
+#define biResetStats(bip) {                                                 \
+  (bip)->stats.reads    = 0;                                                \
+  (bip)->stats.writes   = 0;                                                \
+  (bip)->stats.rdblocks = 0;                                                \
+  (bip)->stats.wrblocks = 0;                                                \
+  (bip)->stats.busy     = 0;                                                \
+}
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void biObjectInit(BlockImage *bip);
+  bool_t biOpen(BlockImage *bip, const BlockImageConfig *config);
+  void biClose(BlockImage *bip);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLKIMAGE_H_ */
+
+/** @} */
@@ -82,6 +82,16 @@ void ChkIntSources(void) {
   }
 #endif
 
+#if HAL_USE_MAC
+  if (mac_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+    return;
+  }
+#endif
+
   gettimeofday(&tv, NULL);
   if (timercmp(&tv, &nextcnt, >=)) {
     timeradd(&nextcnt, &tick, &nextcnt);
@@ -0,0 +1,756 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/mac_lld.c
+ * @brief   Posix low level simulated MAC driver code.
+ * @details The driver simulates an Ethernet interface attached to a
+ *          virtual LAN made of UNIX datagram sockets, each datagram is
+ *          an Ethernet frame without preamble and FCS.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define BUFFER_SIZE ((((SIM_MAC_BUFFERS_SIZE - 1) | 3) + 1) / 4)
+
+#if MAC_USE_ZERO_COPY
+#define RX_HEADROOM (MAC_RECEIVE_HEADROOM / 4)
+#else
+#define RX_HEADROOM 0
+#endif
+
+/**
+ * @brief   Minimum frame size, an Ethernet header.
+ */
+#define ETH_HEADER_SIZE         14
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Ethernet driver 1.
+ */
+MACDriver ETHD1;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static const uint8_t default_mac_address[] = {0xAA, 0x55, 0x13,
+                                              0x37, 0x01, 0x10};
+
+static sim_eth_rx_descriptor_t rd[SIM_MAC_RECEIVE_BUFFERS];
+static sim_eth_tx_descriptor_t td[SIM_MAC_TRANSMIT_BUFFERS];
+
+#if MAC_USE_ZERO_COPY
+/* Receive buffers are preceded by the headroom area, the buffers exceeding
+   the number of descriptors are the spare ones.*/
+static uint32_t rb[SIM_MAC_RECEIVE_BUFFERS + SIM_MAC_RECEIVE_SPARE_BUFFERS]
+                  [RX_HEADROOM + BUFFER_SIZE];
+static MemoryPool rbpool;
+
+/* Frame assembled from transmitted segments.*/
+static uint32_t sgb[BUFFER_SIZE];
+#else
+static uint32_t rb[SIM_MAC_RECEIVE_BUFFERS][BUFFER_SIZE];
+#endif
+static uint32_t tb[SIM_MAC_TRANSMIT_BUFFERS][BUFFER_SIZE];
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds the name of the virtual LAN socket of an address.
+ *
+ * @param[out] sun      pointer to the socket address to be filled
+ * @param[in] p         pointer to a six bytes buffer containing the MAC
+ *                      address
+ */
+static void vlan_address(struct sockaddr_un *sun, const uint8_t *p) {
+
+  memset(sun, 0, sizeof (*sun));
+  sun->sun_family = AF_UNIX;
+  snprintf(sun->sun_path, sizeof (sun->sun_path),
+           "%s/%02x%02x%02x%02x%02x%02x", SIM_MAC_VLAN_PATH,
+           p[0], p[1], p[2], p[3], p[4], p[5]);
+}
+
+/**
+ * @brief   Appends a frame to the capture file.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the frame
+ * @param[in] n         frame size
+ */
+static void pcap_write(MACDriver *macp, const uint8_t *buf, size_t n) {
+  struct timeval tv;
+  uint32_t hdr[4];
+
+  if (macp->pcap == NULL)
+    return;
+
+  gettimeofday(&tv, NULL);
+  hdr[0] = (uint32_t)tv.tv_sec;
+  hdr[1] = (uint32_t)tv.tv_usec;
+  hdr[2] = (uint32_t)n;
+  hdr[3] = (uint32_t)n;
+  fwrite(hdr, sizeof (hdr), 1, macp->pcap);
+  fwrite(buf, n, 1, macp->pcap);
+  fflush(macp->pcap);
+}
+
+/**
+ * @brief   Opens the capture file and writes the pcap global header.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] name      capture file name
+ */
+static void pcap_open(MACDriver *macp, const char *name) {
+  static const uint32_t hdr[6] = {
+    0xA1B2C3D4,                     /* Magic number, native byte order.     */
+    0x00040002,                     /* Version 2.4.                         */
+    0,                              /* GMT offset.                          */
+    0,                              /* Timestamps accuracy.                 */
+    65535,                          /* Snapshot length.                     */
+    1                               /* Link type Ethernet.                  */
+  };
+
+  macp->pcap = fopen(name, "wb");
+  if (macp->pcap == NULL) {
+    printf("ETHD1: Error opening capture file %s\n", name);
+    return;
+  }
+  fwrite(hdr, sizeof (hdr), 1, macp->pcap);
+  fflush(macp->pcap);
+}
+
+/**
+ * @brief   Delivers a frame to the virtual LAN.
+ * @details Frames addressed to a known station are delivered to its socket
+ *          only, other frames are delivered to all the stations.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the frame
+ * @param[in] n         frame size
+ */
+static void vlan_send(MACDriver *macp, const uint8_t *buf, size_t n) {
+  struct sockaddr_un sun;
+  struct dirent *dep;
+  DIR *dirp;
+  unsigned delivered = 0;
+  char self[16];
+
+  pcap_write(macp, buf, n);
+  macp->txframes++;
+
+  /* Unicast frames are sent directly to the destination station if it is
+     part of the LAN.*/
+  if ((buf[0] & 1) == 0) {
+    vlan_address(&sun, buf);
+    if (sendto(macp->sock, buf, n, MSG_DONTWAIT,
+               (struct sockaddr *)&sun, sizeof (sun)) == (ssize_t)n)
+      return;
+    if ((errno != ENOENT) && (errno != ECONNREFUSED)) {
+      macp->txdrops++;
+      return;
+    }
+  }
+
+  /* Flooding.*/
+  snprintf(self, sizeof (self), "%02x%02x%02x%02x%02x%02x",
+           macp->address[0], macp->address[1], macp->address[2],
+           macp->address[3], macp->address[4], macp->address[5]);
+  dirp = opendir(SIM_MAC_VLAN_PATH);
+  if (dirp != NULL) {
+    while ((dep = readdir(dirp)) != NULL) {
+      /* Stations are named after their 12 digits MAC address.*/
+      if ((strlen(dep->d_name) != 12) || (strcmp(dep->d_name, self) == 0))
+        continue;
+      memset(&sun, 0, sizeof (sun));
+      sun.sun_family = AF_UNIX;
+      snprintf(sun.sun_path, sizeof (sun.sun_path), "%s/%.12s",
+               SIM_MAC_VLAN_PATH, dep->d_name);
+      if (sendto(macp->sock, buf, n, MSG_DONTWAIT,
+                 (struct sockaddr *)&sun, sizeof (sun)) == (ssize_t)n)
+        delivered++;
+    }
+    closedir(dirp);
+  }
+  if (delivered == 0)
+    macp->txdrops++;
+}
+
+/**
+ * @brief   Checks if a received frame is addressed to the interface.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the frame
+ * @return              The filter result.
+ * @retval TRUE         if the frame is accepted.
+ * @retval FALSE        if the frame must be discarded.
+ */
+static bool_t rx_filter(MACDriver *macp, const uint8_t *buf) {
+
+  return ((buf[0] & 1) != 0) || (memcmp(buf, macp->address, 6) == 0);
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level MAC initialization.
+ *
+ * @notapi
+ */
+void mac_lld_init(void) {
+  unsigned i;
+
+  macObjectInit(&ETHD1);
+  ETHD1.link_up = FALSE;
+  ETHD1.sock    = INVALID_SOCKET;
+  ETHD1.pcap    = NULL;
+
+  for (i = 0; i < SIM_MAC_RECEIVE_BUFFERS; i++)
+    rd[i].buf = (uint8_t *)&rb[i][RX_HEADROOM];
+  for (i = 0; i < SIM_MAC_TRANSMIT_BUFFERS; i++)
+    td[i].buf = (uint8_t *)tb[i];
+#if MAC_USE_ZERO_COPY
+  chPoolInit(&rbpool, sizeof rb[0], NULL);
+  chPoolLoadArray(&rbpool, rb[SIM_MAC_RECEIVE_BUFFERS],
+                  SIM_MAC_RECEIVE_SPARE_BUFFERS);
+#endif
+}
+
+/**
+ * @brief   Configures and activates the MAC peripheral.
+ * @details The interface joins the virtual LAN.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_start(MACDriver *macp) {
+  struct sockaddr_un sun;
+  const char *pcap;
+  unsigned i;
+
+  /* Resets the state of all descriptors.*/
+  for (i = 0; i < SIM_MAC_RECEIVE_BUFFERS; i++)
+    rd[i].own = TRUE;
+  for (i = 0; i < SIM_MAC_TRANSMIT_BUFFERS; i++)
+    td[i].locked = FALSE;
+  macp->rxdma    = 0;
+  macp->rxptr    = 0;
+  macp->txptr    = 0;
+  macp->rxframes = 0;
+  macp->txframes = 0;
+  macp->txdrops  = 0;
+
+  /* MAC address setup.*/
+  if (macp->config->mac_address == NULL)
+    memcpy(macp->address, default_mac_address, 6);
+  else
+    memcpy(macp->address, macp->config->mac_address, 6);
+
+  /* Virtual LAN socket, a stale socket with the same name is replaced.*/
+  mkdir(SIM_MAC_VLAN_PATH, 0777);
+  vlan_address(&sun, macp->address);
+  unlink(sun.sun_path);
+  macp->sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (macp->sock == INVALID_SOCKET) {
+    printf("ETHD1: Error creating simulator socket\n");
+    exit(1);
+  }
+  if (bind(macp->sock, (struct sockaddr *)&sun, sizeof (sun)) != 0) {
+    printf("ETHD1: Error binding socket %s\n", sun.sun_path);
+    close(macp->sock);
+    exit(1);
+  }
+  printf("Ethernet interface ETHD1 attached to %s\n", sun.sun_path);
+
+  /* Optional capture.*/
+  pcap = macp->config->pcap_file != NULL ? macp->config->pcap_file :
+                                           SIM_MAC_PCAP_FILE;
+  if (pcap != NULL)
+    pcap_open(macp, pcap);
+
+  macp->link_up = TRUE;
+}
+
+/**
+ * @brief   Deactivates the MAC peripheral.
+ * @details The interface leaves the virtual LAN.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_stop(MACDriver *macp) {
+  struct sockaddr_un sun;
+
+  if (macp->state != MAC_STOP) {
+    macp->link_up = FALSE;
+    close(macp->sock);
+    macp->sock = INVALID_SOCKET;
+    vlan_address(&sun, macp->address);
+    unlink(sun.sun_path);
+    if (macp->pcap != NULL) {
+      fclose(macp->pcap);
+      macp->pcap = NULL;
+    }
+  }
+}
+
+/**
+ * @brief   Returns a transmission descriptor.
+ * @details One of the available transmission descriptors is locked and
+ *          returned.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] tdp      pointer to a @p MACTransmitDescriptor structure
+ * @return              The operation status.
+ * @retval RDY_OK       the descriptor has been obtained.
+ * @retval RDY_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                      MACTransmitDescriptor *tdp) {
+  sim_eth_tx_descriptor_t *tdes;
+
+  if (!macp->link_up)
+    return RDY_TIMEOUT;
+
+  chSysLock();
+
+  /* Get Current TX descriptor, it must not be locked by another thread.*/
+  tdes = &td[macp->txptr];
+  if (tdes->locked) {
+    chSysUnlock();
+    return RDY_TIMEOUT;
+  }
+  tdes->locked = TRUE;
+  macp->txptr = (macp->txptr + 1) % SIM_MAC_TRANSMIT_BUFFERS;
+
+  chSysUnlock();
+
+  tdp->offset   = 0;
+  tdp->size     = SIM_MAC_BUFFERS_SIZE;
+  tdp->physdesc = tdes;
+
+  return RDY_OK;
+}
+
+/**
+ * @brief   Releases a transmit descriptor and starts the transmission of the
+ *          enqueued data as a single frame.
+ * @note    The simulated transmission is synchronous.
+ *
+ * @param[in] tdp       the pointer to the @p MACTransmitDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp) {
+
+  chDbgAssert(tdp->physdesc->locked,
+              "mac_lld_release_transmit_descriptor(), #1",
+              "descriptor not locked");
+
+  if (tdp->offset >= ETH_HEADER_SIZE)
+    vlan_send(&ETHD1, tdp->physdesc->buf, tdp->offset);
+
+  chSysLock();
+  tdp->physdesc->locked = FALSE;
+  chSemResetI(&ETHD1.tdsem, 0);
+#if MAC_USE_EVENTS
+  chEvtBroadcastI(&ETHD1.tdevent);
+#endif
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns a receive descriptor.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] rdp      pointer to a @p MACReceiveDescriptor structure
+ * @return              The operation status.
+ * @retval RDY_OK       the descriptor has been obtained.
+ * @retval RDY_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                     MACReceiveDescriptor *rdp) {
+  sim_eth_rx_descriptor_t *rdes;
+
+  chSysLock();
+
+  /* Get Current RX descriptor.*/
+  rdes = &rd[macp->rxptr];
+  if (rdes->own) {
+    chSysUnlock();
+    return RDY_TIMEOUT;
+  }
+  macp->rxptr = (macp->rxptr + 1) % SIM_MAC_RECEIVE_BUFFERS;
+
+  chSysUnlock();
+
+  rdp->offset   = 0;
+  rdp->size     = rdes->size;
+  rdp->physdesc = rdes;
+
+  return RDY_OK;
+}
+
+/**
+ * @brief   Releases a receive descriptor.
+ * @details The descriptor and its buffer are made available for more incoming
+ *          frames.
+ *
+ * @param[in] rdp       the pointer to the @p MACReceiveDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp) {
+
+  chDbgAssert(!rdp->physdesc->own,
+              "mac_lld_release_receive_descriptor(), #1",
+              "attempt to release descriptor already owned by DMA");
+
+  chSysLock();
+  rdp->physdesc->own = TRUE;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Updates and returns the link status.
+ * @note    The link is up while the driver is active.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The link status.
+ * @retval TRUE         if the link is active.
+ * @retval FALSE        if the link is down.
+ *
+ * @notapi
+ */
+bool_t mac_lld_poll_link_status(MACDriver *macp) {
+
+  return macp->link_up;
+}
+
+/**
+ * @brief   Writes to a transmit descriptor's stream.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] buf       pointer to the buffer containing the data to be
+ *                      written
+ * @param[in] size      number of bytes to be written
+ * @return              The number of bytes written into the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if the maximum
+ *                      frame size is reached.
+ *
+ * @notapi
+ */
+size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                         uint8_t *buf,
+                                         size_t size) {
+
+  if (size > tdp->size - tdp->offset)
+    size = tdp->size - tdp->offset;
+
+  if (size > 0) {
+    memcpy(tdp->physdesc->buf + tdp->offset, buf, size);
+    tdp->offset += size;
+  }
+  return size;
+}
+
+/**
+ * @brief   Reads from a receive descriptor's stream.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[in] buf       pointer to the buffer that will receive the read data
+ * @param[in] size      number of bytes to be read
+ * @return              The number of bytes read from the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if there are
+ *                      no more bytes to read.
+ *
+ * @notapi
+ */
+size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                       uint8_t *buf,
+                                       size_t size) {
+
+  if (size > rdp->size - rdp->offset)
+    size = rdp->size - rdp->offset;
+
+  if (size > 0) {
+    memcpy(buf, rdp->physdesc->buf + rdp->offset, size);
+    rdp->offset += size;
+  }
+  return size;
+}
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns a pointer to the next transmit buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that enough buffers can be requested to fill
+ *          a whole frame.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] size      size of the requested buffer. Specify the frame size
+ *                      on the first call then scale the value down subtracting
+ *                      the amount of data already copied into the previous
+ *                      buffers.
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ *                      Note that a returned size lower than the amount
+ *                      requested means that more buffers must be requested
+ *                      in order to fill the frame data entirely.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                          size_t size,
+                                          size_t *sizep) {
+
+  if (tdp->offset == 0) {
+    *sizep      = tdp->size;
+    tdp->offset = size;
+    return tdp->physdesc->buf;
+  }
+  *sizep = 0;
+  return NULL;
+}
+
+/**
+ * @brief   Returns a pointer to the next receive buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that the descriptor chain contains a whole
+ *          frame.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                               size_t *sizep) {
+
+  if (rdp->size > 0) {
+    *sizep      = rdp->size;
+    rdp->offset = rdp->size;
+    rdp->size   = 0;
+    return rdp->physdesc->buf;
+  }
+  *sizep = 0;
+  return NULL;
+}
+
+/**
+ * @brief   Takes ownership of the buffer of a received frame.
+ * @details The frame buffer is detached from the descriptor and replaced
+ *          with a spare buffer.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the frame size
+ * @return              Pointer to the loaned buffer.
+ * @retval NULL         if no spare buffers are available.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                     size_t *sizep) {
+  uint32_t *spare;
+  uint8_t *buf;
+
+  spare = chPoolAlloc(&rbpool);
+  if (spare == NULL)
+    return NULL;
+
+  buf = (uint8_t *)mac_lld_get_next_receive_buffer(rdp, sizep);
+  chDbgAssert(buf != NULL, "mac_lld_loan_receive_buffer(), #1",
+              "descriptor already read");
+  rdp->physdesc->buf = (uint8_t *)&spare[RX_HEADROOM];
+  return buf;
+}
+
+/**
+ * @brief   Gives back a loaned receive buffer.
+ * @details The buffer becomes a spare buffer again.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the loaned buffer
+ *
+ * @notapi
+ */
+void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf) {
+
+  (void)macp;
+
+  chPoolFree(&rbpool, (uint32_t *)buf - RX_HEADROOM);
+}
+
+/**
+ * @brief   Queues a frame made of scattered segments for transmission.
+ * @details The simulated transmission is synchronous, the release callback
+ *          is invoked before returning.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] segp      pointer to an array of @p MACTransmitSegment
+ * @param[in] n         number of segments
+ * @param[in] cb        release callback
+ * @param[in] arg       argument for the release callback
+ * @return              The operation status.
+ * @retval RDY_OK       the frame has been transmitted.
+ * @retval RDY_TIMEOUT  link down.
+ * @retval RDY_RESET    the frame exceeds the maximum frame size.
+ *
+ * @notapi
+ */
+msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                const MACTransmitSegment *segp,
+                                unsigned n,
+                                macreleasecb_t cb,
+                                void *arg) {
+  uint8_t *p = (uint8_t *)sgb;
+  size_t size = 0;
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+    size += segp[i].size;
+  if ((size < ETH_HEADER_SIZE) || (size > SIM_MAC_BUFFERS_SIZE))
+    return RDY_RESET;
+
+  if (!macp->link_up)
+    return RDY_TIMEOUT;
+
+  /* The socket interface requires the frame in a single buffer.*/
+  chSysLock();
+  for (i = 0; i < n; i++) {
+    memcpy(p, segp[i].buf, segp[i].size);
+    p += segp[i].size;
+  }
+  vlan_send(macp, (uint8_t *)sgb, size);
+  chSysUnlock();
+
+  cb(arg);
+  return RDY_OK;
+}
+
+/**
+ * @brief   Invokes the release callbacks of the transmitted frames.
+ * @note    Nothing to do, the callbacks are invoked on transmission.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_reclaim_transmit_segments(MACDriver *macp) {
+
+  (void)macp;
+}
+#endif /* MAC_USE_ZERO_COPY */
+
+/**
+ * @brief   Interrupt simulation.
+ * @details Frames waiting in the virtual LAN socket are moved into the
+ *          free receive descriptors.
+ *
+ * @return              The interrupt status.
+ * @retval TRUE         if frames have been received.
+ * @retval FALSE        if there was nothing to do.
+ */
+bool_t mac_lld_interrupt_pending(void) {
+  MACDriver *macp = &ETHD1;
+  sim_eth_rx_descriptor_t *rdes;
+  bool_t received = FALSE;
+  ssize_t n;
+
+  if (macp->sock == INVALID_SOCKET)
+    return FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+  /* Frames are left in the socket while there are no free descriptors.*/
+  while ((rdes = &rd[macp->rxdma])->own) {
+    n = recv(macp->sock, rdes->buf, SIM_MAC_BUFFERS_SIZE,
+             MSG_DONTWAIT | MSG_TRUNC);
+    if (n < 0)
+      break;
+    if ((n < ETH_HEADER_SIZE) || (n > SIM_MAC_BUFFERS_SIZE) ||
+        !rx_filter(macp, rdes->buf))
+      continue;
+    pcap_write(macp, rdes->buf, (size_t)n);
+    macp->rxframes++;
+    rdes->size  = (size_t)n;
+    rdes->own   = FALSE;
+    macp->rxdma = (macp->rxdma + 1) % SIM_MAC_RECEIVE_BUFFERS;
+    received = TRUE;
+  }
+
+  if (received) {
+    chSysLockFromIsr();
+    chSemResetI(&macp->rdsem, 0);
+#if MAC_USE_EVENTS
+    chEvtBroadcastI(&macp->rdevent);
+#endif
+    chSysUnlockFromIsr();
+  }
+
+  CH_IRQ_EPILOGUE();
+
+  return received;
+}
+
+#endif /* HAL_USE_MAC */
+
+/** @} */
@@ -0,0 +1,336 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/mac_lld.h
+ * @brief   Posix low level simulated MAC driver header.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#ifndef _MAC_LLD_H_
+#define _MAC_LLD_H_
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+#include <stdio.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This implementation supports the zero-copy mode API.
+ */
+#define MAC_SUPPORTS_ZERO_COPY      TRUE
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Number of available transmit buffers.
+ */
+#if !defined(SIM_MAC_TRANSMIT_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_TRANSMIT_BUFFERS            2
+#endif
+
+/**
+ * @brief   Number of available receive buffers.
+ */
+#if !defined(SIM_MAC_RECEIVE_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_RECEIVE_BUFFERS             4
+#endif
+
+/**
+ * @brief   Number of spare receive buffers.
+ * @details Spare buffers replace the receive buffers loaned to the upper
+ *          layers using @p macLoanReceiveBuffer(). This setting is only
+ *          meaningful when @p MAC_USE_ZERO_COPY is enabled.
+ */
+#if !defined(SIM_MAC_RECEIVE_SPARE_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_RECEIVE_SPARE_BUFFERS       4
+#endif
+
+/**
+ * @brief   Maximum supported frame size.
+ */
+#if !defined(SIM_MAC_BUFFERS_SIZE) || defined(__DOXYGEN__)
+#define SIM_MAC_BUFFERS_SIZE                1522
+#endif
+
+/**
+ * @brief   Directory of the virtual LAN.
+ * @details Each simulated interface binds a UNIX datagram socket named
+ *          after its MAC address into this directory, frames are
+ *          delivered to the socket of the destination address or to all
+ *          the sockets in the directory for broadcast, multicast and
+ *          unknown destinations. Other simulator instances or host test
+ *          programs binding a socket in the same directory are part of
+ *          the same LAN.
+ */
+#if !defined(SIM_MAC_VLAN_PATH) || defined(__DOXYGEN__)
+#define SIM_MAC_VLAN_PATH                   "/tmp/chibios_vlan"
+#endif
+
+/**
+ * @brief   Default capture file.
+ * @details If not @p NULL the frames are captured in a pcap file when the
+ *          configuration does not specify a capture file.
+ */
+#if !defined(SIM_MAC_PCAP_FILE) || defined(__DOXYGEN__)
+#define SIM_MAC_PCAP_FILE                   NULL
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if MAC_USE_ZERO_COPY && !CH_USE_MEMPOOLS
+#error "MAC_USE_ZERO_COPY requires CH_USE_MEMPOOLS"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a simulated receive descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Descriptor owned by the simulated DMA, waiting for a frame.
+   */
+  bool_t                own;
+  /**
+   * @brief Size of the received frame.
+   */
+  size_t                size;
+  /**
+   * @brief Descriptor buffer.
+   */
+  uint8_t               *buf;
+} sim_eth_rx_descriptor_t;
+
+/**
+ * @brief   Type of a simulated transmit descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Descriptor locked by a thread.
+   */
+  bool_t                locked;
+  /**
+   * @brief Descriptor buffer.
+   */
+  uint8_t               *buf;
+} sim_eth_tx_descriptor_t;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief MAC address.
+   */
+  uint8_t               *mac_address;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Capture file name or @p NULL.
+   * @details Received and transmitted frames are appended to the file in
+   *          pcap format, if @p NULL then @p SIM_MAC_PCAP_FILE is used.
+   */
+  const char            *pcap_file;
+} MACConfig;
+
+/**
+ * @brief   Structure representing a MAC driver.
+ */
+struct MACDriver {
+  /**
+   * @brief Driver state.
+   */
+  macstate_t            state;
+  /**
+   * @brief Current configuration data.
+   */
+  const MACConfig       *config;
+  /**
+   * @brief Transmit semaphore.
+   */
+  Semaphore             tdsem;
+  /**
+   * @brief Receive semaphore.
+   */
+  Semaphore             rdsem;
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+  /**
+   * @brief Receive event.
+   */
+  EventSource           rdevent;
+  /**
+   * @brief Transmit event.
+   */
+  EventSource           tdevent;
+  /**
+   * @brief Link status change event.
+   */
+  EventSource           lsevent;
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Link status flag.
+   */
+  bool_t                link_up;
+  /**
+   * @brief Virtual LAN socket.
+   */
+  SOCKET                sock;
+  /**
+   * @brief Capture file or @p NULL.
+   */
+  FILE                  *pcap;
+  /**
+   * @brief Interface MAC address.
+   */
+  uint8_t               address[6];
+  /**
+   * @brief Next descriptor to be filled by the simulated DMA.
+   */
+  unsigned              rxdma;
+  /**
+   * @brief Receive next frame index.
+   */
+  unsigned              rxptr;
+  /**
+   * @brief Transmit next frame index.
+   */
+  unsigned              txptr;
+  /**
+   * @brief Frames received.
+   */
+  uint32_t              rxframes;
+  /**
+   * @brief Frames transmitted.
+   */
+  uint32_t              txframes;
+  /**
+   * @brief Frames not delivered to any peer.
+   */
+  uint32_t              txdrops;
+};
+
+/**
+ * @brief   Structure representing a transmit descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Current write offset.
+   */
+  size_t                offset;
+  /**
+   * @brief Available space size.
+   */
+  size_t                size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Pointer to the physical descriptor.
+   */
+  sim_eth_tx_descriptor_t *physdesc;
+} MACTransmitDescriptor;
+
+/**
+ * @brief   Structure representing a receive descriptor.
+ */
+typedef struct {
+  /**
+   * @brief Current read offset.
+   */
+  size_t                offset;
+  /**
+   * @brief Available data size.
+   */
+  size_t                size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Pointer to the physical descriptor.
+   */
+  sim_eth_rx_descriptor_t *physdesc;
+} MACReceiveDescriptor;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern MACDriver ETHD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void mac_lld_init(void);
+  void mac_lld_start(MACDriver *macp);
+  void mac_lld_stop(MACDriver *macp);
+  msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                        MACTransmitDescriptor *tdp);
+  void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp);
+  msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                       MACReceiveDescriptor *rdp);
+  void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp);
+  bool_t mac_lld_poll_link_status(MACDriver *macp);
+  size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                           uint8_t *buf,
+                                           size_t size);
+  size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                         uint8_t *buf,
+                                         size_t size);
+#if MAC_USE_ZERO_COPY
+  uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                            size_t size,
+                                            size_t *sizep);
+  const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                                 size_t *sizep);
+  uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                       size_t *sizep);
+  void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf);
+  msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                  const MACTransmitSegment *segp,
+                                  unsigned n,
+                                  macreleasecb_t cb,
+                                  void *arg);
+  void mac_lld_reclaim_transmit_segments(MACDriver *macp);
+#endif /* MAC_USE_ZERO_COPY */
+  bool_t mac_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_MAC */
+
+#endif /* _MAC_LLD_H_ */
+
+/** @} */
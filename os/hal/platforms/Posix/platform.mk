@@ -1,6 +1,9 @@
 # List of all the Posix platform files.
 PLATFORMSRC = ${CHIBIOS}/os/hal/platforms/Posix/hal_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/blkimage.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/mac_lld.c \
               ${CHIBIOS}/os/hal/platforms/Posix/pal_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/sdc_lld.c \
               ${CHIBIOS}/os/hal/platforms/Posix/serial_lld.c
 
 # Required include directories
@@ -0,0 +1,583 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/sdc_lld.c
+ * @brief   Posix low level simulated SDC driver code.
+ * @details The driver simulates an high capacity SD card stored in RAM, it
+ *          allows to exercise the SDC driver and its users on the host.
+ *
+ * @addtogroup POSIX_SDC
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_SDC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   RCA assigned to the simulated card.
+ */
+#define SIM_RCA                 0x12340000
+
+/**
+ * @brief   R1 ready for data flag.
+ */
+#define SIM_R1_READY_FOR_DATA   (1 << 8)
+
+/**
+ * @brief   R1 application command flag.
+ */
+#define SIM_R1_APP_CMD          (1 << 5)
+
+/**
+ * @brief   R1 erase sequence error flag.
+ */
+#define SIM_R1_ERASE_SEQ_ERROR  (1 << 28)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   SDCD1 driver identifier.
+ */
+#if PLATFORM_SDC_USE_SDC1 || defined(__DOXYGEN__)
+SDCDriver SDCD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+#if PLATFORM_SDC_USE_SDC1 || defined(__DOXYGEN__)
+/**
+ * @brief   Storage of the card simulated by SDCD1.
+ */
+static uint8_t sdc1_storage[SDC_SIM_CAPACITY * MMCSD_BLOCK_SIZE];
+#endif
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds an R1 response from the simulated card state.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @return              The R1 response.
+ */
+static uint32_t sim_r1(SDCDriver *sdcp) {
+  uint32_t state = sdcp->sim_state;
+
+  if ((state == MMCSD_STS_TRAN) && (sdcp->sim_busy > 0)) {
+    sdcp->sim_busy--;
+    state = MMCSD_STS_PRG;
+  }
+  return (state << 9) | SIM_R1_READY_FOR_DATA |
+         (sdcp->sim_appcmd ? SIM_R1_APP_CMD : 0);
+}
+
+/**
+ * @brief   Checks a transfer range.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block
+ * @param[in] n         number of blocks
+ * @return              The operation status.
+ * @retval CH_SUCCESS   valid range.
+ * @retval CH_FAILED    invalid range or card not in transfer state.
+ */
+static bool_t sim_check(SDCDriver *sdcp, uint32_t startblk, uint32_t n) {
+
+  if ((sdcp->sim_state != MMCSD_STS_TRAN) ||
+      (startblk >= SDC_SIM_CAPACITY) || (n > SDC_SIM_CAPACITY - startblk)) {
+    sdcp->errors |= SDC_DATA_TIMEOUT;
+    return CH_FAILED;
+  }
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Checks the bus settings before a data transfer.
+ * @details Host and card must agree on bus width and timing, a mismatch
+ *          is reported as a data CRC error like a real card would do.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ */
+static bool_t sim_bus_check(SDCDriver *sdcp) {
+
+  if (((sdcp->sim_bus == SDC_MODE_4BIT) != sdcp->sim_card_wide) ||
+      ((sdcp->sim_clk == SDC_CLK_50MHz) && !sdcp->sim_card_hs)) {
+    sdcp->errors |= SDC_DATA_CRC_ERROR;
+    return CH_FAILED;
+  }
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Resets the card side bus settings.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ */
+static void sim_bus_reset(SDCDriver *sdcp) {
+
+  sdcp->sim_card_wide = FALSE;
+  sdcp->sim_card_hs   = FALSE;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level SDC driver initialization.
+ *
+ * @notapi
+ */
+void sdc_lld_init(void) {
+
+#if PLATFORM_SDC_USE_SDC1
+  sdcObjectInit(&SDCD1);
+  SDCD1.sim_state     = MMCSD_STS_IDLE;
+  SDCD1.sim_appcmd    = FALSE;
+  SDCD1.sim_busy      = 0;
+  SDCD1.sim_clk       = SDC_CLK_25MHz;
+  SDCD1.sim_bus       = SDC_MODE_1BIT;
+  SDCD1.sim_card_wide = FALSE;
+  SDCD1.sim_card_hs   = FALSE;
+  SDCD1.sim_protected = FALSE;
+  SDCD1.sim_reads     = 0;
+  SDCD1.sim_writes    = 0;
+  SDCD1.sim_storage   = sdc1_storage;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the SDC peripheral.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_start(SDCDriver *sdcp) {
+
+  (void)sdcp;
+}
+
+/**
+ * @brief   Deactivates the SDC peripheral.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_stop(SDCDriver *sdcp) {
+
+  (void)sdcp;
+}
+
+/**
+ * @brief   Starts the SDIO clock and sets it to init mode (400kHz or less).
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_start_clk(SDCDriver *sdcp) {
+
+  sdcp->sim_clk = SDC_CLK_25MHz;
+  sdcp->sim_bus = SDC_MODE_1BIT;
+}
+
+/**
+ * @brief   Sets the SDIO clock to data mode.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] clk       the clock mode
+ *
+ * @notapi
+ */
+void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk) {
+
+  sdcp->sim_clk = clk;
+}
+
+/**
+ * @brief   Stops the SDIO clock.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @notapi
+ */
+void sdc_lld_stop_clk(SDCDriver *sdcp) {
+
+  (void)sdcp;
+}
+
+/**
+ * @brief   Switches the bus to 4 bits mode.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] mode      bus mode
+ *
+ * @notapi
+ */
+void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode) {
+
+  sdcp->sim_bus = mode;
+}
+
+/**
+ * @brief   Sends an SDIO command with no response expected.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ *
+ * @notapi
+ */
+void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg) {
+
+  (void)arg;
+
+  if (cmd == MMCSD_CMD_GO_IDLE_STATE) {
+    sdcp->sim_state = MMCSD_STS_IDLE;
+    sdcp->sim_busy  = 0;
+    sim_bus_reset(sdcp);
+  }
+  sdcp->sim_appcmd = FALSE;
+}
+
+/**
+ * @brief   Sends an SDIO command with a short response expected.
+ * @note    The CRC is not verified.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (one word)
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_send_cmd_short(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                              uint32_t *resp) {
+
+  (void)arg;
+
+  /* Only the ACMD41 response has no CRC, the card is immediately ready and
+     reports high capacity.*/
+  if ((cmd != MMCSD_CMD_APP_OP_COND) || !sdcp->sim_appcmd) {
+    sdcp->sim_appcmd = FALSE;
+    sdcp->errors |= SDC_COMMAND_TIMEOUT;
+    return CH_FAILED;
+  }
+  sdcp->sim_appcmd = FALSE;
+  sdcp->sim_state  = MMCSD_STS_READY;
+  *resp = 0xC0FF8000;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Sends an SDIO command with a short response expected and CRC.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (one word)
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_send_cmd_short_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                  uint32_t *resp) {
+  bool_t appcmd = sdcp->sim_appcmd;
+
+  sdcp->sim_appcmd = FALSE;
+  switch (cmd) {
+  case MMCSD_CMD_SEND_IF_COND:
+    /* Voltage accepted, check pattern echoed.*/
+    *resp = arg & 0xFFF;
+    return CH_SUCCESS;
+  case MMCSD_CMD_APP_CMD:
+    sdcp->sim_appcmd = TRUE;
+    *resp = sim_r1(sdcp);
+    return CH_SUCCESS;
+  case MMCSD_CMD_SEND_RELATIVE_ADDR:
+    sdcp->sim_state = MMCSD_STS_STBY;
+    *resp = SIM_RCA;
+    return CH_SUCCESS;
+  case MMCSD_CMD_SEL_DESEL_CARD:
+    *resp = sim_r1(sdcp);
+    sdcp->sim_state = MMCSD_STS_TRAN;
+    return CH_SUCCESS;
+  case MMCSD_CMD_SET_BUS_WIDTH:
+    if (!appcmd)
+      break;
+    sdcp->sim_card_wide = (arg & 3) == 2;
+    *resp = sim_r1(sdcp);
+    return CH_SUCCESS;
+  case MMCSD_CMD_SET_BLOCKLEN:
+  case MMCSD_CMD_SEND_STATUS:
+    *resp = sim_r1(sdcp);
+    return CH_SUCCESS;
+  case MMCSD_CMD_ERASE_RW_BLK_START:
+    sdcp->sim_erase_start = arg;
+    *resp = sim_r1(sdcp);
+    return CH_SUCCESS;
+  case MMCSD_CMD_ERASE_RW_BLK_END:
+    sdcp->sim_erase_end = arg;
+    *resp = sim_r1(sdcp);
+    return CH_SUCCESS;
+  case MMCSD_CMD_ERASE:
+    if ((sdcp->sim_erase_start > sdcp->sim_erase_end) ||
+        sim_check(sdcp, sdcp->sim_erase_start,
+                  sdcp->sim_erase_end - sdcp->sim_erase_start + 1)) {
+      *resp = sim_r1(sdcp) | SIM_R1_ERASE_SEQ_ERROR;
+      return CH_SUCCESS;
+    }
+    memset(sdcp->sim_storage + sdcp->sim_erase_start * MMCSD_BLOCK_SIZE, 0,
+           (sdcp->sim_erase_end - sdcp->sim_erase_start + 1) *
+           MMCSD_BLOCK_SIZE);
+    *resp = sim_r1(sdcp);
+    sdcp->sim_busy = SDC_SIM_BUSY_POLLS;
+    return CH_SUCCESS;
+  }
+  sdcp->errors |= SDC_COMMAND_TIMEOUT;
+  return CH_FAILED;
+}
+
+/**
+ * @brief   Sends an SDIO command with a long response expected and CRC.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ * @param[out] resp     pointer to the response buffer (four words)
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                 uint32_t *resp) {
+
+  (void)arg;
+
+  sdcp->sim_appcmd = FALSE;
+  switch (cmd) {
+  case MMCSD_CMD_ALL_SEND_CID:
+    sdcp->sim_state = MMCSD_STS_IDENT;
+    resp[0] = 0x00000001;
+    resp[1] = 0x12345678;
+    resp[2] = 0x4D495300;           /* Product name "SIM".                  */
+    resp[3] = 0x00434800;           /* OEM "CH".                            */
+    return CH_SUCCESS;
+  case MMCSD_CMD_SEND_CSD:
+    /* CSD version 2.0, C_SIZE is bits 69..48, READ_BL_LEN is bits 83..80.*/
+    resp[0] = 0x00000001;
+    resp[1] = ((uint32_t)(SDC_SIM_CAPACITY / 1024 - 1) & 0xFFFF) << 16;
+    resp[2] = (9 << 16) | ((uint32_t)(SDC_SIM_CAPACITY / 1024 - 1) >> 16);
+    resp[3] = 0x40000000;
+    return CH_SUCCESS;
+  }
+  sdcp->errors |= SDC_COMMAND_TIMEOUT;
+  return CH_FAILED;
+}
+
+/**
+ * @brief   Reads a special register using a data transfer.
+ * @details The SCR and the CMD6 switch status are simulated.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] bytes     number of bytes to read
+ * @param[in] cmd       card command
+ * @param[in] arg       argument for the command
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                            uint8_t cmd, uint32_t arg) {
+  bool_t appcmd = sdcp->sim_appcmd;
+
+  sdcp->sim_appcmd = FALSE;
+  if (sdcp->sim_state != MMCSD_STS_TRAN) {
+    sdcp->errors |= SDC_DATA_TIMEOUT;
+    return CH_FAILED;
+  }
+  if (sim_bus_check(sdcp))
+    return CH_FAILED;
+  memset(buf, 0, bytes);
+  if ((cmd == MMCSD_CMD_SEND_SCR) && appcmd && (bytes == MMCSD_SCR_SIZE)) {
+    /* Specification version 2.00, 1 and 4 bits bus widths.*/
+    buf[0] = 0x02;
+    buf[1] = 0x05;
+    return CH_SUCCESS;
+  }
+  if ((cmd == MMCSD_CMD_SWITCH) && !appcmd &&
+      (bytes == MMCSD_SWITCH_STATUS_SIZE)) {
+    /* Access mode group, functions supported and function selected.*/
+    buf[13] = SDC_SIM_HIGH_SPEED ? 0x03 : 0x01;
+    if (((arg & 0x0F) == 1) && SDC_SIM_HIGH_SPEED) {
+      buf[16] = 0x01;
+      if (arg & 0x80000000)
+        sdcp->sim_card_hs = TRUE;
+    }
+    else
+      buf[16] = 0x0F;
+    return CH_SUCCESS;
+  }
+  sdcp->errors |= SDC_DATA_TIMEOUT;
+  return CH_FAILED;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to read
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
+                    uint8_t *buf, uint32_t n) {
+
+  if (_sdc_wait_for_transfer_state(sdcp) || sim_bus_check(sdcp) ||
+      sim_check(sdcp, startblk, n))
+    return CH_FAILED;
+
+  memcpy(buf, sdcp->sim_storage + startblk * MMCSD_BLOCK_SIZE,
+         n * MMCSD_BLOCK_SIZE);
+  sdcp->sim_reads++;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to write
+ * @param[out] buf      pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
+                     const uint8_t *buf, uint32_t n) {
+
+  if (_sdc_wait_for_transfer_state(sdcp) || sim_bus_check(sdcp) ||
+      sim_check(sdcp, startblk, n))
+    return CH_FAILED;
+
+  memcpy(sdcp->sim_storage + startblk * MMCSD_BLOCK_SIZE, buf,
+         n * MMCSD_BLOCK_SIZE);
+  sdcp->sim_writes++;
+
+  /* The card is programming after the data transfer.*/
+  sdcp->sim_busy = SDC_SIM_BUSY_POLLS;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Waits for card idle condition.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the operation failed.
+ *
+ * @api
+ */
+bool_t sdc_lld_sync(SDCDriver *sdcp) {
+
+  return _sdc_wait_for_transfer_state(sdcp);
+}
+
+/**
+ * @brief   Card detect.
+ * @note    The simulated card is always inserted.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @return              The card state.
+ * @retval FALSE        card not inserted.
+ * @retval TRUE         card inserted.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_is_card_inserted(SDCDriver *sdcp) {
+
+  (void)sdcp;
+  return TRUE;
+}
+
+/**
+ * @brief   Write protection detection.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @return              The write protection state.
+ * @retval FALSE        not write protected.
+ * @retval TRUE         write protected.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_is_write_protected(SDCDriver *sdcp) {
+
+  return sdcp->sim_protected;
+}
+
+#endif /* HAL_USE_SDC */
+
+/** @} */
@@ -0,0 +1,304 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/sdc_lld.h
+ * @brief   Posix low level simulated SDC driver header.
+ *
+ * @addtogroup POSIX_SDC
+ * @{
+ */
+
+#ifndef _SDC_LLD_H_
+#define _SDC_LLD_H_
+
+#if HAL_USE_SDC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   SDC driver enable switch.
+ * @details If set to @p TRUE the support for SDC1 is included.
+ */
+#if !defined(PLATFORM_SDC_USE_SDC1) || defined(__DOXYGEN__)
+#define PLATFORM_SDC_USE_SDC1               TRUE
+#endif
+
+/**
+ * @brief   Capacity of the simulated card in blocks.
+ * @note    The card is a high capacity card so the value must be a
+ *          multiple of 1024.
+ */
+#if !defined(SDC_SIM_CAPACITY) || defined(__DOXYGEN__)
+#define SDC_SIM_CAPACITY                    4096
+#endif
+
+/**
+ * @brief   Number of status polls reporting the programming state after
+ *          a write operation.
+ * @details This simulates the card busy time after writes.
+ */
+#if !defined(SDC_SIM_BUSY_POLLS) || defined(__DOXYGEN__)
+#define SDC_SIM_BUSY_POLLS                  2
+#endif
+
+/**
+ * @brief   Simulated card high speed mode support.
+ * @details If set to @p FALSE the card refuses the CMD6 high speed switch.
+ */
+#if !defined(SDC_SIM_HIGH_SPEED) || defined(__DOXYGEN__)
+#define SDC_SIM_HIGH_SPEED                  TRUE
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (SDC_SIM_CAPACITY == 0) || ((SDC_SIM_CAPACITY % 1024) != 0)
+#error "invalid SDC_SIM_CAPACITY value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of SDIO bus mode.
+ */
+typedef enum {
+  SDC_MODE_1BIT = 0,
+  SDC_MODE_4BIT,
+  SDC_MODE_8BIT
+} sdcbusmode_t;
+
+/**
+ * @brief   Type of SDIO bus clock.
+ */
+typedef enum {
+  SDC_CLK_25MHz = 0,
+  SDC_CLK_50MHz
+} sdcbusclk_t;
+
+/**
+ * @brief   Type of card flags.
+ */
+typedef uint32_t sdcmode_t;
+
+/**
+ * @brief   SDC Driver condition flags type.
+ */
+typedef uint32_t sdcflags_t;
+
+/**
+ * @brief   Type of a structure representing an SDC driver.
+ */
+typedef struct SDCDriver SDCDriver;
+
+/**
+ * @brief   Driver configuration structure.
+ * @note    The driver negotiates the fastest bus settings supported by the
+ *          card within the limits specified here.
+ */
+typedef struct {
+  /**
+   * @brief Widest bus mode allowed by the board.
+   */
+  sdcbusmode_t              bus_width;
+  /**
+   * @brief Fastest bus clock allowed by the board.
+   */
+  sdcbusclk_t               bus_clk;
+} SDCConfig;
+
+/**
+ * @brief   @p SDCDriver specific methods.
+ */
+#define _sdc_driver_methods                                                 \
+  _mmcsd_block_device_methods
+
+/**
+ * @extends MMCSDBlockDeviceVMT
+ *
+ * @brief   @p SDCDriver virtual methods table.
+ */
+struct SDCDriverVMT {
+  _sdc_driver_methods
+};
+
+/**
+ * @brief   Structure representing an SDC driver.
+ */
+struct SDCDriver {
+  /**
+   * @brief Virtual Methods Table.
+   */
+  const struct SDCDriverVMT *vmt;
+  _sdc_driver_data
+  /**
+   * @brief Current configuration data.
+   */
+  const SDCConfig           *config;
+  /**
+   * @brief Various flags regarding the mounted card.
+   */
+  sdcmode_t                 cardmode;
+  /**
+   * @brief Errors flags.
+   */
+  sdcflags_t                errors;
+  /**
+   * @brief Card RCA.
+   */
+  uint32_t                  rca;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Simulated card state.
+   */
+  uint32_t                  sim_state;
+  /**
+   * @brief Application command prefix received.
+   */
+  bool_t                    sim_appcmd;
+  /**
+   * @brief Remaining busy status polls.
+   */
+  uint32_t                  sim_busy;
+  /**
+   * @brief First block of the erase range.
+   */
+  uint32_t                  sim_erase_start;
+  /**
+   * @brief Last block of the erase range.
+   */
+  uint32_t                  sim_erase_end;
+  /**
+   * @brief Host side bus clock.
+   */
+  sdcbusclk_t               sim_clk;
+  /**
+   * @brief Host side bus mode.
+   */
+  sdcbusmode_t              sim_bus;
+  /**
+   * @brief Card side 4 bits bus mode selected.
+   */
+  bool_t                    sim_card_wide;
+  /**
+   * @brief Card side high speed mode selected.
+   */
+  bool_t                    sim_card_hs;
+  /**
+   * @brief Simulated card write protect switch.
+   */
+  bool_t                    sim_protected;
+  /**
+   * @brief Number of read transfers performed.
+   */
+  uint32_t                  sim_reads;
+  /**
+   * @brief Number of write transfers performed.
+   */
+  uint32_t                  sim_writes;
+  /**
+   * @brief Simulated card storage.
+   */
+  uint8_t                   *sim_storage;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    R1 response utilities
+ * @{
+ */
+/**
+ * @brief   Evaluates to @p TRUE if the R1 response contains error flags.
+ *
+ * @param[in] r1        the r1 response
+ */
+#define MMCSD_R1_ERROR(r1)              (((r1) & MMCSD_R1_ERROR_MASK) != 0)
+
+/**
+ * @brief   Returns the status field of an R1 response.
+ *
+ * @param[in] r1        the r1 response
+ */
+#define MMCSD_R1_STS(r1)                (((r1) >> 9) & 15)
+
+/**
+ * @brief   Evaluates to @p TRUE if the R1 response indicates a locked card.
+ *
+ * @param[in] r1        the r1 response
+ */
+#define MMCSD_R1_IS_CARD_LOCKED(r1)     (((r1) >> 21) & 1)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if PLATFORM_SDC_USE_SDC1 && !defined(__DOXYGEN__)
+extern SDCDriver SDCD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sdc_lld_init(void);
+  void sdc_lld_start(SDCDriver *sdcp);
+  void sdc_lld_stop(SDCDriver *sdcp);
+  void sdc_lld_start_clk(SDCDriver *sdcp);
+  void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk);
+  void sdc_lld_stop_clk(SDCDriver *sdcp);
+  void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode);
+  void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg);
+  bool_t sdc_lld_send_cmd_short(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                uint32_t *resp);
+  bool_t sdc_lld_send_cmd_short_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                    uint32_t *resp);
+  bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
+                                   uint32_t *resp);
+  bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                              uint8_t cmd, uint32_t arg);
+  bool_t sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
+                      uint8_t *buf, uint32_t n);
+  bool_t sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
+                       const uint8_t *buf, uint32_t n);
+  bool_t sdc_lld_sync(SDCDriver *sdcp);
+  bool_t sdc_lld_is_card_inserted(SDCDriver *sdcp);
+  bool_t sdc_lld_is_write_protected(SDCDriver *sdcp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_SDC */
+
+#endif /* _SDC_LLD_H_ */
+
+/** @} */
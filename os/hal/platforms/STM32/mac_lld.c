@@ -36,6 +36,12 @@
 
 #define BUFFER_SIZE ((((STM32_MAC_BUFFERS_SIZE - 1) | 3) + 1) / 4)
 
+#if MAC_USE_ZERO_COPY
+#define RX_HEADROOM (MAC_RECEIVE_HEADROOM / 4)
+#else
+#define RX_HEADROOM 0
+#endif
+
 /* MII divider optimal value.*/
 #if (STM32_HCLK >= 150000000)
 #define MACMIIDR_CR ETH_MACMIIAR_CR_Div102
@@ -51,6 +57,22 @@
 #error "STM32_HCLK below minimum frequency for ETH operations (20MHz)"
 #endif
 
+/* Checksum error of a received IPv4 or IPv6 frame, the status is moved in
+   RDES4 when the enhanced descriptors are used.*/
+#if STM32_MAC_USE_PTP
+#define RX_CHECKSUM_ERROR(rdes)                                             \
+  (((rdes)->rdes0 & STM32_RDES0_ESA) &&                                     \
+   ((rdes)->rdes4 & (STM32_RDES4_IPHE | STM32_RDES4_IPPE)))
+#define TX_TIMESTAMP        STM32_TDES0_TTSE
+#define DMABMR_EDE          ETH_DMABMR_EDE
+#else
+#define RX_CHECKSUM_ERROR(rdes)                                             \
+  (((rdes)->rdes0 & STM32_RDES0_FT) &&                                      \
+   ((rdes)->rdes0 & (STM32_RDES0_IPHCE | STM32_RDES0_PCE)))
+#define TX_TIMESTAMP        0
+#define DMABMR_EDE          0
+#endif
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -70,9 +92,26 @@ static const uint8_t default_mac_address[] = {0xAA, 0x55, 0x13,
 static stm32_eth_rx_descriptor_t rd[STM32_MAC_RECEIVE_BUFFERS];
 static stm32_eth_tx_descriptor_t td[STM32_MAC_TRANSMIT_BUFFERS];
 
+#if MAC_USE_ZERO_COPY
+/* Receive buffers are preceded by the headroom area, the buffers exceeding
+   the number of descriptors are the spare ones.*/
+static uint32_t rb[STM32_MAC_RECEIVE_BUFFERS + STM32_MAC_RECEIVE_SPARE_BUFFERS]
+                  [RX_HEADROOM + BUFFER_SIZE];
+static MemoryPool rbpool;
+#else
 static uint32_t rb[STM32_MAC_RECEIVE_BUFFERS][BUFFER_SIZE];
+#endif
 static uint32_t tb[STM32_MAC_TRANSMIT_BUFFERS][BUFFER_SIZE];
 
+#if MAC_USE_ZERO_COPY
+/* Release callbacks of the frames sent using mac_lld_transmit_segments(),
+   the callback is stored in the slot of the last descriptor of the frame.*/
+static struct {
+  macreleasecb_t        cb;
+  void                  *arg;
+} tr[STM32_MAC_TRANSMIT_BUFFERS];
+#endif
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
@@ -165,6 +204,105 @@ static void mac_lld_set_address(const uint8_t *p) {
   ETH->MACHTLR   = 0;
 }
 
+/**
+ * @brief   Returns the TDES0 checksum insertion setting for a frame.
+ * @details The hardware inserts a wrong ICMP checksum if the field is not
+ *          zero, in that case only the IPv4 header checksum is inserted and
+ *          the checksum computed by software is transmitted unchanged.
+ *
+ * @param[in] p         pointer to the frame start
+ * @param[in] n         number of frame bytes accessible from @p p
+ * @return              The TDES0 CIC field value.
+ */
+static uint32_t tx_checksum_mode(const uint8_t *p, size_t n) {
+#if STM32_MAC_IP_CHECKSUM_OFFLOAD >= 2
+  size_t icmp;
+
+  /* IPv4 frame carrying ICMP.*/
+  if ((n >= 34) && (p[12] == 0x08) && (p[13] == 0x00) && (p[23] == 1)) {
+    icmp = 14 + (size_t)(p[14] & 0x0F) * 4;
+    if ((n >= icmp + 4) && ((p[icmp + 2] | p[icmp + 3]) != 0))
+      return STM32_TDES0_CIC(1);
+  }
+#else
+  (void)p;
+  (void)n;
+#endif
+  return STM32_TDES0_CIC(STM32_MAC_IP_CHECKSUM_OFFLOAD);
+}
+
+#if STM32_MAC_USE_PTP || defined(__DOXYGEN__)
+/**
+ * @brief   Converts a PTP clock sub-seconds value in nanoseconds.
+ *
+ * @param[in] ss        sub-seconds in units of 2^-31 seconds
+ * @return              The nanoseconds.
+ */
+static uint32_t ss2ns(uint32_t ss) {
+
+  return (uint32_t)(((uint64_t)(ss & ETH_PTPTSLR_STSS) * 1000000000) >> 31);
+}
+
+/**
+ * @brief   Converts nanoseconds in a PTP clock sub-seconds value.
+ *
+ * @param[in] ns        nanoseconds, less than one second
+ * @return              The sub-seconds in units of 2^-31 seconds.
+ */
+static uint32_t ns2ss(uint32_t ns) {
+
+  return (uint32_t)(((uint64_t)ns << 31) / 1000000000);
+}
+
+/**
+ * @brief   Waits for the completion of a PTP clock update.
+ * @details The update bits are cleared by the hardware, the wait is bounded
+ *          by @p STM32_MAC_PTP_TIMEOUT.
+ *
+ * @param[in] mask      update bits of the PTPTSCR register to be waited
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the update completed.
+ * @retval CH_FAILED    timeout.
+ */
+static bool_t ptp_wait_update(uint32_t mask) {
+  halrtcnt_t start   = halGetCounterValue();
+  halrtcnt_t timeout = start + US2RTT(STM32_MAC_PTP_TIMEOUT);
+
+  while (ETH->PTPTSCR & mask) {
+    if (!halIsCounterWithin(start, timeout))
+      return (ETH->PTPTSCR & mask) ? CH_FAILED : CH_SUCCESS;
+  }
+  return CH_SUCCESS;
+}
+#endif /* STM32_MAC_USE_PTP */
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Invokes the release callbacks of the transmitted frames.
+ * @note    The callbacks are invoked outside the critical zone.
+ */
+static void tx_reclaim(void) {
+  unsigned i;
+
+  for (i = 0; i < STM32_MAC_TRANSMIT_BUFFERS; i++) {
+    macreleasecb_t cb;
+    void *arg;
+
+    chSysLock();
+    cb  = tr[i].cb;
+    arg = tr[i].arg;
+    if ((cb != NULL) &&
+        !(td[i].tdes0 & (STM32_TDES0_OWN | STM32_TDES0_LOCKED)))
+      tr[i].cb = NULL;
+    else
+      cb = NULL;
+    chSysUnlock();
+    if (cb != NULL)
+      cb(arg);
+  }
+}
+#endif /* MAC_USE_ZERO_COPY */
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
@@ -191,6 +329,9 @@ CH_IRQ_HANDLER(ETH_IRQHandler) {
     /* Data Transmitted.*/
     chSysLockFromIsr();
     chSemResetI(&ETHD1.tdsem, 0);
+#if MAC_USE_EVENTS
+    chEvtBroadcastI(&ETHD1.tdevent);
+#endif
     chSysUnlockFromIsr();
   }
 
@@ -211,12 +352,20 @@ void mac_lld_init(void) {
 
   macObjectInit(&ETHD1);
   ETHD1.link_up = FALSE;
+#if STM32_MAC_IP_CHECKSUM_OFFLOAD
+  ETHD1.rxcsumerrors = 0;
+#endif
 
   /* Descriptor tables are initialized in chained mode, note that the first
      word is not initialized here but in mac_lld_start().*/
   for (i = 0; i < STM32_MAC_RECEIVE_BUFFERS; i++) {
+#if STM32_MAC_RX_MODERATION_TIME > 0
+    /* The receive interrupt is raised by the DMA receive watchdog.*/
+    rd[i].rdes1 = STM32_RDES1_DIC | STM32_RDES1_RCH | STM32_MAC_BUFFERS_SIZE;
+#else
     rd[i].rdes1 = STM32_RDES1_RCH | STM32_MAC_BUFFERS_SIZE;
-    rd[i].rdes2 = (uint32_t)rb[i];
+#endif
+    rd[i].rdes2 = (uint32_t)&rb[i][RX_HEADROOM];
     rd[i].rdes3 = (uint32_t)&rd[(i + 1) % STM32_MAC_RECEIVE_BUFFERS];
   }
   for (i = 0; i < STM32_MAC_TRANSMIT_BUFFERS; i++) {
@@ -224,6 +373,11 @@ void mac_lld_init(void) {
     td[i].tdes2 = (uint32_t)tb[i];
     td[i].tdes3 = (uint32_t)&td[(i + 1) % STM32_MAC_TRANSMIT_BUFFERS];
   }
+#if MAC_USE_ZERO_COPY
+  chPoolInit(&rbpool, sizeof rb[0], NULL);
+  chPoolLoadArray(&rbpool, rb[STM32_MAC_RECEIVE_BUFFERS],
+                  STM32_MAC_RECEIVE_SPARE_BUFFERS);
+#endif
 
   /* Selection of the RMII or MII mode based on info exported by board.h.*/
 #if defined(STM32F10X_CL)
@@ -297,6 +451,9 @@ void mac_lld_start(MACDriver *macp) {
 
   /* MAC clocks activation and commanded reset procedure.*/
   rccEnableETH(FALSE);
+#if STM32_MAC_USE_PTP
+  rccEnableETHPTP(FALSE);
+#endif
   ETH->DMABMR |= ETH_DMABMR_SR;
   while(ETH->DMABMR & ETH_DMABMR_SR)
     ;
@@ -310,6 +467,19 @@ void mac_lld_start(MACDriver *macp) {
   mii_write(macp, MII_BMCR, mii_read(macp, MII_BMCR) & ~BMCR_PDOWN);
 #endif
 
+#if HAL_USE_EXT
+  /* PHY link change interrupt, the pending status is cleared before
+     enabling the interrupt line.*/
+  if (macp->config->phy_extp != NULL) {
+    chDbgAssert(macp->config->phy_extp->state == EXT_ACTIVE,
+                "mac_lld_start(), #1", "EXT driver not active");
+    mii_write(macp, macp->config->phy_int_mask_reg,
+              macp->config->phy_int_mask);
+    (void)mii_read(macp, macp->config->phy_int_status_reg);
+    extChannelEnableI(macp->config->phy_extp, macp->config->phy_channel);
+  }
+#endif
+
   /* MAC configuration.*/
   ETH->MACFFR    = 0;
   ETH->MACFCR    = 0;
@@ -321,6 +491,26 @@ void mac_lld_start(MACDriver *macp) {
   else
     mac_lld_set_address(macp->config->mac_address);
 
+#if STM32_MAC_USE_PTP
+  /* PTP clock started from zero using the fine correction method. All the
+     received frames are time stamped, note that the snapshot control bits
+     of PTPTSCR are named after PTPTSSR in the device header.*/
+  ETH->MACIMR   = ETH_MACIMR_TSTIM;
+  ETH->PTPTSCR  = ETH_PTPTSCR_TSE | ETH_PTPTSSR_TSSARFE;
+  ETH->PTPSSIR  = STM32_MAC_PTP_SSINC;
+  ETH->PTPTSAR  = STM32_MAC_PTP_ADDEND;
+  ETH->PTPTSCR |= ETH_PTPTSCR_TSARU;
+  if (ptp_wait_update(ETH_PTPTSCR_TSARU) == CH_SUCCESS) {
+    ETH->PTPTSCR |= ETH_PTPTSCR_TSFCU;
+    ETH->PTPTSHUR = 0;
+    ETH->PTPTSLUR = 0;
+    ETH->PTPTSCR |= ETH_PTPTSCR_TSSTI;
+    (void)ptp_wait_update(ETH_PTPTSCR_TSSTI);
+  }
+  chDbgAssert((ETH->PTPTSCR & (ETH_PTPTSCR_TSARU | ETH_PTPTSCR_TSSTI)) == 0,
+              "mac_lld_start(), #2", "PTP clock not responding");
+#endif
+
   /* Transmitter and receiver enabled.
      Note that the complete setup of the MAC is performed when the link
      status is detected.*/
@@ -335,12 +525,18 @@ void mac_lld_start(MACDriver *macp) {
   ETH->DMARDLAR = (uint32_t)rd;
   ETH->DMATDLAR = (uint32_t)td;
 
+#if STM32_MAC_RX_MODERATION_TIME > 0
+  /* Receive interrupt moderation.*/
+  ETH->DMARSWTR = STM32_MAC_RWT;
+#endif
+
   /* Enabling required interrupt sources.*/
   ETH->DMASR    = ETH->DMASR;
   ETH->DMAIER   = ETH_DMAIER_NISE | ETH_DMAIER_RIE | ETH_DMAIER_TIE;
 
   /* DMA general settings.*/
-  ETH->DMABMR   = ETH_DMABMR_AAB | ETH_DMABMR_RDP_1Beat | ETH_DMABMR_PBL_1Beat;
+  ETH->DMABMR   = DMABMR_EDE | ETH_DMABMR_AAB | ETH_DMABMR_RDP_1Beat |
+                  ETH_DMABMR_PBL_1Beat;
 
   /* Transmit FIFO flush.*/
   ETH->DMAOMR   = ETH_DMAOMR_FTF;
@@ -362,6 +558,14 @@ void mac_lld_start(MACDriver *macp) {
 void mac_lld_stop(MACDriver *macp) {
 
   if (macp->state != MAC_STOP) {
+#if HAL_USE_EXT
+    /* PHY link change interrupt disabled.*/
+    if (macp->config->phy_extp != NULL) {
+      extChannelDisableI(macp->config->phy_extp, macp->config->phy_channel);
+      mii_write(macp, macp->config->phy_int_mask_reg, 0);
+    }
+#endif
+
 #if STM32_MAC_ETH1_CHANGE_PHY_STATE
     /* PHY in power down mode until the driver will be restarted.*/
     mii_write(macp, MII_BMCR, mii_read(macp, MII_BMCR) | BMCR_PDOWN);
@@ -374,6 +578,9 @@ void mac_lld_stop(MACDriver *macp) {
     ETH->DMASR    = ETH->DMASR;
 
     /* MAC clocks stopped.*/
+#if STM32_MAC_USE_PTP
+    rccDisableETHPTP(FALSE);
+#endif
     rccDisableETH(FALSE);
 
     /* ISR vector disabled.*/
@@ -398,6 +605,10 @@ msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
                                       MACTransmitDescriptor *tdp) {
   stm32_eth_tx_descriptor_t *tdes;
 
+#if MAC_USE_ZERO_COPY
+  tx_reclaim();
+#endif
+
   if (!macp->link_up)
     return RDY_TIMEOUT;
 
@@ -413,6 +624,18 @@ msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
     return RDY_TIMEOUT;
   }
 
+#if MAC_USE_ZERO_COPY
+  /* The descriptor is still holding the segment of a frame not yet
+     released.*/
+  if (tr[tdes - td].cb != NULL) {
+    chSysUnlock();
+    return RDY_TIMEOUT;
+  }
+
+  /* The descriptor could point to a segment of a previous frame.*/
+  tdes->tdes2 = (uint32_t)tb[tdes - td];
+#endif
+
   /* Marks the current descriptor as locked using a reserved bit.*/
   tdes->tdes0 |= STM32_TDES0_LOCKED;
 
@@ -447,9 +670,10 @@ void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp) {
 
   /* Unlocks the descriptor and returns it to the DMA engine.*/
   tdp->physdesc->tdes1 = tdp->offset;
-  tdp->physdesc->tdes0 = STM32_TDES0_CIC(STM32_MAC_IP_CHECKSUM_OFFLOAD) |
-                         STM32_TDES0_IC | STM32_TDES0_LS | STM32_TDES0_FS |
-                         STM32_TDES0_TCH | STM32_TDES0_OWN;
+  tdp->physdesc->tdes0 = tx_checksum_mode((const uint8_t *)tdp->physdesc->tdes2,
+                                          tdp->offset) |
+                         TX_TIMESTAMP | STM32_TDES0_IC | STM32_TDES0_LS |
+                         STM32_TDES0_FS | STM32_TDES0_TCH | STM32_TDES0_OWN;
 
   /* If the DMA engine is stalled then a restart request is issued.*/
   if ((ETH->DMASR & ETH_DMASR_TPS) == ETH_DMASR_TPS_Suspended) {
@@ -483,11 +707,18 @@ msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
   /* Iterates through received frames until a valid one is found, invalid
      frames are discarded.*/
   while (!(rdes->rdes0 & STM32_RDES0_OWN)) {
-    if (!(rdes->rdes0 & (STM32_RDES0_AFM | STM32_RDES0_ES))
 #if STM32_MAC_IP_CHECKSUM_OFFLOAD
-        && (rdes->rdes0 & STM32_RDES0_FT)
-        && !(rdes->rdes0 & (STM32_RDES0_IPHCE | STM32_RDES0_PCE))
+    /* IPv4 and IPv6 frames with an header or payload checksum error. The
+       other frames are accepted, including the non-IP ones and those with
+       a payload not verified by the hardware.*/
+    if (RX_CHECKSUM_ERROR(rdes) && (rdes->rdes0 & STM32_RDES0_LS)) {
+      macp->rxcsumerrors++;
+      rdes->rdes0 = STM32_RDES0_OWN;
+      rdes = (stm32_eth_rx_descriptor_t *)rdes->rdes3;
+      continue;
+    }
 #endif
+    if (!(rdes->rdes0 & (STM32_RDES0_AFM | STM32_RDES0_ES))
         && (rdes->rdes0 & STM32_RDES0_FS) && (rdes->rdes0 & STM32_RDES0_LS)) {
       /* Found a valid one.*/
       rdp->offset   = 0;
@@ -554,6 +785,12 @@ bool_t mac_lld_poll_link_status(MACDriver *macp) {
 
   maccr = ETH->MACCR;
 
+#if HAL_USE_EXT
+  /* Acknowledges the PHY interrupt, the line is released.*/
+  if (macp->config->phy_extp != NULL)
+    (void)mii_read(macp, macp->config->phy_int_status_reg);
+#endif
+
   /* PHY CR and SR registers read.*/
   (void)mii_read(macp, MII_BMSR);
   bmsr = mii_read(macp, MII_BMSR);
@@ -732,8 +969,340 @@ const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
   *sizep = 0;
   return NULL;
 }
+
+/**
+ * @brief   Takes ownership of the buffer of a received frame.
+ * @details The frame buffer is detached from the descriptor and replaced
+ *          with a spare buffer.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the frame size
+ * @return              Pointer to the loaned buffer.
+ * @retval NULL         if no spare buffers are available.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                     size_t *sizep) {
+  uint32_t *spare;
+  uint8_t *buf;
+
+  chDbgAssert(!(rdp->physdesc->rdes0 & STM32_RDES0_OWN),
+              "mac_lld_loan_receive_buffer(), #1",
+              "attempt to loan descriptor already owned by DMA");
+
+  /* The frame buffer can be loaned only if there is a spare buffer able to
+     replace it in the ring.*/
+  spare = chPoolAlloc(&rbpool);
+  if (spare == NULL)
+    return NULL;
+
+  buf = (uint8_t *)mac_lld_get_next_receive_buffer(rdp, sizep);
+  chDbgAssert(buf != NULL, "mac_lld_loan_receive_buffer(), #2",
+              "descriptor already read");
+  rdp->physdesc->rdes2 = (uint32_t)&spare[RX_HEADROOM];
+  return buf;
+}
+
+/**
+ * @brief   Gives back a loaned receive buffer.
+ * @details The buffer becomes a spare buffer again.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the loaned buffer
+ *
+ * @notapi
+ */
+void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf) {
+
+  (void)macp;
+
+  chPoolFree(&rbpool, (uint32_t *)buf - RX_HEADROOM);
+}
+
+/**
+ * @brief   Queues a frame made of scattered segments for transmission.
+ * @details Each segment uses a descriptor, empty segments are skipped.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] segp      pointer to an array of @p MACTransmitSegment
+ * @param[in] n         number of segments
+ * @param[in] cb        release callback
+ * @param[in] arg       argument for the release callback
+ * @return              The operation status.
+ * @retval RDY_OK       the frame has been queued for transmission.
+ * @retval RDY_TIMEOUT  descriptors not available.
+ * @retval RDY_RESET    the frame cannot be described with the available
+ *                      descriptors.
+ *
+ * @notapi
+ */
+msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                const MACTransmitSegment *segp,
+                                unsigned n,
+                                macreleasecb_t cb,
+                                void *arg) {
+  stm32_eth_tx_descriptor_t *first, *last, *tdes;
+  unsigned i, ndesc;
+
+  /* Counting the required descriptors, frames that would never fit are
+     refused.*/
+  ndesc = 0;
+  for (i = 0; i < n; i++) {
+    if (segp[i].size > 0) {
+      if ((segp[i].size > STM32_TDES1_TBS1_MASK) ||
+          ((segp[i].copy || !STM32_MAC_IS_DMA_CAPABLE(segp[i].buf)) &&
+           (segp[i].size > STM32_MAC_BUFFERS_SIZE)))
+        return RDY_RESET;
+      ndesc++;
+    }
+  }
+  if ((ndesc == 0) || (ndesc > STM32_MAC_TRANSMIT_BUFFERS))
+    return RDY_RESET;
+
+  tx_reclaim();
+
+  if (!macp->link_up)
+    return RDY_TIMEOUT;
+
+  chSysLock();
+
+  /* All the required descriptors must be available.*/
+  first = tdes = macp->txptr;
+  for (i = 0; i < ndesc; i++) {
+    if ((tdes->tdes0 & (STM32_TDES0_OWN | STM32_TDES0_LOCKED)) ||
+        (tr[tdes - td].cb != NULL)) {
+      chSysUnlock();
+      return RDY_TIMEOUT;
+    }
+    tdes = (stm32_eth_tx_descriptor_t *)tdes->tdes3;
+  }
+
+  /* The descriptors are locked, this way they can be filled outside the
+     critical zone.*/
+  tdes = first;
+  for (i = 0; i < ndesc; i++) {
+    tdes->tdes0 |= STM32_TDES0_LOCKED;
+    tdes = (stm32_eth_tx_descriptor_t *)tdes->tdes3;
+  }
+  macp->txptr = tdes;
+
+  chSysUnlock();
+
+  /* Segments not accessible by the DMA or requiring a copy are copied
+     into the descriptor buffer, the others are transmitted in place.*/
+  last = tdes = first;
+  for (i = 0; i < n; i++) {
+    if (segp[i].size == 0)
+      continue;
+    if (!segp[i].copy && STM32_MAC_IS_DMA_CAPABLE(segp[i].buf))
+      tdes->tdes2 = (uint32_t)segp[i].buf;
+    else {
+      memcpy(tb[tdes - td], segp[i].buf, segp[i].size);
+      tdes->tdes2 = (uint32_t)tb[tdes - td];
+    }
+    tdes->tdes1 = segp[i].size;
+    last = tdes;
+    tdes = (stm32_eth_tx_descriptor_t *)tdes->tdes3;
+  }
+  tr[last - td].cb  = cb;
+  tr[last - td].arg = arg;
+
+  chSysLock();
+
+  /* Unlocks the descriptors and returns them to the DMA engine, the first
+     one is returned last so that the DMA cannot see a partial frame.*/
+  tdes = first;
+  for (i = 1; i < ndesc; i++) {
+    tdes = (stm32_eth_tx_descriptor_t *)tdes->tdes3;
+    tdes->tdes0 = (tdes == last ? STM32_TDES0_IC | STM32_TDES0_LS : 0) |
+                  STM32_TDES0_TCH | STM32_TDES0_OWN;
+  }
+  first->tdes0 = tx_checksum_mode((const uint8_t *)first->tdes2,
+                                  first->tdes1) |
+                 (first == last ? STM32_TDES0_IC | STM32_TDES0_LS : 0) |
+                 STM32_TDES0_FS | STM32_TDES0_TCH | STM32_TDES0_OWN;
+
+  /* If the DMA engine is stalled then a restart request is issued.*/
+  if ((ETH->DMASR & ETH_DMASR_TPS) == ETH_DMASR_TPS_Suspended) {
+    ETH->DMASR   = ETH_DMASR_TBUS;
+    ETH->DMATPDR = ETH_DMASR_TBUS; /* Any value is OK.*/
+  }
+
+  chSysUnlock();
+  return RDY_OK;
+}
+
+/**
+ * @brief   Invokes the release callbacks of the transmitted frames.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_reclaim_transmit_segments(MACDriver *macp) {
+
+  (void)macp;
+
+  tx_reclaim();
+}
 #endif /* MAC_USE_ZERO_COPY */
 
+#if STM32_MAC_USE_PTP || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the reception time stamp of a frame.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ * @return              The time stamp availability.
+ * @retval TRUE         if the time stamp has been stored in @p tsp.
+ * @retval FALSE        if the frame has not been time stamped.
+ *
+ * @notapi
+ */
+bool_t mac_lld_get_receive_timestamp(MACReceiveDescriptor *rdp,
+                                     MACTimestamp *tsp) {
+
+  if (!(rdp->physdesc->rdes0 & STM32_RDES0_TSV))
+    return FALSE;
+  tsp->seconds     = rdp->physdesc->rdes7;
+  tsp->nanoseconds = ss2ns(rdp->physdesc->rdes6);
+  return TRUE;
+}
+
+/**
+ * @brief   Returns the transmission time stamp of a frame.
+ *
+ * @param[in] tdp       pointer to a released @p MACTransmitDescriptor
+ *                      structure
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ * @return              The time stamp availability.
+ * @retval TRUE         if the time stamp has been stored in @p tsp.
+ * @retval FALSE        if the frame has not been transmitted yet.
+ *
+ * @notapi
+ */
+bool_t mac_lld_get_transmit_timestamp(MACTransmitDescriptor *tdp,
+                                      MACTimestamp *tsp) {
+  stm32_eth_tx_descriptor_t *tdes = tdp->physdesc;
+
+  /* The time stamp status of a descriptor locked again belongs to the
+     previous frame.*/
+  if ((tdes->tdes0 & (STM32_TDES0_OWN | STM32_TDES0_LOCKED |
+                      STM32_TDES0_TTSS)) != STM32_TDES0_TTSS)
+    return FALSE;
+  tsp->seconds     = tdes->tdes7;
+  tsp->nanoseconds = ss2ns(tdes->tdes6);
+  return TRUE;
+}
+
+/**
+ * @brief   Reads the PTP clock.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ *
+ * @notapi
+ */
+void mac_lld_get_clock_time(MACDriver *macp, MACTimestamp *tsp) {
+  uint32_t sec, ss;
+
+  (void)macp;
+
+  /* The seconds are read again in case the sub-seconds rolled over.*/
+  do {
+    sec = ETH->PTPTSHR;
+    ss  = ETH->PTPTSLR;
+  } while (sec != ETH->PTPTSHR);
+  tsp->seconds     = sec;
+  tsp->nanoseconds = ss2ns(ss);
+}
+
+/**
+ * @brief   Sets the PTP clock.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] tsp       pointer to a @p MACTimestamp structure
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @notapi
+ */
+bool_t mac_lld_set_clock_time(MACDriver *macp, const MACTimestamp *tsp) {
+
+  (void)macp;
+
+  if (ptp_wait_update(ETH_PTPTSCR_TSSTI | ETH_PTPTSCR_TSSTU))
+    return CH_FAILED;
+  ETH->PTPTSHUR = tsp->seconds;
+  ETH->PTPTSLUR = ns2ss(tsp->nanoseconds);
+  ETH->PTPTSCR |= ETH_PTPTSCR_TSSTI;
+  return ptp_wait_update(ETH_PTPTSCR_TSSTI);
+}
+
+/**
+ * @brief   Steps the PTP clock.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] offset    offset in nanoseconds
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @notapi
+ */
+bool_t mac_lld_adjust_clock_time(MACDriver *macp, int64_t offset) {
+  uint64_t mag;
+  uint32_t sign;
+
+  (void)macp;
+
+  /* The update registers hold the offset magnitude and its sign.*/
+  if (offset < 0) {
+    mag  = (uint64_t)-offset;
+    sign = ETH_PTPTSLUR_TSUPNS;
+  }
+  else {
+    mag  = (uint64_t)offset;
+    sign = 0;
+  }
+  if (ptp_wait_update(ETH_PTPTSCR_TSSTI | ETH_PTPTSCR_TSSTU))
+    return CH_FAILED;
+  ETH->PTPTSHUR = (uint32_t)(mag / 1000000000);
+  ETH->PTPTSLUR = sign | ns2ss((uint32_t)(mag % 1000000000));
+  ETH->PTPTSCR |= ETH_PTPTSCR_TSSTU;
+  return ptp_wait_update(ETH_PTPTSCR_TSSTU);
+}
+
+/**
+ * @brief   Adjusts the PTP clock rate.
+ * @details The addend register is scaled from its nominal value, the
+ *          nominal addend is below 2^31 so the result cannot overflow.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] ppb       frequency offset in parts per billion
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @notapi
+ */
+bool_t mac_lld_adjust_clock_frequency(MACDriver *macp, int32_t ppb) {
+  int64_t addend;
+
+  (void)macp;
+
+  addend = (int64_t)STM32_MAC_PTP_ADDEND +
+           (int64_t)STM32_MAC_PTP_ADDEND * ppb / 1000000000;
+  if (ptp_wait_update(ETH_PTPTSCR_TSARU))
+    return CH_FAILED;
+  ETH->PTPTSAR  = (uint32_t)addend;
+  ETH->PTPTSCR |= ETH_PTPTSCR_TSARU;
+  return CH_SUCCESS;
+}
+#endif /* STM32_MAC_USE_PTP */
+
 #endif /* HAL_USE_MAC */
 
 /** @} */
@@ -61,6 +61,14 @@
 #define STM32_RDES0_PCE             0x00000001
 /** @} */
 
+/**
+ * @name    RDES0 constants in enhanced descriptor mode
+ * @{
+ */
+#define STM32_RDES0_TSV             0x00000080
+#define STM32_RDES0_ESA             0x00000001
+/** @} */
+
 /**
  * @name    RDES1 constants
  * @{
@@ -72,6 +80,21 @@
 #define STM32_RDES1_RBS1_MASK       0x00001FFF
 /** @} */
 
+/**
+ * @name    RDES4 constants
+ * @{
+ */
+#define STM32_RDES4_PV              0x00002000
+#define STM32_RDES4_PFT             0x00001000
+#define STM32_RDES4_PMT_MASK        0x00000F00
+#define STM32_RDES4_IPV6PR          0x00000080
+#define STM32_RDES4_IPV4PR          0x00000040
+#define STM32_RDES4_IPCB            0x00000020
+#define STM32_RDES4_IPPE            0x00000010
+#define STM32_RDES4_IPHE            0x00000008
+#define STM32_RDES4_IPPT_MASK       0x00000007
+/** @} */
+
 /**
  * @name    TDES0 constants
  * @{
@@ -142,6 +165,28 @@
 #define STM32_MAC_BUFFERS_SIZE              1522
 #endif
 
+/**
+ * @brief   Number of spare receive buffers.
+ * @details Spare buffers replace the receive buffers loaned to the upper
+ *          layers using @p macLoanReceiveBuffer(), this way the receive
+ *          ring is never left without buffers. This setting is only
+ *          meaningful when @p MAC_USE_ZERO_COPY is enabled.
+ */
+#if !defined(STM32_MAC_RECEIVE_SPARE_BUFFERS) || defined(__DOXYGEN__)
+#define STM32_MAC_RECEIVE_SPARE_BUFFERS     4
+#endif
+
+/**
+ * @brief   Checks if a memory address is accessible by the Ethernet DMA.
+ * @details Segments transmitted using @p macTransmitSegments() that are
+ *          not accessible by the DMA are copied into the descriptors
+ *          buffers. The default excludes the core coupled memory.
+ */
+#if !defined(STM32_MAC_IS_DMA_CAPABLE) || defined(__DOXYGEN__)
+#define STM32_MAC_IS_DMA_CAPABLE(p)                                         \
+  (((uint32_t)(p) & 0xFFFF0000) != 0x10000000)
+#endif
+
 /**
  * @brief   PHY detection timeout.
  * @details Timeout, in milliseconds, for PHY address detection, if a PHY
@@ -181,10 +226,53 @@
  *              insertion are enabled, and pseudo-header checksum is
  *              calculated in hardware.
  *          .
+ * @note    Received frames with checksum errors are discarded in all the
+ *          modes except zero.
+ * @note    Only mode 3 is advertised as @p MAC_SUPPORTS_CHECKSUM_OFFLOAD,
+ *          in this mode the TCP and UDP checksum fields of the transmitted
+ *          frames are overwritten. ICMP checksums are only inserted when
+ *          the field is left zeroed, otherwise the software value is kept.
  */
 #if !defined(STM32_MAC_IP_CHECKSUM_OFFLOAD) || defined(__DOXYGEN__)
 #define STM32_MAC_IP_CHECKSUM_OFFLOAD       0
 #endif
+
+/**
+ * @brief   Receive interrupt moderation time in microseconds.
+ * @details If non-zero the receive interrupt is not raised for each frame,
+ *          it is delayed by the DMA receive watchdog so that multiple
+ *          frames can be handled on a single interrupt. Zero disables the
+ *          moderation.
+ * @note    The maximum value depends on the HCLK frequency, the watchdog
+ *          counts up to 255 periods of 256 HCLK cycles.
+ */
+#if !defined(STM32_MAC_RX_MODERATION_TIME) || defined(__DOXYGEN__)
+#define STM32_MAC_RX_MODERATION_TIME        0
+#endif
+
+/**
+ * @brief   IEEE 1588 time stamping.
+ * @details If enabled the DMA uses the enhanced descriptors, all the
+ *          received frames and the frames transmitted using
+ *          @p macReleaseTransmitDescriptor() are time stamped by the
+ *          hardware PTP clock. The clock is finely adjustable and starts
+ *          from zero when the driver is started.
+ * @note    The frames transmitted using @p macTransmitSegments() are not
+ *          time stamped.
+ */
+#if !defined(STM32_MAC_USE_PTP) || defined(__DOXYGEN__)
+#define STM32_MAC_USE_PTP                   FALSE
+#endif
+
+/**
+ * @brief   PTP clock update timeout.
+ * @details Timeout, in microseconds, for the completion of a PTP clock
+ *          time or addend update, the clock functions fail if the update
+ *          is not acknowledged within the timeout.
+ */
+#if !defined(STM32_MAC_PTP_TIMEOUT) || defined(__DOXYGEN__)
+#define STM32_MAC_PTP_TIMEOUT               1000
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -195,6 +283,69 @@
 #error "STM32_MAC_PHY_TIMEOUT requires the realtime counter service"
 #endif
 
+#if STM32_MAC_USE_PTP && !HAL_IMPLEMENTS_COUNTERS
+#error "STM32_MAC_USE_PTP requires the realtime counter service"
+#endif
+
+#if MAC_USE_ZERO_COPY && !CH_USE_MEMPOOLS
+#error "MAC_USE_ZERO_COPY requires CH_USE_MEMPOOLS"
+#endif
+
+/**
+ * @brief   DMA receive watchdog setting for the interrupt moderation.
+ */
+#define STM32_MAC_RWT                                                       \
+  ((STM32_MAC_RX_MODERATION_TIME * (STM32_HCLK / 1000000) + 255) / 256)
+
+#if (STM32_MAC_RX_MODERATION_TIME > 0) && defined(STM32F10X_CL)
+#error "STM32_MAC_RX_MODERATION_TIME not supported by this device"
+#endif
+
+#if STM32_MAC_RWT > 255
+#error "STM32_MAC_RX_MODERATION_TIME too large"
+#endif
+
+#if (STM32_MAC_IP_CHECKSUM_OFFLOAD < 0) || (STM32_MAC_IP_CHECKSUM_OFFLOAD > 3)
+#error "invalid STM32_MAC_IP_CHECKSUM_OFFLOAD value"
+#endif
+
+#if STM32_MAC_USE_PTP && !defined(STM32F2XX) && !defined(STM32F4XX)
+#error "STM32_MAC_USE_PTP not supported by this device"
+#endif
+
+/**
+ * @brief   PTP clock sub-second increment.
+ * @details The sub-second register counts in units of 2^-31 seconds, the
+ *          increment is chosen so that the accumulator overflows at about
+ *          half the HCLK frequency.
+ */
+#define STM32_MAC_PTP_SSINC                                                 \
+  ((uint32_t)((0x100000000ULL + STM32_HCLK - 1) / STM32_HCLK))
+
+/**
+ * @brief   PTP clock nominal addend value.
+ * @details The accumulator overflows 2^31 / @p STM32_MAC_PTP_SSINC times
+ *          each second.
+ */
+#define STM32_MAC_PTP_ADDEND                                                \
+  ((uint32_t)(0x8000000000000000ULL /                                       \
+              ((uint64_t)STM32_MAC_PTP_SSINC * STM32_HCLK)))
+
+/**
+ * @brief   Frames time stamping capability.
+ */
+#define MAC_SUPPORTS_TIMESTAMPS         STM32_MAC_USE_PTP
+
+/**
+ * @brief   The PHY interrupt is served through the EXT driver.
+ */
+#define MAC_SUPPORTS_LINK_INTERRUPT     HAL_USE_EXT
+
+/**
+ * @brief   Full checksum offload capability.
+ */
+#define MAC_SUPPORTS_CHECKSUM_OFFLOAD   (STM32_MAC_IP_CHECKSUM_OFFLOAD == 3)
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -207,6 +358,12 @@ typedef struct {
   volatile uint32_t     rdes1;
   volatile uint32_t     rdes2;
   volatile uint32_t     rdes3;
+#if STM32_MAC_USE_PTP || defined(__DOXYGEN__)
+  volatile uint32_t     rdes4;
+  volatile uint32_t     rdes5;
+  volatile uint32_t     rdes6;
+  volatile uint32_t     rdes7;
+#endif
 } stm32_eth_rx_descriptor_t;
 
 /**
@@ -217,6 +374,12 @@ typedef struct {
   volatile uint32_t     tdes1;
   volatile uint32_t     tdes2;
   volatile uint32_t     tdes3;
+#if STM32_MAC_USE_PTP || defined(__DOXYGEN__)
+  volatile uint32_t     tdes4;
+  volatile uint32_t     tdes5;
+  volatile uint32_t     tdes6;
+  volatile uint32_t     tdes7;
+#endif
 } stm32_eth_tx_descriptor_t;
 
 /**
@@ -228,6 +391,33 @@ typedef struct {
    */
   uint8_t               *mac_address;
   /* End of the mandatory fields.*/
+#if HAL_USE_EXT || defined(__DOXYGEN__)
+  /**
+   * @brief EXT driver serving the PHY interrupt line.
+   * @details If @p NULL the PHY interrupt is not used and the link status
+   *          must be polled. The EXT driver must be already active when
+   *          the MAC driver is started.
+   */
+  EXTDriver             *phy_extp;
+  /**
+   * @brief EXT channel connected to the PHY interrupt line.
+   * @note  The channel callback must call @p macLinkChangedI(), the
+   *        channel is enabled and disabled by the MAC driver.
+   */
+  expchannel_t          phy_channel;
+  /**
+   * @brief PHY register enabling the link change interrupts.
+   */
+  uint16_t              phy_int_mask_reg;
+  /**
+   * @brief Value written in the interrupt enable register.
+   */
+  uint16_t              phy_int_mask;
+  /**
+   * @brief PHY interrupt status register, cleared on read.
+   */
+  uint16_t              phy_int_status_reg;
+#endif
 } MACConfig;
 
 /**
@@ -255,6 +445,14 @@ struct MACDriver {
    * @brief Receive event.
    */
   EventSource           rdevent;
+  /**
+   * @brief Transmit event.
+   */
+  EventSource           tdevent;
+  /**
+   * @brief Link status change event.
+   */
+  EventSource           lsevent;
 #endif
   /* End of the mandatory fields.*/
   /**
@@ -273,6 +471,12 @@ struct MACDriver {
    * @brief Transmit next frame pointer.
    */
   stm32_eth_tx_descriptor_t *txptr;
+#if STM32_MAC_IP_CHECKSUM_OFFLOAD || defined(__DOXYGEN__)
+  /**
+   * @brief Received frames discarded because of a checksum error.
+   */
+  uint32_t                  rxcsumerrors;
+#endif
 };
 
 /**
@@ -317,6 +521,47 @@ typedef struct {
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Reports if the link status changes are signaled by the PHY.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The link interrupt state.
+ *
+ * @notapi
+ */
+#define mac_lld_is_link_interrupt_enabled(macp)                             \
+  ((macp)->config->phy_extp != NULL)
+
+/**
+ * @brief   Returns the checksums verified by the hardware on a received
+ *          frame.
+ * @details Frames of IPv4 and IPv6 type have been fully verified, IPv4
+ *          fragments and frames with an unsupported payload only have the
+ *          header checksum verified.
+ * @note    In enhanced descriptor mode the status is read from the
+ *          extended status word.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @return              The verified checksums.
+ *
+ * @notapi
+ */
+#if STM32_MAC_USE_PTP || defined(__DOXYGEN__)
+#define mac_lld_get_receive_checksum_status(rdp)                            \
+  (!((rdp)->physdesc->rdes0 & STM32_RDES0_ESA) ||                           \
+   !((rdp)->physdesc->rdes4 & (STM32_RDES4_IPV4PR | STM32_RDES4_IPV6PR)) ?  \
+   MAC_CHECKSUM_NONE :                                                      \
+   ((rdp)->physdesc->rdes4 & STM32_RDES4_IPCB) ||                           \
+   !((rdp)->physdesc->rdes4 & STM32_RDES4_IPPT_MASK) ?                      \
+   MAC_CHECKSUM_IP : (MAC_CHECKSUM_IP | MAC_CHECKSUM_PAYLOAD))
+#else
+#define mac_lld_get_receive_checksum_status(rdp)                            \
+  (((rdp)->physdesc->rdes0 & STM32_RDES0_FT) ?                              \
+   (MAC_CHECKSUM_IP | MAC_CHECKSUM_PAYLOAD) :                               \
+   (((rdp)->physdesc->rdes0 & (STM32_RDES0_IPHCE | STM32_RDES0_PCE)) ==     \
+    STM32_RDES0_PCE) ? MAC_CHECKSUM_IP : MAC_CHECKSUM_NONE)
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -350,7 +595,26 @@ extern "C" {
                                             size_t *sizep);
   const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
                                                  size_t *sizep);
+  uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                       size_t *sizep);
+  void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf);
+  msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                  const MACTransmitSegment *segp,
+                                  unsigned n,
+                                  macreleasecb_t cb,
+                                  void *arg);
+  void mac_lld_reclaim_transmit_segments(MACDriver *macp);
 #endif /* MAC_USE_ZERO_COPY */
+#if STM32_MAC_USE_PTP
+  bool_t mac_lld_get_receive_timestamp(MACReceiveDescriptor *rdp,
+                                       MACTimestamp *tsp);
+  bool_t mac_lld_get_transmit_timestamp(MACTransmitDescriptor *tdp,
+                                        MACTimestamp *tsp);
+  void mac_lld_get_clock_time(MACDriver *macp, MACTimestamp *tsp);
+  bool_t mac_lld_set_clock_time(MACDriver *macp, const MACTimestamp *tsp);
+  bool_t mac_lld_adjust_clock_time(MACDriver *macp, int64_t offset);
+  bool_t mac_lld_adjust_clock_frequency(MACDriver *macp, int32_t ppb);
+#endif /* STM32_MAC_USE_PTP */
 #ifdef __cplusplus
 }
 #endif
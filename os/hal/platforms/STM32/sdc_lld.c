@@ -397,17 +397,22 @@ void sdc_lld_start_clk(SDCDriver *sdcp) {
 }
 
 /**
- * @brief   Sets the SDIO clock to data mode (25MHz or less).
+ * @brief   Sets the SDIO clock to data mode.
  *
  * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] clk       the bus clock, 25MHz or 50MHz (or less)
  *
  * @notapi
  */
-void sdc_lld_set_data_clk(SDCDriver *sdcp) {
+void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk) {
+  uint32_t clkcr = SDIO->CLKCR & ~(SDIO_CLKCR_BYPASS | 0x000000FF);
 
   (void)sdcp;
 
-  SDIO->CLKCR = (SDIO->CLKCR & 0xFFFFFF00) | STM32_SDIO_DIV_HS;
+  if (clk == SDC_CLK_50MHz)
+    SDIO->CLKCR = clkcr | STM32_SDIO_CLKCR_50MHZ;
+  else
+    SDIO->CLKCR = clkcr | STM32_SDIO_DIV_HS;
 }
 
 /**
@@ -579,6 +584,74 @@ bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
   return CH_SUCCESS;
 }
 
+/**
+ * @brief   Reads a card register through the data lines.
+ * @details This function is used for the data blocks shorter than
+ *          @p MMCSD_BLOCK_SIZE returned by commands like ACMD51 or CMD6.
+ * @note    The card must be in transfer state, the @p APP_CMD prefix, if
+ *          required, must be sent by the caller.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] buf      pointer to the read buffer, it must be aligned to 32
+ *                      bits
+ * @param[in] bytes     number of bytes to read, a power of two between 4 and
+ *                      @p MMCSD_BLOCK_SIZE
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                            uint8_t cmd, uint32_t arg) {
+  uint32_t resp[1];
+  uint32_t bsize;
+
+  chDbgCheck((bytes >= 4) && (bytes <= MMCSD_BLOCK_SIZE) &&
+             ((bytes & (bytes - 1)) == 0) && (((unsigned)buf & 3) == 0),
+             "sdc_lld_read_special");
+
+  SDIO->DTIMER = STM32_SDC_READ_TIMEOUT;
+
+  /* Prepares the DMA channel for reading.*/
+  dmaStreamSetMemory0(sdcp->dma, buf);
+  dmaStreamSetTransactionSize(sdcp->dma, bytes / sizeof (uint32_t));
+  dmaStreamSetMode(sdcp->dma, sdcp->dmamode | STM32_DMA_CR_DIR_P2M);
+  dmaStreamEnable(sdcp->dma);
+
+  /* Setting up data transfer, the block size field is log2(bytes).*/
+  for (bsize = 0; (1U << bsize) < bytes; bsize++)
+    ;
+  SDIO->ICR   = STM32_SDIO_ICR_ALL_FLAGS;
+  SDIO->MASK  = SDIO_MASK_DCRCFAILIE |
+                SDIO_MASK_DTIMEOUTIE |
+                SDIO_MASK_STBITERRIE |
+                SDIO_MASK_RXOVERRIE |
+                SDIO_MASK_DATAENDIE;
+  SDIO->DLEN  = bytes;
+
+  /* Transaction starts just after DTEN bit setting.*/
+  SDIO->DCTRL = SDIO_DCTRL_DTDIR |
+                (bsize << 4) |
+                SDIO_DCTRL_DMAEN |
+                SDIO_DCTRL_DTEN;
+
+  if (sdc_lld_send_cmd_short_crc(sdcp, cmd, arg, resp) ||
+      MMCSD_R1_ERROR(resp[0]))
+    goto error;
+  if (sdc_lld_wait_transaction_end(sdcp, 1, resp) == TRUE)
+    goto error;
+
+  return CH_SUCCESS;
+
+error:
+  sdc_lld_error_cleanup(sdcp, 1, resp);
+  return CH_FAILED;
+}
+
 /**
  * @brief   Reads one or more blocks.
  *
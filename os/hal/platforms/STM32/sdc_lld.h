@@ -137,23 +137,32 @@
 #endif
 
 /*
- * SDIO clock divider.
+ * SDIO clock divider. The high speed mode uses the bypass mode when the
+ * SDIO clock is within 50MHz, else the minimum divider.
  */
 #if (defined(STM32F4XX) || defined(STM32F2XX))
 #define STM32_SDIO_DIV_HS                   0
 #define STM32_SDIO_DIV_LS                   120
+#define STM32_SDIO_CLKCR_50MHZ              SDIO_CLKCR_BYPASS
+#define STM32_SDIO_DIV_50MHZ                1
 
 #elif STM32_HCLK > 48000000
 #define STM32_SDIO_DIV_HS                   1
 #define STM32_SDIO_DIV_LS                   178
+#define STM32_SDIO_CLKCR_50MHZ              0
+#define STM32_SDIO_DIV_50MHZ                2
 #else
 
 #define STM32_SDIO_DIV_HS                   0
 #define STM32_SDIO_DIV_LS                   118
+#define STM32_SDIO_CLKCR_50MHZ              SDIO_CLKCR_BYPASS
+#define STM32_SDIO_DIV_50MHZ                1
 #endif
 
 /**
  * @brief   SDIO data timeouts in SDIO clock cycles.
+ * @note    The timeouts are calculated for the fastest bus clock so they are
+ *          longer when the card runs at lower speed.
  */
 #if (defined(STM32F4XX) || defined(STM32F2XX))
 #if !STM32_CLOCK48_REQUIRED
@@ -161,15 +170,15 @@
 #endif
 
 #define STM32_SDC_WRITE_TIMEOUT                                             \
-  (((STM32_PLL48CLK / (STM32_SDIO_DIV_HS + 2)) / 1000) * SDC_WRITE_TIMEOUT_MS)
+  (((STM32_PLL48CLK / STM32_SDIO_DIV_50MHZ) / 1000) * SDC_WRITE_TIMEOUT_MS)
 #define STM32_SDC_READ_TIMEOUT                                              \
-  (((STM32_PLL48CLK / (STM32_SDIO_DIV_HS + 2)) / 1000) * SDC_READ_TIMEOUT_MS)
+  (((STM32_PLL48CLK / STM32_SDIO_DIV_50MHZ) / 1000) * SDC_READ_TIMEOUT_MS)
 
 #else
 #define STM32_SDC_WRITE_TIMEOUT                                             \
-  (((STM32_HCLK / (STM32_SDIO_DIV_HS + 2)) / 1000) * SDC_WRITE_TIMEOUT_MS)
+  (((STM32_HCLK / STM32_SDIO_DIV_50MHZ) / 1000) * SDC_WRITE_TIMEOUT_MS)
 #define STM32_SDC_READ_TIMEOUT                                              \
-  (((STM32_HCLK / (STM32_SDIO_DIV_HS + 2)) / 1000) * SDC_READ_TIMEOUT_MS)
+  (((STM32_HCLK / STM32_SDIO_DIV_50MHZ) / 1000) * SDC_READ_TIMEOUT_MS)
 #endif
 
 /*===========================================================================*/
@@ -185,6 +194,14 @@ typedef enum {
   SDC_MODE_8BIT
 } sdcbusmode_t;
 
+/**
+ * @brief   Type of SDIO bus clock.
+ */
+typedef enum {
+  SDC_CLK_25MHz = 0,
+  SDC_CLK_50MHz
+} sdcbusclk_t;
+
 /**
  * @brief   Type of card flags.
  */
@@ -202,10 +219,18 @@ typedef struct SDCDriver SDCDriver;
 
 /**
  * @brief   Driver configuration structure.
- * @note    It could be empty on some architectures.
+ * @note    The driver negotiates the fastest bus settings supported by the
+ *          card within the limits specified here.
  */
 typedef struct {
-  uint32_t dummy;
+  /**
+   * @brief Widest bus mode allowed by the board.
+   */
+  sdcbusmode_t              bus_width;
+  /**
+   * @brief Fastest bus clock allowed by the board.
+   */
+  sdcbusclk_t               bus_clk;
 } SDCConfig;
 
 /**
@@ -231,7 +256,7 @@ struct SDCDriver {
    * @brief Virtual Methods Table.
    */
   const struct SDCDriverVMT *vmt;
-  _mmcsd_block_device_data
+  _sdc_driver_data
   /**
    * @brief Current configuration data.
    */
@@ -289,7 +314,7 @@ extern "C" {
   void sdc_lld_start(SDCDriver *sdcp);
   void sdc_lld_stop(SDCDriver *sdcp);
   void sdc_lld_start_clk(SDCDriver *sdcp);
-  void sdc_lld_set_data_clk(SDCDriver *sdcp);
+  void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk);
   void sdc_lld_stop_clk(SDCDriver *sdcp);
   void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode);
   void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg);
@@ -299,6 +324,8 @@ extern "C" {
                                     uint32_t *resp);
   bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
                                    uint32_t *resp);
+  bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                              uint8_t cmd, uint32_t arg);
   bool_t sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
                       uint8_t *buf, uint32_t n);
   bool_t sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
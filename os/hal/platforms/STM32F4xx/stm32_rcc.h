@@ -523,6 +523,26 @@
                                          RCC_AHB1ENR_ETHMACTXEN |           \
                                          RCC_AHB1ENR_ETHMACRXEN, lp)
 
+/**
+ * @brief   Enables the ETH PTP clock.
+ * @note    The @p lp parameter is ignored in this family.
+ *
+ * @param[in] lp        low power enable flag
+ *
+ * @api
+ */
+#define rccEnableETHPTP(lp) rccEnableAHB1(RCC_AHB1ENR_ETHMACPTPEN, lp)
+
+/**
+ * @brief   Disables the ETH PTP clock.
+ * @note    The @p lp parameter is ignored in this family.
+ *
+ * @param[in] lp        low power enable flag
+ *
+ * @api
+ */
+#define rccDisableETHPTP(lp) rccDisableAHB1(RCC_AHB1ENR_ETHMACPTPEN, lp)
+
 /**
  * @brief   Resets the ETH peripheral.
  *
@@ -191,4 +191,25 @@ void halPolledDelay(halrtcnt_t ticks) {
 }
 #endif /* HAL_IMPLEMENTS_COUNTERS */
 
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+/**
+ * @brief   Time source of the kernel locks profiler.
+ * @details The realtime counter is used if implemented by the platform, the
+ *          system time otherwise. With the system time most of the short
+ *          contentions would be accounted as zero.
+ *
+ * @return              The current time in counter or system ticks.
+ *
+ * @special
+ */
+uint32_t halGetLocksCounter(void) {
+
+#if HAL_IMPLEMENTS_COUNTERS
+  return (uint32_t)halGetCounterValue();
+#else
+  return (uint32_t)chTimeNow();
+#endif
+}
+#endif /* CH_DBG_LOCKS_PROFILING */
+
 /** @} */
@@ -86,6 +86,8 @@ void macObjectInit(MACDriver *macp) {
   chSemInit(&macp->rdsem, 0);
 #if MAC_USE_EVENTS
   chEvtInit(&macp->rdevent);
+  chEvtInit(&macp->tdevent);
+  chEvtInit(&macp->lsevent);
 #endif
 }
 
@@ -267,6 +269,199 @@ bool_t macPollLinkStatus(MACDriver *macp) {
   return mac_lld_poll_link_status(macp);
 }
 
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @brief   Notifies a link status change.
+ * @details Broadcasts the link status change event, the listeners are
+ *          expected to call @p macPollLinkStatus() in order to read the new
+ *          status from the PHY.
+ * @note    This function is meant to be invoked by the callback of the
+ *          PHY interrupt line.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @iclass
+ */
+void macLinkChangedI(MACDriver *macp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((macp != NULL), "macLinkChangedI");
+
+  chEvtBroadcastI(&macp->lsevent);
+}
+#endif /* MAC_USE_EVENTS */
+
+#if MAC_SUPPORTS_TIMESTAMPS || defined(__DOXYGEN__)
+/**
+ * @brief   Reads the MAC clock.
+ * @details The MAC clock is the time base of the frames time stamps.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] tsp      pointer to a @p MACTimestamp structure
+ *
+ * @api
+ */
+void macGetClockTime(MACDriver *macp, MACTimestamp *tsp) {
+
+  chDbgCheck((macp != NULL) && (tsp != NULL), "macGetClockTime");
+  chDbgAssert(macp->state == MAC_ACTIVE, "macGetClockTime(), #1",
+              "not active");
+
+  mac_lld_get_clock_time(macp, tsp);
+}
+
+/**
+ * @brief   Sets the MAC clock.
+ * @note    The clock is reset to zero each time the driver is started.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] tsp       pointer to a @p MACTimestamp structure
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @api
+ */
+bool_t macSetClockTime(MACDriver *macp, const MACTimestamp *tsp) {
+
+  chDbgCheck((macp != NULL) && (tsp != NULL) &&
+             (tsp->nanoseconds < 1000000000), "macSetClockTime");
+  chDbgAssert(macp->state == MAC_ACTIVE, "macSetClockTime(), #1",
+              "not active");
+
+  return mac_lld_set_clock_time(macp, tsp);
+}
+
+/**
+ * @brief   Steps the MAC clock.
+ * @details The offset is added atomically to the running clock.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] offset    offset in nanoseconds, negative values move the
+ *                      clock backward
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @api
+ */
+bool_t macAdjustClockTime(MACDriver *macp, int64_t offset) {
+
+  chDbgCheck((macp != NULL), "macAdjustClockTime");
+  chDbgAssert(macp->state == MAC_ACTIVE, "macAdjustClockTime(), #1",
+              "not active");
+
+  return mac_lld_adjust_clock_time(macp, offset);
+}
+
+/**
+ * @brief   Adjusts the MAC clock rate.
+ * @details The adjustment replaces the previous one, it is not cumulative.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] ppb       frequency offset from the nominal rate in parts per
+ *                      billion, positive values make the clock faster
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the clock did not accept the update.
+ *
+ * @api
+ */
+bool_t macAdjustClockFrequency(MACDriver *macp, int32_t ppb) {
+
+  chDbgCheck((macp != NULL) && (ppb > -1000000000) && (ppb < 1000000000),
+             "macAdjustClockFrequency");
+  chDbgAssert(macp->state == MAC_ACTIVE, "macAdjustClockFrequency(), #1",
+              "not active");
+
+  return mac_lld_adjust_clock_frequency(macp, ppb);
+}
+#endif /* MAC_SUPPORTS_TIMESTAMPS */
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Transmits a frame made of scattered segments.
+ * @details The segments are chained into the transmit descriptors and sent
+ *          directly from their memory, segments not accessible by the DMA
+ *          or having the @p copy flag set are copied in the descriptors
+ *          buffers. The memory of the segments transmitted in place must
+ *          not be modified nor freed until the callback @p cb is invoked,
+ *          this happens in the context of a thread invoking the transmit
+ *          functions after the frame has been transmitted or on
+ *          @p macReclaimTransmitSegments().
+ *          If enough descriptors are not currently available then the
+ *          invoking thread is queued until they are freed.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] segp      pointer to an array of @p MACTransmitSegment
+ *                      structures, the array itself is not used after the
+ *                      function returns
+ * @param[in] n         number of segments
+ * @param[in] cb        release callback
+ * @param[in] arg       argument for the release callback
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       the frame has been queued for transmission.
+ * @retval RDY_TIMEOUT  the operation timed out, the callback will not be
+ *                      invoked.
+ * @retval RDY_RESET    the frame cannot be described with the available
+ *                      descriptors, it must be transmitted using
+ *                      @p macWaitTransmitDescriptor() instead. The callback
+ *                      will not be invoked.
+ *
+ * @api
+ */
+msg_t macTransmitSegments(MACDriver *macp,
+                          const MACTransmitSegment *segp,
+                          unsigned n,
+                          macreleasecb_t cb,
+                          void *arg,
+                          systime_t time) {
+  msg_t msg;
+  systime_t now;
+
+  chDbgCheck((macp != NULL) && (segp != NULL) && (n > 0) && (cb != NULL),
+             "macTransmitSegments");
+  chDbgAssert(macp->state == MAC_ACTIVE, "macTransmitSegments(), #1",
+              "not active");
+
+  while (((msg = mac_lld_transmit_segments(macp, segp, n, cb, arg)) ==
+          RDY_TIMEOUT) && (time > 0)) {
+    chSysLock();
+    now = chTimeNow();
+    if ((msg = chSemWaitTimeoutS(&macp->tdsem, time)) == RDY_TIMEOUT) {
+      chSysUnlock();
+      break;
+    }
+    if (time != TIME_INFINITE)
+      time -= (chTimeNow() - now);
+    chSysUnlock();
+  }
+  return msg;
+}
+
+/**
+ * @brief   Invokes the release callbacks of the transmitted frames.
+ * @details Frames sent using @p macTransmitSegments() are released lazily
+ *          by the transmit functions, this function allows to release
+ *          them when there is no transmission activity.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @api
+ */
+void macReclaimTransmitSegments(MACDriver *macp) {
+
+  chDbgCheck((macp != NULL), "macReclaimTransmitSegments");
+
+  mac_lld_reclaim_transmit_segments(macp);
+}
+#endif /* MAC_USE_ZERO_COPY */
+
 #endif /* HAL_USE_MAC */
 
 /** @} */
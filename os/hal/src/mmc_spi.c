@@ -119,7 +119,7 @@ static bool_t mmc_read(void *instance, uint32_t startblk,
 static bool_t mmc_write(void *instance, uint32_t startblk,
                  const uint8_t *buffer, uint32_t n) {
 
-  if (mmcStartSequentialWrite((MMCDriver *)instance, startblk))
+  if (mmcStartMultipleWrite((MMCDriver *)instance, startblk, n))
       return CH_FAILED;
   while (n > 0) {
       if (mmcSequentialWrite((MMCDriver *)instance, buffer))
@@ -383,6 +383,7 @@ void mmcObjectInit(MMCDriver *mmcp) {
   mmcp->state = BLK_STOP;
   mmcp->config = NULL;
   mmcp->block_addresses = FALSE;
+  mmcp->pre_erase = FALSE;
 }
 
 /**
@@ -463,6 +464,10 @@ bool_t mmcConnect(MMCDriver *mmcp) {
     chThdSleepMilliseconds(10);
   }
 
+  /* The pre-erase command is SD specific, it is disabled on the first
+     failure.*/
+  mmcp->pre_erase = TRUE;
+
   /* Try to detect if this is a high capacity card and switch to block
      addresses if possible.
      This method is based on "How to support SDC Ver2 and high capacity cards"
@@ -688,13 +693,47 @@ bool_t mmcStopSequentialRead(MMCDriver *mmcp) {
 bool_t mmcStartSequentialWrite(MMCDriver *mmcp, uint32_t startblk) {
 
   chDbgCheck(mmcp != NULL, "mmcStartSequentialWrite");
+
+  return mmcStartMultipleWrite(mmcp, startblk, 0);
+}
+
+/**
+ * @brief   Starts a sequential write of a known number of blocks.
+ * @details On SD cards the number of blocks is announced using ACMD23 so
+ *          that the card can pre-erase the whole area before the data
+ *          transfer, this speeds up the following sequential writes.
+ * @note    Writing less blocks than announced is allowed, the content of
+ *          the remaining pre-erased blocks is undefined.
+ *
+ * @param[in] mmcp      pointer to the @p MMCDriver object
+ * @param[in] startblk  first block to write
+ * @param[in] n         number of blocks to be written or zero if unknown
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the operation failed.
+ *
+ * @api
+ */
+bool_t mmcStartMultipleWrite(MMCDriver *mmcp, uint32_t startblk, uint32_t n) {
+
+  chDbgCheck(mmcp != NULL, "mmcStartMultipleWrite");
   chDbgAssert(mmcp->state == BLK_READY,
-              "mmcStartSequentialWrite(), #1", "invalid state");
+              "mmcStartMultipleWrite(), #1", "invalid state");
 
   /* Write operation in progress.*/
   mmcp->state = BLK_WRITING;
 
   spiStart(mmcp->config->spip, mmcp->config->hscfg);
+
+  /* Pre-erase, MMC cards reject the command and the feature is disabled.*/
+  if ((n > 1) && mmcp->pre_erase) {
+    if ((send_command_R1(mmcp, MMCSD_CMD_APP_CMD, 0) != 0x00) ||
+        (send_command_R1(mmcp, MMCSD_CMD_SET_WR_BLK_ERASE_COUNT,
+                         n & 0x007FFFFF) != 0x00))
+      mmcp->pre_erase = FALSE;
+  }
+
   spiSelect(mmcp->config->spip);
   if (mmcp->block_addresses)
     send_hdr(mmcp, MMCSD_CMD_WRITE_MULTIPLE_BLOCK, startblk);
@@ -731,14 +770,17 @@ bool_t mmcSequentialWrite(MMCDriver *mmcp, const uint8_t *buffer) {
   if (mmcp->state != BLK_WRITING)
     return CH_FAILED;
 
+  /* Waits for the end of the programming of the previous block, the wait is
+     deferred so that the card programming time overlaps with the caller
+     preparing the next buffer.*/
+  wait(mmcp);
+
   spiSend(mmcp->config->spip, sizeof(start), start);    /* Data prologue.   */
   spiSend(mmcp->config->spip, MMCSD_BLOCK_SIZE, buffer);/* Data.            */
   spiIgnore(mmcp->config->spip, 2);                     /* CRC ignored.     */
   spiReceive(mmcp->config->spip, 1, b);
-  if ((b[0] & 0x1F) == 0x05) {
-    wait(mmcp);
+  if ((b[0] & 0x1F) == 0x05)
     return CH_SUCCESS;
-  }
 
   /* Error.*/
   spiUnselect(mmcp->config->spip);
@@ -766,6 +808,8 @@ bool_t mmcStopSequentialWrite(MMCDriver *mmcp) {
   if (mmcp->state != BLK_WRITING)
     return CH_FAILED;
 
+  /* The last block must be programmed before the stop token.*/
+  wait(mmcp);
   spiSend(mmcp->config->spip, sizeof(stop), stop);
   spiUnselect(mmcp->config->spip);
 
@@ -35,6 +35,40 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+/**
+ * @name    SCR fields
+ * @{
+ */
+#define SDC_SCR_SD_SPEC(scr)            ((scr)[0] & 0x0F)
+#define SDC_SCR_BUS_WIDTHS(scr)         ((scr)[1] & 0x0F)
+#define SDC_SCR_BUS_WIDTH_4             0x04
+/** @} */
+
+/**
+ * @name    CMD6 arguments and status fields for the access mode group
+ * @{
+ */
+#define SDC_CMD6_CHECK_HIGH_SPEED       0x00FFFFF1
+#define SDC_CMD6_SWITCH_HIGH_SPEED      0x80FFFFF1
+#define SDC_CMD6_HIGH_SPEED_SUPPORT(st) (((st)[13] & 0x02) != 0)
+#define SDC_CMD6_GROUP1_FUNCTION(st)    ((st)[16] & 0x0F)
+/** @} */
+
+/**
+ * @name    Driver lock
+ * @details The lock serializes the synchronous APIs against the requests
+ *          served by the asynchronous worker thread.
+ * @{
+ */
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+#define sdc_lock(sdcp)                  chMtxLock(&(sdcp)->mutex)
+#define sdc_unlock(sdcp)                chMtxUnlock()
+#else
+#define sdc_lock(sdcp)
+#define sdc_unlock(sdcp)
+#endif
+/** @} */
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -43,6 +77,15 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Default configuration, the fastest settings supported by the
+ *          card are selected.
+ */
+static const SDCConfig default_config = {
+  SDC_MODE_4BIT,
+  SDC_CLK_50MHz
+};
+
 /**
  * @brief   Virtual methods table.
  */
@@ -61,6 +104,279 @@ static const struct SDCDriverVMT sdc_vmt = {
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Negotiates the bus width and timing with an SD card.
+ * @details The SCR is read in order to find the supported bus widths and
+ *          the specification version, cards compliant with version 1.10
+ *          or later are then queried using CMD6 for the high speed mode.
+ *          The fastest settings supported by both the card and the board
+ *          configuration are selected.
+ * @note    A card refusing the high speed switch is not an error, the bus
+ *          clock is left at 25MHz.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+static bool_t sdc_negotiate_bus(SDCDriver *sdcp) {
+  uint32_t resp[1];
+  uint32_t buf[MMCSD_SWITCH_STATUS_SIZE / sizeof (uint32_t)];
+  uint8_t *bp = (uint8_t *)buf;
+  uint8_t spec;
+
+  /* Reads the SCR register.*/
+  if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_APP_CMD, sdcp->rca, resp) ||
+      MMCSD_R1_ERROR(resp[0]))
+    return CH_FAILED;
+  if (sdc_lld_read_special(sdcp, bp, MMCSD_SCR_SIZE, MMCSD_CMD_SEND_SCR, 0))
+    return CH_FAILED;
+  spec = SDC_SCR_SD_SPEC(bp);
+
+  /* Switches to wide bus mode if supported by both sides.*/
+  if ((sdcp->config->bus_width != SDC_MODE_1BIT) &&
+      (SDC_SCR_BUS_WIDTHS(bp) & SDC_SCR_BUS_WIDTH_4)) {
+    sdc_lld_set_bus_mode(sdcp, SDC_MODE_4BIT);
+    if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_APP_CMD, sdcp->rca, resp) ||
+        MMCSD_R1_ERROR(resp[0]))
+      return CH_FAILED;
+    if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_SET_BUS_WIDTH, 2, resp) ||
+        MMCSD_R1_ERROR(resp[0]))
+      return CH_FAILED;
+  }
+
+  /* CMD6 is supported starting from the specification version 1.10.*/
+  if ((sdcp->config->bus_clk == SDC_CLK_25MHz) || (spec < 1))
+    return CH_SUCCESS;
+
+  /* Checks the high speed function support then switches to it.*/
+  if (sdc_lld_read_special(sdcp, bp, MMCSD_SWITCH_STATUS_SIZE,
+                           MMCSD_CMD_SWITCH, SDC_CMD6_CHECK_HIGH_SPEED) ||
+      !SDC_CMD6_HIGH_SPEED_SUPPORT(bp))
+    return CH_SUCCESS;
+  if (sdc_lld_read_special(sdcp, bp, MMCSD_SWITCH_STATUS_SIZE,
+                           MMCSD_CMD_SWITCH, SDC_CMD6_SWITCH_HIGH_SPEED) ||
+      (SDC_CMD6_GROUP1_FUNCTION(bp) != 1))
+    return CH_SUCCESS;
+
+  /* The card timing changes within 8 clocks after the switch status block,
+     the bus clock can be raised now.*/
+  sdc_lld_set_data_clk(sdcp, SDC_CLK_50MHz);
+  sdcp->cardmode |= SDC_MODE_HIGH_SPEED;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Reads one or more blocks.
+ * @note    The driver lock must be owned by the caller.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to read
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ */
+static bool_t sdc_read(SDCDriver *sdcp, uint32_t startblk,
+                       uint8_t *buf, uint32_t n) {
+  bool_t status;
+
+  chDbgAssert(sdcp->state == BLK_READY, "sdc_read(), #1", "invalid state");
+
+  if ((startblk + n - 1) > sdcp->capacity){
+    sdcp->errors |= SDC_OVERFLOW_ERROR;
+    return CH_FAILED;
+  }
+
+  /* Read operation in progress.*/
+  sdcp->state = BLK_READING;
+
+  status = sdc_lld_read(sdcp, startblk, buf, n);
+
+  /* Read operation finished.*/
+  sdcp->state = BLK_READY;
+  return status;
+}
+
+/**
+ * @brief   Writes one or more blocks.
+ * @note    The driver lock must be owned by the caller.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] startblk  first block to write
+ * @param[out] buf      pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ */
+static bool_t sdc_write(SDCDriver *sdcp, uint32_t startblk,
+                        const uint8_t *buf, uint32_t n) {
+  bool_t status;
+
+  chDbgAssert(sdcp->state == BLK_READY, "sdc_write(), #1", "invalid state");
+
+  if ((startblk + n - 1) > sdcp->capacity){
+    sdcp->errors |= SDC_OVERFLOW_ERROR;
+    return CH_FAILED;
+  }
+
+  /* Write operation in progress.*/
+  sdcp->state = BLK_WRITING;
+
+  status = sdc_lld_write(sdcp, startblk, buf, n);
+
+  /* Write operation finished.*/
+  sdcp->state = BLK_READY;
+  return status;
+}
+
+/**
+ * @brief   Waits for card idle condition.
+ * @note    The driver lock must be owned by the caller.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the operation failed.
+ */
+static bool_t sdc_sync(SDCDriver *sdcp) {
+  bool_t result;
+
+  if (sdcp->state != BLK_READY)
+    return CH_FAILED;
+
+  /* Synchronization operation in progress.*/
+  sdcp->state = BLK_SYNCING;
+
+  result = sdc_lld_sync(sdcp);
+
+  /* Synchronization operation finished.*/
+  sdcp->state = BLK_READY;
+  return result;
+}
+
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Asynchronous requests worker thread.
+ * @details The requests are served in order. Queued read or write requests
+ *          continuing the current one both on the card and in memory are
+ *          merged into a single multi-block transfer. The next transfer is
+ *          started as soon as the previous one completed, the card busy
+ *          time is awaited by the low level driver before the next command.
+ *          The driver lock is held during each transfer, the callbacks are
+ *          invoked with the lock released.
+ *
+ * @param[in] p         pointer to the @p SDCDriver object
+ */
+static msg_t sdc_async_thread(void *p) {
+  SDCDriver *sdcp = p;
+  SDCRequest *batch[SDC_ASYNC_QUEUE_SIZE];
+  SDCRequest *rqp;
+  sdccallback_t callback;
+  sdcflags_t errors;
+  unsigned i, cnt;
+  uint32_t n;
+  bool_t result;
+  msg_t msg;
+
+  chRegSetThreadName("sdc_async");
+  while (TRUE) {
+    chMBFetch(&sdcp->async_queue, &msg, TIME_INFINITE);
+    batch[0] = (SDCRequest *)msg;
+    cnt = 1;
+    n = batch[0]->n;
+
+    /* Merging the queued requests contiguous to the first one.*/
+    if (batch[0]->type != SDC_REQ_SYNC) {
+      chSysLock();
+      while ((cnt < SDC_ASYNC_QUEUE_SIZE) &&
+             (chMBGetUsedCountI(&sdcp->async_queue) > 0)) {
+        rqp = (SDCRequest *)chMBPeekI(&sdcp->async_queue);
+        if ((rqp->type != batch[0]->type) ||
+            (rqp->startblk != batch[0]->startblk + n) ||
+            (rqp->buf != batch[0]->buf + n * MMCSD_BLOCK_SIZE))
+          break;
+        chMBFetchI(&sdcp->async_queue, &msg);
+        batch[cnt++] = rqp;
+        n += rqp->n;
+      }
+      chSchRescheduleS();
+      chSysUnlock();
+    }
+
+    /* The card could have been disconnected meanwhile.*/
+    sdc_lock(sdcp);
+    if (sdcp->state != BLK_READY)
+      result = CH_FAILED;
+    else {
+      switch (batch[0]->type) {
+      case SDC_REQ_READ:
+        result = sdc_read(sdcp, batch[0]->startblk, batch[0]->buf, n);
+        break;
+      case SDC_REQ_WRITE:
+        result = sdc_write(sdcp, batch[0]->startblk, batch[0]->buf, n);
+        break;
+      default:
+        result = sdc_sync(sdcp);
+      }
+    }
+    chSysLock();
+    errors = sdcp->errors;
+    sdcp->errors = SDC_NO_ERROR;
+    chSysUnlock();
+    sdc_unlock(sdcp);
+
+    /* Completion, a request is notified either through its callback or
+       through its semaphore, never both, so the request is not touched
+       anymore after the notification and it can be reused or resubmitted
+       by its owner.*/
+    for (i = 0; i < cnt; i++) {
+      rqp = batch[i];
+      callback = rqp->callback;
+      rqp->result = result;
+      rqp->errors = errors;
+      if (callback != NULL)
+        callback(sdcp, rqp);
+      else
+        chBSemSignal(&rqp->done);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief   Queues an asynchronous request.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] rqp       pointer to the @p SDCRequest object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   request queued.
+ * @retval CH_FAILED    the queue is full.
+ */
+static bool_t sdc_async_post(SDCDriver *sdcp, SDCRequest *rqp) {
+  msg_t msg;
+
+  chBSemInit(&rqp->done, TRUE);
+  rqp->result = CH_FAILED;
+  rqp->errors = SDC_NO_ERROR;
+
+  chSysLock();
+  chDbgAssert(sdcp->async_thread != NULL,
+              "sdc_async_post(), #1", "driver not started");
+  msg = chMBPostS(&sdcp->async_queue, (msg_t)rqp, TIME_IMMEDIATE);
+  chSysUnlock();
+  return msg == RDY_OK ? CH_SUCCESS : CH_FAILED;
+}
+#endif /* SDC_USE_ASYNC */
+
 /**
  * @brief   Wait for the card to complete pending operations.
  *
@@ -130,6 +446,11 @@ void sdcObjectInit(SDCDriver *sdcp) {
   sdcp->errors   = SDC_NO_ERROR;
   sdcp->config   = NULL;
   sdcp->capacity = 0;
+#if SDC_USE_ASYNC
+  chMtxInit(&sdcp->mutex);
+  chMBInit(&sdcp->async_queue, sdcp->async_buffer, SDC_ASYNC_QUEUE_SIZE);
+  sdcp->async_thread = NULL;
+#endif
 }
 
 /**
@@ -146,9 +467,20 @@ void sdcStart(SDCDriver *sdcp, const SDCConfig *config) {
 
   chDbgCheck(sdcp != NULL, "sdcStart");
 
+#if SDC_USE_ASYNC
+  /* The worker thread is spawned on the first activation.*/
+  if (sdcp->async_thread == NULL)
+    sdcp->async_thread = chThdCreateStatic(sdcp->async_wa,
+                                           sizeof(sdcp->async_wa),
+                                           SDC_ASYNC_PRIORITY,
+                                           sdc_async_thread, sdcp);
+#endif
+
   chSysLock();
   chDbgAssert((sdcp->state == BLK_STOP) || (sdcp->state == BLK_ACTIVE),
               "sdcStart(), #1", "invalid state");
+  if (config == NULL)
+    config = &default_config;
   sdcp->config = config;
   sdc_lld_start(sdcp);
   sdcp->state = BLK_ACTIVE;
@@ -192,6 +524,8 @@ bool_t sdcConnect(SDCDriver *sdcp) {
   uint32_t resp[1];
 
   chDbgCheck(sdcp != NULL, "sdcConnect");
+
+  sdc_lock(sdcp);
   chDbgAssert((sdcp->state == BLK_ACTIVE) || (sdcp->state == BLK_READY),
               "mmcConnect(), #1", "invalid state");
 
@@ -276,8 +610,8 @@ bool_t sdcConnect(SDCDriver *sdcp) {
                                 sdcp->rca, sdcp->csd))
     goto failed;
 
-  /* Switches to high speed.*/
-  sdc_lld_set_data_clk(sdcp);
+  /* Switches to data mode clock.*/
+  sdc_lld_set_data_clk(sdcp, SDC_CLK_25MHz);
 
   /* Selects the card for operations.*/
   if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_SEL_DESEL_CARD,
@@ -290,16 +624,11 @@ bool_t sdcConnect(SDCDriver *sdcp) {
       MMCSD_R1_ERROR(resp[0]))
     goto failed;
 
-  /* Switches to wide bus mode.*/
+  /* Switches to the fastest bus mode and clock.*/
   switch (sdcp->cardmode & SDC_MODE_CARDTYPE_MASK) {
   case SDC_MODE_CARDTYPE_SDV11:
   case SDC_MODE_CARDTYPE_SDV20:
-    sdc_lld_set_bus_mode(sdcp, SDC_MODE_4BIT);
-    if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_APP_CMD, sdcp->rca, resp) ||
-        MMCSD_R1_ERROR(resp[0]))
-      goto failed;
-    if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_SET_BUS_WIDTH, 2, resp) ||
-        MMCSD_R1_ERROR(resp[0]))
+    if (sdc_negotiate_bus(sdcp))
       goto failed;
     break;
   }
@@ -311,12 +640,14 @@ bool_t sdcConnect(SDCDriver *sdcp) {
 
   /* Initialization complete.*/
   sdcp->state = BLK_READY;
+  sdc_unlock(sdcp);
   return CH_SUCCESS;
 
   /* Connection failed, state reset to BLK_ACTIVE.*/
 failed:
   sdc_lld_stop_clk(sdcp);
   sdcp->state = BLK_ACTIVE;
+  sdc_unlock(sdcp);
   return CH_FAILED;
 }
 
@@ -335,11 +666,13 @@ bool_t sdcDisconnect(SDCDriver *sdcp) {
 
   chDbgCheck(sdcp != NULL, "sdcDisconnect");
 
+  sdc_lock(sdcp);
   chSysLock();
   chDbgAssert((sdcp->state == BLK_ACTIVE) || (sdcp->state == BLK_READY),
               "sdcDisconnect(), #1", "invalid state");
   if (sdcp->state == BLK_ACTIVE) {
     chSysUnlock();
+    sdc_unlock(sdcp);
     return CH_SUCCESS;
   }
   sdcp->state = BLK_DISCONNECTING;
@@ -349,12 +682,14 @@ bool_t sdcDisconnect(SDCDriver *sdcp) {
   if (_sdc_wait_for_transfer_state(sdcp)) {
     sdc_lld_stop_clk(sdcp);
     sdcp->state = BLK_ACTIVE;
+    sdc_unlock(sdcp);
     return CH_FAILED;
   }
 
   /* Card clock stopped.*/
   sdc_lld_stop_clk(sdcp);
   sdcp->state = BLK_ACTIVE;
+  sdc_unlock(sdcp);
   return CH_SUCCESS;
 }
 
@@ -379,20 +714,10 @@ bool_t sdcRead(SDCDriver *sdcp, uint32_t startblk,
   bool_t status;
 
   chDbgCheck((sdcp != NULL) && (buf != NULL) && (n > 0), "sdcRead");
-  chDbgAssert(sdcp->state == BLK_READY, "sdcRead(), #1", "invalid state");
-
-  if ((startblk + n - 1) > sdcp->capacity){
-    sdcp->errors |= SDC_OVERFLOW_ERROR;
-    return CH_FAILED;
-  }
-
-  /* Read operation in progress.*/
-  sdcp->state = BLK_READING;
-
-  status = sdc_lld_read(sdcp, startblk, buf, n);
 
-  /* Read operation finished.*/
-  sdcp->state = BLK_READY;
+  sdc_lock(sdcp);
+  status = sdc_read(sdcp, startblk, buf, n);
+  sdc_unlock(sdcp);
   return status;
 }
 
@@ -417,20 +742,10 @@ bool_t sdcWrite(SDCDriver *sdcp, uint32_t startblk,
   bool_t status;
 
   chDbgCheck((sdcp != NULL) && (buf != NULL) && (n > 0), "sdcWrite");
-  chDbgAssert(sdcp->state == BLK_READY, "sdcWrite(), #1", "invalid state");
-
-  if ((startblk + n - 1) > sdcp->capacity){
-    sdcp->errors |= SDC_OVERFLOW_ERROR;
-    return CH_FAILED;
-  }
 
-  /* Write operation in progress.*/
-  sdcp->state = BLK_WRITING;
-
-  status = sdc_lld_write(sdcp, startblk, buf, n);
-
-  /* Write operation finished.*/
-  sdcp->state = BLK_READY;
+  sdc_lock(sdcp);
+  status = sdc_write(sdcp, startblk, buf, n);
+  sdc_unlock(sdcp);
   return status;
 }
 
@@ -472,16 +787,9 @@ bool_t sdcSync(SDCDriver *sdcp) {
 
   chDbgCheck(sdcp != NULL, "sdcSync");
 
-  if (sdcp->state != BLK_READY)
-    return CH_FAILED;
-
-  /* Synchronization operation in progress.*/
-  sdcp->state = BLK_SYNCING;
-
-  result = sdc_lld_sync(sdcp);
-
-  /* Synchronization operation finished.*/
-  sdcp->state = BLK_READY;
+  sdc_lock(sdcp);
+  result = sdc_sync(sdcp);
+  sdc_unlock(sdcp);
   return result;
 }
 
@@ -528,6 +836,8 @@ bool_t sdcErase(SDCDriver *sdcp, uint32_t startblk, uint32_t endblk) {
   uint32_t resp[1];
 
   chDbgCheck((sdcp != NULL), "sdcErase");
+
+  sdc_lock(sdcp);
   chDbgAssert(sdcp->state == BLK_READY, "sdcErase(), #1", "invalid state");
 
   /* Erase operation in progress.*/
@@ -563,13 +873,149 @@ bool_t sdcErase(SDCDriver *sdcp, uint32_t startblk, uint32_t endblk) {
   _sdc_wait_for_transfer_state(sdcp);
 
   sdcp->state = BLK_READY;
+  sdc_unlock(sdcp);
   return CH_SUCCESS;
 
 failed:
   sdcp->state = BLK_READY;
+  sdc_unlock(sdcp);
   return CH_FAILED;
 }
 
+#if SDC_USE_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Starts an asynchronous read operation.
+ * @details The request is queued and the function returns immediately,
+ *          the completion is notified through the callback if specified,
+ *          else through the request semaphore, see @p sdcWaitRequest().
+ * @pre     The driver must be in the @p BLK_READY state when the request
+ *          is served.
+ * @note    The synchronous APIs can be used while asynchronous requests
+ *          are pending, they are serialized with the queued transfers.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] rqp      pointer to the @p SDCRequest object
+ * @param[in] startblk  first block to read
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] n         number of blocks to read
+ * @param[in] callback  completion callback or @p NULL
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   request queued.
+ * @retval CH_FAILED    the requests queue is full.
+ *
+ * @api
+ */
+bool_t sdcStartRead(SDCDriver *sdcp, SDCRequest *rqp, uint32_t startblk,
+                    uint8_t *buf, uint32_t n, sdccallback_t callback) {
+
+  chDbgCheck((sdcp != NULL) && (rqp != NULL) && (buf != NULL) && (n > 0),
+             "sdcStartRead");
+
+  rqp->type     = SDC_REQ_READ;
+  rqp->startblk = startblk;
+  rqp->buf      = buf;
+  rqp->n        = n;
+  rqp->callback = callback;
+  return sdc_async_post(sdcp, rqp);
+}
+
+/**
+ * @brief   Starts an asynchronous write operation.
+ * @details The request is queued and the function returns immediately,
+ *          the completion is notified through the callback if specified,
+ *          else through the request semaphore, see @p sdcWaitRequest().
+ * @pre     The driver must be in the @p BLK_READY state when the request
+ *          is served.
+ * @note    The synchronous APIs can be used while asynchronous requests
+ *          are pending, they are serialized with the queued transfers.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] rqp      pointer to the @p SDCRequest object
+ * @param[in] startblk  first block to write
+ * @param[in] buf       pointer to the write buffer, it must not be modified
+ *                      until the request completion
+ * @param[in] n         number of blocks to write
+ * @param[in] callback  completion callback or @p NULL
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   request queued.
+ * @retval CH_FAILED    the requests queue is full.
+ *
+ * @api
+ */
+bool_t sdcStartWrite(SDCDriver *sdcp, SDCRequest *rqp, uint32_t startblk,
+                     const uint8_t *buf, uint32_t n, sdccallback_t callback) {
+
+  chDbgCheck((sdcp != NULL) && (rqp != NULL) && (buf != NULL) && (n > 0),
+             "sdcStartWrite");
+
+  rqp->type     = SDC_REQ_WRITE;
+  rqp->startblk = startblk;
+  rqp->buf      = (uint8_t *)buf;
+  rqp->n        = n;
+  rqp->callback = callback;
+  return sdc_async_post(sdcp, rqp);
+}
+
+/**
+ * @brief   Starts an asynchronous synchronization operation.
+ * @details The request completes after all the previously queued requests
+ *          and when the card is idle. The completion is notified through
+ *          the callback if specified, else through the request semaphore,
+ *          see @p sdcWaitRequest().
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] rqp      pointer to the @p SDCRequest object
+ * @param[in] callback  completion callback or @p NULL
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   request queued.
+ * @retval CH_FAILED    the requests queue is full.
+ *
+ * @api
+ */
+bool_t sdcStartSync(SDCDriver *sdcp, SDCRequest *rqp,
+                    sdccallback_t callback) {
+
+  chDbgCheck((sdcp != NULL) && (rqp != NULL), "sdcStartSync");
+
+  rqp->type     = SDC_REQ_SYNC;
+  rqp->startblk = 0;
+  rqp->buf      = NULL;
+  rqp->n        = 0;
+  rqp->callback = callback;
+  return sdc_async_post(sdcp, rqp);
+}
+
+/**
+ * @brief   Waits for the completion of an asynchronous request.
+ * @details The result of the operation can be retrieved using
+ *          @p sdcGetRequestResult() after a successful wait.
+ * @pre     The request must have been started without a callback, the
+ *          requests with a callback are only notified through the callback.
+ *
+ * @param[in] rqp       pointer to a queued @p SDCRequest object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The wait result.
+ * @retval RDY_OK       if the request has been completed.
+ * @retval RDY_TIMEOUT  if the request has not been completed within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t sdcWaitRequest(SDCRequest *rqp, systime_t time) {
+
+  chDbgCheck((rqp != NULL) && (rqp->callback == NULL), "sdcWaitRequest");
+
+  return chBSemWaitTimeout(&rqp->done, time);
+}
+#endif /* SDC_USE_ASYNC */
+
 #endif /* HAL_USE_SDC */
 
 /** @} */
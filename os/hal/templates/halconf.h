@@ -296,6 +296,13 @@
 #if !defined(SDC_NICE_WAITING) || defined(__DOXYGEN__)
 #define SDC_NICE_WAITING            TRUE
 #endif
+
+/**
+ * @brief   Enables the asynchronous requests API.
+ */
+#if !defined(SDC_USE_ASYNC) || defined(__DOXYGEN__)
+#define SDC_USE_ASYNC               FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
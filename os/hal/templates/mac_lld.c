@@ -306,6 +306,82 @@ const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
 
   return NULL;
 }
+
+/**
+ * @brief   Takes ownership of the buffer of a received frame.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the frame size
+ * @return              Pointer to the loaned buffer.
+ * @retval NULL         if no spare buffers are available.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                     size_t *sizep) {
+
+  (void)rdp;
+  (void)sizep;
+
+  return NULL;
+}
+
+/**
+ * @brief   Gives back a loaned receive buffer.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the loaned buffer
+ *
+ * @notapi
+ */
+void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf) {
+
+  (void)macp;
+  (void)buf;
+}
+
+/**
+ * @brief   Queues a frame made of scattered segments for transmission.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] segp      pointer to an array of @p MACTransmitSegment
+ * @param[in] n         number of segments
+ * @param[in] cb        release callback
+ * @param[in] arg       argument for the release callback
+ * @return              The operation status.
+ * @retval RDY_OK       the frame has been queued for transmission.
+ * @retval RDY_TIMEOUT  descriptors not available.
+ * @retval RDY_RESET    the frame cannot be described with the available
+ *                      descriptors.
+ *
+ * @notapi
+ */
+msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                const MACTransmitSegment *segp,
+                                unsigned n,
+                                macreleasecb_t cb,
+                                void *arg) {
+
+  (void)macp;
+  (void)segp;
+  (void)n;
+  (void)cb;
+  (void)arg;
+
+  return RDY_RESET;
+}
+
+/**
+ * @brief   Invokes the release callbacks of the transmitted frames.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_reclaim_transmit_segments(MACDriver *macp) {
+
+  (void)macp;
+}
 #endif /* MAC_USE_ZERO_COPY */
 
 #endif /* HAL_USE_MAC */
@@ -97,6 +97,14 @@ struct MACDriver {
    * @brief Receive event.
    */
   EventSource           rdevent;
+  /**
+   * @brief Transmit event.
+   */
+  EventSource           tdevent;
+  /**
+   * @brief Link status change event.
+   */
+  EventSource           lsevent;
 #endif
   /* End of the mandatory fields.*/
 };
@@ -168,6 +176,15 @@ extern "C" {
                                             size_t *sizep);
   const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
                                                  size_t *sizep);
+  uint8_t *mac_lld_loan_receive_buffer(MACReceiveDescriptor *rdp,
+                                       size_t *sizep);
+  void mac_lld_return_receive_buffer(MACDriver *macp, uint8_t *buf);
+  msg_t mac_lld_transmit_segments(MACDriver *macp,
+                                  const MACTransmitSegment *segp,
+                                  unsigned n,
+                                  macreleasecb_t cb,
+                                  void *arg);
+  void mac_lld_reclaim_transmit_segments(MACDriver *macp);
 #endif /* MAC_USE_ZERO_COPY */
 #ifdef __cplusplus
 }
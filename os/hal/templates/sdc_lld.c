@@ -109,15 +109,17 @@ void sdc_lld_start_clk(SDCDriver *sdcp) {
 }
 
 /**
- * @brief   Sets the SDIO clock to data mode (25MHz or less).
+ * @brief   Sets the SDIO clock to data mode.
  *
  * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] clk       the bus clock, 25MHz or 50MHz (or less)
  *
  * @notapi
  */
-void sdc_lld_set_data_clk(SDCDriver *sdcp) {
+void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk) {
 
   (void)sdcp;
+  (void)clk;
 }
 
 /**
@@ -249,6 +251,35 @@ bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
   return CH_SUCCESS;
 }
 
+/**
+ * @brief   Reads a card register through the data lines.
+ * @note    The card must be in transfer state, the @p APP_CMD prefix, if
+ *          required, must be sent by the caller.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] bytes     number of bytes to read
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                            uint8_t cmd, uint32_t arg) {
+
+  (void)sdcp;
+  (void)buf;
+  (void)bytes;
+  (void)cmd;
+  (void)arg;
+
+  return CH_SUCCESS;
+}
+
 /**
  * @brief   Reads one or more blocks.
  *
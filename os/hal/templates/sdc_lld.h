@@ -65,6 +65,14 @@ typedef enum {
   SDC_MODE_8BIT
 } sdcbusmode_t;
 
+/**
+ * @brief   Type of SDIO bus clock.
+ */
+typedef enum {
+  SDC_CLK_25MHz = 0,
+  SDC_CLK_50MHz
+} sdcbusclk_t;
+
 /**
  * @brief   Type of card flags.
  */
@@ -82,10 +90,18 @@ typedef struct SDCDriver SDCDriver;
 
 /**
  * @brief   Driver configuration structure.
- * @note    It could be empty on some architectures.
+ * @note    The driver negotiates the fastest bus settings supported by the
+ *          card within the limits specified here.
  */
 typedef struct {
-  uint32_t                  dummy;
+  /**
+   * @brief Widest bus mode allowed by the board.
+   */
+  sdcbusmode_t              bus_width;
+  /**
+   * @brief Fastest bus clock allowed by the board.
+   */
+  sdcbusclk_t               bus_clk;
 } SDCConfig;
 
 /**
@@ -111,7 +127,7 @@ struct SDCDriver {
    * @brief Virtual Methods Table.
    */
   const struct SDCDriverVMT *vmt;
-  _mmcsd_block_device_data
+  _sdc_driver_data
   /**
    * @brief Current configuration data.
    */
@@ -176,7 +192,7 @@ extern "C" {
   void sdc_lld_start(SDCDriver *sdcp);
   void sdc_lld_stop(SDCDriver *sdcp);
   void sdc_lld_start_clk(SDCDriver *sdcp);
-  void sdc_lld_set_data_clk(SDCDriver *sdcp);
+  void sdc_lld_set_data_clk(SDCDriver *sdcp, sdcbusclk_t clk);
   void sdc_lld_stop_clk(SDCDriver *sdcp);
   void sdc_lld_set_bus_mode(SDCDriver *sdcp, sdcbusmode_t mode);
   void sdc_lld_send_cmd_none(SDCDriver *sdcp, uint8_t cmd, uint32_t arg);
@@ -186,6 +202,8 @@ extern "C" {
                                     uint32_t *resp);
   bool_t sdc_lld_send_cmd_long_crc(SDCDriver *sdcp, uint8_t cmd, uint32_t arg,
                                    uint32_t *resp);
+  bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                              uint8_t cmd, uint32_t arg);
   bool_t sdc_lld_read(SDCDriver *sdcp, uint32_t startblk,
                       uint8_t *buf, uint32_t n);
   bool_t sdc_lld_write(SDCDriver *sdcp, uint32_t startblk,
@@ -107,6 +107,7 @@
 #include "chsys.h"
 #include "chvt.h"
 #include "chschd.h"
+#include "chwait.h"
 #include "chsem.h"
 #include "chbsem.h"
 #include "chmtx.h"
@@ -46,6 +46,10 @@
  */
 typedef struct CondVar {
   ThreadsQueue          c_queue;        /**< @brief CondVar threads queue.*/
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+  struct LockProfile    *c_prof;        /**< @brief Profile record or
+                                                    @p NULL.                */
+#endif
 } CondVar;
 
 #ifdef __cplusplus
@@ -73,7 +77,8 @@ extern "C" {
  *
  * @param[in] name      the name of the condition variable
  */
-#define _CONDVAR_DATA(name) {_THREADSQUEUE_DATA(name.c_queue)}
+#define _CONDVAR_DATA(name) {_THREADSQUEUE_DATA(name.c_queue)                \
+                             _LOCKPROFILE_DATA}
 
 /**
  * @brief Static condition variable initializer.
@@ -70,6 +70,18 @@
 #define CH_THREAD_FILL_VALUE        0xFF
 #endif
 
+/**
+ * @brief   Time source for the locks profiler.
+ * @details By default the time is read through @p halGetLocksCounter(),
+ *          it returns the HAL realtime counter value if implemented by the
+ *          platform and the system time otherwise. The macro can be
+ *          redefined in @p chconf.h in order to use a different counter,
+ *          this is required when the kernel is used without the HAL.
+ */
+#ifndef CH_DBG_LOCKS_PROFILING_COUNTER
+#define CH_DBG_LOCKS_PROFILING_COUNTER() halGetLocksCounter()
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -132,6 +144,113 @@ extern ch_trace_buffer_t dbg_trace_buffer;
 #define dbg_trace(otp)
 #endif
 
+/*===========================================================================*/
+/* Locks profiler related structures and macros.                             */
+/*===========================================================================*/
+
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+typedef struct LockProfile LockProfile;
+
+/**
+ * @brief   Lock profile record.
+ * @details Contention statistics of a @p Mutex, @p Semaphore or
+ *          @p CondVar object, times are expressed in
+ *          @p CH_DBG_LOCKS_PROFILING_COUNTER() units.
+ * @note    The hold time is only accounted for mutexes.
+ * @note    For condition variables each wait is accounted as a contended
+ *          acquisition.
+ */
+struct LockProfile {
+  LockProfile           *lp_next;   /**< @brief Next registered profile.    */
+  const char            *lp_name;   /**< @brief Object name or @p NULL.     */
+  uint32_t              lp_locks;   /**< @brief Acquisitions counter.       */
+  uint32_t              lp_contended; /**< @brief Acquisitions requiring a
+                                                  wait.                     */
+  uint32_t              lp_boosts;  /**< @brief Priority inheritance boosts
+                                                of the owner.               */
+  uint32_t              lp_wait_total; /**< @brief Total wait time.         */
+  uint32_t              lp_wait_max; /**< @brief Worst wait time.           */
+  uint32_t              lp_hold_total; /**< @brief Total hold time.         */
+  uint32_t              lp_hold_max; /**< @brief Worst hold time.           */
+  uint32_t              lp_locked_at; /**< @brief Time of the last
+                                                  acquisition.              */
+};
+
+/**
+ * @brief   Trailing part of the static initializers of the profiled objects.
+ */
+#define _LOCKPROFILE_DATA , NULL
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the first registered lock profile.
+ * @details The other profiles can be reached following the @p lp_next
+ *          field, the list is terminated by @p NULL.
+ *
+ * @special
+ */
+#define chDbgGetFirstLockProfile() (dbg_lockprof_list)
+
+/**
+ * @brief   Registers a mutex in the locks profiler.
+ *
+ * @param[in] mp        pointer to the @p Mutex structure
+ * @param[out] lpp      pointer to the @p LockProfile structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chDbgProfileMutex(mp, lpp, name) {                                  \
+  chDbgRegisterLockProfile(lpp, name);                                      \
+  (mp)->m_prof = (lpp);                                                     \
+}
+
+/**
+ * @brief   Registers a semaphore in the locks profiler.
+ *
+ * @param[in] sp        pointer to the @p Semaphore structure
+ * @param[out] lpp      pointer to the @p LockProfile structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chDbgProfileSemaphore(sp, lpp, name) {                              \
+  chDbgRegisterLockProfile(lpp, name);                                      \
+  (sp)->s_prof = (lpp);                                                     \
+}
+
+/**
+ * @brief   Registers a condition variable in the locks profiler.
+ *
+ * @param[in] cp        pointer to the @p CondVar structure
+ * @param[out] lpp      pointer to the @p LockProfile structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chDbgProfileCondVar(cp, lpp, name) {                                \
+  chDbgRegisterLockProfile(lpp, name);                                      \
+  (cp)->c_prof = (lpp);                                                     \
+}
+/** @} */
+
+#if !defined(__DOXYGEN__)
+extern LockProfile *dbg_lockprof_list;
+#endif
+
+#else /* !CH_DBG_LOCKS_PROFILING */
+/* When the profiler is disabled these functions are replaced by empty
+   macros.*/
+#define _LOCKPROFILE_DATA
+#define dbg_lockprof_acquired(lpp)
+#define dbg_lockprof_waited(lpp, start)
+#define dbg_lockprof_released(lpp)
+#define dbg_lockprof_boosted(lpp)
+#endif /* !CH_DBG_LOCKS_PROFILING */
+
 /*===========================================================================*/
 /* Parameters checking related macros.                                       */
 /*===========================================================================*/
@@ -234,6 +353,15 @@ extern "C" {
   void _trace_init(void);
   void dbg_trace(Thread *otp);
 #endif
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+  void dbg_lockprof_acquired(LockProfile *lpp);
+  void dbg_lockprof_waited(LockProfile *lpp, uint32_t start);
+  void dbg_lockprof_released(LockProfile *lpp);
+  void dbg_lockprof_boosted(LockProfile *lpp);
+  void chDbgRegisterLockProfile(LockProfile *lpp, const char *name);
+  void chDbgResetLockProfile(LockProfile *lpp);
+  uint32_t halGetLocksCounter(void);
+#endif
 #if CH_DBG_ENABLED
   extern const char *dbg_panic_msg;
   void chDbgPanic(const char *msg);
@@ -59,6 +59,11 @@ typedef struct EventSource {
   EventListener         *es_next;       /**< @brief First Event Listener
                                                     registered on the Event
                                                     Source.                 */
+#if CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+  WaitObject            *es_wlist;      /**< @brief Descriptors of the threads
+                                                    waiting on multiple
+                                                    objects.                */
+#endif
 } EventSource;
 
 /**
@@ -72,7 +77,7 @@ typedef void (*evhandler_t)(eventid_t);
  *          source that is part of a bigger structure.
  * @param name the name of the event source variable
  */
-#define _EVENTSOURCE_DATA(name) {(void *)(&name)}
+#define _EVENTSOURCE_DATA(name) {(void *)(&name) _WAITLIST_DATA}
 
 /**
  * @brief   Static event source initializer.
@@ -124,8 +129,13 @@ typedef void (*evhandler_t)(eventid_t);
  *
  * @init
  */
+#if !CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
 #define chEvtInit(esp) \
   ((esp)->es_next = (EventListener *)(void *)(esp))
+#else
+#define chEvtInit(esp) \
+  ((esp)->es_next = (EventListener *)(void *)(esp), (esp)->es_wlist = NULL)
+#endif
 
 /**
  * @brief   Verifies if there is at least one @p EventListener registered.
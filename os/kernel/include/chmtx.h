@@ -41,12 +41,35 @@ typedef struct Mutex {
                                                 @p NULL.                    */
   struct Mutex          *m_next;    /**< @brief Next @p Mutex into an
                                                 owner-list or @p NULL.      */
+#if CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+  cnt_t                 m_cnt;      /**< @brief Lock operations of the owner
+                                                pending on this mutex, the
+                                                first lock included.        */
+  bool_t                m_recursive; /**< @brief The owner can lock the
+                                                mutex again.                */
+#endif
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+  tprio_t               m_ceiling;  /**< @brief Priority ceiling or zero for
+                                                a priority inheritance
+                                                mutex.                      */
+  tprio_t               m_prevprio; /**< @brief Owner priority before the
+                                                ceiling was applied.        */
+#endif
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+  struct LockProfile    *m_prof;    /**< @brief Profile record or @p NULL.  */
+#endif
 } Mutex;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   void chMtxInit(Mutex *mp);
+#if CH_USE_MUTEXES_CEILING
+  void chMtxInitCeiling(Mutex *mp, tprio_t ceiling);
+#endif
+#if CH_USE_MUTEXES_RECURSIVE
+  void chMtxInitRecursive(Mutex *mp);
+#endif
   void chMtxLock(Mutex *mp);
   void chMtxLockS(Mutex *mp);
   bool_t chMtxTryLock(Mutex *mp);
@@ -58,6 +81,32 @@ extern "C" {
 }
 #endif
 
+/**
+ * @brief   Recursion part of the static mutex initializers.
+ * @details It expands to nothing when the @p CH_USE_MUTEXES_RECURSIVE option
+ *          is disabled.
+ *
+ * @param[in] recursive @p TRUE for a recursive mutex
+ */
+#if !CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+#define _MUTEX_RECURSIVE_PART(recursive)
+#else
+#define _MUTEX_RECURSIVE_PART(recursive) , 0, (recursive)
+#endif
+
+/**
+ * @brief   Ceiling part of the static mutex initializers.
+ * @details It expands to nothing when the @p CH_USE_MUTEXES_CEILING option
+ *          is disabled.
+ *
+ * @param[in] ceiling   the priority ceiling or zero
+ */
+#if !CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+#define _MUTEX_CEILING_PART(ceiling)
+#else
+#define _MUTEX_CEILING_PART(ceiling) , (ceiling), 0
+#endif
+
 /**
  * @brief   Data part of a static mutex initializer.
  * @details This macro should be used when statically initializing a mutex
@@ -65,7 +114,9 @@ extern "C" {
  *
  * @param[in] name      the name of the mutex variable
  */
-#define _MUTEX_DATA(name) {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL}
+#define _MUTEX_DATA(name) {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL     \
+                           _MUTEX_RECURSIVE_PART(FALSE)                     \
+                           _MUTEX_CEILING_PART(0) _LOCKPROFILE_DATA}
 
 /**
  * @brief   Static mutex initializer.
@@ -76,6 +127,54 @@ extern "C" {
  */
 #define MUTEX_DECL(name) Mutex name = _MUTEX_DATA(name)
 
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @brief   Data part of a static priority ceiling mutex initializer.
+ * @details This macro should be used when statically initializing a
+ *          priority ceiling mutex that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the priority ceiling
+ */
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL _MUTEX_RECURSIVE_PART(FALSE) \
+   _MUTEX_CEILING_PART(ceiling) _LOCKPROFILE_DATA}
+
+/**
+ * @brief   Static priority ceiling mutex initializer.
+ * @details Statically initialized mutexes require no explicit initialization
+ *          using @p chMtxInitCeiling().
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the priority ceiling
+ */
+#define MUTEX_CEILING_DECL(name, ceiling)                                   \
+  Mutex name = _MUTEX_CEILING_DATA(name, ceiling)
+#endif /* CH_USE_MUTEXES_CEILING */
+
+#if CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+/**
+ * @brief   Data part of a static recursive mutex initializer.
+ * @details This macro should be used when statically initializing a
+ *          recursive mutex that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the mutex variable
+ */
+#define _MUTEX_RECURSIVE_DATA(name)                                         \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL _MUTEX_RECURSIVE_PART(TRUE) \
+   _MUTEX_CEILING_PART(0) _LOCKPROFILE_DATA}
+
+/**
+ * @brief   Static recursive mutex initializer.
+ * @details Statically initialized mutexes require no explicit initialization
+ *          using @p chMtxInitRecursive().
+ *
+ * @param[in] name      the name of the mutex variable
+ */
+#define MUTEX_RECURSIVE_DECL(name)                                          \
+  Mutex name = _MUTEX_RECURSIVE_DATA(name)
+#endif /* CH_USE_MUTEXES_RECURSIVE */
+
 /**
  * @name    Macro Functions
  * @{
@@ -69,6 +69,10 @@ struct GenericQueue {
   uint8_t               *q_rdptr;   /**< @brief Read pointer.               */
   qnotify_t             q_notify;   /**< @brief Data notification callback. */
   void                  *q_link;    /**< @brief Application defined field.  */
+#if CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+  WaitObject            *q_wlist;   /**< @brief Descriptors of the threads
+                                                waiting on multiple objects.*/
+#endif
 };
 
 /**
@@ -208,6 +212,7 @@ typedef GenericQueue InputQueue;
   (uint8_t *)(buffer),                                                      \
   (inotify),                                                                \
   (link)                                                                    \
+  _WAITLIST_DATA                                                            \
 }
 
 /**
@@ -325,6 +330,7 @@ typedef GenericQueue OutputQueue;
   (uint8_t *)(buffer),                                                      \
   (onotify),                                                                \
   (link)                                                                    \
+  _WAITLIST_DATA                                                            \
 }
 
 /**
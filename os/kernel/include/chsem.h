@@ -38,6 +38,13 @@ typedef struct Semaphore {
   ThreadsQueue          s_queue;    /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 s_cnt;      /**< @brief The semaphore counter.      */
+#if CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+  WaitObject            *s_wlist;   /**< @brief Descriptors of the threads
+                                                waiting on multiple objects.*/
+#endif
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+  struct LockProfile    *s_prof;    /**< @brief Profile record or @p NULL.  */
+#endif
 } Semaphore;
 
 #ifdef __cplusplus
@@ -69,7 +76,8 @@ extern "C" {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
-#define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n}
+#define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n        \
+                                  _WAITLIST_DATA _LOCKPROFILE_DATA}
 
 /**
  * @brief   Static semaphore initializer.
@@ -98,6 +106,7 @@ extern "C" {
  * @brief   Increases the semaphore counter.
  * @details This macro can be used when the counter is known to be not
  *          negative.
+ * @note    Threads waiting in @p chWaitMultiple() are not notified.
  *
  * @iclass
  */
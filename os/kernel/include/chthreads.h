@@ -50,7 +50,9 @@
                                          answer.                            */
 #define THD_STATE_WTMSG         12  /**< @brief Waiting for a message.      */
 #define THD_STATE_WTQUEUE       13  /**< @brief Waiting on an I/O queue.    */
-#define THD_STATE_FINAL         14  /**< @brief Thread terminated.          */
+#define THD_STATE_WTMULTI       14  /**< @brief Waiting on multiple
+                                         objects.                           */
+#define THD_STATE_FINAL         15  /**< @brief Thread terminated.          */
 
 /**
  * @brief   Thread states as array of strings.
@@ -60,7 +62,7 @@
 #define THD_STATE_NAMES                                                     \
   "READY", "CURRENT", "SUSPENDED", "WTSEM", "WTMTX", "WTCOND", "SLEEPING",  \
   "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ", "SNDMSG", "WTMSG", "WTQUEUE", \
-  "FINAL"
+  "WTMULTI", "FINAL"
 /** @} */
 
 /**
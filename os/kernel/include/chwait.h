@@ -0,0 +1,131 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwait.h
+ * @brief   Multiple objects wait macros and structures.
+ *
+ * @addtogroup waitmultiple
+ * @{
+ */
+
+#ifndef _CHWAIT_H_
+#define _CHWAIT_H_
+
+/**
+ * @brief   Trailing part of the static initializers of the waitable objects.
+ * @details Initializes the descriptors list when the @p CH_USE_WAITMULTIPLE
+ *          option is enabled, it expands to nothing otherwise.
+ */
+#if !CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+#define _WAITLIST_DATA
+#else
+#define _WAITLIST_DATA , NULL
+#endif
+
+#if CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+
+/**
+ * @name    Waitable object types
+ * @{
+ */
+#define WAIT_SEMAPHORE          0   /**< @brief Semaphore counter positive. */
+#define WAIT_INPUTQUEUE         1   /**< @brief Input queue not empty.      */
+#define WAIT_OUTPUTQUEUE        2   /**< @brief Output queue not full.      */
+#define WAIT_MAILBOX            3   /**< @brief Mailbox message pending.    */
+#define WAIT_EVENTSOURCE        4   /**< @brief Event source broadcasted.   */
+/** @} */
+
+typedef struct WaitObject WaitObject;
+
+/**
+ * @brief   Waitable object descriptor.
+ * @details A descriptor binds a kernel object to a @p chWaitMultiple()
+ *          call, it also works as the link element used to attach the
+ *          waiting thread to the object for the duration of the wait.
+ */
+struct WaitObject {
+  WaitObject            *wo_next;       /**< @brief Next descriptor attached
+                                                    to the same object.     */
+  Thread                *wo_thread;     /**< @brief Thread waiting on the
+                                                    object.                 */
+  void                  *wo_objp;       /**< @brief Pointer to the kernel
+                                                    object.                 */
+  uint8_t               wo_type;        /**< @brief Type of the kernel
+                                                    object.                 */
+  bool_t                wo_signaled;    /**< @brief Object signaled during
+                                                    the wait.               */
+};
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Notifies the descriptors attached to an object.
+ * @details The threads waiting on the objects list, if any, are made ready.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] wlp       the list of the descriptors attached to the object
+ *
+ * @iclass
+ */
+#define chWaitNotifyI(wlp) {                                                \
+  if ((wlp) != NULL)                                                        \
+    _wait_notify(wlp);                                                      \
+}
+/** @} */
+
+/**
+ * @brief   Data part of a static waitable object descriptor initializer.
+ *
+ * @param[in] type      the type of the kernel object
+ * @param[in] objp      pointer to the kernel object
+ */
+#define _WAITOBJECT_DATA(type, objp) {NULL, NULL, (void *)(objp), (type),  \
+                                      FALSE}
+
+/**
+ * @brief   Static waitable object descriptor initializer.
+ *
+ * @param[in] name      the name of the descriptor variable
+ * @param[in] type      the type of the kernel object
+ * @param[in] objp      pointer to the kernel object
+ */
+#define WAITOBJECT_DECL(name, type, objp)                                   \
+  WaitObject name = _WAITOBJECT_DATA(type, objp)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _wait_notify(WaitObject *wlp);
+  void chWaitObjectInit(WaitObject *wop, uint8_t type, void *objp);
+  eventmask_t chWaitMultiple(WaitObject *wobjs, cnt_t n, systime_t time);
+  eventmask_t chWaitMultipleS(WaitObject *wobjs, cnt_t n, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_WAITMULTIPLE */
+
+#endif /* _CHWAIT_H_ */
+
+/** @} */
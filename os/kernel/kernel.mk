@@ -15,6 +15,7 @@ KERNSRC = ${CHIBIOS}/os/kernel/src/chsys.c \
           ${CHIBIOS}/os/kernel/src/chmsg.c \
           ${CHIBIOS}/os/kernel/src/chmboxes.c \
           ${CHIBIOS}/os/kernel/src/chqueues.c \
+          ${CHIBIOS}/os/kernel/src/chwait.c \
           ${CHIBIOS}/os/kernel/src/chmemcore.c \
           ${CHIBIOS}/os/kernel/src/chheap.c \
           ${CHIBIOS}/os/kernel/src/chmempools.c
@@ -54,6 +54,9 @@ void chCondInit(CondVar *cp) {
   chDbgCheck(cp != NULL, "chCondInit");
 
   queue_init(&cp->c_queue);
+#if CH_DBG_LOCKS_PROFILING
+  cp->c_prof = NULL;
+#endif
 }
 
 /**
@@ -178,6 +181,12 @@ msg_t chCondWaitS(CondVar *cp) {
   Thread *ctp = currp;
   Mutex *mp;
   msg_t msg;
+#if CH_USE_MUTEXES_RECURSIVE
+  cnt_t cnt;
+#endif
+#if CH_DBG_LOCKS_PROFILING
+  uint32_t start;
+#endif
 
   chDbgCheckClassS();
   chDbgCheck(cp != NULL, "chCondWaitS");
@@ -185,12 +194,25 @@ msg_t chCondWaitS(CondVar *cp) {
               "chCondWaitS(), #1",
               "not owning a mutex");
 
+#if CH_USE_MUTEXES_RECURSIVE
+  /* The mutex is fully released during the wait regardless of the nested
+     locks, the counter is restored after re-acquiring it.*/
+  cnt = ctp->p_mtxlist->m_cnt;
+  ctp->p_mtxlist->m_cnt = 1;
+#endif
   mp = chMtxUnlockS();
   ctp->p_u.wtobjp = cp;
   prio_insert(ctp, &cp->c_queue);
+#if CH_DBG_LOCKS_PROFILING
+  start = CH_DBG_LOCKS_PROFILING_COUNTER();
+#endif
   chSchGoSleepS(THD_STATE_WTCOND);
   msg = ctp->p_u.rdymsg;
+  dbg_lockprof_waited(cp->c_prof, start);
   chMtxLockS(mp);
+#if CH_USE_MUTEXES_RECURSIVE
+  mp->m_cnt = cnt;
+#endif
   return msg;
 }
 
@@ -263,6 +285,12 @@ msg_t chCondWaitTimeout(CondVar *cp, systime_t time) {
 msg_t chCondWaitTimeoutS(CondVar *cp, systime_t time) {
   Mutex *mp;
   msg_t msg;
+#if CH_USE_MUTEXES_RECURSIVE
+  cnt_t cnt;
+#endif
+#if CH_DBG_LOCKS_PROFILING
+  uint32_t start;
+#endif
 
   chDbgCheckClassS();
   chDbgCheck((cp != NULL) && (time != TIME_IMMEDIATE), "chCondWaitTimeoutS");
@@ -270,12 +298,24 @@ msg_t chCondWaitTimeoutS(CondVar *cp, systime_t time) {
               "chCondWaitTimeoutS(), #1",
               "not owning a mutex");
 
+#if CH_USE_MUTEXES_RECURSIVE
+  cnt = currp->p_mtxlist->m_cnt;
+  currp->p_mtxlist->m_cnt = 1;
+#endif
   mp = chMtxUnlockS();
   currp->p_u.wtobjp = cp;
   prio_insert(currp, &cp->c_queue);
+#if CH_DBG_LOCKS_PROFILING
+  start = CH_DBG_LOCKS_PROFILING_COUNTER();
+#endif
   msg = chSchGoSleepTimeoutS(THD_STATE_WTCOND, time);
-  if (msg != RDY_TIMEOUT)
+  if (msg != RDY_TIMEOUT) {
+    dbg_lockprof_waited(cp->c_prof, start);
     chMtxLockS(mp);
+#if CH_USE_MUTEXES_RECURSIVE
+    mp->m_cnt = cnt;
+#endif
+  }
   return msg;
 }
 #endif /* CH_USE_CONDVARS_TIMEOUT */
@@ -39,6 +39,7 @@
  *            - SV#11, misplaced S-class function.
  *            .
  *          - Trace buffer.
+ *          - Locks contention profiler.
  *          - Parameters check.
  *          - Kernel assertions.
  *          - Kernel panics.
@@ -244,6 +245,133 @@ void dbg_trace(Thread *otp) {
 }
 #endif /* CH_DBG_ENABLE_TRACE */
 
+/*===========================================================================*/
+/* Locks profiler related code and variables.                                */
+/*===========================================================================*/
+
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+/**
+ * @brief   List of the registered lock profiles.
+ */
+LockProfile *dbg_lockprof_list;
+
+/**
+ * @brief   Accounts an uncontended acquisition.
+ *
+ * @param[in] lpp       pointer to the @p LockProfile structure or @p NULL
+ *
+ * @notapi
+ */
+void dbg_lockprof_acquired(LockProfile *lpp) {
+
+  if (lpp != NULL) {
+    lpp->lp_locks++;
+    lpp->lp_locked_at = CH_DBG_LOCKS_PROFILING_COUNTER();
+  }
+}
+
+/**
+ * @brief   Accounts an acquisition after a wait.
+ *
+ * @param[in] lpp       pointer to the @p LockProfile structure or @p NULL
+ * @param[in] start     counter value at the beginning of the wait
+ *
+ * @notapi
+ */
+void dbg_lockprof_waited(LockProfile *lpp, uint32_t start) {
+
+  if (lpp != NULL) {
+    uint32_t now = CH_DBG_LOCKS_PROFILING_COUNTER();
+    uint32_t t = now - start;
+
+    lpp->lp_locks++;
+    lpp->lp_contended++;
+    lpp->lp_wait_total += t;
+    if (t > lpp->lp_wait_max)
+      lpp->lp_wait_max = t;
+    lpp->lp_locked_at = now;
+  }
+}
+
+/**
+ * @brief   Accounts a release.
+ *
+ * @param[in] lpp       pointer to the @p LockProfile structure or @p NULL
+ *
+ * @notapi
+ */
+void dbg_lockprof_released(LockProfile *lpp) {
+
+  if (lpp != NULL) {
+    uint32_t t = CH_DBG_LOCKS_PROFILING_COUNTER() - lpp->lp_locked_at;
+
+    lpp->lp_hold_total += t;
+    if (t > lpp->lp_hold_max)
+      lpp->lp_hold_max = t;
+  }
+}
+
+/**
+ * @brief   Accounts a priority inheritance boost.
+ *
+ * @param[in] lpp       pointer to the @p LockProfile structure or @p NULL
+ *
+ * @notapi
+ */
+void dbg_lockprof_boosted(LockProfile *lpp) {
+
+  if (lpp != NULL)
+    lpp->lp_boosts++;
+}
+
+/**
+ * @brief   Initializes a lock profile and registers it.
+ * @note    Registering an already registered profile just clears its
+ *          statistics.
+ *
+ * @param[out] lpp      pointer to the @p LockProfile structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+void chDbgRegisterLockProfile(LockProfile *lpp, const char *name) {
+  LockProfile *p;
+
+  chDbgCheck(lpp != NULL, "chDbgRegisterLockProfile");
+
+  chSysLock();
+  lpp->lp_name = name;
+  chDbgResetLockProfile(lpp);
+  p = dbg_lockprof_list;
+  while ((p != NULL) && (p != lpp))
+    p = p->lp_next;
+  if (p == NULL) {
+    lpp->lp_next = dbg_lockprof_list;
+    dbg_lockprof_list = lpp;
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Clears the statistics of a lock profile.
+ *
+ * @param[out] lpp      pointer to the @p LockProfile structure
+ *
+ * @special
+ */
+void chDbgResetLockProfile(LockProfile *lpp) {
+
+  lpp->lp_locks      = 0;
+  lpp->lp_contended  = 0;
+  lpp->lp_boosts     = 0;
+  lpp->lp_wait_total = 0;
+  lpp->lp_wait_max   = 0;
+  lpp->lp_hold_total = 0;
+  lpp->lp_hold_max   = 0;
+  lpp->lp_locked_at  = 0;
+}
+#endif /* CH_DBG_LOCKS_PROFILING */
+
 /*===========================================================================*/
 /* Panic related code and variables.                                         */
 /*===========================================================================*/
@@ -186,6 +186,9 @@ void chEvtBroadcastFlagsI(EventSource *esp, flagsmask_t flags) {
     chEvtSignalI(elp->el_listener, elp->el_mask);
     elp = elp->el_next;
   }
+#if CH_USE_WAITMULTIPLE
+  chWaitNotifyI(esp->es_wlist);
+#endif
 }
 
 /**
@@ -58,6 +58,34 @@
  *          The mechanism works with any number of nested mutexes and any
  *          number of involved threads. The algorithm complexity (worst case)
  *          is N with N equal to the number of nested mutexes.
+ *
+ *          <h2>Priority ceiling mutexes</h2>
+ *          When the @p CH_USE_MUTEXES_CEILING option is enabled a mutex can
+ *          be initialized with a static priority ceiling using
+ *          @p chMtxInitCeiling(), such mutexes implement the <b>immediate</b>
+ *          priority ceiling protocol instead of the priority inheritance.<br>
+ *          The owner of the mutex is raised to the ceiling priority as soon
+ *          as the mutex is taken, this is an O(1) operation and there is no
+ *          dependencies chain to explore. When the mutex is released the
+ *          previous priority is restored, raised to the priority of the
+ *          threads waiting on the other mutexes still owned by the thread,
+ *          so the release is O(N) with N equal to the number of owned
+ *          mutexes, as the priority recalculation of the priority
+ *          inheritance unlock. The ceiling must be equal or
+ *          higher than the base priority of any thread using the mutex,
+ *          under this condition the lock operation never has to wait
+ *          unless the owner sleeps while holding the mutex and locking
+ *          sections protected by ceiling mutexes cannot deadlock.
+ *
+ *          <h2>Recursive mutexes</h2>
+ *          When the @p CH_USE_MUTEXES_RECURSIVE option is enabled a mutex
+ *          can be initialized as recursive using @p chMtxInitRecursive(),
+ *          the owner of such a mutex can lock it again, the other mutexes
+ *          are not affected. The nested lock is accounted on the mutex on
+ *          top of the owner stack of owned mutexes, so the unlock operations
+ *          are still performed in lock-reverse order even when the re-locked
+ *          mutex is not the last locked one, the mutex is released when the
+ *          matching number of unlock operations has been performed.
  * @pre     In order to use the mutex APIs the @p CH_USE_MUTEXES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling mutexes requires 5-12 (depending on the architecture)
@@ -69,6 +97,48 @@
 
 #if CH_USE_MUTEXES || defined(__DOXYGEN__)
 
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @brief   Applies the priority ceiling of a mutex to its new owner.
+ * @note    The macro has no effect on priority inheritance mutexes because
+ *          their ceiling is zero.
+ */
+#define ceiling_enter(mp, tp) {                                             \
+  (mp)->m_prevprio = (tp)->p_prio;                                          \
+  if ((tp)->p_prio < (mp)->m_ceiling)                                       \
+    (tp)->p_prio = (mp)->m_ceiling;                                         \
+}
+
+/**
+ * @brief   Restores the owner priority after releasing a ceiling mutex.
+ * @details The priority the thread had before taking the mutex is raised
+ *          to the priority of the threads waiting on the mutexes still
+ *          owned, boosts acquired through the priority inheritance while
+ *          the ceiling was applied are preserved.
+ * @note    The owned mutexes list is scanned because the threads waiting
+ *          on an outer mutex with priority lower than the ceiling do not
+ *          boost the owner, their priority is not recorded anywhere else.
+ *          The complexity is O(N) with N equal to the number of mutexes
+ *          still owned by the thread.
+ *
+ * @param[in] ump       pointer to the released @p Mutex structure
+ * @param[in] tp        pointer to the former owner thread
+ */
+static void ceiling_exit(Mutex *ump, Thread *tp) {
+  tprio_t newprio = ump->m_prevprio;
+  Mutex *mp = tp->p_mtxlist;
+
+  while (mp != NULL) {
+    if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
+      newprio = mp->m_queue.p_next->p_prio;
+    mp = mp->m_next;
+  }
+  tp->p_prio = newprio;
+}
+#else
+#define ceiling_enter(mp, tp)
+#endif
+
 /**
  * @brief   Initializes s @p Mutex structure.
  *
@@ -82,7 +152,57 @@ void chMtxInit(Mutex *mp) {
 
   queue_init(&mp->m_queue);
   mp->m_owner = NULL;
+#if CH_USE_MUTEXES_RECURSIVE
+  mp->m_cnt = 0;
+  mp->m_recursive = FALSE;
+#endif
+#if CH_USE_MUTEXES_CEILING
+  mp->m_ceiling = 0;
+#endif
+#if CH_DBG_LOCKS_PROFILING
+  mp->m_prof = NULL;
+#endif
+}
+
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes s @p Mutex structure as a priority ceiling mutex.
+ * @note    The ceiling must be equal or higher than the base priority of
+ *          all the threads that will lock the mutex.
+ *
+ * @param[out] mp       pointer to a @p Mutex structure
+ * @param[in] ceiling   the priority ceiling
+ *
+ * @init
+ */
+void chMtxInitCeiling(Mutex *mp, tprio_t ceiling) {
+
+  chDbgCheck((mp != NULL) && (ceiling >= LOWPRIO) && (ceiling <= HIGHPRIO),
+             "chMtxInitCeiling");
+
+  chMtxInit(mp);
+  mp->m_ceiling = ceiling;
+}
+#endif /* CH_USE_MUTEXES_CEILING */
+
+#if CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes s @p Mutex structure as a recursive mutex.
+ * @details The owner of a recursive mutex can lock it again, the mutex is
+ *          released when all the nested locks have been unlocked.
+ *
+ * @param[out] mp       pointer to a @p Mutex structure
+ *
+ * @init
+ */
+void chMtxInitRecursive(Mutex *mp) {
+
+  chDbgCheck(mp != NULL, "chMtxInitRecursive");
+
+  chMtxInit(mp);
+  mp->m_recursive = TRUE;
 }
+#endif /* CH_USE_MUTEXES_RECURSIVE */
 
 /**
  * @brief   Locks the specified mutex.
@@ -106,6 +226,9 @@ void chMtxLock(Mutex *mp) {
  * @brief   Locks the specified mutex.
  * @post    The mutex is locked and inserted in the per-thread stack of owned
  *          mutexes.
+ * @note    The owner of a recursive mutex can lock it again, the
+ *          operation just increases the nested locks counter of the mutex
+ *          on top of the owned mutexes stack.
  *
  * @param[in] mp        pointer to the @p Mutex structure
  *
@@ -116,13 +239,35 @@ void chMtxLockS(Mutex *mp) {
 
   chDbgCheckClassS();
   chDbgCheck(mp != NULL, "chMtxLockS");
+#if CH_USE_MUTEXES_CEILING
+  chDbgAssert((mp->m_ceiling == 0) || (ctp->p_realprio <= mp->m_ceiling),
+              "chMtxLockS(), #3",
+              "ceiling violation");
+#endif
+
+#if CH_USE_MUTEXES_RECURSIVE
+  /* Nested lock of a recursive mutex by its owner, it is counted on the top
+     of the owned mutexes stack so that the matching unlock is the next one
+     regardless of the position of the mutex in the stack.*/
+  if (mp->m_recursive && (mp->m_owner == ctp)) {
+    ctp->p_mtxlist->m_cnt++;
+    return;
+  }
+#endif
 
   /* Is the mutex already locked? */
   if (mp->m_owner != NULL) {
     /* Priority inheritance protocol; explores the thread-mutex dependencies
        boosting the priority of all the affected threads to equal the priority
-       of the running thread requesting the mutex.*/
+       of the running thread requesting the mutex. The owner of a ceiling
+       mutex already runs at the ceiling priority so the loop is skipped.*/
     Thread *tp = mp->m_owner;
+#if CH_DBG_LOCKS_PROFILING
+    uint32_t start = CH_DBG_LOCKS_PROFILING_COUNTER();
+
+    if (tp->p_prio < ctp->p_prio)
+      dbg_lockprof_boosted(mp->m_prof);
+#endif
     /* Does the running thread have higher priority than the mutex
        owning thread? */
     while (tp->p_prio < ctp->p_prio) {
@@ -170,12 +315,18 @@ void chMtxLockS(Mutex *mp) {
        the mutex to this thread.*/
     chDbgAssert(mp->m_owner == ctp, "chMtxLockS(), #1", "not owner");
     chDbgAssert(ctp->p_mtxlist == mp, "chMtxLockS(), #2", "not owned");
+    dbg_lockprof_waited(mp->m_prof, start);
   }
   else {
     /* It was not owned, inserted in the owned mutexes list.*/
     mp->m_owner = ctp;
     mp->m_next = ctp->p_mtxlist;
     ctp->p_mtxlist = mp;
+#if CH_USE_MUTEXES_RECURSIVE
+    mp->m_cnt = 1;
+#endif
+    ceiling_enter(mp, ctp);
+    dbg_lockprof_acquired(mp->m_prof);
   }
 }
 
@@ -228,12 +379,28 @@ bool_t chMtxTryLockS(Mutex *mp) {
 
   chDbgCheckClassS();
   chDbgCheck(mp != NULL, "chMtxTryLockS");
+#if CH_USE_MUTEXES_CEILING
+  chDbgAssert((mp->m_ceiling == 0) || (currp->p_realprio <= mp->m_ceiling),
+              "chMtxTryLockS(), #1",
+              "ceiling violation");
+#endif
 
+#if CH_USE_MUTEXES_RECURSIVE
+  if (mp->m_recursive && (mp->m_owner == currp)) {
+    currp->p_mtxlist->m_cnt++;
+    return TRUE;
+  }
+#endif
   if (mp->m_owner != NULL)
     return FALSE;
   mp->m_owner = currp;
   mp->m_next = currp->p_mtxlist;
   currp->p_mtxlist = mp;
+#if CH_USE_MUTEXES_RECURSIVE
+  mp->m_cnt = 1;
+#endif
+  ceiling_enter(mp, currp);
+  dbg_lockprof_acquired(mp->m_prof);
   return TRUE;
 }
 
@@ -243,7 +410,10 @@ bool_t chMtxTryLockS(Mutex *mp) {
  * @post    The mutex is unlocked and removed from the per-thread stack of
  *          owned mutexes.
  *
- * @return              A pointer to the unlocked mutex.
+ * @return              A pointer to the unlocked mutex. A nested unlock
+ *                      returns the mutex on top of the owned mutexes stack,
+ *                      it is still owned and it can differ from the
+ *                      re-locked mutex.
  *
  * @api
  */
@@ -261,7 +431,16 @@ Mutex *chMtxUnlock(void) {
   /* Removes the top Mutex from the Thread's owned mutexes list and marks it
      as not owned.*/
   ump = ctp->p_mtxlist;
+#if CH_USE_MUTEXES_RECURSIVE
+  /* Nested unlock, a nested lock is pending on the top mutex and it is
+     just discounted.*/
+  if (--ump->m_cnt > 0) {
+    chSysUnlock();
+    return ump;
+  }
+#endif
   ctp->p_mtxlist = ump->m_next;
+  dbg_lockprof_released(ump->m_prof);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
@@ -276,6 +455,11 @@ Mutex *chMtxUnlock(void) {
          priority will have at least that priority.*/
       if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
         newprio = mp->m_queue.p_next->p_prio;
+#if CH_USE_MUTEXES_CEILING
+      /* The ceiling of the still owned mutexes must be preserved.*/
+      if (mp->m_ceiling > newprio)
+        newprio = mp->m_ceiling;
+#endif
       mp = mp->m_next;
     }
     /* Assigns to the current thread the highest priority among all the
@@ -287,10 +471,24 @@ Mutex *chMtxUnlock(void) {
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_RECURSIVE
+    ump->m_cnt = 1;
+#endif
+    ceiling_enter(ump, tp);
     chSchWakeupS(tp, RDY_OK);
   }
-  else
+  else {
     ump->m_owner = NULL;
+#if CH_USE_MUTEXES_CEILING
+    /* Restores the priority the thread had before taking a ceiling mutex,
+       boosts coming from the priority inheritance on the outer mutexes are
+       preserved.*/
+    if (ump->m_ceiling != 0) {
+      ceiling_exit(ump, ctp);
+      chSchRescheduleS();
+    }
+#endif
+  }
   chSysUnlock();
   return ump;
 }
@@ -303,7 +501,10 @@ Mutex *chMtxUnlock(void) {
  * @post    This function does not reschedule so a call to a rescheduling
  *          function must be performed before unlocking the kernel.
  *
- * @return              A pointer to the unlocked mutex.
+ * @return              A pointer to the unlocked mutex. A nested unlock
+ *                      returns the mutex on top of the owned mutexes stack,
+ *                      it is still owned and it can differ from the
+ *                      re-locked mutex.
  *
  * @sclass
  */
@@ -322,7 +523,14 @@ Mutex *chMtxUnlockS(void) {
   /* Removes the top Mutex from the owned mutexes list and marks it as not
      owned.*/
   ump = ctp->p_mtxlist;
+#if CH_USE_MUTEXES_RECURSIVE
+  /* Nested unlock, a nested lock is pending on the top mutex and it is
+     just discounted.*/
+  if (--ump->m_cnt > 0)
+    return ump;
+#endif
   ctp->p_mtxlist = ump->m_next;
+  dbg_lockprof_released(ump->m_prof);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
@@ -337,6 +545,11 @@ Mutex *chMtxUnlockS(void) {
          priority will have at least that priority.*/
       if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
         newprio = mp->m_queue.p_next->p_prio;
+#if CH_USE_MUTEXES_CEILING
+      /* The ceiling of the still owned mutexes must be preserved.*/
+      if (mp->m_ceiling > newprio)
+        newprio = mp->m_ceiling;
+#endif
       mp = mp->m_next;
     }
     ctp->p_prio = newprio;
@@ -346,17 +559,26 @@ Mutex *chMtxUnlockS(void) {
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_RECURSIVE
+    ump->m_cnt = 1;
+#endif
+    ceiling_enter(ump, tp);
     chSchReadyI(tp);
   }
-  else
+  else {
     ump->m_owner = NULL;
+#if CH_USE_MUTEXES_CEILING
+    if (ump->m_ceiling != 0)
+      ceiling_exit(ump, ctp);
+#endif
+  }
   return ump;
 }
 
 /**
  * @brief   Unlocks all the mutexes owned by the invoking thread.
  * @post    The stack of owned mutexes is emptied and all the found
- *          mutexes are unlocked.
+ *          mutexes are unlocked, nested locks included.
  * @note    This function is <b>MUCH MORE</b> efficient than releasing the
  *          mutexes one by one and not just because the call overhead,
  *          this function does not have any overhead related to the priority
@@ -372,11 +594,16 @@ void chMtxUnlockAll(void) {
     do {
       Mutex *ump = ctp->p_mtxlist;
       ctp->p_mtxlist = ump->m_next;
+      dbg_lockprof_released(ump->m_prof);
       if (chMtxQueueNotEmptyS(ump)) {
         Thread *tp = fifo_remove(&ump->m_queue);
         ump->m_owner = tp;
         ump->m_next = tp->p_mtxlist;
         tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_RECURSIVE
+        ump->m_cnt = 1;
+#endif
+        ceiling_enter(ump, tp);
         chSchReadyI(tp);
       }
       else
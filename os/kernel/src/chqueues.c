@@ -45,6 +45,12 @@
 
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
 
+#if CH_USE_WAITMULTIPLE
+#define qnotify(qp) chWaitNotifyI((qp)->q_wlist)
+#else
+#define qnotify(qp) {}
+#endif
+
 /**
  * @brief   Puts the invoking thread into the queue's threads queue.
  *
@@ -94,6 +100,9 @@ void chIQInit(InputQueue *iqp, uint8_t *bp, size_t size, qnotify_t infy,
   iqp->q_top = bp + size;
   iqp->q_notify = infy;
   iqp->q_link = link;
+#if CH_USE_WAITMULTIPLE
+  iqp->q_wlist = NULL;
+#endif
 }
 
 /**
@@ -144,6 +153,7 @@ msg_t chIQPutI(InputQueue *iqp, uint8_t b) {
 
   if (notempty(&iqp->q_waiting))
     chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+  qnotify(iqp);
 
   return Q_OK;
 }
@@ -274,6 +284,9 @@ void chOQInit(OutputQueue *oqp, uint8_t *bp, size_t size, qnotify_t onfy,
   oqp->q_top = bp + size;
   oqp->q_notify = onfy;
   oqp->q_link = link;
+#if CH_USE_WAITMULTIPLE
+  oqp->q_wlist = NULL;
+#endif
 }
 
 /**
@@ -295,6 +308,7 @@ void chOQResetI(OutputQueue *oqp) {
   oqp->q_counter = chQSizeI(oqp);
   while (notempty(&oqp->q_waiting))
     chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_RESET;
+  qnotify(oqp);
 }
 
 /**
@@ -368,6 +382,7 @@ msg_t chOQGetI(OutputQueue *oqp) {
 
   if (notempty(&oqp->q_waiting))
     chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+  qnotify(oqp);
 
   return b;
 }
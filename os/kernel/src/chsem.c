@@ -67,6 +67,12 @@
 #define sem_insert(tp, qp) queue_insert(tp, qp)
 #endif
 
+#if CH_USE_WAITMULTIPLE
+#define sem_notify(sp) chWaitNotifyI((sp)->s_wlist)
+#else
+#define sem_notify(sp) {}
+#endif
+
 /**
  * @brief   Initializes a semaphore with the specified counter value.
  *
@@ -82,6 +88,12 @@ void chSemInit(Semaphore *sp, cnt_t n) {
 
   queue_init(&sp->s_queue);
   sp->s_cnt = n;
+#if CH_USE_WAITMULTIPLE
+  sp->s_wlist = NULL;
+#endif
+#if CH_DBG_LOCKS_PROFILING
+  sp->s_prof = NULL;
+#endif
 }
 
 /**
@@ -140,6 +152,8 @@ void chSemResetI(Semaphore *sp, cnt_t n) {
   sp->s_cnt = n;
   while (++cnt <= 0)
     chSchReadyI(lifo_remove(&sp->s_queue))->p_u.rdymsg = RDY_RESET;
+  if (n > 0)
+    sem_notify(sp);
 }
 
 /**
@@ -185,11 +199,19 @@ msg_t chSemWaitS(Semaphore *sp) {
               "inconsistent semaphore");
 
   if (--sp->s_cnt < 0) {
+#if CH_DBG_LOCKS_PROFILING
+    uint32_t start = CH_DBG_LOCKS_PROFILING_COUNTER();
+#endif
     currp->p_u.wtobjp = sp;
     sem_insert(currp, &sp->s_queue);
     chSchGoSleepS(THD_STATE_WTSEM);
+#if CH_DBG_LOCKS_PROFILING
+    if (currp->p_u.rdymsg == RDY_OK)
+      dbg_lockprof_waited(sp->s_prof, start);
+#endif
     return currp->p_u.rdymsg;
   }
+  dbg_lockprof_acquired(sp->s_prof);
   return RDY_OK;
 }
 
@@ -250,14 +272,27 @@ msg_t chSemWaitTimeoutS(Semaphore *sp, systime_t time) {
               "inconsistent semaphore");
 
   if (--sp->s_cnt < 0) {
+#if CH_DBG_LOCKS_PROFILING
+    uint32_t start;
+    msg_t msg;
+#endif
     if (TIME_IMMEDIATE == time) {
       sp->s_cnt++;
       return RDY_TIMEOUT;
     }
     currp->p_u.wtobjp = sp;
     sem_insert(currp, &sp->s_queue);
+#if CH_DBG_LOCKS_PROFILING
+    start = CH_DBG_LOCKS_PROFILING_COUNTER();
+    msg = chSchGoSleepTimeoutS(THD_STATE_WTSEM, time);
+    if (msg == RDY_OK)
+      dbg_lockprof_waited(sp->s_prof, start);
+    return msg;
+#else
     return chSchGoSleepTimeoutS(THD_STATE_WTSEM, time);
+#endif
   }
+  dbg_lockprof_acquired(sp->s_prof);
   return RDY_OK;
 }
 
@@ -279,6 +314,12 @@ void chSemSignal(Semaphore *sp) {
   chSysLock();
   if (++sp->s_cnt <= 0)
     chSchWakeupS(fifo_remove(&sp->s_queue), RDY_OK);
+#if CH_USE_WAITMULTIPLE
+  else if (sp->s_wlist != NULL) {
+    _wait_notify(sp->s_wlist);
+    chSchRescheduleS();
+  }
+#endif
   chSysUnlock();
 }
 
@@ -309,6 +350,8 @@ void chSemSignalI(Semaphore *sp) {
     tp->p_u.rdymsg = RDY_OK;
     chSchReadyI(tp);
   }
+  else
+    sem_notify(sp);
 }
 
 /**
@@ -338,6 +381,8 @@ void chSemAddCounterI(Semaphore *sp, cnt_t n) {
       chSchReadyI(fifo_remove(&sp->s_queue))->p_u.rdymsg = RDY_OK;
     n--;
   }
+  if (sp->s_cnt > 0)
+    sem_notify(sp);
 }
 
 #if CH_USE_SEMSW || defined(__DOXYGEN__)
@@ -372,14 +417,24 @@ msg_t chSemSignalWait(Semaphore *sps, Semaphore *spw) {
   chSysLock();
   if (++sps->s_cnt <= 0)
     chSchReadyI(fifo_remove(&sps->s_queue))->p_u.rdymsg = RDY_OK;
+  else
+    sem_notify(sps);
   if (--spw->s_cnt < 0) {
     Thread *ctp = currp;
+#if CH_DBG_LOCKS_PROFILING
+    uint32_t start = CH_DBG_LOCKS_PROFILING_COUNTER();
+#endif
     sem_insert(ctp, &spw->s_queue);
     ctp->p_u.wtobjp = spw;
     chSchGoSleepS(THD_STATE_WTSEM);
     msg = ctp->p_u.rdymsg;
+#if CH_DBG_LOCKS_PROFILING
+    if (msg == RDY_OK)
+      dbg_lockprof_waited(spw->s_prof, start);
+#endif
   }
   else {
+    dbg_lockprof_acquired(spw->s_prof);
     chSchRescheduleS();
     msg = RDY_OK;
   }
@@ -0,0 +1,268 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwait.c
+ * @brief   Multiple objects wait code.
+ *
+ * @addtogroup waitmultiple
+ * @details A thread can wait for any of a set of heterogeneous kernel
+ *          objects to become ready.
+ *          <h2>Operation mode</h2>
+ *          The waiting thread describes each object with a @p WaitObject
+ *          descriptor and invokes @p chWaitMultiple(). The descriptors are
+ *          linked to the objects and the thread goes to sleep, the objects
+ *          make the thread ready when their state changes, no polling is
+ *          involved. On return the descriptors are unlinked and a mask of
+ *          the ready objects is returned, bit @p n of the mask represents
+ *          the descriptor @p n of the array.<br>
+ *          The supported objects and their ready conditions are:
+ *          - <b>Semaphore</b>: the counter is greater than zero.
+ *          - <b>InputQueue</b>: the queue is not empty.
+ *          - <b>OutputQueue</b>: the queue is not full.
+ *          - <b>Mailbox</b>: there is at least a message in the mailbox.
+ *          - <b>EventSource</b>: the source has been broadcasted during the
+ *            wait.
+ *          .
+ *          The wait operation does not consume the resources, the ready
+ *          objects must be accessed by the caller using their own APIs,
+ *          possibly using a @p TIME_IMMEDIATE timeout because another thread
+ *          could have used the resource in the meantime.
+ * @pre     In order to use the multiple wait APIs the @p CH_USE_WAITMULTIPLE
+ *          option must be enabled in @p chconf.h.
+ * @note    Enabling this option adds a pointer field to the @p Semaphore,
+ *          @p GenericQueue and @p EventSource structures.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_WAITMULTIPLE || defined(__DOXYGEN__)
+
+/**
+ * @brief   Returns the address of the descriptors list of an object.
+ *
+ * @param[in] wop       pointer to a @p WaitObject structure
+ * @return              The address of the list head within the object.
+ */
+static WaitObject **wait_list(WaitObject *wop) {
+
+  switch (wop->wo_type) {
+#if CH_USE_SEMAPHORES
+  case WAIT_SEMAPHORE:
+    return &((Semaphore *)wop->wo_objp)->s_wlist;
+#endif
+#if CH_USE_QUEUES
+  case WAIT_INPUTQUEUE:
+  case WAIT_OUTPUTQUEUE:
+    return &((GenericQueue *)wop->wo_objp)->q_wlist;
+#endif
+#if CH_USE_MAILBOXES
+  case WAIT_MAILBOX:
+    return &((Mailbox *)wop->wo_objp)->mb_fullsem.s_wlist;
+#endif
+#if CH_USE_EVENTS
+  case WAIT_EVENTSOURCE:
+    return &((EventSource *)wop->wo_objp)->es_wlist;
+#endif
+  }
+  chDbgAssert(FALSE, "wait_list(), #1", "invalid object type");
+  return NULL;
+}
+
+/**
+ * @brief   Checks if the object associated to a descriptor is ready.
+ *
+ * @param[in] wop       pointer to a @p WaitObject structure
+ * @return              The object state.
+ * @retval FALSE        if the object is not ready.
+ * @retval TRUE         if the object is ready.
+ */
+static bool_t wait_ready(WaitObject *wop) {
+
+  switch (wop->wo_type) {
+#if CH_USE_SEMAPHORES
+  case WAIT_SEMAPHORE:
+    return chSemGetCounterI((Semaphore *)wop->wo_objp) > 0;
+#endif
+#if CH_USE_QUEUES
+  case WAIT_INPUTQUEUE:
+    return !chIQIsEmptyI((InputQueue *)wop->wo_objp);
+  case WAIT_OUTPUTQUEUE:
+    return !chOQIsFullI((OutputQueue *)wop->wo_objp);
+#endif
+#if CH_USE_MAILBOXES
+  case WAIT_MAILBOX:
+    return chMBGetUsedCountI((Mailbox *)wop->wo_objp) > 0;
+#endif
+  }
+  return wop->wo_signaled;
+}
+
+/**
+ * @brief   Makes ready the threads waiting on a descriptors list.
+ * @note    This function is meant to be invoked through the
+ *          @p chWaitNotifyI() macro by the objects implementations.
+ *
+ * @param[in] wlp       the list of the descriptors attached to the object
+ *
+ * @notapi
+ */
+void _wait_notify(WaitObject *wlp) {
+
+  do {
+    wlp->wo_signaled = TRUE;
+    if (wlp->wo_thread->p_state == THD_STATE_WTMULTI)
+      chSchReadyI(wlp->wo_thread)->p_u.rdymsg = RDY_OK;
+    wlp = wlp->wo_next;
+  } while (wlp != NULL);
+}
+
+/**
+ * @brief   Initializes a @p WaitObject structure.
+ *
+ * @param[out] wop      pointer to a @p WaitObject structure
+ * @param[in] type      type of the kernel object:
+ *                      - @a WAIT_SEMAPHORE
+ *                      - @a WAIT_INPUTQUEUE
+ *                      - @a WAIT_OUTPUTQUEUE
+ *                      - @a WAIT_MAILBOX
+ *                      - @a WAIT_EVENTSOURCE
+ *                      .
+ * @param[in] objp      pointer to the kernel object
+ *
+ * @init
+ */
+void chWaitObjectInit(WaitObject *wop, uint8_t type, void *objp) {
+
+  chDbgCheck((wop != NULL) && (objp != NULL) && (type <= WAIT_EVENTSOURCE),
+             "chWaitObjectInit");
+
+  wop->wo_next = NULL;
+  wop->wo_thread = NULL;
+  wop->wo_objp = objp;
+  wop->wo_type = type;
+  wop->wo_signaled = FALSE;
+}
+
+/**
+ * @brief   Waits for any of the specified objects to become ready.
+ *
+ * @param[in] wobjs     array of @p WaitObject structures
+ * @param[in] n         number of elements in the array, the maximum is the
+ *                      number of bits in an @p eventmask_t
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The mask of the ready objects, bit @p i represents
+ *                      the descriptor @p wobjs[i].
+ * @retval 0            if the operation has timed out.
+ *
+ * @api
+ */
+eventmask_t chWaitMultiple(WaitObject *wobjs, cnt_t n, systime_t time) {
+  eventmask_t m;
+
+  chSysLock();
+  m = chWaitMultipleS(wobjs, n, time);
+  chSysUnlock();
+  return m;
+}
+
+/**
+ * @brief   Waits for any of the specified objects to become ready.
+ *
+ * @param[in] wobjs     array of @p WaitObject structures
+ * @param[in] n         number of elements in the array, the maximum is the
+ *                      number of bits in an @p eventmask_t
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The mask of the ready objects, bit @p i represents
+ *                      the descriptor @p wobjs[i].
+ * @retval 0            if the operation has timed out.
+ *
+ * @sclass
+ */
+eventmask_t chWaitMultipleS(WaitObject *wobjs, cnt_t n, systime_t time) {
+  WaitObject **wlpp;
+  eventmask_t m;
+  systime_t now, elapsed;
+  msg_t msg;
+  cnt_t i;
+
+  chDbgCheckClassS();
+  chDbgCheck((wobjs != NULL) && (n > 0) &&
+             (n <= (cnt_t)(sizeof(eventmask_t) * 8)), "chWaitMultipleS");
+
+  /* Fast path, an object is already ready.*/
+  m = 0;
+  for (i = 0; i < n; i++) {
+    wobjs[i].wo_signaled = FALSE;
+    if (wait_ready(&wobjs[i]))
+      m |= (eventmask_t)1 << i;
+  }
+  if ((m != 0) || (TIME_IMMEDIATE == time))
+    return m;
+
+  while (TRUE) {
+    /* Attaching the descriptors to the objects and going to sleep.*/
+    for (i = 0; i < n; i++) {
+      wlpp = wait_list(&wobjs[i]);
+      wobjs[i].wo_thread = currp;
+      wobjs[i].wo_next = *wlpp;
+      *wlpp = &wobjs[i];
+    }
+    now = chTimeNow();
+    msg = chSchGoSleepTimeoutS(THD_STATE_WTMULTI, time);
+
+    /* Detaching the descriptors and collecting the ready objects.*/
+    for (i = 0; i < n; i++) {
+      wlpp = wait_list(&wobjs[i]);
+      while (*wlpp != &wobjs[i])
+        wlpp = &(*wlpp)->wo_next;
+      *wlpp = wobjs[i].wo_next;
+      wobjs[i].wo_next = NULL;
+      wobjs[i].wo_thread = NULL;
+      if (wait_ready(&wobjs[i]))
+        m |= (eventmask_t)1 << i;
+    }
+    if ((m != 0) || (msg == RDY_TIMEOUT))
+      return m;
+
+    /* The object that woke up the thread has been consumed by another
+       thread before this one could run, going back to sleep for the
+       remaining time.*/
+    if (time != TIME_INFINITE) {
+      elapsed = chTimeNow() - now;
+      if (elapsed >= time)
+        return 0;
+      time -= elapsed;
+    }
+  }
+}
+
+#endif /* CH_USE_WAITMULTIPLE */
+
+/** @} */
@@ -190,6 +190,33 @@
 #define CH_USE_MUTEXES                  TRUE
 #endif
 
+/**
+ * @brief   Priority ceiling mutexes.
+ * @details If enabled then mutexes can be initialized with a static priority
+ *          ceiling, such mutexes use the immediate priority ceiling protocol
+ *          instead of the priority inheritance.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_MUTEXES_CEILING) || defined(__DOXYGEN__)
+#define CH_USE_MUTEXES_CEILING          FALSE
+#endif
+
+/**
+ * @brief   Recursive mutexes.
+ * @details If enabled then a mutex can be initialized as recursive using
+ *          @p chMtxInitRecursive(), the owner of a recursive mutex can lock
+ *          it again and the mutex is released when all the nested locks
+ *          have been unlocked.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_MUTEXES_RECURSIVE) || defined(__DOXYGEN__)
+#define CH_USE_MUTEXES_RECURSIVE        FALSE
+#endif
+
 /**
  * @brief   Conditional Variables APIs.
  * @details If enabled then the conditional variables APIs are included
@@ -281,6 +308,19 @@
 #define CH_USE_QUEUES                   TRUE
 #endif
 
+/**
+ * @brief   Multiple objects wait APIs.
+ * @details If enabled then the @p chWaitMultiple() API is included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Enabling this option adds a field to the @p Semaphore,
+ *          @p GenericQueue and @p EventSource structures.
+ */
+#if !defined(CH_USE_WAITMULTIPLE) || defined(__DOXYGEN__)
+#define CH_USE_WAITMULTIPLE             FALSE
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -437,6 +477,18 @@
 #define CH_DBG_THREADS_PROFILING        TRUE
 #endif
 
+/**
+ * @brief   Debug option, locks profiling.
+ * @details If enabled then a pointer field is added to the @p Mutex,
+ *          @p Semaphore and @p CondVar structures, the objects registered
+ *          in the profiler collect contention statistics.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_DBG_LOCKS_PROFILING) || defined(__DOXYGEN__)
+#define CH_DBG_LOCKS_PROFILING          FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
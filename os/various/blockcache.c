@@ -0,0 +1,410 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blockcache.c
+ * @brief   Block devices cache code.
+ *
+ * @addtogroup block_cache
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "blockcache.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Address of the buffer slot associated to an entry.
+ */
+#define slot(bcp, i) ((bcp)->buffer + (size_t)(i) * BLOCK_CACHE_BLOCK_SIZE)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Searches a block in the cache.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @return              The index of the entry containing the block.
+ * @retval bcp->n       if the block is not cached.
+ */
+static uint32_t lookup(BlockCache *bcp, uint32_t blk) {
+  uint32_t i;
+
+  for (i = 0; i < bcp->n; i++) {
+    if ((bcp->entries[i].flags & BC_VALID) && (bcp->entries[i].blk == blk))
+      break;
+  }
+  return i;
+}
+
+/**
+ * @brief   Checks if a block is cached and dirty.
+ */
+static bool_t is_dirty(BlockCache *bcp, uint32_t blk) {
+  uint32_t i = lookup(bcp, blk);
+
+  return (i < bcp->n) && (bcp->entries[i].flags & BC_DIRTY);
+}
+
+/**
+ * @brief   Exchanges two entries and their buffer slots.
+ */
+static void swap(BlockCache *bcp, uint32_t i, uint32_t j) {
+  BlockCacheEntry e;
+  uint32_t *p = (uint32_t *)slot(bcp, i);
+  uint32_t *q = (uint32_t *)slot(bcp, j);
+  unsigned k;
+
+  e = bcp->entries[i];
+  bcp->entries[i] = bcp->entries[j];
+  bcp->entries[j] = e;
+  for (k = 0; k < BLOCK_CACHE_BLOCK_SIZE / sizeof (uint32_t); k++) {
+    uint32_t w = p[k];
+    p[k] = q[k];
+    q[k] = w;
+  }
+}
+
+/**
+ * @brief   Writes back a dirty block and its dirty neighbours.
+ * @details The run of consecutive dirty blocks containing the specified
+ *          entry is moved into adjacent buffer slots, then it is written
+ *          on the device using a single multi-block operation.
+ * @note    The entries can be moved by this function.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] i         index of a dirty entry
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ */
+static bool_t write_back(BlockCache *bcp, uint32_t i) {
+  uint32_t first, k, base, j, idx;
+
+  /* Boundaries of the run of dirty blocks.*/
+  first = bcp->entries[i].blk;
+  while ((first > 0) && is_dirty(bcp, first - 1))
+    first--;
+  k = 1;
+  while ((k < bcp->n) && is_dirty(bcp, first + k))
+    k++;
+
+  /* Moving the run into consecutive slots.*/
+  base = lookup(bcp, first);
+  if (base + k > bcp->n)
+    base = bcp->n - k;
+  for (j = 0; j < k; j++) {
+    idx = lookup(bcp, first + j);
+    if (idx != base + j)
+      swap(bcp, idx, base + j);
+  }
+
+  if (blkWrite(bcp->bdp, first, slot(bcp, base), k))
+    return CH_FAILED;
+  for (j = 0; j < k; j++)
+    bcp->entries[base + j].flags &= ~BC_DIRTY;
+  bcp->stats.writes++;
+  bcp->stats.wrblocks += k;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Allocates an entry for a new block.
+ * @details A free entry is used if available else the least recently used
+ *          entry is evicted, writing it back if dirty.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @param[in] blk       block number
+ * @return              The index of the allocated entry.
+ * @retval bcp->n       if the write back of the evicted block failed.
+ */
+static uint32_t allocate(BlockCache *bcp, uint32_t blk) {
+  uint32_t i, victim;
+
+  victim = 0;
+  for (i = 0; i < bcp->n; i++) {
+    if (!(bcp->entries[i].flags & BC_VALID)) {
+      victim = i;
+      break;
+    }
+    if (bcp->entries[i].age < bcp->entries[victim].age)
+      victim = i;
+  }
+  if (bcp->entries[victim].flags & BC_DIRTY) {
+    uint32_t vblk = bcp->entries[victim].blk;
+
+    if (write_back(bcp, victim))
+      return bcp->n;
+    victim = lookup(bcp, vblk);
+  }
+  bcp->entries[victim].blk   = blk;
+  bcp->entries[victim].flags = BC_VALID;
+  return victim;
+}
+
+static bool_t bc_is_inserted(void *instance) {
+
+  return blkIsInserted(((BlockCache *)instance)->bdp);
+}
+
+static bool_t bc_is_protected(void *instance) {
+
+  return blkIsWriteProtected(((BlockCache *)instance)->bdp);
+}
+
+static bool_t bc_connect(void *instance) {
+  BlockCache *bcp = instance;
+  BlockDeviceInfo bdi;
+
+  /* The device could have been already connected by the application.*/
+  if ((blkGetDriverState(bcp->bdp) != BLK_READY) && blkConnect(bcp->bdp))
+    return CH_FAILED;
+  if (blkGetInfo(bcp->bdp, &bdi) || (bdi.blk_size != BLOCK_CACHE_BLOCK_SIZE))
+    return CH_FAILED;
+  bcInvalidate(bcp);
+  bcp->state = BLK_READY;
+  return CH_SUCCESS;
+}
+
+static bool_t bc_disconnect(void *instance) {
+  BlockCache *bcp = instance;
+  bool_t err = CH_SUCCESS;
+
+  if (bcp->state == BLK_READY)
+    err = bcFlush(bcp);
+  bcInvalidate(bcp);
+  bcp->state = BLK_ACTIVE;
+  return blkDisconnect(bcp->bdp) || err;
+}
+
+static bool_t bc_read(void *instance, uint32_t startblk,
+                      uint8_t *buffer, uint32_t n) {
+  BlockCache *bcp = instance;
+  uint32_t i, k;
+
+  if (bcp->state != BLK_READY)
+    return CH_FAILED;
+
+  while (n > 0) {
+    i = lookup(bcp, startblk);
+    if (i < bcp->n) {
+      memcpy(buffer, slot(bcp, i), BLOCK_CACHE_BLOCK_SIZE);
+      bcp->entries[i].age = ++bcp->age;
+      bcp->stats.hits++;
+      k = 1;
+    }
+    else if (n == 1) {
+      /* Single block reads are cached, this is the typical access pattern
+         of the file system metadata.*/
+      i = allocate(bcp, startblk);
+      if (i >= bcp->n)
+        return CH_FAILED;
+      if (blkRead(bcp->bdp, startblk, slot(bcp, i), 1)) {
+        bcp->entries[i].flags = 0;
+        return CH_FAILED;
+      }
+      memcpy(buffer, slot(bcp, i), BLOCK_CACHE_BLOCK_SIZE);
+      bcp->entries[i].age = ++bcp->age;
+      bcp->stats.misses++;
+      k = 1;
+    }
+    else {
+      /* Runs of not cached blocks in multi-block reads are transferred
+         directly into the caller buffer without polluting the cache.*/
+      k = 1;
+      while ((k < n) && (lookup(bcp, startblk + k) >= bcp->n))
+        k++;
+      if (blkRead(bcp->bdp, startblk, buffer, k))
+        return CH_FAILED;
+      bcp->stats.misses += k;
+    }
+    startblk += k;
+    buffer += k * BLOCK_CACHE_BLOCK_SIZE;
+    n -= k;
+  }
+  return CH_SUCCESS;
+}
+
+static bool_t bc_write(void *instance, uint32_t startblk,
+                       const uint8_t *buffer, uint32_t n) {
+  BlockCache *bcp = instance;
+  uint32_t i;
+
+  if (bcp->state != BLK_READY)
+    return CH_FAILED;
+
+  if (n == 1) {
+    /* Single block writes are delayed until the entry is evicted or the
+       cache is synchronized.*/
+    i = lookup(bcp, startblk);
+    if (i < bcp->n)
+      bcp->stats.hits++;
+    else {
+      i = allocate(bcp, startblk);
+      if (i >= bcp->n)
+        return CH_FAILED;
+      bcp->stats.misses++;
+    }
+    memcpy(slot(bcp, i), buffer, BLOCK_CACHE_BLOCK_SIZE);
+    bcp->entries[i].flags |= BC_DIRTY;
+    bcp->entries[i].age = ++bcp->age;
+    return CH_SUCCESS;
+  }
+
+  /* Multi-block writes go directly to the device, the cached copies of the
+     written blocks are updated and become clean.*/
+  if (blkWrite(bcp->bdp, startblk, buffer, n))
+    return CH_FAILED;
+  bcp->stats.writes++;
+  bcp->stats.wrblocks += n;
+  for (i = 0; i < bcp->n; i++) {
+    uint32_t blk = bcp->entries[i].blk;
+
+    if ((bcp->entries[i].flags & BC_VALID) &&
+        (blk >= startblk) && (blk - startblk < n)) {
+      memcpy(slot(bcp, i), buffer + (blk - startblk) * BLOCK_CACHE_BLOCK_SIZE,
+             BLOCK_CACHE_BLOCK_SIZE);
+      bcp->entries[i].flags &= ~BC_DIRTY;
+    }
+  }
+  return CH_SUCCESS;
+}
+
+static bool_t bc_sync(void *instance) {
+  BlockCache *bcp = instance;
+
+  if (bcp->state != BLK_READY)
+    return CH_FAILED;
+  if (bcFlush(bcp))
+    return CH_FAILED;
+  return blkSync(bcp->bdp);
+}
+
+static bool_t bc_get_info(void *instance, BlockDeviceInfo *bdip) {
+
+  return blkGetInfo(((BlockCache *)instance)->bdp, bdip);
+}
+
+static const struct BlockCacheVMT vmt = {
+  bc_is_inserted, bc_is_protected, bc_connect, bc_disconnect,
+  bc_read, bc_write, bc_sync, bc_get_info
+};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Block cache object initialization.
+ * @note    The cache is not thread safe, the accesses must be serialized
+ *          by the caller as for the cached device itself.
+ *
+ * @param[out] bcp      pointer to the @p BlockCache object to be initialized
+ * @param[in] bdp       pointer to the cached @p BaseBlockDevice object
+ * @param[in] entries   array of @p n entries descriptors
+ * @param[in] buffer    blocks buffer of <tt>n * BLOCK_CACHE_BLOCK_SIZE</tt>
+ *                      bytes, it must be aligned to 32 bits
+ * @param[in] n         number of cached blocks
+ *
+ * @init
+ */
+void bcObjectInit(BlockCache *bcp, BaseBlockDevice *bdp,
+                  BlockCacheEntry *entries, uint8_t *buffer, uint32_t n) {
+
+  chDbgCheck((bcp != NULL) && (bdp != NULL) && (entries != NULL) &&
+             (buffer != NULL) && (n > 0), "bcObjectInit");
+
+  bcp->vmt     = &vmt;
+  bcp->state   = BLK_ACTIVE;
+  bcp->bdp     = bdp;
+  bcp->entries = entries;
+  bcp->buffer  = buffer;
+  bcp->n       = n;
+  bcInvalidate(bcp);
+  bcResetStats(bcp);
+}
+
+/**
+ * @brief   Writes back all the dirty blocks.
+ * @details Adjacent dirty blocks are coalesced in multi-block writes.
+ * @note    The device is not synchronized, use @p blkSync() in order to
+ *          also synchronize the device.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+bool_t bcFlush(BlockCache *bcp) {
+  uint32_t i;
+
+  chDbgCheck(bcp != NULL, "bcFlush");
+
+  /* Each write back can move entries so the scan restarts every time.*/
+  i = 0;
+  while (i < bcp->n) {
+    if (bcp->entries[i].flags & BC_DIRTY) {
+      if (write_back(bcp, i))
+        return CH_FAILED;
+      i = 0;
+    }
+    else
+      i++;
+  }
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Discards all the cached blocks.
+ * @note    Dirty blocks are lost, use @p bcFlush() before invalidating
+ *          in order to preserve them.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @api
+ */
+void bcInvalidate(BlockCache *bcp) {
+  uint32_t i;
+
+  chDbgCheck(bcp != NULL, "bcInvalidate");
+
+  for (i = 0; i < bcp->n; i++) {
+    bcp->entries[i].flags = 0;
+    bcp->entries[i].age   = 0;
+  }
+  bcp->age = 0;
+}
+
+/** @} */
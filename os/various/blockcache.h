@@ -0,0 +1,174 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blockcache.h
+ * @brief   Block devices cache structures and macros.
+ *
+ * @addtogroup block_cache
+ * @{
+ */
+
+#ifndef _BLOCKCACHE_H_
+#define _BLOCKCACHE_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Cache entry flags
+ * @{
+ */
+#define BC_VALID                1   /**< @brief Entry contains a block.     */
+#define BC_DIRTY                2   /**< @brief Block not yet written back. */
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the cached blocks.
+ * @details The cache can only be connected to devices having this block
+ *          size.
+ */
+#if !defined(BLOCK_CACHE_BLOCK_SIZE) || defined(__DOXYGEN__)
+#define BLOCK_CACHE_BLOCK_SIZE  512
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (BLOCK_CACHE_BLOCK_SIZE % 4) != 0
+#error "BLOCK_CACHE_BLOCK_SIZE must be a multiple of 4"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache entry descriptor.
+ * @details The entry with index @p i describes the block stored at offset
+ *          <tt>i * BLOCK_CACHE_BLOCK_SIZE</tt> of the cache buffer.
+ */
+typedef struct {
+  uint32_t              blk;        /**< @brief Cached block number.        */
+  uint32_t              age;        /**< @brief Last access stamp.          */
+  uint8_t               flags;      /**< @brief Entry flags.                */
+} BlockCacheEntry;
+
+/**
+ * @brief   Cache statistics.
+ */
+typedef struct {
+  uint32_t              hits;       /**< @brief Blocks found in cache.      */
+  uint32_t              misses;     /**< @brief Blocks not found in cache.  */
+  uint32_t              writes;     /**< @brief Write operations performed
+                                                on the device.              */
+  uint32_t              wrblocks;   /**< @brief Blocks written on the
+                                                device.                     */
+} BlockCacheStats;
+
+/**
+ * @brief   @p BlockCache specific data.
+ */
+#define _block_cache_data                                                   \
+  _base_block_device_data                                                   \
+  /* Cached block device.*/                                                 \
+  BaseBlockDevice       *bdp;                                               \
+  /* Entries descriptors array.*/                                           \
+  BlockCacheEntry       *entries;                                           \
+  /* Blocks buffer.*/                                                       \
+  uint8_t               *buffer;                                            \
+  /* Number of entries.*/                                                   \
+  uint32_t              n;                                                  \
+  /* Access stamps counter.*/                                               \
+  uint32_t              age;                                                \
+  /* Statistics.*/                                                          \
+  BlockCacheStats       stats;
+
+/**
+ * @brief   @p BlockCache virtual methods table.
+ */
+struct BlockCacheVMT {
+  _base_block_device_methods
+};
+
+/**
+ * @extends BaseBlockDevice
+ *
+ * @brief   Block cache object.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct BlockCacheVMT *vmt;
+  _block_cache_data
+} BlockCache;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns a pointer to the cache statistics.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ * @return              Pointer to a @p BlockCacheStats structure.
+ *
+ * @api
+ */
+#define bcGetStats(bcp) (&(bcp)->stats)
+
+/**
+ * @brief   Clears the cache statistics.
+ *
+ * @param[in] bcp       pointer to the @p BlockCache object
+ *
+ * @api
+ */
+#define bcResetStats(bcp) {                                                 \
+  (bcp)->stats.hits     = 0;                                                \
+  (bcp)->stats.misses   = 0;                                                \
+  (bcp)->stats.writes   = 0;                                                \
+  (bcp)->stats.wrblocks = 0;                                                \
+}
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void bcObjectInit(BlockCache *bcp, BaseBlockDevice *bdp,
+                    BlockCacheEntry *entries, uint8_t *buffer, uint32_t n);
+  bool_t bcFlush(BlockCache *bcp);
+  void bcInvalidate(BlockCache *bcp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLOCKCACHE_H_ */
+
+/** @} */
@@ -789,6 +789,74 @@ namespace chibios_rt {
     }
   };
 
+  /*------------------------------------------------------------------------*
+   * chibios_rt::StaticThread                                               *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Static threads template class with compile-time parameters.
+   * @details Working area size and priority are fixed at compile time and
+   *          the thread body is invoked without virtual dispatch. The
+   *          derived class @p T must implement a public
+   *          <tt>msg_t main(void)</tt> method, the method is invoked using
+   *          a qualified call so it can be inlined in the thread entry
+   *          function.
+   *
+   * @param T               the derived thread class
+   * @param N               the working area size for the thread class
+   * @param P               the thread priority
+   */
+  template <class T, size_t N, tprio_t P>
+  class StaticThread : public BaseThread {
+  private:
+    /**
+     * @brief   Thread entry function.
+     */
+    static msg_t entry(void *arg) {
+
+      return static_cast<T *>(arg)->T::main();
+    }
+
+  protected:
+    WORKING_AREA(wa, N);
+
+  public:
+    /**
+     * @brief   Working area size of the thread class.
+     */
+    static const size_t stack_size = N;
+
+    /**
+     * @brief   Priority of the thread class.
+     */
+    static const tprio_t priority = P;
+
+    /**
+     * @brief   Thread constructor.
+     * @details The thread object is initialized but the thread is not
+     *          started here.
+     *
+     * @init
+     */
+    StaticThread(void) : BaseThread() {
+
+    }
+
+    /**
+     * @brief   Creates and starts a system thread at the class priority.
+     *
+     * @return                  A reference to the created thread with
+     *                          reference counter set to one.
+     *
+     * @api
+     */
+    ThreadReference start(void) {
+
+      thread_ref = chThdCreateStatic(wa, sizeof(wa), P, entry,
+                                     static_cast<T *>(this));
+      return *this;
+    }
+  };
+
 #if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
   /*------------------------------------------------------------------------*
    * chibios_rt::CounterSemaphore                                           *
@@ -2066,6 +2134,267 @@ namespace chibios_rt {
                                   (cnt_t)(sizeof mb_buf / sizeof (msg_t))) {
     }
   };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::TypedMailbox                                               *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating a typed mailbox and its buffer.
+   * @details The mailbox capacity is fixed at compile time and must be a
+   *          power of two, the buffer indexes are free running counters
+   *          and the wrap-around is a mask operation that the compiler can
+   *          fold. The messages are of type @p T, usually a pointer type,
+   *          no casts to and from @p msg_t are required.
+   * @note    The semaphores synchronization is the same of the
+   *          @p ::Mailbox kernel object.
+   *
+   * @param T                   type of the messages, it must be a pointer
+   *                            or a small type that can be copied by value
+   * @param N                   size of the mailbox, it must be a power of
+   *                            two
+   */
+  template <class T, cnt_t N>
+  class TypedMailbox {
+  private:
+    /* Compile-time check, the array size is negative if N is not a power
+       of two.*/
+    typedef char n_must_be_a_power_of_two[((N > 0) &&
+                                           ((N & (N - 1)) == 0)) ? 1 : -1];
+
+    T                   mb_buf[N];
+    unsigned            mb_wridx;
+    unsigned            mb_rdidx;
+    ::Semaphore         mb_fullsem;
+    ::Semaphore         mb_emptysem;
+
+  public:
+    /**
+     * @brief   TypedMailbox constructor.
+     *
+     * @init
+     */
+    TypedMailbox(void) : mb_wridx(0), mb_rdidx(0) {
+
+      chSemInit(&mb_fullsem, 0);
+      chSemInit(&mb_emptysem, N);
+    }
+
+    /**
+     * @brief   Resets the mailbox.
+     * @details All the waiting threads are resumed with status @p RDY_RESET
+     *          and the queued messages are lost.
+     *
+     * @api
+     */
+    void reset(void) {
+
+      chSysLock();
+      mb_wridx = mb_rdidx = 0;
+      chSemResetI(&mb_emptysem, N);
+      chSemResetI(&mb_fullsem, 0);
+      chSchRescheduleS();
+      chSysUnlock();
+    }
+
+    /**
+     * @brief   Posts a message into the mailbox.
+     * @details The invoking thread waits until a empty slot in the mailbox
+     *          becomes available or the specified time runs out.
+     *
+     * @param[in] msg       the message to be posted on the mailbox
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly posted.
+     * @retval RDY_RESET    if the mailbox has been reset while waiting.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @api
+     */
+    msg_t post(T msg, systime_t time) {
+      msg_t rdymsg;
+
+      chSysLock();
+      rdymsg = postS(msg, time);
+      chSysUnlock();
+      return rdymsg;
+    }
+
+    /**
+     * @brief   Posts a message into the mailbox.
+     * @details The invoking thread waits until a empty slot in the mailbox
+     *          becomes available or the specified time runs out.
+     *
+     * @param[in] msg       the message to be posted on the mailbox
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly posted.
+     * @retval RDY_RESET    if the mailbox has been reset while waiting.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @sclass
+     */
+    msg_t postS(T msg, systime_t time) {
+      msg_t rdymsg;
+
+      rdymsg = chSemWaitTimeoutS(&mb_emptysem, time);
+      if (rdymsg == RDY_OK) {
+        mb_buf[mb_wridx++ & (N - 1)] = msg;
+        chSemSignalI(&mb_fullsem);
+        chSchRescheduleS();
+      }
+      return rdymsg;
+    }
+
+    /**
+     * @brief   Posts a message into the mailbox.
+     * @details This variant is non-blocking, the function returns a timeout
+     *          condition if the queue is full.
+     *
+     * @param[in] msg       the message to be posted on the mailbox
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly posted.
+     * @retval RDY_TIMEOUT  if the mailbox is full and the message cannot be
+     *                      posted.
+     *
+     * @iclass
+     */
+    msg_t postI(T msg) {
+
+      chDbgCheckClassI();
+
+      if (chSemGetCounterI(&mb_emptysem) <= 0)
+        return RDY_TIMEOUT;
+      chSemFastWaitI(&mb_emptysem);
+      mb_buf[mb_wridx++ & (N - 1)] = msg;
+      chSemSignalI(&mb_fullsem);
+      return RDY_OK;
+    }
+
+    /**
+     * @brief   Retrieves a message from the mailbox.
+     * @details The invoking thread waits until a message is posted in the
+     *          mailbox or the specified time runs out.
+     *
+     * @param[out] msgp     pointer to a message variable for the received
+     *                      message
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly fetched.
+     * @retval RDY_RESET    if the mailbox has been reset while waiting.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @api
+     */
+    msg_t fetch(T *msgp, systime_t time) {
+      msg_t rdymsg;
+
+      chSysLock();
+      rdymsg = fetchS(msgp, time);
+      chSysUnlock();
+      return rdymsg;
+    }
+
+    /**
+     * @brief   Retrieves a message from the mailbox.
+     * @details The invoking thread waits until a message is posted in the
+     *          mailbox or the specified time runs out.
+     *
+     * @param[out] msgp     pointer to a message variable for the received
+     *                      message
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly fetched.
+     * @retval RDY_RESET    if the mailbox has been reset while waiting.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @sclass
+     */
+    msg_t fetchS(T *msgp, systime_t time) {
+      msg_t rdymsg;
+
+      rdymsg = chSemWaitTimeoutS(&mb_fullsem, time);
+      if (rdymsg == RDY_OK) {
+        *msgp = mb_buf[mb_rdidx++ & (N - 1)];
+        chSemSignalI(&mb_emptysem);
+        chSchRescheduleS();
+      }
+      return rdymsg;
+    }
+
+    /**
+     * @brief   Retrieves a message from the mailbox.
+     * @details This variant is non-blocking, the function returns a timeout
+     *          condition if the queue is empty.
+     *
+     * @param[out] msgp     pointer to a message variable for the received
+     *                      message
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been correctly fetched.
+     * @retval RDY_TIMEOUT  if the mailbox is empty and a message cannot be
+     *                      fetched.
+     *
+     * @iclass
+     */
+    msg_t fetchI(T *msgp) {
+
+      chDbgCheckClassI();
+
+      if (chSemGetCounterI(&mb_fullsem) <= 0)
+        return RDY_TIMEOUT;
+      chSemFastWaitI(&mb_fullsem);
+      *msgp = mb_buf[mb_rdidx++ & (N - 1)];
+      chSemSignalI(&mb_emptysem);
+      return RDY_OK;
+    }
+
+    /**
+     * @brief   Returns the number of free message slots into the mailbox.
+     * @note    The returned value can be less than zero when there are waiting
+     *          threads on the internal semaphore.
+     *
+     * @return              The number of empty message slots.
+     *
+     * @iclass
+     */
+    cnt_t getFreeCountI(void) {
+
+      chDbgCheckClassI();
+
+      return chSemGetCounterI(&mb_emptysem);
+    }
+
+    /**
+     * @brief   Returns the number of used message slots into the mailbox.
+     * @note    The returned value can be less than zero when there are waiting
+     *          threads on the internal semaphore.
+     *
+     * @return              The number of queued messages.
+     *
+     * @iclass
+     */
+    cnt_t getUsedCountI(void) {
+
+      chDbgCheckClassI();
+
+      return chSemGetCounterI(&mb_fullsem);
+    }
+  };
 #endif /* CH_USE_MAILBOXES */
 
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
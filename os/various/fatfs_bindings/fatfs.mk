@@ -1,7 +1,9 @@
 # FATFS files.
 FATFSSRC = ${CHIBIOS}/os/various/fatfs_bindings/fatfs_diskio.c \
            ${CHIBIOS}/os/various/fatfs_bindings/fatfs_syscall.c \
+           ${CHIBIOS}/os/various/blockcache.c \
            ${CHIBIOS}/ext/fatfs/src/ff.c \
            ${CHIBIOS}/ext/fatfs/src/option/ccsbcs.c
 
-FATFSINC = ${CHIBIOS}/ext/fatfs/src
+FATFSINC = ${CHIBIOS}/ext/fatfs/src \
+           ${CHIBIOS}/os/various/fatfs_bindings
@@ -5,21 +5,19 @@
 /* disk I/O modules and attach it to FatFs module with common interface. */
 /*-----------------------------------------------------------------------*/
 
+#include <string.h>
+
 #include "ch.h"
 #include "hal.h"
 #include "ffconf.h"
 #include "diskio.h"
-
-#if HAL_USE_MMC_SPI && HAL_USE_SDC
-#error "cannot specify both MMC_SPI and SDC drivers"
-#endif
+#include "fatfs_diskio.h"
 
 #if HAL_USE_MMC_SPI
 extern MMCDriver MMCD1;
-#elif HAL_USE_SDC
+#endif
+#if HAL_USE_SDC
 extern SDCDriver SDCD1;
-#else
-#error "MMC_SPI or SDC driver must be specified"
 #endif
 
 #if HAL_USE_RTC
@@ -27,11 +25,339 @@ extern SDCDriver SDCD1;
 extern RTCDriver RTCD1;
 #endif
 
+#if FATFS_BLOCK_CACHE_SIZE > 0
+#include "blockcache.h"
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Correspondence between physical drive number and physical drive.      */
 
-#define MMC     0
-#define SDC     0
+/*
+ * Physical drive descriptor.
+ */
+typedef struct {
+  BaseBlockDevice   *bdp;       /* Block device or NULL if unassigned.    */
+  Mutex             mtx;        /* Serializes the accesses to the drive.  */
+  bool_t            staging;    /* Unaligned transfers must be staged.    */
+#if FATFS_BLOCK_CACHE_SIZE > 0
+  BlockCache        cache;      /* Cache in front of the block device.    */
+  BlockCacheEntry   entries[FATFS_BLOCK_CACHE_SIZE];
+  uint32_t          buffer[FATFS_BLOCK_CACHE_SIZE * BLOCK_CACHE_BLOCK_SIZE /
+                           sizeof (uint32_t)];
+#endif
+} FatFSDrive;
+
+static FatFSDrive drives[FATFS_DRIVES];
+static bool_t drives_ready;
+
+/*
+ * Initializes the drives table on first use, the SDC driver is assigned
+ * to the first free drive followed by the MMC_SPI driver. Only the SDC
+ * driver, DMA-based, uses the staging buffers.
+ */
+static void drives_init(void) {
+  unsigned i;
+
+  chSysLock();
+  if (!drives_ready) {
+    for (i = 0; i < FATFS_DRIVES; i++) {
+      drives[i].bdp = NULL;
+      drives[i].staging = FALSE;
+      chMtxInit(&drives[i].mtx);
+    }
+    i = 0;
+#if HAL_USE_SDC
+    drives[i].staging = TRUE;
+    drives[i++].bdp = (BaseBlockDevice *)&SDCD1;
+#endif
+#if HAL_USE_MMC_SPI
+    if (i < FATFS_DRIVES)
+      drives[i].bdp = (BaseBlockDevice *)&MMCD1;
+#endif
+    drives_ready = TRUE;
+  }
+  chSysUnlock();
+}
+
+/*
+ * Locks a drive, returns NULL if the drive has no device assigned.
+ */
+static FatFSDrive *drive_lock(BYTE drv) {
+  FatFSDrive *dp;
+
+  if (drv >= FATFS_DRIVES)
+    return NULL;
+  drives_init();
+  dp = &drives[drv];
+  chMtxLock(&dp->mtx);
+  if (dp->bdp == NULL) {
+    chMtxUnlock();
+    return NULL;
+  }
+  return dp;
+}
+
+#define drive_unlock(dp) chMtxUnlock()
+
+#if FATFS_BLOCK_CACHE_SIZE > 0
+/*
+ * The cache is usable only while the underlying device is ready.
+ */
+#define drive_ready(dp) ((blkGetDriverState(&(dp)->cache) == BLK_READY) &&  \
+                         (blkGetDriverState((dp)->bdp) == BLK_READY))
+
+/*
+ * Block device used for the data transfers.
+ */
+#define drive_device(dp) (&(dp)->cache)
+#else
+#define drive_ready(dp) (blkGetDriverState((dp)->bdp) == BLK_READY)
+#define drive_device(dp) ((dp)->bdp)
+#endif
+
+/*
+ * Assigns a block device to a physical drive, NULL unassigns the drive.
+ * The staging flag must be TRUE for devices unable to efficiently handle
+ * unaligned buffers, typically DMA-based drivers, it is ignored if the
+ * staging buffers are disabled.
+ * The volumes hosted on the drive must not be mounted.
+ */
+bool_t fatfsRegisterDrive(unsigned drv, BaseBlockDevice *bdp,
+                          bool_t staging) {
+  FatFSDrive *dp;
+
+  if (drv >= FATFS_DRIVES)
+    return CH_FAILED;
+  drives_init();
+  dp = &drives[drv];
+  chMtxLock(&dp->mtx);
+#if FATFS_BLOCK_CACHE_SIZE > 0
+  /* Pending data is written back to the previous device.*/
+  if ((dp->bdp != NULL) && drive_ready(dp))
+    bcFlush(&dp->cache);
+  /* The cache is connected again by disk_initialize().*/
+  bcObjectInit(&dp->cache, bdp, dp->entries, (uint8_t *)dp->buffer,
+               FATFS_BLOCK_CACHE_SIZE);
+#endif
+  dp->bdp = bdp;
+  dp->staging = staging;
+  chMtxUnlock();
+  return CH_SUCCESS;
+}
+
+/*
+ * Disconnects the device assigned to a physical drive, the cached data is
+ * written back first. It must be used in place of the device disconnect
+ * function when the drive is cached because the cache content is discarded
+ * by the next disk_initialize(), the medium could have been replaced.
+ */
+bool_t fatfsDisconnectDrive(unsigned drv) {
+  FatFSDrive *dp;
+  bool_t err;
+
+  if ((drv >= FATFS_DRIVES) || ((dp = drive_lock((BYTE)drv)) == NULL))
+    return CH_FAILED;
+#if FATFS_BLOCK_CACHE_SIZE > 0
+  if (blkGetDriverState(&dp->cache) == BLK_READY)
+    err = blkDisconnect(&dp->cache);
+  else
+#endif
+    err = blkDisconnect(dp->bdp);
+  drive_unlock(dp);
+  return err;
+}
+
+/*
+ * Returns the block device assigned to a physical drive or NULL.
+ */
+BaseBlockDevice *fatfsGetDrive(unsigned drv) {
+
+  if (drv >= FATFS_DRIVES)
+    return NULL;
+  drives_init();
+  return drives[drv].bdp;
+}
+
+/*
+ * Returns the status of a locked drive.
+ */
+static DSTATUS drive_status(FatFSDrive *dp) {
+  DSTATUS stat = 0;
+
+  /* It is initialized externally, just reads the status.*/
+  if (blkGetDriverState(dp->bdp) != BLK_READY)
+    stat |= STA_NOINIT;
+  if (blkIsWriteProtected(dp->bdp))
+    stat |= STA_PROTECT;
+  return stat;
+}
+
+/*
+ * Reads sectors from a locked drive.
+ */
+static DRESULT read_sectors(FatFSDrive *dp, BYTE *buff, DWORD sector,
+                            BYTE count) {
+
+  if (!drive_ready(dp))
+    return RES_NOTRDY;
+  if (blkRead(drive_device(dp), sector, buff, count))
+    return RES_ERROR;
+  return RES_OK;
+}
+
+#if _READONLY == 0
+/*
+ * Writes sectors on a locked drive.
+ */
+static DRESULT write_sectors(FatFSDrive *dp, const BYTE *buff, DWORD sector,
+                             BYTE count) {
+
+  if (!drive_ready(dp))
+    return RES_NOTRDY;
+  if (blkIsWriteProtected(dp->bdp))
+    return RES_WRPRT;
+  if (blkWrite(drive_device(dp), sector, buff, count))
+    return RES_ERROR;
+  return RES_OK;
+}
+#endif /* _READONLY */
+
+#if FATFS_STAGING_BUFFERS > 0
+/*-----------------------------------------------------------------------*/
+/* Aligned staging buffers                                               */
+
+static uint32_t stbuffers[FATFS_STAGING_BUFFERS]
+                         [FATFS_STAGING_BLOCKS * MMCSD_BLOCK_SIZE /
+                          sizeof (uint32_t)];
+static bool_t stbusy[FATFS_STAGING_BUFFERS];
+static SEMAPHORE_DECL(stsem, FATFS_STAGING_BUFFERS);
+static FatFSStagingStats ststats;
+
+#define is_aligned(p) (((size_t)(p) & (sizeof (uint32_t) - 1)) == 0)
+
+/*
+ * Gets a free staging buffer, waits if all the buffers are in use.
+ */
+static uint8_t *staging_get(BYTE count) {
+  unsigned i;
+
+  chSysLock();
+  if (chSemGetCounterI(&stsem) <= 0)
+    ststats.waits++;
+  chSemWaitS(&stsem);
+  for (i = 0; stbusy[i]; i++)
+    ;
+  stbusy[i] = TRUE;
+  ststats.staged++;
+  ststats.blocks += count;
+  chSysUnlock();
+  return (uint8_t *)stbuffers[i];
+}
+
+/*
+ * Returns a staging buffer to the pool.
+ */
+static void staging_release(uint8_t *bp) {
+
+  chSysLock();
+  stbusy[(bp - (uint8_t *)stbuffers) / sizeof stbuffers[0]] = FALSE;
+  chSemSignalI(&stsem);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/*
+ * Decides if a transfer has to go through a staging buffer, only drives
+ * flagged for staging are considered and single sector transfers are left
+ * to the driver.
+ */
+static bool_t staging_required(FatFSDrive *dp, const BYTE *buff,
+                               BYTE count) {
+
+  if (!dp->staging || is_aligned(buff))
+    return FALSE;
+  chSysLock();
+  ststats.unaligned++;
+  chSysUnlock();
+  return count > 1;
+}
+
+/*
+ * Returns a copy of the staging statistics.
+ */
+void fatfsGetStagingStats(FatFSStagingStats *sp) {
+
+  chSysLock();
+  *sp = ststats;
+  chSysUnlock();
+}
+
+/*
+ * Clears the staging statistics.
+ */
+void fatfsResetStagingStats(void) {
+
+  chSysLock();
+  ststats.unaligned = 0;
+  ststats.staged    = 0;
+  ststats.blocks    = 0;
+  ststats.waits     = 0;
+  chSysUnlock();
+}
+
+/*
+ * Reads sectors from a locked drive through a staging buffer.
+ */
+static DRESULT staged_read(FatFSDrive *dp, BYTE *buff, DWORD sector,
+                           BYTE count) {
+  DRESULT res = RES_OK;
+  uint8_t *bp;
+
+  /* Multiple sectors chunks are read into an aligned buffer then copied.*/
+  bp = staging_get(count);
+  while (count > 0) {
+    BYTE n = count < FATFS_STAGING_BLOCKS ? count : FATFS_STAGING_BLOCKS;
+
+    res = read_sectors(dp, bp, sector, n);
+    if (res != RES_OK)
+      break;
+    memcpy(buff, bp, n * MMCSD_BLOCK_SIZE);
+    buff   += n * MMCSD_BLOCK_SIZE;
+    sector += n;
+    count  -= n;
+  }
+  staging_release(bp);
+  return res;
+}
+
+#if _READONLY == 0
+/*
+ * Writes sectors on a locked drive through a staging buffer.
+ */
+static DRESULT staged_write(FatFSDrive *dp, const BYTE *buff, DWORD sector,
+                            BYTE count) {
+  DRESULT res = RES_OK;
+  uint8_t *bp;
+
+  /* Multiple sectors chunks are copied into an aligned buffer then
+     written.*/
+  bp = staging_get(count);
+  while (count > 0) {
+    BYTE n = count < FATFS_STAGING_BLOCKS ? count : FATFS_STAGING_BLOCKS;
+
+    memcpy(bp, buff, n * MMCSD_BLOCK_SIZE);
+    res = write_sectors(dp, bp, sector, n);
+    if (res != RES_OK)
+      break;
+    buff   += n * MMCSD_BLOCK_SIZE;
+    sector += n;
+    count  -= n;
+  }
+  staging_release(bp);
+  return res;
+}
+#endif /* _READONLY */
+#endif /* FATFS_STAGING_BUFFERS > 0 */
 
 
 
@@ -42,30 +368,26 @@ DSTATUS disk_initialize (
     BYTE drv                /* Physical drive nmuber (0..) */
 )
 {
+  FatFSDrive *dp;
   DSTATUS stat;
 
-  switch (drv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&MMCD1))
-      stat |=  STA_PROTECT;
-    return stat;
-#else
-  case SDC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&SDCD1))
-      stat |=  STA_PROTECT;
-    return stat;
-#endif
+  if ((dp = drive_lock(drv)) == NULL)
+    return STA_NODISK;
+
+#if FATFS_BLOCK_CACHE_SIZE > 0
+  /* The cache is (re)connected to the device, its content is discarded
+     because the medium could have been replaced meanwhile. Pending data is
+     written back by fatfsDisconnectDrive() and fatfsRegisterDrive().*/
+  if (blkGetDriverState(dp->bdp) == BLK_READY) {
+    bcObjectInit(&dp->cache, dp->bdp, dp->entries, (uint8_t *)dp->buffer,
+                 FATFS_BLOCK_CACHE_SIZE);
+    blkConnect(&dp->cache);
   }
-  return STA_NODISK;
+#endif
+
+  stat = drive_status(dp);
+  drive_unlock(dp);
+  return stat;
 }
 
 
@@ -77,30 +399,14 @@ DSTATUS disk_status (
     BYTE drv        /* Physical drive nmuber (0..) */
 )
 {
+  FatFSDrive *dp;
   DSTATUS stat;
 
-  switch (drv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&MMCD1))
-      stat |= STA_PROTECT;
-    return stat;
-#else
-  case SDC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&SDCD1))
-      stat |= STA_PROTECT;
-    return stat;
-#endif
-  }
-  return STA_NODISK;
+  if ((dp = drive_lock(drv)) == NULL)
+    return STA_NODISK;
+  stat = drive_status(dp);
+  drive_unlock(dp);
+  return stat;
 }
 
 
@@ -115,32 +421,19 @@ DRESULT disk_read (
     BYTE count        /* Number of sectors to read (1..255) */
 )
 {
-  switch (drv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (mmcStartSequentialRead(&MMCD1, sector))
-      return RES_ERROR;
-    while (count > 0) {
-      if (mmcSequentialRead(&MMCD1, buff))
-        return RES_ERROR;
-      buff += MMCSD_BLOCK_SIZE;
-      count--;
-    }
-    if (mmcStopSequentialRead(&MMCD1))
-        return RES_ERROR;
-    return RES_OK;
-#else
-  case SDC:
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (sdcRead(&SDCD1, sector, buff, count))
-      return RES_ERROR;
-    return RES_OK;
+  FatFSDrive *dp;
+  DRESULT res;
+
+  if ((dp = drive_lock(drv)) == NULL)
+    return RES_PARERR;
+#if FATFS_STAGING_BUFFERS > 0
+  if (staging_required(dp, buff, count))
+    res = staged_read(dp, buff, sector, count);
+  else
 #endif
-  }
-  return RES_PARERR;
+    res = read_sectors(dp, buff, sector, count);
+  drive_unlock(dp);
+  return res;
 }
 
 
@@ -156,34 +449,19 @@ DRESULT disk_write (
     BYTE count            /* Number of sectors to write (1..255) */
 )
 {
-  switch (drv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    if (blkGetDriverState(&MMCD1) != BLK_READY)
-        return RES_NOTRDY;
-    if (mmcIsWriteProtected(&MMCD1))
-        return RES_WRPRT;
-    if (mmcStartSequentialWrite(&MMCD1, sector))
-        return RES_ERROR;
-    while (count > 0) {
-        if (mmcSequentialWrite(&MMCD1, buff))
-            return RES_ERROR;
-        buff += MMCSD_BLOCK_SIZE;
-        count--;
-    }
-    if (mmcStopSequentialWrite(&MMCD1))
-        return RES_ERROR;
-    return RES_OK;
-#else
-  case SDC:
-    if (blkGetDriverState(&SDCD1) != BLK_READY)
-      return RES_NOTRDY;
-    if (sdcWrite(&SDCD1, sector, buff, count))
-      return RES_ERROR;
-    return RES_OK;
+  FatFSDrive *dp;
+  DRESULT res;
+
+  if ((dp = drive_lock(drv)) == NULL)
+    return RES_PARERR;
+#if FATFS_STAGING_BUFFERS > 0
+  if (staging_required(dp, buff, count))
+    res = staged_write(dp, buff, sector, count);
+  else
 #endif
-  }
-  return RES_PARERR;
+    res = write_sectors(dp, buff, sector, count);
+  drive_unlock(dp);
+  return res;
 }
 #endif /* _READONLY */
 
@@ -192,54 +470,92 @@ DRESULT disk_write (
 /*-----------------------------------------------------------------------*/
 /* Miscellaneous Functions                                               */
 
+/*
+ * Erases a range of sectors, the erase is only a hint so devices without
+ * an erase primitive just ignore it.
+ */
+#if _USE_ERASE
+static DRESULT erase_sectors(FatFSDrive *dp, DWORD start, DWORD end) {
+
+#if FATFS_BLOCK_CACHE_SIZE > 0
+  /* The erased sectors must not survive in the cache.*/
+  bcFlush(&dp->cache);
+  bcInvalidate(&dp->cache);
+#endif
+#if HAL_USE_MMC_SPI
+  if (dp->bdp == (BaseBlockDevice *)&MMCD1) {
+    mmcErase(&MMCD1, start, end);
+    return RES_OK;
+  }
+#endif
+#if HAL_USE_SDC
+  if (dp->bdp == (BaseBlockDevice *)&SDCD1) {
+    sdcErase(&SDCD1, start, end);
+    return RES_OK;
+  }
+#endif
+  (void)start;
+  (void)end;
+  return RES_OK;
+}
+#endif /* _USE_ERASE */
+
+/*
+ * Returns the erase block size of a device in sectors, one if unknown.
+ */
+static DWORD erase_block_size(FatFSDrive *dp) {
+
+#if HAL_USE_SDC
+  if (dp->bdp == (BaseBlockDevice *)&SDCD1)
+    return 256; /* 512b blocks in one erase block */
+#endif
+  (void)dp;
+  return 1;
+}
+
 DRESULT disk_ioctl (
     BYTE drv,        /* Physical drive nmuber (0..) */
     BYTE ctrl,        /* Control code */
     void *buff        /* Buffer to send/receive control data */
 )
 {
-  switch (drv) {
-#if HAL_USE_MMC_SPI
-  case MMC:
-    switch (ctrl) {
-    case CTRL_SYNC:
-        return RES_OK;
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
-#if _USE_ERASE
-    case CTRL_ERASE_SECTOR:
-        mmcErase(&MMCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
-#endif
-    default:
-        return RES_PARERR;
-    }
-#else
-  case SDC:
-    switch (ctrl) {
-    case CTRL_SYNC:
-        return RES_OK;
-    case GET_SECTOR_COUNT:
-        *((DWORD *)buff) = mmcsdGetCardCapacity(&SDCD1);
-        return RES_OK;
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
-    case GET_BLOCK_SIZE:
-        *((DWORD *)buff) = 256; /* 512b blocks in one erase block */
-        return RES_OK;
+  FatFSDrive *dp;
+  BlockDeviceInfo bdi;
+  DRESULT res;
+
+  if ((dp = drive_lock(drv)) == NULL)
+    return RES_PARERR;
+  if (!drive_ready(dp)) {
+    drive_unlock(dp);
+    return RES_NOTRDY;
+  }
+
+  switch (ctrl) {
+  case CTRL_SYNC:
+    res = blkSync(drive_device(dp)) ? RES_ERROR : RES_OK;
+    break;
+  case GET_SECTOR_COUNT:
+    if ((res = blkGetInfo(dp->bdp, &bdi) ? RES_ERROR : RES_OK) == RES_OK)
+      *((DWORD *)buff) = bdi.blk_num;
+    break;
+  case GET_SECTOR_SIZE:
+    if ((res = blkGetInfo(dp->bdp, &bdi) ? RES_ERROR : RES_OK) == RES_OK)
+      *((WORD *)buff) = (WORD)bdi.blk_size;
+    break;
+  case GET_BLOCK_SIZE:
+    *((DWORD *)buff) = erase_block_size(dp);
+    res = RES_OK;
+    break;
 #if _USE_ERASE
-    case CTRL_ERASE_SECTOR:
-        sdcErase(&SDCD1, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
-#endif
-    default:
-        return RES_PARERR;
-    }
+  case CTRL_ERASE_SECTOR:
+    res = erase_sectors(dp, *((DWORD *)buff), *((DWORD *)buff + 1));
+    break;
 #endif
+  default:
+    res = RES_PARERR;
   }
-  return RES_PARERR;
+  drive_unlock(dp);
+  return res;
 }
 
 DWORD get_fattime(void) {
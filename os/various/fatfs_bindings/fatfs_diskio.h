@@ -0,0 +1,90 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*------------------------------------------------------------------------*/
+/* ChibiOS/RT specific extensions of the FatFs disk I/O module            */
+/*------------------------------------------------------------------------*/
+
+#ifndef _FATFS_DISKIO_H_
+#define _FATFS_DISKIO_H_
+
+/*
+ * Number of physical drives in the drives table, by default one for each
+ * FatFs volume. Drives are assigned to block devices using
+ * fatfsRegisterDrive(), initially the SDC driver (if enabled) is
+ * assigned to drive 0 and the MMC_SPI driver (if enabled) to the next
+ * drive.
+ */
+#if !defined(FATFS_DRIVES)
+#define FATFS_DRIVES            _VOLUMES
+#endif
+
+/*
+ * Number of sectors cached in RAM for each drive, zero disables the cache.
+ */
+#if !defined(FATFS_BLOCK_CACHE_SIZE)
+#define FATFS_BLOCK_CACHE_SIZE  0
+#endif
+
+/*
+ * Number of aligned staging buffers, zero disables the staging.
+ * Transfers of multiple sectors from/to buffers not aligned to 32 bits
+ * are performed through the staging buffers in chunks of
+ * FATFS_STAGING_BLOCKS sectors, this avoids the block by block bouncing
+ * performed by DMA-based drivers on unaligned buffers. Staging is enabled
+ * per drive by fatfsRegisterDrive(), by default only on the SDC drive.
+ */
+#if !defined(FATFS_STAGING_BUFFERS)
+#define FATFS_STAGING_BUFFERS   0
+#endif
+
+/*
+ * Size of each staging buffer in sectors.
+ */
+#if !defined(FATFS_STAGING_BLOCKS)
+#define FATFS_STAGING_BLOCKS    4
+#endif
+
+#if (FATFS_STAGING_BUFFERS > 0) && (FATFS_STAGING_BLOCKS < 2)
+#error "FATFS_STAGING_BLOCKS must be at least 2"
+#endif
+
+/*
+ * Staging buffers statistics.
+ */
+typedef struct {
+  uint32_t      unaligned;      /* Transfers on unaligned buffers.        */
+  uint32_t      staged;         /* Transfers performed through staging.   */
+  uint32_t      blocks;         /* Sectors moved through staging.         */
+  uint32_t      waits;          /* Waits for a free staging buffer.       */
+} FatFSStagingStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  bool_t fatfsRegisterDrive(unsigned drv, BaseBlockDevice *bdp,
+                            bool_t staging);
+  bool_t fatfsDisconnectDrive(unsigned drv);
+  BaseBlockDevice *fatfsGetDrive(unsigned drv);
+#if FATFS_STAGING_BUFFERS > 0
+  void fatfsGetStagingStats(FatFSStagingStats *sp);
+  void fatfsResetStagingStats(void);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FATFS_DISKIO_H_ */
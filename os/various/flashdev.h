@@ -0,0 +1,159 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    flashdev.h
+ * @brief   Flash devices access.
+ * @details This header defines an abstract interface useful to access
+ *          sector-erasable flash memories in a standardized way.
+ *
+ * @addtogroup flash_device
+ * @{
+ */
+
+#ifndef _FLASHDEV_H_
+#define _FLASHDEV_H_
+
+/**
+ * @brief   Flash device info.
+ */
+typedef struct {
+  uint32_t      sector_size;        /**< @brief Sector size in bytes.       */
+  uint32_t      sectors;            /**< @brief Total number of sectors.    */
+  uint32_t      align;              /**< @brief Programming unit in bytes,
+                                                offsets and sizes of the
+                                                program operations must be
+                                                multiple of this value.     */
+} FlashInfo;
+
+/**
+ * @brief   Value of the erased flash bytes.
+ */
+#define FLASH_ERASED            0xFF
+
+/**
+ * @brief   @p BaseFlash specific methods.
+ * @note    Offsets are expressed in bytes from the start of the device.
+ */
+#define _base_flash_methods                                                 \
+  /* Reads data from the device.*/                                          \
+  bool_t (*read)(void *instance, uint32_t offset,                           \
+                 uint8_t *buffer, size_t n);                                \
+  /* Programs previously erased locations.*/                                \
+  bool_t (*program)(void *instance, uint32_t offset,                        \
+                    const uint8_t *buffer, size_t n);                       \
+  /* Erases a sector.*/                                                     \
+  bool_t (*erase)(void *instance, uint32_t sector);                         \
+  /* Device info.*/                                                         \
+  bool_t (*get_info)(void *instance, FlashInfo *fip);
+
+/**
+ * @brief   @p BaseFlash specific data.
+ * @note    It is empty because @p BaseFlash is only an interface without
+ *          implementation.
+ */
+#define _base_flash_data
+
+/**
+ * @brief   @p BaseFlash virtual methods table.
+ */
+struct BaseFlashVMT {
+  _base_flash_methods
+};
+
+/**
+ * @brief   Base flash device class.
+ * @details This class represents a generic flash memory made of sectors
+ *          that can only be erased as a whole. Erased locations read as
+ *          @p FLASH_ERASED and can be programmed once before the next
+ *          erase of their sector.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct BaseFlashVMT *vmt;
+  _base_flash_data
+} BaseFlash;
+
+/**
+ * @name    Macro Functions (BaseFlash)
+ * @{
+ */
+/**
+ * @brief   Reads data from the device.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @param[in] offset    offset of the first byte to be read
+ * @param[out] buf      pointer to the read buffer
+ * @param[in] n         number of bytes to be read
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+#define flashRead(ip, offset, buf, n)                                       \
+  ((ip)->vmt->read(ip, offset, buf, n))
+
+/**
+ * @brief   Programs data into previously erased locations.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @param[in] offset    offset of the first byte to be programmed
+ * @param[in] buf       pointer to the data buffer
+ * @param[in] n         number of bytes to be programmed
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+#define flashProgram(ip, offset, buf, n)                                    \
+  ((ip)->vmt->program(ip, offset, buf, n))
+
+/**
+ * @brief   Erases a sector.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @param[in] sector    sector number
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+#define flashErase(ip, sector) ((ip)->vmt->erase(ip, sector))
+
+/**
+ * @brief   Returns a media information structure.
+ *
+ * @param[in] ip        pointer to a @p BaseFlash or derived class
+ * @param[out] fip      pointer to a @p FlashInfo structure
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @api
+ */
+#define flashGetInfo(ip, fip) ((ip)->vmt->get_info(ip, fip))
+/** @} */
+
+#endif /* _FLASHDEV_H_ */
+
+/** @} */
@@ -0,0 +1,1004 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    flashkv.c
+ * @brief   Flash key-value store code.
+ * @details The store is a log of records appended to the flash sectors,
+ *          each sector starts with a header carrying a sequence number
+ *          that orders the sectors in the log. A record is made of a
+ *          header, the value and a padding up to the device programming
+ *          unit, the header contains a CRC of the whole record.<br>
+ *          The records of a transaction are programmed contiguously in a
+ *          single sector, the first and the last records are marked, on
+ *          mount only the records of transactions whose last record is
+ *          intact are replayed into the index. The oldest sector is
+ *          reclaimed by copying its live records at the end of the log
+ *          before erasing it, one erased sector is always kept for this
+ *          purpose.
+ *
+ * @addtogroup flash_kv
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "flashkv.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Sector header magic number.
+ */
+#define FKV_MAGIC               0x31564B46
+
+/**
+ * @brief   Empty index slot marker.
+ */
+#define FKV_EMPTY               0xFFFFFFFF
+
+/**
+ * @name    Record flags
+ * @{
+ */
+#define FKV_FIRST               1   /**< @brief First record of a
+                                                transaction.                */
+#define FKV_LAST                2   /**< @brief Last record of a
+                                                transaction.                */
+#define FKV_DELETE              4   /**< @brief Key deletion record.        */
+/** @} */
+
+/**
+ * @brief   Size of the local buffers used for flash accesses.
+ * @note    It is also the maximum supported programming unit.
+ */
+#define FKV_CHUNK               64
+
+/**
+ * @brief   Rounds a size up to the device programming unit.
+ */
+#define align_up(kvp, n)                                                    \
+  (((uint32_t)(n) + (kvp)->align - 1) & ~((kvp)->align - 1))
+
+/**
+ * @brief   Size of a record with a value of @p n bytes.
+ */
+#define rec_size(kvp, n) align_up(kvp, FLASHKV_RECORD_HEADER + (n))
+
+/**
+ * @brief   Size of the sectors header.
+ */
+#define hdr_size(kvp) align_up(kvp, sizeof(fkvsector_t))
+
+/**
+ * @brief   Records space of a sector.
+ */
+#define capacity(kvp) ((kvp)->sector_size - hdr_size(kvp))
+
+/**
+ * @brief   Offset of a sector.
+ */
+#define sector_base(kvp, s) ((uint32_t)(s) * (kvp)->sector_size)
+
+/**
+ * @brief   Home slot of a key in the index.
+ */
+#define home(key)                                                           \
+  ((((uint32_t)(key) * 2654435761U) >> 16) & (FLASHKV_INDEX_SIZE - 1))
+
+/**
+ * @brief   Sector header.
+ */
+typedef struct {
+  uint32_t              magic;
+  uint32_t              seq;
+  uint32_t              crc;
+} fkvsector_t;
+
+/**
+ * @brief   Record header.
+ * @note    The CRC covers the header fields following it and the value.
+ */
+typedef struct {
+  uint32_t              crc;
+  uint32_t              key;
+  uint16_t              size;
+  uint8_t               flags;
+  uint8_t               reserved;
+} fkvrecord_t;
+
+/**
+ * @brief   Record check results.
+ */
+typedef enum {
+  REC_VALID = 0,                    /**< Intact record.                     */
+  REC_ERASED = 1,                   /**< End of the log.                    */
+  REC_INVALID = 2                   /**< Corrupted or interrupted record.   */
+} fkvrecstate_t;
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   CRC32 nibble table.
+ */
+static const uint32_t crc_table[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+  0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+  0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Updates a CRC32 (IEEE 802.3) over a buffer.
+ * @note    The initial value is all ones, the final value is complemented
+ *          by the callers.
+ */
+static uint32_t crc32(uint32_t crc, const uint8_t *p, size_t n) {
+
+  while (n-- > 0) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ crc_table[crc & 15];
+    crc = (crc >> 4) ^ crc_table[crc & 15];
+  }
+  return crc;
+}
+
+/**
+ * @brief   Computes the CRC of a sector header.
+ */
+static uint32_t sector_crc(const fkvsector_t *shp) {
+
+  return ~crc32(0xFFFFFFFF, (const uint8_t *)shp, 8);
+}
+
+/**
+ * @brief   Searches a key in the index.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @return              The slot containing the key or the empty slot where
+ *                      the key would be inserted.
+ */
+static uint32_t index_find(FlashKV *kvp, uint32_t key) {
+  uint32_t i = home(key);
+
+  while ((kvp->index[i].offset != FKV_EMPTY) && (kvp->index[i].key != key))
+    i = (i + 1) & (FLASHKV_INDEX_SIZE - 1);
+  return i;
+}
+
+/**
+ * @brief   Removes a slot from the index.
+ * @details The following entries of the probe sequence are moved back so
+ *          the lookups never need deletion markers.
+ */
+static void index_remove(FlashKV *kvp, uint32_t i) {
+  uint32_t j = i, k;
+
+  while (TRUE) {
+    j = (j + 1) & (FLASHKV_INDEX_SIZE - 1);
+    if (kvp->index[j].offset == FKV_EMPTY)
+      break;
+    /* The entry can fill the hole unless its home slot lies cyclically
+       between the hole and the entry itself.*/
+    k = home(kvp->index[j].key);
+    if ((j > i) ? ((k <= i) || (k > j)) : ((k <= i) && (k > j))) {
+      kvp->index[i] = kvp->index[j];
+      i = j;
+    }
+  }
+  kvp->index[i].offset = FKV_EMPTY;
+  kvp->keys--;
+}
+
+/**
+ * @brief   Applies a committed record to the index.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] offset    flash offset of the record
+ * @param[in] rp        pointer to the record header
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    the index is full.
+ */
+static bool_t apply(FlashKV *kvp, uint32_t offset, const fkvrecord_t *rp) {
+  uint32_t i = index_find(kvp, rp->key);
+  FlashKVEntry *ep = &kvp->index[i];
+
+  if (ep->offset == FKV_EMPTY) {
+    if (rp->flags & FKV_DELETE)
+      return CH_SUCCESS;
+    if (kvp->keys >= FLASHKV_INDEX_SIZE - 1)
+      return CH_FAILED;
+    kvp->keys++;
+  }
+  else {
+    kvp->sector[ep->offset / kvp->sector_size].live -=
+        rec_size(kvp, ep->size);
+    if (rp->flags & FKV_DELETE) {
+      index_remove(kvp, i);
+      return CH_SUCCESS;
+    }
+  }
+  ep->key    = rp->key;
+  ep->offset = offset;
+  ep->size   = rp->size;
+  kvp->sector[offset / kvp->sector_size].live += rec_size(kvp, rp->size);
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Reads and checks a record.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] offset    flash offset of the record
+ * @param[in] end       end offset of the sector
+ * @param[out] rp       pointer to the record header
+ * @return              The record state.
+ */
+static fkvrecstate_t read_record(FlashKV *kvp, uint32_t offset,
+                                 uint32_t end, fkvrecord_t *rp) {
+  uint8_t buf[FKV_CHUNK];
+  uint32_t crc, done, n;
+
+  if (end - offset < FLASHKV_RECORD_HEADER)
+    return REC_ERASED;
+  if (flashRead(kvp->flp, offset, (uint8_t *)rp, sizeof(fkvrecord_t)))
+    return REC_INVALID;
+  memset(buf, FLASH_ERASED, sizeof(fkvrecord_t));
+  if (memcmp(rp, buf, sizeof(fkvrecord_t)) == 0)
+    return REC_ERASED;
+  if (rec_size(kvp, rp->size) > end - offset)
+    return REC_INVALID;
+  crc = crc32(0xFFFFFFFF, (const uint8_t *)rp + 4, sizeof(fkvrecord_t) - 4);
+  for (done = 0; done < rp->size; done += n) {
+    n = rp->size - done < FKV_CHUNK ? rp->size - done : FKV_CHUNK;
+    if (flashRead(kvp->flp, offset + FLASHKV_RECORD_HEADER + done, buf, n))
+      return REC_INVALID;
+    crc = crc32(crc, buf, n);
+  }
+  return ~crc == rp->crc ? REC_VALID : REC_INVALID;
+}
+
+/**
+ * @brief   Checks if a sector is erased.
+ */
+static bool_t is_blank(FlashKV *kvp, uint32_t s) {
+  uint8_t buf[FKV_CHUNK];
+  uint32_t offset, i;
+
+  for (offset = 0; offset < kvp->sector_size; offset += FKV_CHUNK) {
+    i = kvp->sector_size - offset < FKV_CHUNK ?
+        kvp->sector_size - offset : FKV_CHUNK;
+    if (flashRead(kvp->flp, sector_base(kvp, s) + offset, buf, i))
+      return FALSE;
+    while (i > 0) {
+      if (buf[--i] != FLASH_ERASED)
+        return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Erases a sector and returns it to the erased pool.
+ */
+static bool_t erase_sector(FlashKV *kvp, uint32_t s) {
+
+  if (flashErase(kvp->flp, s))
+    return CH_FAILED;
+  kvp->stats.erases++;
+  kvp->sector[s].seq  = 0;
+  kvp->sector[s].live = 0;
+  kvp->free++;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Returns the oldest sector in the log.
+ */
+static uint32_t oldest(FlashKV *kvp) {
+  uint32_t s, v = kvp->active;
+
+  for (s = 0; s < kvp->sectors; s++) {
+    if ((kvp->sector[s].seq != 0) && (kvp->sector[s].seq < kvp->sector[v].seq))
+      v = s;
+  }
+  return v;
+}
+
+/**
+ * @brief   Appends a new erased sector to the log.
+ * @details The sectors are allocated circularly after the active one so
+ *          the erase cycles are spread over the whole device.
+ */
+static bool_t open_sector(FlashKV *kvp) {
+  uint8_t buf[FKV_CHUNK];
+  fkvsector_t sh;
+  uint32_t s = kvp->active, i;
+
+  for (i = 0; i < kvp->sectors; i++) {
+    s = (s + 1) % kvp->sectors;
+    if (kvp->sector[s].seq == 0)
+      break;
+  }
+  if (i >= kvp->sectors)
+    return CH_FAILED;
+
+  sh.magic = FKV_MAGIC;
+  sh.seq   = kvp->seq + 1;
+  sh.crc   = sector_crc(&sh);
+  memset(buf, FLASH_ERASED, hdr_size(kvp));
+  memcpy(buf, &sh, sizeof(sh));
+  if (flashProgram(kvp->flp, sector_base(kvp, s), buf, hdr_size(kvp)))
+    return CH_FAILED;
+  kvp->seq++;
+  kvp->sector[s].seq  = kvp->seq;
+  kvp->sector[s].live = 0;
+  kvp->free--;
+  kvp->active = s;
+  kvp->wroff  = hdr_size(kvp);
+#if FLASHKV_USE_GC_THREAD
+  if (kvp->free < FLASHKV_GC_THRESHOLD)
+    chBSemSignal(&kvp->gcsem);
+#endif
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Copies a live record at the end of the log.
+ * @details The copy is a transaction on its own, the value is streamed
+ *          from the old location in chunks.
+ */
+static bool_t copy_record(FlashKV *kvp, uint32_t src, const fkvrecord_t *rp) {
+  uint8_t buf[FKV_CHUNK];
+  fkvrecord_t rec = *rp;
+  uint32_t n = rec_size(kvp, rp->size), end = FLASHKV_RECORD_HEADER + rp->size;
+  uint32_t crc, dst, done, chunk, vs, ve;
+
+  if ((kvp->wroff + n > kvp->sector_size) &&
+      ((kvp->free == 0) || open_sector(kvp)))
+    return CH_FAILED;
+
+  rec.flags = (rp->flags & FKV_DELETE) | FKV_FIRST | FKV_LAST;
+  crc = crc32(0xFFFFFFFF, (const uint8_t *)&rec + 4, sizeof(rec) - 4);
+  for (done = FLASHKV_RECORD_HEADER; done < end; done += chunk) {
+    chunk = end - done < FKV_CHUNK ? end - done : FKV_CHUNK;
+    if (flashRead(kvp->flp, src + done, buf, chunk))
+      return CH_FAILED;
+    crc = crc32(crc, buf, chunk);
+  }
+  rec.crc = ~crc;
+
+  /* The record image is rebuilt chunk by chunk, header first.*/
+  dst = sector_base(kvp, kvp->active) + kvp->wroff;
+  for (done = 0; done < n; done += chunk) {
+    chunk = n - done < FKV_CHUNK ? n - done : FKV_CHUNK;
+    memset(buf, FLASH_ERASED, chunk);
+    if (done < FLASHKV_RECORD_HEADER)
+      memcpy(buf, (const uint8_t *)&rec + done, FLASHKV_RECORD_HEADER - done);
+    vs = done > FLASHKV_RECORD_HEADER ? done : FLASHKV_RECORD_HEADER;
+    ve = done + chunk < end ? done + chunk : end;
+    if ((vs < ve) && flashRead(kvp->flp, src + vs, buf + (vs - done), ve - vs))
+      return CH_FAILED;
+    if (flashProgram(kvp->flp, dst + done, buf, chunk)) {
+      /* The sector tail is not erased anymore.*/
+      kvp->wroff = kvp->sector_size;
+      return CH_FAILED;
+    }
+  }
+  kvp->wroff += n;
+  kvp->stats.copied += n;
+  return apply(kvp, dst, &rec);
+}
+
+/**
+ * @brief   Reclaims the oldest sector of the log.
+ */
+static bool_t gc_one(FlashKV *kvp) {
+  fkvrecord_t rec;
+  uint32_t v = oldest(kvp), base, off;
+
+  if ((v == kvp->active) && ((kvp->free == 0) || open_sector(kvp)))
+    return CH_FAILED;
+
+  base = sector_base(kvp, v);
+  off  = hdr_size(kvp);
+  while ((kvp->sector[v].live > 0) &&
+         (read_record(kvp, base + off, base + kvp->sector_size,
+                      &rec) == REC_VALID)) {
+    if (kvp->index[index_find(kvp, rec.key)].offset == base + off) {
+      if (copy_record(kvp, base + off, &rec))
+        return CH_FAILED;
+    }
+    off += rec_size(kvp, rec.size);
+  }
+
+  /* Live records not reachable by the scan would be lost.*/
+  if ((kvp->sector[v].live > 0) || erase_sector(kvp, v))
+    return CH_FAILED;
+  kvp->stats.compactions++;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Makes room for @p n bytes in the active sector.
+ */
+static bool_t reserve(FlashKV *kvp, uint32_t n) {
+  uint32_t i = 0;
+
+  while (kvp->wroff + n > kvp->sector_size) {
+    /* The last erased sector is reserved to the compaction.*/
+    if (kvp->free > 1) {
+      if (open_sector(kvp))
+        return CH_FAILED;
+    }
+    else {
+      if (i == 0)
+        kvp->stats.stalls++;
+      if ((i++ >= kvp->sectors) || gc_one(kvp))
+        return CH_FAILED;
+    }
+  }
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Replays the committed transactions of a sector.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] s         sector number
+ * @param[out] endp     offset of the log end inside the sector, the sector
+ *                      size if the log is followed by a corrupted record
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    the index is full.
+ */
+static bool_t replay(FlashKV *kvp, uint32_t s, uint32_t *endp) {
+  fkvrecord_t rec;
+  fkvrecstate_t state;
+  uint32_t base = sector_base(kvp, s), end = base + kvp->sector_size;
+  uint32_t off = base + hdr_size(kvp), first = FKV_EMPTY, p;
+
+  while ((state = read_record(kvp, off, end, &rec)) == REC_VALID) {
+    /* A first record discards an uncommitted transaction.*/
+    if (rec.flags & FKV_FIRST)
+      first = off;
+    off += rec_size(kvp, rec.size);
+    if ((rec.flags & FKV_LAST) && (first != FKV_EMPTY)) {
+      for (p = first; p < off; p += rec_size(kvp, rec.size)) {
+        if (flashRead(kvp->flp, p, (uint8_t *)&rec, sizeof(rec)) ||
+            apply(kvp, p, &rec))
+          return CH_FAILED;
+      }
+      first = FKV_EMPTY;
+    }
+  }
+  *endp = state == REC_ERASED ? off - base : kvp->sector_size;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Reads the device geometry and clears the store state.
+ */
+static bool_t setup(FlashKV *kvp) {
+  FlashInfo fi;
+  uint32_t i;
+
+  kvp->mounted = FALSE;
+  if (flashGetInfo(kvp->flp, &fi) || (fi.sectors < 2) ||
+      (fi.align == 0) || (fi.align > FKV_CHUNK) ||
+      ((fi.align & (fi.align - 1)) != 0) || ((fi.sector_size % fi.align) != 0))
+    return CH_FAILED;
+  kvp->sector_size = fi.sector_size;
+  kvp->sectors     = fi.sectors < FLASHKV_MAX_SECTORS ?
+                     fi.sectors : FLASHKV_MAX_SECTORS;
+  kvp->align       = fi.align;
+
+  /* Any transaction must fit in a single sector.*/
+  if (hdr_size(kvp) + align_up(kvp, FLASHKV_BUFFER_SIZE) > kvp->sector_size)
+    return CH_FAILED;
+
+  for (i = 0; i < FLASHKV_INDEX_SIZE; i++)
+    kvp->index[i].offset = FKV_EMPTY;
+  for (i = 0; i < kvp->sectors; i++) {
+    kvp->sector[i].seq  = 0;
+    kvp->sector[i].live = 0;
+  }
+  kvp->keys   = 0;
+  kvp->free   = 0;
+  kvp->seq    = 0;
+  kvp->active = kvp->sectors - 1;
+  kvp->wroff  = kvp->sector_size;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Rebuilds the store state from the flash content.
+ */
+static bool_t mount(FlashKV *kvp) {
+  fkvsector_t sh;
+  uint32_t s, next, last;
+
+  if (setup(kvp))
+    return CH_FAILED;
+
+  /* Sectors without a valid header are erased, they can be left over by
+     an interrupted erase or sector allocation.*/
+  for (s = 0; s < kvp->sectors; s++) {
+    if (flashRead(kvp->flp, sector_base(kvp, s), (uint8_t *)&sh, sizeof(sh)))
+      return CH_FAILED;
+    if ((sh.magic == FKV_MAGIC) && (sh.seq != 0) && (sh.crc == sector_crc(&sh))) {
+      kvp->sector[s].seq = sh.seq;
+      if (sh.seq > kvp->seq)
+        kvp->seq = sh.seq;
+    }
+    else if (is_blank(kvp, s))
+      kvp->free++;
+    else if (erase_sector(kvp, s))
+      return CH_FAILED;
+  }
+  if (kvp->free == kvp->sectors)
+    return open_sector(kvp);
+
+  /* Replaying the sectors in log order, the last one is the active one.*/
+  last = 0;
+  while (TRUE) {
+    next = kvp->sectors;
+    for (s = 0; s < kvp->sectors; s++) {
+      if ((kvp->sector[s].seq > last) &&
+          ((next == kvp->sectors) ||
+           (kvp->sector[s].seq < kvp->sector[next].seq)))
+        next = s;
+    }
+    if (next == kvp->sectors)
+      break;
+    if (replay(kvp, next, &kvp->wroff))
+      return CH_FAILED;
+    kvp->active = next;
+    last = kvp->sector[next].seq;
+  }
+
+  /* A compaction interrupted after allocating the reserved sector is
+     completed now. If the copies cannot be completed because the last
+     one was torn then the newest sector only contains copies, it is
+     erased and the originals, still intact, are replayed again.*/
+  if ((kvp->free == 0) && gc_one(kvp)) {
+    if (erase_sector(kvp, kvp->active))
+      return CH_FAILED;
+    return mount(kvp);
+  }
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Appends a record to the transaction buffer.
+ */
+static bool_t tx_add(FlashKV *kvp, uint32_t key, uint8_t flags,
+                     const void *buf, size_t n) {
+  uint8_t *p = (uint8_t *)kvp->txbuf + kvp->txlen;
+  fkvrecord_t rec;
+  size_t size;
+
+  if (!kvp->mounted || (n > FLASHKV_BUFFER_SIZE) ||
+      ((size = rec_size(kvp, n)) > FLASHKV_BUFFER_SIZE - kvp->txlen)) {
+    kvp->txerr = TRUE;
+    return CH_FAILED;
+  }
+  rec.crc      = 0;
+  rec.key      = key;
+  rec.size     = (uint16_t)n;
+  rec.flags    = flags;
+  rec.reserved = FLASH_ERASED;
+  memcpy(p, &rec, sizeof(rec));
+  memcpy(p + FLASHKV_RECORD_HEADER, buf, n);
+  memset(p + FLASHKV_RECORD_HEADER + n, FLASH_ERASED,
+         size - FLASHKV_RECORD_HEADER - n);
+  kvp->txlen += size;
+  return CH_SUCCESS;
+}
+
+#if FLASHKV_USE_GC_THREAD || defined(__DOXYGEN__)
+/**
+ * @brief   Background compaction thread.
+ */
+static msg_t gc_thread(void *arg) {
+  FlashKV *kvp = arg;
+  uint32_t v, i;
+
+  chRegSetThreadName("flashkv");
+  while (TRUE) {
+    chBSemWait(&kvp->gcsem);
+    chMtxLock(&kvp->mtx);
+    for (i = 0; kvp->mounted && (kvp->free < FLASHKV_GC_THRESHOLD) &&
+                (i < kvp->sectors); i++) {
+      /* Rewriting the active sector or a sector mostly made of live
+         records would consume the space being reclaimed, the commits
+         perform those compactions when there is no other choice.*/
+      v = oldest(kvp);
+      if ((v == kvp->active) ||
+          (kvp->sector[v].live > capacity(kvp) - capacity(kvp) / 4) ||
+          gc_one(kvp))
+        break;
+    }
+    chMtxUnlock();
+  }
+  return 0;
+}
+#endif /* FLASHKV_USE_GC_THREAD */
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Flash key-value store object initialization.
+ *
+ * @param[out] kvp      pointer to the @p FlashKV object to be initialized
+ * @param[in] flp       pointer to the @p BaseFlash device, the store uses
+ *                      up to @p FLASHKV_MAX_SECTORS sectors starting from
+ *                      the first one
+ *
+ * @init
+ */
+void fkvObjectInit(FlashKV *kvp, BaseFlash *flp) {
+
+  chDbgCheck((kvp != NULL) && (flp != NULL), "fkvObjectInit");
+
+  kvp->flp     = flp;
+  kvp->mounted = FALSE;
+  kvp->keys    = 0;
+  kvp->txlen   = 0;
+  kvp->txerr   = FALSE;
+  chMtxInit(&kvp->mtx);
+#if FLASHKV_USE_GC_THREAD
+  chBSemInit(&kvp->gcsem, TRUE);
+  kvp->gctp = NULL;
+#endif
+  fkvResetStats(kvp);
+}
+
+/**
+ * @brief   Mounts the store.
+ * @details The log is scanned and the index is rebuilt from the committed
+ *          transactions, the interrupted ones are discarded. A blank
+ *          device is formatted.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    device error or unsupported geometry.
+ *
+ * @api
+ */
+bool_t fkvMount(FlashKV *kvp) {
+  bool_t err;
+
+  chDbgCheck(kvp != NULL, "fkvMount");
+
+  chMtxLock(&kvp->mtx);
+  err = mount(kvp);
+  kvp->mounted = !err;
+  chMtxUnlock();
+#if FLASHKV_USE_GC_THREAD
+  if (!err && (kvp->gctp == NULL))
+    kvp->gctp = chThdCreateStatic(kvp->gcwa, sizeof(kvp->gcwa),
+                                  FLASHKV_GC_PRIORITY, gc_thread, kvp);
+#endif
+  return err;
+}
+
+/**
+ * @brief   Erases the store.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded, the store is mounted and empty.
+ * @retval CH_FAILED    device error or unsupported geometry.
+ *
+ * @api
+ */
+bool_t fkvFormat(FlashKV *kvp) {
+  uint32_t s;
+  bool_t err;
+
+  chDbgCheck(kvp != NULL, "fkvFormat");
+
+  chMtxLock(&kvp->mtx);
+  err = setup(kvp);
+  for (s = 0; !err && (s < kvp->sectors); s++)
+    err = erase_sector(kvp, s);
+  if (!err)
+    err = open_sector(kvp);
+  kvp->mounted = !err;
+  chMtxUnlock();
+#if FLASHKV_USE_GC_THREAD
+  if (!err && (kvp->gctp == NULL))
+    kvp->gctp = chThdCreateStatic(kvp->gcwa, sizeof(kvp->gcwa),
+                                  FLASHKV_GC_PRIORITY, gc_thread, kvp);
+#endif
+  return err;
+}
+
+/**
+ * @brief   Reads the value of a key.
+ * @details The lookup is performed in the RAM index, only the value is
+ *          read from the flash.
+ * @note    This function must not be invoked inside a transaction.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @param[out] buf      pointer to the value buffer
+ * @param[in,out] np    on entry the buffer size, on exit the value size,
+ *                      values larger than the buffer are truncated
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    key not found or device error.
+ *
+ * @api
+ */
+bool_t fkvGet(FlashKV *kvp, uint32_t key, void *buf, size_t *np) {
+  FlashKVEntry *ep;
+  bool_t err = CH_FAILED;
+
+  chDbgCheck((kvp != NULL) && (np != NULL) && ((buf != NULL) || (*np == 0)),
+             "fkvGet");
+
+  chMtxLock(&kvp->mtx);
+  if (kvp->mounted) {
+    ep = &kvp->index[index_find(kvp, key)];
+    if (ep->offset != FKV_EMPTY) {
+      err = flashRead(kvp->flp, ep->offset + FLASHKV_RECORD_HEADER, buf,
+                      *np < ep->size ? *np : ep->size);
+      *np = ep->size;
+    }
+  }
+  chMtxUnlock();
+  return err;
+}
+
+/**
+ * @brief   Writes the value of a key.
+ * @details This is a transaction made of a single record.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @param[in] buf       pointer to the value
+ * @param[in] n         value size
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    store full, value too large or device error.
+ *
+ * @api
+ */
+bool_t fkvPut(FlashKV *kvp, uint32_t key, const void *buf, size_t n) {
+
+  fkvBegin(kvp);
+  if (fkvTxPut(kvp, key, buf, n)) {
+    fkvAbort(kvp);
+    return CH_FAILED;
+  }
+  return fkvCommit(kvp);
+}
+
+/**
+ * @brief   Deletes a key.
+ * @details This is a transaction made of a single record, nothing is
+ *          written if the key does not exist.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    store full or device error.
+ *
+ * @api
+ */
+bool_t fkvDelete(FlashKV *kvp, uint32_t key) {
+
+  fkvBegin(kvp);
+  if (kvp->mounted &&
+      (kvp->index[index_find(kvp, key)].offset == FKV_EMPTY)) {
+    fkvAbort(kvp);
+    return CH_SUCCESS;
+  }
+  if (fkvTxDelete(kvp, key)) {
+    fkvAbort(kvp);
+    return CH_FAILED;
+  }
+  return fkvCommit(kvp);
+}
+
+/**
+ * @brief   Starts a transaction.
+ * @details The store is locked until the transaction is committed or
+ *          aborted, the modifications become visible on commit.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ *
+ * @api
+ */
+void fkvBegin(FlashKV *kvp) {
+
+  chDbgCheck(kvp != NULL, "fkvBegin");
+
+  chMtxLock(&kvp->mtx);
+  kvp->txlen = 0;
+  kvp->txerr = FALSE;
+}
+
+/**
+ * @brief   Adds a key write to the current transaction.
+ * @note    A failure is remembered and makes the commit fail.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @param[in] buf       pointer to the value
+ * @param[in] n         value size
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    transaction buffer full.
+ *
+ * @api
+ */
+bool_t fkvTxPut(FlashKV *kvp, uint32_t key, const void *buf, size_t n) {
+
+  chDbgCheck((kvp != NULL) && ((buf != NULL) || (n == 0)), "fkvTxPut");
+
+  return tx_add(kvp, key, 0, buf, n);
+}
+
+/**
+ * @brief   Adds a key deletion to the current transaction.
+ * @note    A failure is remembered and makes the commit fail.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @param[in] key       the key
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    transaction buffer full.
+ *
+ * @api
+ */
+bool_t fkvTxDelete(FlashKV *kvp, uint32_t key) {
+
+  chDbgCheck(kvp != NULL, "fkvTxDelete");
+
+  return tx_add(kvp, key, FKV_DELETE, NULL, 0);
+}
+
+/**
+ * @brief   Commits the current transaction.
+ * @details The records are programmed with a single operation after
+ *          making room in the active sector, after a power failure either
+ *          all or none of them are found on mount.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    previous transaction error, store full or device
+ *                      error, the transaction is discarded.
+ *
+ * @api
+ */
+bool_t fkvCommit(FlashKV *kvp) {
+  uint8_t *p = (uint8_t *)kvp->txbuf;
+  fkvrecord_t rec;
+  uint32_t off, n, keys = 0, records = 0, base;
+  bool_t err;
+
+  chDbgCheck(kvp != NULL, "fkvCommit");
+
+  err = kvp->txerr || !kvp->mounted;
+  if (!err && (kvp->txlen > 0)) {
+    /* Transaction markers and CRCs.*/
+    for (off = 0; off < kvp->txlen; off += n) {
+      memcpy(&rec, p + off, sizeof(rec));
+      n = rec_size(kvp, rec.size);
+      rec.flags &= FKV_DELETE;
+      if (off == 0)
+        rec.flags |= FKV_FIRST;
+      if (off + n == kvp->txlen)
+        rec.flags |= FKV_LAST;
+      rec.crc = ~crc32(crc32(0xFFFFFFFF, (const uint8_t *)&rec + 4,
+                             sizeof(rec) - 4),
+                       p + off + FLASHKV_RECORD_HEADER, rec.size);
+      memcpy(p + off, &rec, sizeof(rec));
+      if (!(rec.flags & FKV_DELETE) &&
+          (kvp->index[index_find(kvp, rec.key)].offset == FKV_EMPTY))
+        keys++;
+      records++;
+    }
+
+    if ((kvp->keys + keys > FLASHKV_INDEX_SIZE - 1) ||
+        reserve(kvp, kvp->txlen))
+      err = CH_FAILED;
+    else {
+      base = sector_base(kvp, kvp->active) + kvp->wroff;
+      if (flashProgram(kvp->flp, base, p, kvp->txlen)) {
+        /* The sector tail is not erased anymore.*/
+        kvp->wroff = kvp->sector_size;
+        err = CH_FAILED;
+      }
+      else {
+        for (off = 0; off < kvp->txlen; off += rec_size(kvp, rec.size)) {
+          memcpy(&rec, p + off, sizeof(rec));
+          (void)apply(kvp, base + off, &rec);
+        }
+        kvp->wroff += kvp->txlen;
+        kvp->stats.commits++;
+        kvp->stats.records += records;
+      }
+    }
+  }
+  kvp->txlen = 0;
+  chMtxUnlock();
+  return err;
+}
+
+/**
+ * @brief   Discards the current transaction.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ *
+ * @api
+ */
+void fkvAbort(FlashKV *kvp) {
+
+  chDbgCheck(kvp != NULL, "fkvAbort");
+
+  kvp->txlen = 0;
+  chMtxUnlock();
+}
+
+/**
+ * @brief   Reclaims the oldest sector.
+ * @details The live records of the oldest sector are moved at the end of
+ *          the log and the sector is erased, it can be invoked when the
+ *          system is idle in order to prepare erased sectors.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    store full or device error.
+ *
+ * @api
+ */
+bool_t fkvCompact(FlashKV *kvp) {
+  bool_t err;
+
+  chDbgCheck(kvp != NULL, "fkvCompact");
+
+  chMtxLock(&kvp->mtx);
+  err = !kvp->mounted || gc_one(kvp);
+  chMtxUnlock();
+  return err;
+}
+
+/** @} */
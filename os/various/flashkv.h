@@ -0,0 +1,338 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    flashkv.h
+ * @brief   Flash key-value store structures and macros.
+ *
+ * @addtogroup flash_kv
+ * @{
+ */
+
+#ifndef _FLASHKV_H_
+#define _FLASHKV_H_
+
+#include "flashdev.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the records header in bytes.
+ */
+#define FLASHKV_RECORD_HEADER   12
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Number of slots of the RAM index.
+ * @details The index is an open addressing hash table, it can hold up to
+ *          <tt>FLASHKV_INDEX_SIZE - 1</tt> keys but the lookups are faster
+ *          if it is kept at most half full.
+ * @note    The value must be a power of two.
+ */
+#if !defined(FLASHKV_INDEX_SIZE) || defined(__DOXYGEN__)
+#define FLASHKV_INDEX_SIZE          64
+#endif
+
+/**
+ * @brief   Maximum number of flash sectors used by the store.
+ */
+#if !defined(FLASHKV_MAX_SECTORS) || defined(__DOXYGEN__)
+#define FLASHKV_MAX_SECTORS         16
+#endif
+
+/**
+ * @brief   Size of the transaction buffer in bytes.
+ * @details All the records of a transaction are formatted in this buffer
+ *          and programmed with a single operation on commit, it limits
+ *          both the size of the transactions and of the values.
+ */
+#if !defined(FLASHKV_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define FLASHKV_BUFFER_SIZE         256
+#endif
+
+/**
+ * @brief   Enables the background compaction thread.
+ * @details If enabled a thread reclaims the oldest sectors while the
+ *          erased sectors are less than @p FLASHKV_GC_THRESHOLD, the
+ *          commits then rarely have to wait for a compaction.
+ */
+#if !defined(FLASHKV_USE_GC_THREAD) || defined(__DOXYGEN__)
+#define FLASHKV_USE_GC_THREAD       TRUE
+#endif
+
+/**
+ * @brief   Number of erased sectors the compaction thread keeps available.
+ * @note    One erased sector is always reserved for the compaction itself.
+ */
+#if !defined(FLASHKV_GC_THRESHOLD) || defined(__DOXYGEN__)
+#define FLASHKV_GC_THRESHOLD        2
+#endif
+
+/**
+ * @brief   Compaction thread priority.
+ */
+#if !defined(FLASHKV_GC_PRIORITY) || defined(__DOXYGEN__)
+#define FLASHKV_GC_PRIORITY         (LOWPRIO + 1)
+#endif
+
+/**
+ * @brief   Compaction thread stack size.
+ * @note    The compaction nests two 64 bytes copy buffers, the record copy
+ *          and the sector opening, on top of the flash driver calls.
+ */
+#if !defined(FLASHKV_GC_STACK_SIZE) || defined(__DOXYGEN__)
+#define FLASHKV_GC_STACK_SIZE       512
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_USE_MUTEXES
+#error "FlashKV requires CH_USE_MUTEXES"
+#endif
+
+#if FLASHKV_USE_GC_THREAD && !CH_USE_SEMAPHORES
+#error "FLASHKV_USE_GC_THREAD requires CH_USE_SEMAPHORES"
+#endif
+
+#if (FLASHKV_INDEX_SIZE < 2) ||                                             \
+    ((FLASHKV_INDEX_SIZE & (FLASHKV_INDEX_SIZE - 1)) != 0)
+#error "FLASHKV_INDEX_SIZE must be a power of two"
+#endif
+
+#if FLASHKV_MAX_SECTORS < 2
+#error "FLASHKV_MAX_SECTORS must be at least 2"
+#endif
+
+#if (FLASHKV_BUFFER_SIZE <= FLASHKV_RECORD_HEADER) ||                      \
+    (FLASHKV_BUFFER_SIZE > 65535)
+#error "invalid FLASHKV_BUFFER_SIZE value"
+#endif
+
+#if FLASHKV_GC_THRESHOLD < 2
+#error "FLASHKV_GC_THRESHOLD must be at least 2"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Index entry.
+ */
+typedef struct {
+  uint32_t              key;        /**< @brief Key.                        */
+  uint32_t              offset;     /**< @brief Flash offset of the last
+                                                committed record of the key,
+                                                all ones if the slot is
+                                                empty.                      */
+  uint16_t              size;       /**< @brief Value size.                 */
+} FlashKVEntry;
+
+/**
+ * @brief   Sector descriptor.
+ */
+typedef struct {
+  uint32_t              seq;        /**< @brief Sequence number, zero if
+                                                the sector is erased.       */
+  uint32_t              live;       /**< @brief Bytes occupied by live
+                                                records.                    */
+} FlashKVSector;
+
+/**
+ * @brief   Store statistics.
+ */
+typedef struct {
+  uint32_t              commits;    /**< @brief Committed transactions.     */
+  uint32_t              records;    /**< @brief Committed records.          */
+  uint32_t              compactions;/**< @brief Reclaimed sectors.          */
+  uint32_t              stalls;     /**< @brief Commits that had to wait for
+                                                a compaction.               */
+  uint32_t              copied;     /**< @brief Bytes moved by the
+                                                compactions.                */
+  uint32_t              erases;     /**< @brief Erased sectors.             */
+} FlashKVStats;
+
+/**
+ * @brief   Flash key-value store object.
+ */
+typedef struct {
+  /**
+   * @brief Flash device.
+   */
+  BaseFlash             *flp;
+  /**
+   * @brief Store mounted flag.
+   */
+  bool_t                mounted;
+  /**
+   * @brief Sector size in bytes.
+   */
+  uint32_t              sector_size;
+  /**
+   * @brief Number of sectors used by the store.
+   */
+  uint32_t              sectors;
+  /**
+   * @brief Programming unit of the device.
+   */
+  uint32_t              align;
+  /**
+   * @brief Sector currently being written.
+   */
+  uint32_t              active;
+  /**
+   * @brief Write offset inside the active sector.
+   */
+  uint32_t              wroff;
+  /**
+   * @brief Last assigned sector sequence number.
+   */
+  uint32_t              seq;
+  /**
+   * @brief Number of erased sectors.
+   */
+  uint32_t              free;
+  /**
+   * @brief Number of keys in the index.
+   */
+  uint32_t              keys;
+  /**
+   * @brief Sectors descriptors.
+   */
+  FlashKVSector         sector[FLASHKV_MAX_SECTORS];
+  /**
+   * @brief RAM index.
+   */
+  FlashKVEntry          index[FLASHKV_INDEX_SIZE];
+  /**
+   * @brief Mutex protecting the store.
+   */
+  Mutex                 mtx;
+  /**
+   * @brief Bytes used in the transaction buffer.
+   */
+  size_t                txlen;
+  /**
+   * @brief Transaction failed flag.
+   */
+  bool_t                txerr;
+  /**
+   * @brief Transaction buffer.
+   */
+  uint32_t              txbuf[(FLASHKV_BUFFER_SIZE + 3) / 4];
+#if FLASHKV_USE_GC_THREAD || defined(__DOXYGEN__)
+  /**
+   * @brief Compaction requests semaphore.
+   */
+  BinarySemaphore       gcsem;
+  /**
+   * @brief Compaction thread.
+   */
+  Thread                *gctp;
+  /**
+   * @brief Compaction thread working area.
+   */
+  WORKING_AREA(gcwa, FLASHKV_GC_STACK_SIZE);
+#endif
+  /**
+   * @brief Statistics.
+   */
+  FlashKVStats          stats;
+} FlashKV;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of keys in the store.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              The number of keys.
+ *
+ * @api
+ */
+#define fkvGetKeys(kvp) ((kvp)->keys)
+
+/**
+ * @brief   Returns a pointer to the store statistics.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ * @return              Pointer to a @p FlashKVStats structure.
+ *
+ * @api
+ */
+#define fkvGetStats(kvp) (&(kvp)->stats)
+
+/**
+ * @brief   Clears the store statistics.
+ *
+ * @param[in] kvp       pointer to the @p FlashKV object
+ *
+ * @api
+ */
+#define fkvResetStats(kvp) {                                                \
+  (kvp)->stats.commits     = 0;                                             \
+  (kvp)->stats.records     = 0;                                             \
+  (kvp)->stats.compactions = 0;                                             \
+  (kvp)->stats.stalls      = 0;                                             \
+  (kvp)->stats.copied      = 0;                                             \
+  (kvp)->stats.erases      = 0;                                             \
+}
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void fkvObjectInit(FlashKV *kvp, BaseFlash *flp);
+  bool_t fkvMount(FlashKV *kvp);
+  bool_t fkvFormat(FlashKV *kvp);
+  bool_t fkvGet(FlashKV *kvp, uint32_t key, void *buf, size_t *np);
+  bool_t fkvPut(FlashKV *kvp, uint32_t key, const void *buf, size_t n);
+  bool_t fkvDelete(FlashKV *kvp, uint32_t key);
+  void fkvBegin(FlashKV *kvp);
+  bool_t fkvTxPut(FlashKV *kvp, uint32_t key, const void *buf, size_t n);
+  bool_t fkvTxDelete(FlashKV *kvp, uint32_t key);
+  bool_t fkvCommit(FlashKV *kvp);
+  void fkvAbort(FlashKV *kvp);
+  bool_t fkvCompact(FlashKV *kvp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLASHKV_H_ */
+
+/** @} */
@@ -60,27 +60,69 @@
 #include "arch/cc.h"
 #include "arch/sys_arch.h"
 
+#if !CH_USE_MEMPOOLS
+#error "sys_arch requires CH_USE_MEMPOOLS"
+#endif
+
+// semaphores and mailboxes are allocated in constant time from static
+// pools, the heap is only used when a pool is empty or for mailboxes
+// larger than the pools ones
+struct small_mbox {
+  Mailbox       mb;
+  msg_t         buf[SYS_ARCH_MBOX_SMALL_SIZE];
+};
+
+struct large_mbox {
+  Mailbox       mb;
+  msg_t         buf[SYS_ARCH_MBOX_LARGE_SIZE];
+};
+
+struct sys_arch_stats sys_arch_stats;
+
+static Semaphore sems[SYS_ARCH_SEM_POOL_SIZE];
+static struct small_mbox small_mboxes[SYS_ARCH_MBOX_SMALL_POOL_SIZE];
+static struct large_mbox large_mboxes[SYS_ARCH_MBOX_LARGE_POOL_SIZE];
+static MemoryPool sem_pool, small_mbox_pool, large_mbox_pool;
+
+#define IS_IN(p, a) (((void *)(p) >= (void *)(a)) &&                        \
+                     ((void *)(p) < (void *)&(a)[sizeof (a) / sizeof (a)[0]]))
+
 void sys_init(void) {
 
+  chPoolInit(&sem_pool, sizeof (Semaphore), NULL);
+  chPoolLoadArray(&sem_pool, sems, SYS_ARCH_SEM_POOL_SIZE);
+  chPoolInit(&small_mbox_pool, sizeof (struct small_mbox), NULL);
+  chPoolLoadArray(&small_mbox_pool, small_mboxes,
+                  SYS_ARCH_MBOX_SMALL_POOL_SIZE);
+  chPoolInit(&large_mbox_pool, sizeof (struct large_mbox), NULL);
+  chPoolLoadArray(&large_mbox_pool, large_mboxes,
+                  SYS_ARCH_MBOX_LARGE_POOL_SIZE);
 }
 
 err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
 
-  *sem = chHeapAlloc(NULL, sizeof(Semaphore));
-  if (*sem == 0) {
-    SYS_STATS_INC(sem.err);
-    return ERR_MEM;
-  }
+  *sem = chPoolAlloc(&sem_pool);
+  if (*sem != 0)
+    sys_arch_stats.sem_pool++;
   else {
-    chSemInit(*sem, (cnt_t)count);
-    SYS_STATS_INC_USED(sem);
-    return ERR_OK;
+    *sem = chHeapAlloc(NULL, sizeof(Semaphore));
+    if (*sem == 0) {
+      SYS_STATS_INC(sem.err);
+      return ERR_MEM;
+    }
+    sys_arch_stats.sem_heap++;
   }
+  chSemInit(*sem, (cnt_t)count);
+  SYS_STATS_INC_USED(sem);
+  return ERR_OK;
 }
 
 void sys_sem_free(sys_sem_t *sem) {
 
-  chHeapFree(*sem);
+  if (IS_IN(*sem, sems))
+    chPoolFree(&sem_pool, *sem);
+  else
+    chHeapFree(*sem);
   *sem = SYS_SEM_NULL;
   SYS_STATS_DEC(sem.used);
 }
@@ -123,17 +165,25 @@ void sys_sem_set_invalid(sys_sem_t *sem) {
 }
 
 err_t sys_mbox_new(sys_mbox_t *mbox, int size) {
-  
-  *mbox = chHeapAlloc(NULL, sizeof(Mailbox) + sizeof(msg_t) * size);
-  if (*mbox == 0) {
-    SYS_STATS_INC(mbox.err);
-    return ERR_MEM;
-  }
+
+  *mbox = 0;
+  if (size <= SYS_ARCH_MBOX_SMALL_SIZE)
+    *mbox = chPoolAlloc(&small_mbox_pool);
+  if ((*mbox == 0) && (size <= SYS_ARCH_MBOX_LARGE_SIZE))
+    *mbox = chPoolAlloc(&large_mbox_pool);
+  if (*mbox != 0)
+    sys_arch_stats.mbox_pool++;
   else {
-    chMBInit(*mbox, (void *)(((uint8_t *)*mbox) + sizeof(Mailbox)), size);
-    SYS_STATS_INC(mbox.used);
-    return ERR_OK;
+    *mbox = chHeapAlloc(NULL, sizeof(Mailbox) + sizeof(msg_t) * size);
+    if (*mbox == 0) {
+      SYS_STATS_INC(mbox.err);
+      return ERR_MEM;
+    }
+    sys_arch_stats.mbox_heap++;
   }
+  chMBInit(*mbox, (void *)(((uint8_t *)*mbox) + sizeof(Mailbox)), size);
+  SYS_STATS_INC(mbox.used);
+  return ERR_OK;
 }
 
 void sys_mbox_free(sys_mbox_t *mbox) {
@@ -145,7 +195,12 @@ void sys_mbox_free(sys_mbox_t *mbox) {
     SYS_STATS_INC(mbox.err);
     chMBReset(*mbox);
   }
-  chHeapFree(*mbox);
+  if (IS_IN(*mbox, small_mboxes))
+    chPoolFree(&small_mbox_pool, *mbox);
+  else if (IS_IN(*mbox, large_mboxes))
+    chPoolFree(&large_mbox_pool, *mbox);
+  else
+    chHeapFree(*mbox);
   *mbox = SYS_MBOX_NULL;
   SYS_STATS_DEC(mbox.used);
 }
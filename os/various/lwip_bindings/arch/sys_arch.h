@@ -62,6 +62,52 @@ typedef int             sys_prot_t;
 #define SYS_THREAD_NULL (Thread *)0
 #define SYS_SEM_NULL    (Semaphore *)0
 
+#define SYS_ARCH_MAX(a, b)              ((a) > (b) ? (a) : (b))
+#define SYS_ARCH_MAX3(a, b, c)          SYS_ARCH_MAX(SYS_ARCH_MAX(a, b), c)
+
+/* Number of semaphores in the static pool, further semaphores are
+   allocated from the heap.*/
+#ifndef SYS_ARCH_SEM_POOL_SIZE
+#define SYS_ARCH_SEM_POOL_SIZE          (MEMP_NUM_NETCONN + 4)
+#endif
+
+/* Number of small mailboxes in the static pool, small mailboxes serve the
+   raw, UDP and accept mailboxes.*/
+#ifndef SYS_ARCH_MBOX_SMALL_POOL_SIZE
+#define SYS_ARCH_MBOX_SMALL_POOL_SIZE   MEMP_NUM_NETCONN
+#endif
+
+/* Number of large mailboxes in the static pool, large mailboxes serve the
+   TCP receive mailboxes and the tcpip thread mailbox.*/
+#ifndef SYS_ARCH_MBOX_LARGE_POOL_SIZE
+#define SYS_ARCH_MBOX_LARGE_POOL_SIZE   (MEMP_NUM_NETCONN + 1)
+#endif
+
+/* Size of the small mailboxes.*/
+#ifndef SYS_ARCH_MBOX_SMALL_SIZE
+#define SYS_ARCH_MBOX_SMALL_SIZE        SYS_ARCH_MAX3(DEFAULT_RAW_RECVMBOX_SIZE,\
+                                                      DEFAULT_UDP_RECVMBOX_SIZE,\
+                                                      DEFAULT_ACCEPTMBOX_SIZE)
+#endif
+
+/* Size of the large mailboxes, larger mailboxes are allocated from the
+   heap.*/
+#ifndef SYS_ARCH_MBOX_LARGE_SIZE
+#define SYS_ARCH_MBOX_LARGE_SIZE        SYS_ARCH_MAX(DEFAULT_TCP_RECVMBOX_SIZE, \
+                                                     SYS_ARCH_MBOX_SMALL_SIZE)
+#endif
+
+/* Allocation statistics of the semaphores and mailboxes, objects not
+   served by the pools are allocated from the heap.*/
+struct sys_arch_stats {
+  uint32_t      sem_pool;       /* Semaphores allocated from the pool.    */
+  uint32_t      sem_heap;       /* Semaphores allocated from the heap.    */
+  uint32_t      mbox_pool;      /* Mailboxes allocated from the pools.    */
+  uint32_t      mbox_heap;      /* Mailboxes allocated from the heap.     */
+};
+
+extern struct sys_arch_stats sys_arch_stats;
+
 /* let sys.h use binary semaphores for mutexes */
 #define LWIP_COMPAT_MUTEX 1
 
@@ -70,17 +70,85 @@
 #include <lwip/stats.h>
 #include <lwip/snmp.h>
 #include <lwip/tcpip.h>
+#include "lwip/ip.h"
+#include "lwip/udp.h"
+#include "lwip/inet_chksum.h"
 #include "netif/etharp.h"
 #include "netif/ppp_oe.h"
 
 #define PERIODIC_TIMER_ID       1
 #define FRAME_RECEIVED_ID       2
+#define LINK_CHANGED_ID         4
+
+#if !CH_USE_MEMPOOLS
+#error "lwipthread requires CH_USE_MEMPOOLS"
+#endif
+
+#if LWIP_USE_ZERO_COPY_RX
+#if !MAC_USE_ZERO_COPY
+#error "LWIP_USE_ZERO_COPY_RX requires MAC_USE_ZERO_COPY"
+#endif
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "LWIP_USE_ZERO_COPY_RX requires LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+#if ETH_PAD_SIZE
+#error "LWIP_USE_ZERO_COPY_RX requires ETH_PAD_SIZE set to zero"
+#endif
+
+/*
+ * Size of the pbuf header stored in the headroom area of the loaned MAC
+ * buffers, right in front of the frame.
+ */
+#define RX_PBUF_SIZE            LWIP_MEM_ALIGN_SIZE(sizeof (struct pbuf_custom))
+#endif
+
+#if LWIP_USE_ZERO_COPY_TX
+#if !MAC_USE_ZERO_COPY
+#error "LWIP_USE_ZERO_COPY_TX requires MAC_USE_ZERO_COPY"
+#endif
+#if ETH_PAD_SIZE
+#error "LWIP_USE_ZERO_COPY_TX requires ETH_PAD_SIZE set to zero"
+#endif
+#endif
+
+#if (!CHECKSUM_GEN_IP || !CHECKSUM_GEN_UDP || !CHECKSUM_GEN_TCP ||         \
+     !CHECKSUM_GEN_ICMP) && !MAC_SUPPORTS_CHECKSUM_OFFLOAD
+#error "checksum generation disabled but not offloaded to the MAC driver"
+#endif
+
+/*
+ * The received frames are verified here when lwIP skips the checksums, only
+ * the checksums not already verified by the MAC driver are computed.
+ */
+#define RX_CHECKSUM_FALLBACK                                                \
+  (!CHECKSUM_CHECK_IP || !CHECKSUM_CHECK_UDP || !CHECKSUM_CHECK_TCP)
+
+/*
+ * Batch of received frames passed to the tcpip thread in a single message.
+ */
+struct rx_batch {
+  struct netif          *netif;
+  unsigned              n;
+  struct pbuf           *frames[LWIP_RX_BATCH_SIZE];
+};
 
 /**
  * Stack area for the LWIP-MAC thread.
  */
 WORKING_AREA(wa_lwip_thread, LWIP_THREAD_STACK_SIZE);
 
+/**
+ * Receive path statistics.
+ */
+struct lwipthread_rxstats lwip_rxstats;
+
+static struct rx_batch rx_batches[LWIP_RX_BATCHES];
+static MemoryPool rx_batch_pool;
+
+#if LWIP_USE_MAC_QUEUE
+static MACQueue *rx_queue;
+#endif
+
 /*
  * Initialization.
  */
@@ -96,8 +164,82 @@ static void low_level_init(struct netif *netif) {
   netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
 
   /* Do whatever else is needed to initialize interface. */
+#if LWIP_USE_ZERO_COPY_RX
+  chDbgAssert(RX_PBUF_SIZE <= MAC_RECEIVE_HEADROOM, "low_level_init(), #1",
+              "MAC_RECEIVE_HEADROOM too small");
+#endif
+}
+
+#if LWIP_USE_ZERO_COPY_TX
+/*
+ * Drops the reference to a chain transmitted in place. The driver invokes
+ * it from any thread reclaiming the transmit descriptors, this includes
+ * the callers of macWaitTransmitDescriptor() and macTransmitSegments() on
+ * the same driver, pbuf_free() is only safe if all of them are the tcpip
+ * thread.
+ */
+static void tx_pbuf_release(void *p) {
+
+  pbuf_free((struct pbuf *)p);
+}
+
+/*
+ * Checks if the headers in the first pbuf of a chain can be modified while
+ * the DMA is reading them. The TCP segments are kept by lwIP for
+ * retransmission and their headers are rewritten in place, a chain
+ * referenced elsewhere can be modified as well.
+ */
+static bool_t tx_mutable_headers(struct pbuf *p) {
+
+  if (p->ref > 1)
+    return TRUE;
+  if (((struct eth_hdr *)p->payload)->type != PP_HTONS(ETHTYPE_IP))
+    return FALSE;
+  return (p->len < SIZEOF_ETH_HDR + IP_HLEN) ||
+         (IPH_PROTO((struct ip_hdr *)((u8_t *)p->payload + SIZEOF_ETH_HDR)) ==
+          IP_PROTO_TCP);
+}
+
+/*
+ * Describes a chain as transmit segments. If the headers are mutable only
+ * the first pbuf is copied into the driver buffers, the following pbufs are
+ * transmitted in place if they are PBUF_ROM or PBUF_REF references to data
+ * not modified by lwIP. Returns zero if the whole chain must be copied.
+ */
+static unsigned tx_segments(struct pbuf *p, MACTransmitSegment *segp) {
+  struct pbuf *q;
+  bool_t mutable;
+  unsigned n = 0;
+
+  if (p->len < SIZEOF_ETH_HDR)
+    return 0;
+  mutable = tx_mutable_headers(p);
+  if (mutable && (p->next == NULL))
+    return 0;
+  for (q = p; q != NULL; q = q->next) {
+    if (n >= LWIP_TX_MAX_SEGMENTS)
+      return 0;
+    if (mutable && (q != p) &&
+        (q->type != PBUF_ROM) && (q->type != PBUF_REF))
+      return 0;
+    segp[n].buf  = (const uint8_t *)q->payload;
+    segp[n].size = (size_t)q->len;
+    segp[n].copy = mutable && (q == p);
+    n++;
+  }
+  return n;
 }
 
+/*
+ * Releases the transmitted chains, executed by the tcpip thread.
+ */
+static void tx_reclaim(void *arg) {
+
+  (void)arg;
+  macReclaimTransmitSegments(&ETHD1);
+}
+#endif
+
 /*
  * Transmits a frame.
  */
@@ -106,6 +248,30 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p) {
   MACTransmitDescriptor td;
 
   (void)netif;
+
+#if LWIP_USE_ZERO_COPY_TX
+  {
+    MACTransmitSegment segs[LWIP_TX_MAX_SEGMENTS];
+    unsigned n = tx_segments(p, segs);
+    msg_t msg;
+
+    if (n > 0) {
+      /* The chain is referenced until the driver releases it.*/
+      pbuf_ref(p);
+      msg = macTransmitSegments(&ETHD1, segs, n, tx_pbuf_release, p,
+                                MS2ST(LWIP_SEND_TIMEOUT));
+      if (msg == RDY_OK) {
+        LINK_STATS_INC(link.xmit);
+        return ERR_OK;
+      }
+      pbuf_free(p);
+      if (msg == RDY_TIMEOUT)
+        return ERR_TIMEOUT;
+    }
+    /* Chain not suitable for the driver, it is copied.*/
+  }
+#endif
+
   if (macWaitTransmitDescriptor(&ETHD1, &td, MS2ST(LWIP_SEND_TIMEOUT)) != RDY_OK)
     return ERR_TIMEOUT;
 
@@ -127,10 +293,156 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p) {
   return ERR_OK;
 }
 
+#if LWIP_USE_ZERO_COPY_RX
 /*
- * Receives a frame.
+ * Gives a loaned buffer back to the MAC driver when lwIP frees the pbuf.
  */
-static struct pbuf *low_level_input(struct netif *netif) {
+static void rx_pbuf_free(struct pbuf *p) {
+#if LWIP_USE_MAC_QUEUE
+  MACQueueFrame fr;
+
+  /* The buffer no more counts toward the queue limit.*/
+  fr.buf = (uint8_t *)p + RX_PBUF_SIZE;
+  macqReleaseFrame(rx_queue, &fr);
+#else
+  macReturnReceiveBuffer(&ETHD1, (uint8_t *)p + RX_PBUF_SIZE);
+#endif
+}
+#endif
+
+#if RX_CHECKSUM_FALLBACK
+/*
+ * Verifies the checksums skipped by both lwIP and the MAC driver. The IPv4
+ * fragments payload cannot be verified before reassembly, malformed packets
+ * are left to lwIP.
+ */
+static bool_t rx_checksum_verify(struct pbuf *p, unsigned status) {
+  struct ip_hdr *iphdr;
+  ip_addr_t src, dest;
+  u16_t hlen, len, offset;
+  u8_t proto;
+  bool_t ok;
+
+  if ((status & (MAC_CHECKSUM_IP | MAC_CHECKSUM_PAYLOAD)) ==
+      (MAC_CHECKSUM_IP | MAC_CHECKSUM_PAYLOAD))
+    return TRUE;
+  if ((p->len < SIZEOF_ETH_HDR + IP_HLEN) ||
+      (((struct eth_hdr *)p->payload)->type != PP_HTONS(ETHTYPE_IP)))
+    return TRUE;
+  iphdr = (struct ip_hdr *)((u8_t *)p->payload + SIZEOF_ETH_HDR);
+  hlen  = IPH_HL(iphdr) * 4;
+  len   = ntohs(IPH_LEN(iphdr));
+  if ((IPH_V(iphdr) != 4) || (hlen < IP_HLEN) ||
+      (p->len < SIZEOF_ETH_HDR + hlen) || (len < hlen) ||
+      (len > p->tot_len - SIZEOF_ETH_HDR))
+    return TRUE;
+
+#if !CHECKSUM_CHECK_IP
+  if (!(status & MAC_CHECKSUM_IP) && (inet_chksum(iphdr, hlen) != 0))
+    return FALSE;
+#endif
+
+  if ((status & MAC_CHECKSUM_PAYLOAD) ||
+      ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) != 0))
+    return TRUE;
+  proto = IPH_PROTO(iphdr);
+  switch (proto) {
+#if !CHECKSUM_CHECK_UDP
+  case IP_PROTO_UDP:
+    /* A zero checksum means that the sender did not compute it.*/
+    if ((len < hlen + UDP_HLEN) ||
+        (p->len < SIZEOF_ETH_HDR + hlen + UDP_HLEN) ||
+        ((((u8_t *)iphdr)[hlen + 6] | ((u8_t *)iphdr)[hlen + 7]) == 0))
+      return TRUE;
+    break;
+#endif
+#if !CHECKSUM_CHECK_TCP
+  case IP_PROTO_TCP:
+    break;
+#endif
+  default:
+    return TRUE;
+  }
+
+  /* Checksum over the pseudo header and the payload, the Ethernet padding
+     of short frames is excluded.*/
+  ip_addr_copy(src, iphdr->src);
+  ip_addr_copy(dest, iphdr->dest);
+  offset = SIZEOF_ETH_HDR + hlen;
+  len   -= hlen;
+  pbuf_header(p, -(s16_t)offset);
+  ok = inet_chksum_pseudo_partial(p, &src, &dest, proto, len, len) == 0;
+  pbuf_header(p, (s16_t)offset);
+  return ok;
+}
+#endif /* RX_CHECKSUM_FALLBACK */
+
+#if LWIP_USE_MAC_QUEUE
+/*
+ * Receives a frame from the classifier queue, the checksums verified by
+ * the MAC driver are returned in csump.
+ */
+static struct pbuf *low_level_input(struct netif *netif, unsigned *csump) {
+  MACQueueFrame fr;
+  struct pbuf *p;
+  u16_t len;
+
+  (void)netif;
+  if (macqGetFrame(rx_queue, &fr, TIME_IMMEDIATE) == RDY_OK) {
+    len = (u16_t)fr.size;
+    *csump = fr.csum;
+
+#if LWIP_USE_ZERO_COPY_RX
+    {
+      struct pbuf_custom *pc;
+
+      /* The queued frames are loaned buffers, the pbuf header is built in
+         the headroom as for the frames loaned by the MAC driver.*/
+      pc = (struct pbuf_custom *)(fr.buf - RX_PBUF_SIZE);
+      pc->custom_free_function = rx_pbuf_free;
+      LINK_STATS_INC(link.recv);
+      return pbuf_alloced_custom(PBUF_RAW, len, PBUF_POOL, pc, fr.buf, len);
+    }
+#endif
+
+#if ETH_PAD_SIZE
+    len += ETH_PAD_SIZE;        /* allow room for Ethernet padding */
+#endif
+
+    /* We allocate a pbuf chain of pbufs from the pool. */
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+
+    if (p != NULL) {
+
+#if ETH_PAD_SIZE
+      pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
+#endif
+
+      pbuf_take(p, fr.buf, (u16_t)fr.size);
+      macqReleaseFrame(rx_queue, &fr);
+
+#if ETH_PAD_SIZE
+      pbuf_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
+#endif
+
+      LINK_STATS_INC(link.recv);
+    }
+    else {
+      macqReleaseFrame(rx_queue, &fr);
+      LINK_STATS_INC(link.memerr);
+      LINK_STATS_INC(link.drop);
+    }
+    return p;
+  }
+  return NULL;
+}
+
+#else /* !LWIP_USE_MAC_QUEUE */
+/*
+ * Receives a frame, the checksums verified by the MAC driver are returned
+ * in csump.
+ */
+static struct pbuf *low_level_input(struct netif *netif, unsigned *csump) {
   MACReceiveDescriptor rd;
   struct pbuf *p, *q;
   u16_t len;
@@ -138,6 +450,29 @@ static struct pbuf *low_level_input(struct netif *netif) {
   (void)netif;
   if (macWaitReceiveDescriptor(&ETHD1, &rd, TIME_IMMEDIATE) == RDY_OK) {
     len = (u16_t)rd.size;
+    *csump = macGetReceiveChecksumStatus(&rd);
+
+#if LWIP_USE_ZERO_COPY_RX
+    {
+      struct pbuf_custom *pc;
+      uint8_t *buf;
+      size_t n;
+
+      /* The pbuf header is built in the headroom in front of the frame.
+         The pbuf is declared as PBUF_POOL so that lwIP is able to restore
+         the headers it removed, this is not possible with PBUF_REF. The
+         payload never moves in front of the frame start.*/
+      buf = macLoanReceiveBuffer(&rd, &n);
+      if (buf != NULL) {
+        macReleaseReceiveDescriptor(&rd);
+        pc = (struct pbuf_custom *)(buf - RX_PBUF_SIZE);
+        pc->custom_free_function = rx_pbuf_free;
+        LINK_STATS_INC(link.recv);
+        return pbuf_alloced_custom(PBUF_RAW, len, PBUF_POOL, pc, buf, (u16_t)n);
+      }
+      /* No spare buffers in the MAC driver, the frame is copied.*/
+    }
+#endif
 
 #if ETH_PAD_SIZE
     len += ETH_PAD_SIZE;        /* allow room for Ethernet padding */
@@ -172,6 +507,19 @@ static struct pbuf *low_level_input(struct netif *netif) {
   }
   return NULL;
 }
+#endif /* !LWIP_USE_MAC_QUEUE */
+
+/*
+ * Feeds a batch of frames to the stack, executed by the tcpip thread.
+ */
+static void rx_batch_input(void *arg) {
+  struct rx_batch *bp = arg;
+  unsigned i;
+
+  for (i = 0; i < bp->n; i++)
+    ethernet_input(bp->frames[i], bp->netif);
+  chPoolFree(&rx_batch_pool, bp);
+}
 
 /*
  * Initialization.
@@ -210,16 +558,30 @@ static err_t ethernetif_init(struct netif *netif) {
  *
  * @param[in] p pointer to a @p lwipthread_opts structure or @p NULL
  * @return The function does not return.
+ * @retval RDY_RESET @p LWIP_USE_MAC_QUEUE is enabled and the options do
+ *         not specify a queue served by a classifier started on ETHD1.
  */
 msg_t lwip_thread(void *p) {
   EvTimer evt;
-  EventListener el0, el1;
+  EventListener el0, el1, el2;
   struct ip_addr ip, gateway, netmask;
   static struct netif thisif;
-  static const MACConfig mac_config = {thisif.hwaddr};
+  static MACConfig mac_config;
 
   chRegSetThreadName("lwipthread");
 
+#if LWIP_USE_MAC_QUEUE
+  /* The queue can only be specified in the options, the thread terminates
+     if it is missing or not served by a classifier started on ETHD1.*/
+  rx_queue = p != NULL ? ((struct lwipthread_opts *)p)->macqueue : NULL;
+  if ((rx_queue == NULL) || (rx_queue->clp == NULL) ||
+      (rx_queue->clp->macp != &ETHD1))
+    return RDY_RESET;
+#endif
+
+  chPoolInit(&rx_batch_pool, sizeof (struct rx_batch), NULL);
+  chPoolLoadArray(&rx_batch_pool, rx_batches, LWIP_RX_BATCHES);
+
   /* Initializes the thing.*/
   tcpip_init(NULL, NULL);
 
@@ -233,6 +595,8 @@ msg_t lwip_thread(void *p) {
     ip.addr = opts->address;
     gateway.addr = opts->gateway;
     netmask.addr = opts->netmask;
+    if (opts->macconfig != NULL)
+      mac_config = *opts->macconfig;
   }
   else {
     thisif.hwaddr[0] = LWIP_ETHADDR_0;
@@ -245,7 +609,12 @@ msg_t lwip_thread(void *p) {
     LWIP_GATEWAY(&gateway);
     LWIP_NETMASK(&netmask);
   }
+#if LWIP_USE_MAC_QUEUE
+  (void)mac_config;
+#else
+  mac_config.mac_address = thisif.hwaddr;
   macStart(&ETHD1, &mac_config);
+#endif
   netif_add(&thisif, &ip, &netmask, &gateway, NULL, ethernetif_init, tcpip_input);
 
   netif_set_default(&thisif);
@@ -255,8 +624,13 @@ msg_t lwip_thread(void *p) {
   evtInit(&evt, LWIP_LINK_POLL_INTERVAL);
   evtStart(&evt);
   chEvtRegisterMask(&evt.et_es, &el0, PERIODIC_TIMER_ID);
+#if LWIP_USE_MAC_QUEUE
+  chEvtRegisterMask(macqGetEventSource(rx_queue), &el1, FRAME_RECEIVED_ID);
+#else
   chEvtRegisterMask(macGetReceiveEventSource(&ETHD1), &el1, FRAME_RECEIVED_ID);
-  chEvtAddEvents(PERIODIC_TIMER_ID | FRAME_RECEIVED_ID);
+#endif
+  chEvtRegisterMask(macGetLinkEventSource(&ETHD1), &el2, LINK_CHANGED_ID);
+  chEvtAddEvents(PERIODIC_TIMER_ID | FRAME_RECEIVED_ID | LINK_CHANGED_ID);
 
   /* Goes to the final priority after initialization.*/
   chThdSetPriority(LWIP_THREAD_PRIORITY);
@@ -264,6 +638,17 @@ msg_t lwip_thread(void *p) {
   while (TRUE) {
     eventmask_t mask = chEvtWaitAny(ALL_EVENTS);
     if (mask & PERIODIC_TIMER_ID) {
+#if LWIP_USE_ZERO_COPY_TX
+      /* Chains transmitted while idle are otherwise released only by the
+         next transmission.*/
+      tcpip_callback_with_block(tx_reclaim, NULL, 0);
+#endif
+      /* The PHY registers are read periodically only if the PHY does not
+         signal the link changes.*/
+      if (!macIsLinkInterruptEnabled(&ETHD1))
+        mask |= LINK_CHANGED_ID;
+    }
+    if (mask & LINK_CHANGED_ID) {
       bool_t current_link_status = macPollLinkStatus(&ETHD1);
       if (current_link_status != netif_is_link_up(&thisif)) {
         if (current_link_status)
@@ -275,9 +660,27 @@ msg_t lwip_thread(void *p) {
       }
     }
     if (mask & FRAME_RECEIVED_ID) {
+      struct rx_batch *bp;
       struct pbuf *p;
-      while ((p = low_level_input(&thisif)) != NULL) {
+      unsigned n = 0, csum;
+
+      bp = chPoolAlloc(&rx_batch_pool);
+      if (bp != NULL) {
+        bp->netif = &thisif;
+        bp->n     = 0;
+      }
+      while ((n < LWIP_RX_BATCH_SIZE) &&
+             ((p = low_level_input(&thisif, &csum)) != NULL)) {
         struct eth_hdr *ethhdr = p->payload;
+        n++;
+#if RX_CHECKSUM_FALLBACK
+        if (!rx_checksum_verify(p, csum)) {
+          LINK_STATS_INC(link.chkerr);
+          LINK_STATS_INC(link.drop);
+          pbuf_free(p);
+          continue;
+        }
+#endif
         switch (htons(ethhdr->type)) {
         /* IP or ARP packet? */
         case ETHTYPE_IP:
@@ -287,7 +690,12 @@ msg_t lwip_thread(void *p) {
         case ETHTYPE_PPPOEDISC:
         case ETHTYPE_PPPOE:
 #endif /* PPPOE_SUPPORT */
-          /* full packet send to tcpip_thread to process */
+          /* full packet added to the batch for tcpip_thread */
+          if (bp != NULL) {
+            bp->frames[bp->n++] = p;
+            break;
+          }
+          /* no batches available, the packet is sent alone */
           if (thisif.input(p, &thisif) == ERR_OK)
             break;
           LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
@@ -295,6 +703,32 @@ msg_t lwip_thread(void *p) {
           pbuf_free(p);
         }
       }
+
+      /* The whole batch is posted using a single message.*/
+      if (bp != NULL) {
+        if (bp->n == 0)
+          chPoolFree(&rx_batch_pool, bp);
+        else if (tcpip_callback_with_block(rx_batch_input, bp, 0) != ERR_OK) {
+          LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: batch post error\n"));
+          while (bp->n > 0) {
+            pbuf_free(bp->frames[--bp->n]);
+            LINK_STATS_INC(link.drop);
+          }
+          chPoolFree(&rx_batch_pool, bp);
+        }
+        else
+          lwip_rxstats.batches++;
+      }
+
+      lwip_rxstats.wakeups++;
+      lwip_rxstats.frames += n;
+      if (n > lwip_rxstats.max_frames)
+        lwip_rxstats.max_frames = n;
+
+      /* More frames could be pending, they are handled on the next
+         iteration so that other events are not delayed.*/
+      if (n == LWIP_RX_BATCH_SIZE)
+        chEvtAddEvents(FRAME_RECEIVED_ID);
     }
   }
   return 0;
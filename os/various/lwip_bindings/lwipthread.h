@@ -36,7 +36,11 @@
 #define LWIP_THREAD_STACK_SIZE              512
 #endif
 
-/** @brief Link poll interval. */
+/**
+ * @brief Link poll interval.
+ * @note  The link status is not polled if the MAC driver is configured to
+ *        use the PHY interrupt.
+ */
 #if !defined(LWIP_LINK_POLL_INTERVAL) || defined(__DOXYGEN__)
 #define LWIP_LINK_POLL_INTERVAL             S2ST(5)
 #endif
@@ -61,6 +65,82 @@
 #define LWIP_SEND_TIMEOUT                   50
 #endif
 
+/**
+ * @brief Zero-copy receive path.
+ * @details Received frames are passed to lwIP directly into the MAC
+ *          buffers, the buffers are returned to the MAC driver when lwIP
+ *          frees the pbufs. Frames are copied as usual when the MAC driver
+ *          runs out of spare buffers.
+ * @note  Requires @p MAC_USE_ZERO_COPY and @p LWIP_SUPPORT_CUSTOM_PBUF,
+ *        @p ETH_PAD_SIZE must be zero.
+ */
+#if !defined(LWIP_USE_ZERO_COPY_RX) || defined(__DOXYGEN__)
+#define LWIP_USE_ZERO_COPY_RX               FALSE
+#endif
+
+/**
+ * @brief Zero-copy transmit path.
+ * @details The pbuf chains are transmitted in place by the MAC driver, the
+ *          pbufs are referenced until the transmission is complete. For
+ *          chains already referenced elsewhere or carrying TCP segments,
+ *          whose headers lwIP rewrites in place when retransmitting, only
+ *          the first pbuf is copied and the following @p PBUF_ROM or
+ *          @p PBUF_REF pbufs are transmitted in place. Other chains are
+ *          copied as usual.
+ * @note  Requires @p MAC_USE_ZERO_COPY, @p ETH_PAD_SIZE must be zero.
+ * @note  The application must not modify the data of sent pbufs while
+ *        they are still referenced.
+ * @note  The pbufs are freed by the thread reclaiming the transmit
+ *        descriptors, any thread transmitting on the MAC driver. The driver
+ *        must not be shared with other threads, for example an UDP/IP
+ *        stack, because pbuf_free() is not thread safe.
+ */
+#if !defined(LWIP_USE_ZERO_COPY_TX) || defined(__DOXYGEN__)
+#define LWIP_USE_ZERO_COPY_TX               FALSE
+#endif
+
+/**
+ * @brief Reception from a MAC classifier queue.
+ * @details The frames are received from the @p MACQueue specified in the
+ *          thread options instead of the MAC driver, this way the frames
+ *          of other queues are served by higher priority threads and do
+ *          not wait behind the lwIP traffic.
+ * @note  The MAC driver and the classifier must be started by the
+ *        application before the lwIP thread, the @p macconfig option is
+ *        ignored.
+ * @note  The thread options are mandatory, without a valid queue the
+ *        lwIP thread terminates immediately.
+ * @note  With @p LWIP_USE_ZERO_COPY_RX the frames count toward the queue
+ *        limit until lwIP frees their pbufs.
+ */
+#if !defined(LWIP_USE_MAC_QUEUE) || defined(__DOXYGEN__)
+#define LWIP_USE_MAC_QUEUE                  FALSE
+#endif
+
+/** @brief Maximum number of pbufs in a zero-copy transmitted chain. */
+#if !defined(LWIP_TX_MAX_SEGMENTS) || defined(__DOXYGEN__)
+#define LWIP_TX_MAX_SEGMENTS                4
+#endif
+
+/**
+ * @brief Maximum number of frames handled on a receive event.
+ * @details The received frames are passed to the tcpip thread in batches
+ *          of up to this number of frames using a single message, the
+ *          remaining frames are handled on the next loop iteration.
+ */
+#if !defined(LWIP_RX_BATCH_SIZE) || defined(__DOXYGEN__)
+#define LWIP_RX_BATCH_SIZE                  8
+#endif
+
+/**
+ * @brief Number of receive batches.
+ * @details Batches still queued in the tcpip thread are not available, if
+ *          all the batches are busy then frames are posted one by one.
+ */
+#if !defined(LWIP_RX_BATCHES) || defined(__DOXYGEN__)
+#define LWIP_RX_BATCHES                     2
+#endif
+
 /** @brief Link speed. */
 #if !defined(LWIP_LINK_SPEED) || defined(__DOXYGEN__)
 #define LWIP_LINK_SPEED                     100000000
@@ -106,6 +186,10 @@
 #define LWIP_IFNAME1                        's'
 #endif
 
+#if LWIP_USE_MAC_QUEUE
+#include "macqueues.h"
+#endif
+
 /**
  * @brief Runtime TCP/IP settings.
  */
@@ -114,9 +198,33 @@ struct lwipthread_opts {
   uint32_t      address;
   uint32_t      netmask;
   uint32_t      gateway;
+  /**
+   * @brief Board specific MAC driver configuration or @p NULL.
+   * @note  The MAC address is taken from @p macaddress.
+   */
+  const MACConfig *macconfig;
+#if LWIP_USE_MAC_QUEUE || defined(__DOXYGEN__)
+  /**
+   * @brief Queue the frames are received from.
+   */
+  MACQueue      *macqueue;
+#endif
+};
+
+/**
+ * @brief Receive path statistics.
+ * @details The average number of frames per wakeup is
+ *          <tt>frames / wakeups</tt>.
+ */
+struct lwipthread_rxstats {
+  uint32_t      wakeups;        /**< @brief Receive events handled.         */
+  uint32_t      frames;         /**< @brief Frames read from the MAC.       */
+  uint32_t      batches;        /**< @brief Batches posted to tcpip.        */
+  uint32_t      max_frames;     /**< @brief Maximum frames in a wakeup.     */
 };
 
 extern WORKING_AREA(wa_lwip_thread, LWIP_THREAD_STACK_SIZE);
+extern struct lwipthread_rxstats lwip_rxstats;
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,357 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    macqueues.c
+ * @brief   MAC receive queues code.
+ *
+ * @addtogroup mac_queues
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "macqueues.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define ETH_HEADER_SIZE         14
+#define ETH_TYPE_IP             0x0800
+#define ETH_TYPE_VLAN           0x8100
+#define VLAN_TAG_SIZE           4
+
+#define IP_HEADER_SIZE          20
+#define IP_PROTO_UDP            17
+
+/**
+ * @brief   Frame information stored in the buffer headroom.
+ * @details The frame size is in the lower half word, the checksum status
+ *          in the upper one.
+ */
+#define FRAME_INFO(buf)         (((uint32_t *)(buf))[-1])
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint16_t get16(const uint8_t *p) {
+
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/**
+ * @brief   Returns the first queue matching a frame.
+ *
+ * @param[in] clp       pointer to the @p MACClassifier object
+ * @param[in] f         pointer to the frame
+ * @param[in] n         frame size
+ * @return              The matching queue.
+ * @retval NULL         if no queue matched.
+ */
+static MACQueue *classify(MACClassifier *clp, const uint8_t *f, size_t n) {
+  MACQueue *qp;
+  size_t l3 = ETH_HEADER_SIZE, ihl;
+  uint16_t type, port = 0;
+  unsigned prio = 0;
+  bool_t tagged = FALSE, udp = FALSE;
+
+  if (n < ETH_HEADER_SIZE)
+    return NULL;
+
+  /* Priority and encapsulated EtherType of the tagged frames.*/
+  type = get16(&f[12]);
+  if ((type == ETH_TYPE_VLAN) && (n >= ETH_HEADER_SIZE + VLAN_TAG_SIZE)) {
+    tagged = TRUE;
+    prio   = f[14] >> 5;
+    type   = get16(&f[16]);
+    l3    += VLAN_TAG_SIZE;
+  }
+
+  /* Destination port of the UDP datagrams, the fragments following the
+     first one do not carry the UDP header. A header length below the
+     minimum is malformed, the port would be read from the IP header.*/
+  if ((type == ETH_TYPE_IP) && (n >= l3 + IP_HEADER_SIZE) &&
+      (f[l3 + 9] == IP_PROTO_UDP) && ((get16(&f[l3 + 6]) & 0x1FFF) == 0)) {
+    ihl = (size_t)(f[l3] & 0x0F) * 4;
+    if ((ihl >= IP_HEADER_SIZE) && (n >= l3 + ihl + 4)) {
+      udp  = TRUE;
+      port = get16(&f[l3 + ihl + 2]);
+    }
+  }
+
+  for (qp = clp->queues; qp != NULL; qp = qp->next) {
+    switch (qp->match) {
+    case MACQ_MATCH_ANY:
+      return qp;
+    case MACQ_MATCH_ETHERTYPE:
+      if (type == qp->value)
+        return qp;
+      break;
+    case MACQ_MATCH_VLAN_PRIO:
+      if (tagged && (prio >= qp->value))
+        return qp;
+      break;
+    case MACQ_MATCH_UDP_PORT:
+      if (udp && (port == qp->value))
+        return qp;
+      break;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Classifier thread.
+ * @details The frame buffers are loaned from the MAC driver so the receive
+ *          descriptors are released immediately, the frames are then
+ *          processed in place by the queue consumers.
+ */
+static msg_t classifier_thread(void *arg) {
+  MACClassifier *clp = arg;
+  MACReceiveDescriptor rd;
+  MACQueue *qp;
+  uint8_t *buf;
+  size_t n;
+  unsigned csum;
+
+  chRegSetThreadName("macclassifier");
+  while (TRUE) {
+    if (macWaitReceiveDescriptor(clp->macp, &rd, TIME_INFINITE) != RDY_OK)
+      continue;
+    csum = macGetReceiveChecksumStatus(&rd);
+    buf = macLoanReceiveBuffer(&rd, &n);
+    macReleaseReceiveDescriptor(&rd);
+    if (buf == NULL) {
+      clp->nobufs++;
+      continue;
+    }
+
+    qp = classify(clp, buf, n);
+    if (qp == NULL) {
+      clp->unmatched++;
+      macReturnReceiveBuffer(clp->macp, buf);
+      continue;
+    }
+    FRAME_INFO(buf) = (uint32_t)n | ((uint32_t)csum << 16);
+
+    /* The frame is discarded if the queue already holds its share of the
+       spare buffers, the other queues are not starved.*/
+    chSysLock();
+    if ((qp->loaned < qp->limit) &&
+        (chMBPostI(&qp->mb, (msg_t)buf) == RDY_OK)) {
+      qp->loaned++;
+      qp->frames++;
+      chEvtBroadcastI(&qp->event);
+      chSchRescheduleS();
+      buf = NULL;
+    }
+    else
+      qp->drops++;
+    chSysUnlock();
+
+    /* Queue full or over its limit, the frame is discarded.*/
+    if (buf != NULL)
+      macReturnReceiveBuffer(clp->macp, buf);
+  }
+  return 0;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   MAC classifier object initialization.
+ *
+ * @param[out] clp      pointer to the @p MACClassifier object to be
+ *                      initialized
+ *
+ * @init
+ */
+void macclsObjectInit(MACClassifier *clp) {
+
+  chDbgCheck(clp != NULL, "macclsObjectInit");
+
+  clp->macp      = NULL;
+  clp->queues    = NULL;
+  clp->tp        = NULL;
+  clp->nobufs    = 0;
+  clp->unmatched = 0;
+}
+
+/**
+ * @brief   Adds a queue to a classifier.
+ * @details The queues are matched in the order they are added, each frame
+ *          is assigned to the first matching queue. The frames not matched
+ *          by any queue are discarded, a @p MACQ_MATCH_ANY queue added last
+ *          receives all of them.
+ *
+ * @param[in] clp       pointer to the @p MACClassifier object
+ * @param[in] qp        pointer to the @p MACQueue object
+ *
+ * @init
+ */
+void macclsAddQueue(MACClassifier *clp, MACQueue *qp) {
+  MACQueue **qpp;
+
+  chDbgCheck((clp != NULL) && (qp != NULL), "macclsAddQueue");
+  chDbgAssert((clp->tp == NULL) && (qp->clp == NULL),
+              "macclsAddQueue(), #1", "invalid state");
+
+  qp->clp = clp;
+  for (qpp = &clp->queues; *qpp != NULL; qpp = &(*qpp)->next)
+    ;
+  *qpp = qp;
+}
+
+/**
+ * @brief   Starts a classifier.
+ * @details The classifier thread takes over the reception from the MAC
+ *          driver, the frames must be received from the queues from now
+ *          on.
+ * @note    The classifier thread priority should not be lower than the
+ *          priority of the threads serving the queues.
+ * @note    The frames are discarded if the MAC driver runs out of spare
+ *          buffers. Each queue holds at most @p limit spare buffers, if
+ *          the spare buffers are at least the sum of the limits of all
+ *          the queues then a queue can never be starved by the others.
+ *          With fewer spare buffers the limits of the bulk traffic queues
+ *          must leave enough buffers for the limits of the critical ones.
+ *
+ * @param[in] clp       pointer to the @p MACClassifier object
+ * @param[in] macp      pointer to the @p MACDriver object, the driver must
+ *                      be already started
+ * @param[in] prio      classifier thread priority
+ *
+ * @api
+ */
+void macclsStart(MACClassifier *clp, MACDriver *macp, tprio_t prio) {
+
+  chDbgCheck((clp != NULL) && (macp != NULL), "macclsStart");
+  chDbgAssert((clp->tp == NULL) && (macp->state == MAC_ACTIVE),
+              "macclsStart(), #1", "invalid state");
+
+  clp->macp = macp;
+  clp->tp = chThdCreateStatic(clp->wa, sizeof(clp->wa), prio,
+                              classifier_thread, clp);
+}
+
+/**
+ * @brief   MAC queue object initialization.
+ *
+ * @param[out] qp       pointer to the @p MACQueue object to be initialized
+ * @param[in] match     classification rule, see @p MACQ_MATCH_ANY,
+ *                      @p MACQ_MATCH_ETHERTYPE, @p MACQ_MATCH_VLAN_PRIO and
+ *                      @p MACQ_MATCH_UDP_PORT
+ * @param[in] value     classification rule value
+ * @param[in] buf       mailbox buffer, one entry for each queued frame
+ * @param[in] n         number of frames that can be queued
+ * @param[in] limit     maximum number of buffers loaned to the queue, it
+ *                      includes the queued frames and the frames not yet
+ *                      released by the consumers
+ *
+ * @init
+ */
+void macqObjectInit(MACQueue *qp, uint8_t match, uint16_t value,
+                    msg_t *buf, cnt_t n, cnt_t limit) {
+
+  chDbgCheck((qp != NULL) && (match <= MACQ_MATCH_UDP_PORT) &&
+             (buf != NULL) && (n > 0) && (limit > 0), "macqObjectInit");
+
+  qp->next   = NULL;
+  qp->clp    = NULL;
+  qp->match  = match;
+  qp->value  = value;
+  qp->limit  = limit;
+  qp->loaned = 0;
+  qp->frames = 0;
+  qp->drops  = 0;
+  chMBInit(&qp->mb, buf, n);
+  chEvtInit(&qp->event);
+}
+
+/**
+ * @brief   Waits for a frame on a queue.
+ * @details The frame is processed in place, it must be given back using
+ *          @p macqReleaseFrame() once consumed.
+ * @note    The buffer is preceded by @p MAC_RECEIVE_HEADROOM bytes that
+ *          the caller can use freely until the frame is released.
+ *
+ * @param[in] qp        pointer to the @p MACQueue object
+ * @param[out] fp       pointer to a @p MACQueueFrame structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       the frame has been obtained.
+ * @retval RDY_TIMEOUT  frame not available.
+ *
+ * @api
+ */
+msg_t macqGetFrame(MACQueue *qp, MACQueueFrame *fp, systime_t time) {
+  msg_t msg, buf;
+
+  chDbgCheck((qp != NULL) && (fp != NULL), "macqGetFrame");
+
+  msg = chMBFetch(&qp->mb, &buf, time);
+  if (msg != RDY_OK)
+    return msg;
+  fp->buf  = (uint8_t *)buf;
+  fp->size = (size_t)(FRAME_INFO(fp->buf) & 0xFFFF);
+  fp->csum = (unsigned)(FRAME_INFO(fp->buf) >> 16);
+  return RDY_OK;
+}
+
+/**
+ * @brief   Releases a frame obtained using @p macqGetFrame().
+ * @details The buffer is given back to the MAC driver and no more counts
+ *          toward the queue limit.
+ * @note    Only the @p buf field of the frame structure is used.
+ *
+ * @param[in] qp        pointer to the @p MACQueue object
+ * @param[in] fp        pointer to the @p MACQueueFrame structure
+ *
+ * @api
+ */
+void macqReleaseFrame(MACQueue *qp, MACQueueFrame *fp) {
+
+  chDbgCheck((qp != NULL) && (qp->clp != NULL) && (fp != NULL),
+             "macqReleaseFrame");
+  chDbgAssert(qp->loaned > 0, "macqReleaseFrame(), #1", "not loaned");
+
+  macReturnReceiveBuffer(qp->clp->macp, fp->buf);
+  chSysLock();
+  qp->loaned--;
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_MAC */
+
+/** @} */
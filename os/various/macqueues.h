@@ -0,0 +1,235 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    macqueues.h
+ * @brief   MAC receive queues structures and macros.
+ *
+ * @addtogroup mac_queues
+ * @{
+ */
+
+#ifndef _MACQUEUES_H_
+#define _MACQUEUES_H_
+
+#include "hal.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Classification rules
+ * @{
+ */
+/**
+ * @brief   Matches all the frames.
+ */
+#define MACQ_MATCH_ANY              0
+/**
+ * @brief   Matches the frames with the specified EtherType.
+ * @note    The EtherType following the VLAN tag is compared for the
+ *          tagged frames.
+ */
+#define MACQ_MATCH_ETHERTYPE        1
+/**
+ * @brief   Matches the VLAN tagged frames with a priority equal or greater
+ *          than the specified value.
+ */
+#define MACQ_MATCH_VLAN_PRIO        2
+/**
+ * @brief   Matches the UDP/IPv4 datagrams sent to the specified port.
+ */
+#define MACQ_MATCH_UDP_PORT         3
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Classifier thread stack size.
+ */
+#if !defined(MACQ_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define MACQ_THREAD_STACK_SIZE      256
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !MAC_USE_ZERO_COPY
+#error "MAC queues require MAC_USE_ZERO_COPY"
+#endif
+
+#if MAC_RECEIVE_HEADROOM < 4
+#error "MAC queues require MAC_RECEIVE_HEADROOM of at least 4 bytes"
+#endif
+
+#if !CH_USE_MAILBOXES || !CH_USE_EVENTS
+#error "MAC queues require CH_USE_MAILBOXES and CH_USE_EVENTS"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a MAC classifier.
+ */
+typedef struct MACClassifier MACClassifier;
+
+/**
+ * @brief   Type of a frame received from a queue.
+ */
+typedef struct {
+  uint8_t               *buf;       /**< @brief Frame buffer.               */
+  size_t                size;       /**< @brief Frame size.                 */
+  unsigned              csum;       /**< @brief Checksums verified by the
+                                                hardware.                   */
+} MACQueueFrame;
+
+/**
+ * @brief   Type of a MAC receive queue.
+ */
+typedef struct MACQueue MACQueue;
+
+/**
+ * @brief   Structure representing a MAC receive queue.
+ */
+struct MACQueue {
+  /**
+   * @brief Next queue in classification order.
+   */
+  MACQueue              *next;
+  /**
+   * @brief Classifier the queue belongs to or @p NULL.
+   */
+  MACClassifier         *clp;
+  /**
+   * @brief Classification rule.
+   */
+  uint8_t               match;
+  /**
+   * @brief Classification rule value.
+   */
+  uint16_t              value;
+  /**
+   * @brief Queued frames.
+   */
+  Mailbox               mb;
+  /**
+   * @brief Frame queued event.
+   */
+  EventSource           event;
+  /**
+   * @brief Maximum number of buffers loaned to the queue.
+   */
+  cnt_t                 limit;
+  /**
+   * @brief Buffers loaned to the queue, queued or not yet released by
+   *        the consumers.
+   */
+  cnt_t                 loaned;
+  /**
+   * @brief Queued frames counter.
+   */
+  uint32_t              frames;
+  /**
+   * @brief Frames discarded because the queue was full or over its limit.
+   */
+  uint32_t              drops;
+};
+
+/**
+ * @brief   Structure representing a MAC classifier.
+ */
+struct MACClassifier {
+  /**
+   * @brief MAC driver.
+   */
+  MACDriver             *macp;
+  /**
+   * @brief Queues in classification order.
+   */
+  MACQueue              *queues;
+  /**
+   * @brief Classifier thread.
+   */
+  Thread                *tp;
+  /**
+   * @brief Classifier thread working area.
+   */
+  WORKING_AREA(wa, MACQ_THREAD_STACK_SIZE);
+  /**
+   * @brief Frames discarded because no spare buffers were available.
+   */
+  uint32_t              nobufs;
+  /**
+   * @brief Frames discarded because no queue matched.
+   */
+  uint32_t              unmatched;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the frame queued event source.
+ *
+ * @param[in] qp        pointer to the @p MACQueue object
+ * @return              The pointer to the @p EventSource structure.
+ *
+ * @api
+ */
+#define macqGetEventSource(qp) (&(qp)->event)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void macclsObjectInit(MACClassifier *clp);
+  void macclsAddQueue(MACClassifier *clp, MACQueue *qp);
+  void macclsStart(MACClassifier *clp, MACDriver *macp, tprio_t prio);
+  void macqObjectInit(MACQueue *qp, uint8_t match, uint16_t value,
+                      msg_t *buf, cnt_t n, cnt_t limit);
+  msg_t macqGetFrame(MACQueue *qp, MACQueueFrame *fp, systime_t time);
+  void macqReleaseFrame(MACQueue *qp, MACQueueFrame *fp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_MAC */
+
+#endif /* _MACQUEUES_H_ */
+
+/** @} */
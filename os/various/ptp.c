@@ -0,0 +1,446 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ptp.c
+ * @brief   PTP slave code.
+ *
+ * @addtogroup ptp
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "ptp.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define PTP_VERSION             2
+#define PTP_FLAG0_TWO_STEP      0x02
+#define PTP_CONTROL_DELAY_REQ   1
+#define PTP_LOG_INTERVAL_NONE   0x7F
+
+#define NS_PER_SECOND           1000000000
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint16_t get16(const uint8_t *p) {
+
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+/**
+ * @brief   Decodes a correction field.
+ *
+ * @param[in] p         pointer to the field
+ * @return              The correction in nanoseconds.
+ */
+static ptptime_t get_correction(const uint8_t *p) {
+  uint64_t v = 0;
+  unsigned i;
+
+  for (i = 0; i < 8; i++)
+    v = (v << 8) | p[i];
+
+  /* The field is in units of 2^-16 nanoseconds.*/
+  return (ptptime_t)v / 65536;
+}
+
+/**
+ * @brief   Decodes a timestamp field.
+ *
+ * @param[in] p         pointer to the field
+ * @return              The time in nanoseconds.
+ */
+static ptptime_t get_timestamp(const uint8_t *p) {
+  uint64_t sec = 0;
+  uint32_t ns = 0;
+  unsigned i;
+
+  for (i = 0; i < 6; i++)
+    sec = (sec << 8) | p[i];
+  for (i = 6; i < 10; i++)
+    ns = (ns << 8) | p[i];
+  return (ptptime_t)sec * NS_PER_SECOND + (ptptime_t)ns;
+}
+
+/**
+ * @brief   Limits a frequency adjustment to the configured range.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] ppb       frequency adjustment
+ * @return              The limited frequency adjustment.
+ */
+static int32_t clamp_ppb(PTPServo *sp, int64_t ppb) {
+
+  if (ppb > sp->config->max_ppb)
+    return sp->config->max_ppb;
+  if (ppb < -sp->config->max_ppb)
+    return -sp->config->max_ppb;
+  return (int32_t)ppb;
+}
+
+/**
+ * @brief   Sets the local clock rate.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] ppb       frequency adjustment
+ */
+static void servo_adjfreq(PTPServo *sp, int64_t ppb) {
+
+  sp->ppb = clamp_ppb(sp, ppb);
+  sp->config->adjfreq(sp->config->arg, sp->ppb);
+}
+
+/**
+ * @brief   Removes an offset by stepping the local clock.
+ * @details The last Sync timestamps are no more consistent with the local
+ *          clock and are invalidated.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] offset    offset from the master
+ */
+static void servo_step(PTPServo *sp, ptptime_t offset) {
+
+  sp->config->adjtime(sp->config->arg, -offset);
+  sp->steps++;
+  sp->syncvalid = FALSE;
+}
+
+/**
+ * @brief   Feeds an offset measurement to the servo.
+ * @details The first two measurements estimate the local clock drift, the
+ *          clock is then stepped and tracked by a PI controller.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] offset    offset from the master
+ * @param[in] local     local time of the measurement
+ */
+static void servo_sample(PTPServo *sp, ptptime_t offset, ptptime_t local) {
+  const PTPServoConfig *config = sp->config;
+  ptptime_t abs_offset = offset < 0 ? -offset : offset;
+  ptptime_t diff;
+
+  sp->offset = offset;
+  switch (sp->state) {
+  case PTP_UNLOCKED:
+    sp->offset0 = offset;
+    sp->local0  = local;
+    sp->state   = PTP_LOCKING;
+    break;
+  case PTP_LOCKING:
+    if (local <= sp->local0) {
+      sp->offset0 = offset;
+      sp->local0  = local;
+      break;
+    }
+
+    /* Drift of the local clock at the current rate, the difference is
+       limited in order to avoid overflows, the result is clamped anyway.*/
+    diff = offset - sp->offset0;
+    if (diff > NS_PER_SECOND)
+      diff = NS_PER_SECOND;
+    else if (diff < -NS_PER_SECOND)
+      diff = -NS_PER_SECOND;
+    servo_adjfreq(sp, sp->ppb - diff * NS_PER_SECOND / (local - sp->local0));
+    sp->integral = (int64_t)sp->ppb * 65536;
+    if ((config->step_threshold == 0) || (abs_offset > config->step_threshold))
+      servo_step(sp, offset);
+    sp->state = PTP_LOCKED;
+
+    /* The path delay measured so far is biased by the drift, it is
+       measured again at the corrected rate.*/
+    sp->delayvalid = FALSE;
+    break;
+  case PTP_LOCKED:
+    if ((config->step_threshold > 0) &&
+        (abs_offset > config->step_threshold)) {
+      sp->state = PTP_UNLOCKED;
+      break;
+    }
+
+    /* PI controller, the integral term is limited to the adjustment range
+       in order to avoid wind-up.*/
+    sp->integral -= (int64_t)config->ki * offset;
+    if (sp->integral > (int64_t)config->max_ppb * 65536)
+      sp->integral = (int64_t)config->max_ppb * 65536;
+    else if (sp->integral < -(int64_t)config->max_ppb * 65536)
+      sp->integral = -(int64_t)config->max_ppb * 65536;
+    servo_adjfreq(sp, (sp->integral - (int64_t)config->kp * offset) / 65536);
+    break;
+  }
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   PTP servo object initialization.
+ * @note    The clock rate is not changed until the first drift estimation.
+ *
+ * @param[out] sp       pointer to the @p PTPServo object to be initialized
+ * @param[in] config    pointer to the @p PTPServoConfig object
+ *
+ * @init
+ */
+void ptpsrvObjectInit(PTPServo *sp, const PTPServoConfig *config) {
+
+  chDbgCheck((sp != NULL) && (config != NULL) &&
+             (config->adjtime != NULL) && (config->adjfreq != NULL) &&
+             (config->max_ppb > 0), "ptpsrvObjectInit");
+
+  sp->config     = config;
+  sp->state      = PTP_UNLOCKED;
+  sp->t1         = 0;
+  sp->t2         = 0;
+  sp->delay      = 0;
+  sp->offset     = 0;
+  sp->local0     = 0;
+  sp->offset0    = 0;
+  sp->integral   = 0;
+  sp->ppb        = 0;
+  sp->steps      = 0;
+  sp->syncvalid  = FALSE;
+  sp->delayvalid = FALSE;
+}
+
+/**
+ * @brief   Feeds a Sync measurement to the servo.
+ * @details Once the path delay is known each Sync produces an offset
+ *          measurement and a clock correction.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] t1        master transmit time, corrected
+ * @param[in] t2        local receive time
+ *
+ * @api
+ */
+void ptpsrvSync(PTPServo *sp, ptptime_t t1, ptptime_t t2) {
+
+  chDbgCheck(sp != NULL, "ptpsrvSync");
+
+  sp->t1        = t1;
+  sp->t2        = t2;
+  sp->syncvalid = TRUE;
+  if (sp->delayvalid)
+    servo_sample(sp, (t2 - t1) - sp->delay, t2);
+}
+
+/**
+ * @brief   Feeds a Delay_Req measurement to the servo.
+ * @details The mean path delay is computed using the last Sync timestamps
+ *          and filtered, the first measurement after the drift estimation
+ *          restarts the filter.
+ * @note    The local timestamps must not be separated by a clock step,
+ *          @p t3 must be taken after the last Sync reception.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @param[in] t3        local transmit time
+ * @param[in] t4        master receive time, corrected
+ *
+ * @api
+ */
+void ptpsrvDelay(PTPServo *sp, ptptime_t t3, ptptime_t t4) {
+  ptptime_t delay;
+
+  chDbgCheck(sp != NULL, "ptpsrvDelay");
+
+  if (!sp->syncvalid)
+    return;
+
+  /* Before the drift correction the measurement can even be negative, it
+     is only used for the first offsets.*/
+  delay = ((sp->t2 - sp->t1) + (t4 - t3)) / 2;
+  if (!sp->delayvalid) {
+    sp->delay      = delay;
+    sp->delayvalid = TRUE;
+  }
+  else
+    sp->delay += (delay - sp->delay) / (1 << PTP_DELAY_FILTER_SHIFT);
+}
+
+/**
+ * @brief   PTP slave object initialization.
+ *
+ * @param[out] slp      pointer to the @p PTPSlave object to be initialized
+ * @param[in] config    pointer to the @p PTPServoConfig object
+ * @param[in] clockid   pointer to the eight bytes local clock identity,
+ *                      normally derived from the MAC address
+ * @param[in] domain    PTP domain
+ *
+ * @init
+ */
+void ptpslvObjectInit(PTPSlave *slp, const PTPServoConfig *config,
+                      const uint8_t *clockid, uint8_t domain) {
+
+  chDbgCheck((slp != NULL) && (clockid != NULL), "ptpslvObjectInit");
+
+  ptpsrvObjectInit(&slp->servo, config);
+  memcpy(slp->port, clockid, 8);
+  put16(&slp->port[8], 1);
+  slp->hasmaster    = FALSE;
+  slp->domain       = domain;
+  slp->syncpending  = FALSE;
+  slp->delaypending = FALSE;
+  slp->delayseq     = 0;
+}
+
+/**
+ * @brief   Processes a received PTP message.
+ * @details Sync, Follow_Up and Delay_Resp messages from the master are
+ *          fed to the servo, the other messages are ignored.
+ *
+ * @param[in] slp       pointer to the @p PTPSlave object
+ * @param[in] msg       pointer to the PTP message, without the transport
+ *                      headers
+ * @param[in] n         message size
+ * @param[in] rxtime    local receive time, only meaningful for the event
+ *                      messages
+ *
+ * @api
+ */
+void ptpslvInput(PTPSlave *slp, const uint8_t *msg, size_t n,
+                 ptptime_t rxtime) {
+  ptptime_t corr;
+  uint16_t seq;
+  size_t len;
+
+  chDbgCheck((slp != NULL) && (msg != NULL), "ptpslvInput");
+
+  if ((n < PTP_HEADER_SIZE) || ((msg[1] & 0x0F) != PTP_VERSION) ||
+      (msg[4] != slp->domain))
+    return;
+  len = get16(&msg[2]);
+  if ((len < PTP_HEADER_SIZE) || (len > n))
+    return;
+  seq  = get16(&msg[30]);
+  corr = get_correction(&msg[8]);
+
+  /* The first Sync sender becomes the master, the other senders are
+     ignored.*/
+  if (!slp->hasmaster) {
+    if ((msg[0] & 0x0F) != PTP_MSG_SYNC)
+      return;
+    memcpy(slp->master, &msg[20], 10);
+    slp->hasmaster = TRUE;
+  }
+  else if (memcmp(slp->master, &msg[20], 10) != 0)
+    return;
+
+  switch (msg[0] & 0x0F) {
+  case PTP_MSG_SYNC:
+    if (len < PTP_HEADER_SIZE + 10)
+      return;
+    if (msg[6] & PTP_FLAG0_TWO_STEP) {
+      slp->syncpending = TRUE;
+      slp->syncseq     = seq;
+      slp->synct2      = rxtime;
+      slp->synccorr    = corr;
+    }
+    else {
+      slp->syncpending = FALSE;
+      ptpsrvSync(&slp->servo, get_timestamp(&msg[34]) + corr, rxtime);
+    }
+    break;
+  case PTP_MSG_FOLLOW_UP:
+    if ((len < PTP_HEADER_SIZE + 10) || !slp->syncpending ||
+        (seq != slp->syncseq))
+      return;
+    slp->syncpending = FALSE;
+    ptpsrvSync(&slp->servo, get_timestamp(&msg[34]) + slp->synccorr + corr,
+               slp->synct2);
+    break;
+  case PTP_MSG_DELAY_RESP:
+    if ((len < PTP_DELAY_RESP_SIZE) || !slp->delaypending ||
+        (seq != slp->delayseq) || (memcmp(&msg[44], slp->port, 10) != 0))
+      return;
+    slp->delaypending = FALSE;
+
+    /* A clock step after the transmission invalidates the exchange.*/
+    if (slp->delaysteps == slp->servo.steps)
+      ptpsrvDelay(&slp->servo, slp->delayt3, get_timestamp(&msg[34]) - corr);
+    break;
+  }
+}
+
+/**
+ * @brief   Builds a Delay_Req message.
+ * @details A Delay_Req is normally sent after each Sync, the transmit
+ *          time must then be reported using @p ptpslvDelayReqSent().
+ *
+ * @param[in] slp       pointer to the @p PTPSlave object
+ * @param[out] buf      pointer to a buffer of @p PTP_DELAY_REQ_SIZE bytes
+ * @return              The message size.
+ *
+ * @api
+ */
+size_t ptpslvBuildDelayReq(PTPSlave *slp, uint8_t *buf) {
+
+  chDbgCheck((slp != NULL) && (buf != NULL), "ptpslvBuildDelayReq");
+
+  /* The origin timestamp is left zeroed, the transmit time is measured
+     by the MAC.*/
+  memset(buf, 0, PTP_DELAY_REQ_SIZE);
+  buf[0] = PTP_MSG_DELAY_REQ;
+  buf[1] = PTP_VERSION;
+  put16(&buf[2], PTP_DELAY_REQ_SIZE);
+  buf[4] = slp->domain;
+  memcpy(&buf[20], slp->port, 10);
+  put16(&buf[30], ++slp->delayseq);
+  buf[32] = PTP_CONTROL_DELAY_REQ;
+  buf[33] = PTP_LOG_INTERVAL_NONE;
+  slp->delaypending = FALSE;
+  return PTP_DELAY_REQ_SIZE;
+}
+
+/**
+ * @brief   Reports the transmit time of the last Delay_Req.
+ *
+ * @param[in] slp       pointer to the @p PTPSlave object
+ * @param[in] t3        local transmit time
+ *
+ * @api
+ */
+void ptpslvDelayReqSent(PTPSlave *slp, ptptime_t t3) {
+
+  chDbgCheck(slp != NULL, "ptpslvDelayReqSent");
+
+  slp->delayt3      = t3;
+  slp->delaysteps   = slp->servo.steps;
+  slp->delaypending = TRUE;
+}
+
+/** @} */
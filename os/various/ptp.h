@@ -0,0 +1,355 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ptp.h
+ * @brief   PTP slave structures and macros.
+ *
+ * @addtogroup ptp
+ * @{
+ */
+
+#ifndef _PTP_H_
+#define _PTP_H_
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    PTP transport
+ * @{
+ */
+/**
+ * @brief   EtherType of the PTP messages carried directly over Ethernet.
+ */
+#define PTP_ETHERTYPE               0x88F7
+/**
+ * @brief   UDP port of the event messages.
+ */
+#define PTP_EVENT_PORT              319
+/**
+ * @brief   UDP port of the general messages.
+ */
+#define PTP_GENERAL_PORT            320
+/** @} */
+
+/**
+ * @name    PTP message types
+ * @{
+ */
+#define PTP_MSG_SYNC                0x0
+#define PTP_MSG_DELAY_REQ           0x1
+#define PTP_MSG_FOLLOW_UP           0x8
+#define PTP_MSG_DELAY_RESP          0x9
+/** @} */
+
+/**
+ * @name    PTP message sizes
+ * @{
+ */
+#define PTP_HEADER_SIZE             34
+#define PTP_DELAY_REQ_SIZE          44
+#define PTP_DELAY_RESP_SIZE         54
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Path delay filter weight.
+ * @details Each path delay measurement moves the estimate by 2^-N of the
+ *          difference, zero disables the filter.
+ */
+#if !defined(PTP_DELAY_FILTER_SHIFT) || defined(__DOXYGEN__)
+#define PTP_DELAY_FILTER_SHIFT      3
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (PTP_DELAY_FILTER_SHIFT < 0) || (PTP_DELAY_FILTER_SHIFT > 16)
+#error "invalid PTP_DELAY_FILTER_SHIFT value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a PTP time, in nanoseconds.
+ */
+typedef int64_t ptptime_t;
+
+/**
+ * @brief   Servo possible states.
+ */
+typedef enum {
+  PTP_UNLOCKED = 0,                 /**< No offset measured yet.            */
+  PTP_LOCKING = 1,                  /**< Waiting for a second offset
+                                         in order to estimate the drift.    */
+  PTP_LOCKED = 2                    /**< Clock tracked by the PI loop.      */
+} ptpservostate_t;
+
+/**
+ * @brief   Servo configuration structure.
+ * @note    The gains are in units of 2^-16 ppb per nanosecond of offset,
+ *          the values 45875 and 19661 (0.7 and 0.3) are adequate for a
+ *          Sync interval of one second.
+ */
+typedef struct {
+  /**
+   * @brief Proportional gain.
+   */
+  int32_t               kp;
+  /**
+   * @brief Integral gain.
+   */
+  int32_t               ki;
+  /**
+   * @brief Maximum frequency adjustment in ppb.
+   */
+  int32_t               max_ppb;
+  /**
+   * @brief Offsets larger than this are corrected by stepping the clock.
+   * @details While locked a larger offset restarts the drift estimation,
+   *          zero makes the servo step the clock only once on lock.
+   */
+  ptptime_t             step_threshold;
+  /**
+   * @brief Clock step callback.
+   * @details The offset, in nanoseconds, must be added to the clock.
+   */
+  void                  (*adjtime)(void *arg, ptptime_t offset);
+  /**
+   * @brief Clock rate callback.
+   * @details The clock rate must be set to the nominal rate plus the
+   *          specified offset in ppb.
+   */
+  void                  (*adjfreq)(void *arg, int32_t ppb);
+  /**
+   * @brief Argument for the callbacks.
+   */
+  void                  *arg;
+} PTPServoConfig;
+
+/**
+ * @brief   PTP servo object.
+ * @details The servo is fed with the four timestamps of the Sync and
+ *          Delay_Req exchanges and disciplines the local clock through
+ *          the configuration callbacks.
+ */
+typedef struct {
+  /**
+   * @brief Current configuration data.
+   */
+  const PTPServoConfig  *config;
+  /**
+   * @brief Servo state.
+   */
+  ptpservostate_t       state;
+  /**
+   * @brief Master transmit time of the last Sync.
+   */
+  ptptime_t             t1;
+  /**
+   * @brief Local receive time of the last Sync.
+   */
+  ptptime_t             t2;
+  /**
+   * @brief Filtered mean path delay.
+   */
+  ptptime_t             delay;
+  /**
+   * @brief Last measured offset from the master.
+   */
+  ptptime_t             offset;
+  /**
+   * @brief Local time of the first offset while locking.
+   */
+  ptptime_t             local0;
+  /**
+   * @brief First offset while locking.
+   */
+  ptptime_t             offset0;
+  /**
+   * @brief Integral term in units of 2^-16 ppb.
+   */
+  int64_t               integral;
+  /**
+   * @brief Current frequency adjustment in ppb.
+   */
+  int32_t               ppb;
+  /**
+   * @brief Number of clock steps performed.
+   * @details Timestamps taken before a step cannot be mixed with the
+   *          following ones.
+   */
+  uint32_t              steps;
+  /**
+   * @brief The @p t1 and @p t2 fields are valid.
+   */
+  bool_t                syncvalid;
+  /**
+   * @brief The @p delay field is valid.
+   */
+  bool_t                delayvalid;
+} PTPServo;
+
+/**
+ * @brief   PTP slave object.
+ * @details The slave follows the first master heard in its domain, the
+ *          best master clock algorithm is not implemented. The messages
+ *          transport, Ethernet or UDP, is handled by the application.
+ */
+typedef struct {
+  /**
+   * @brief Clock servo.
+   */
+  PTPServo              servo;
+  /**
+   * @brief Local port identity.
+   */
+  uint8_t               port[10];
+  /**
+   * @brief Master port identity.
+   */
+  uint8_t               master[10];
+  /**
+   * @brief A master has been selected.
+   */
+  bool_t                hasmaster;
+  /**
+   * @brief PTP domain.
+   */
+  uint8_t               domain;
+  /**
+   * @brief A two-step Sync is waiting for its Follow_Up.
+   */
+  bool_t                syncpending;
+  /**
+   * @brief Sequence identifier of the pending Sync.
+   */
+  uint16_t              syncseq;
+  /**
+   * @brief Receive time of the pending Sync.
+   */
+  ptptime_t             synct2;
+  /**
+   * @brief Correction field of the pending Sync.
+   */
+  ptptime_t             synccorr;
+  /**
+   * @brief A Delay_Req is waiting for its Delay_Resp.
+   */
+  bool_t                delaypending;
+  /**
+   * @brief Sequence identifier of the last Delay_Req.
+   */
+  uint16_t              delayseq;
+  /**
+   * @brief Transmit time of the pending Delay_Req.
+   */
+  ptptime_t             delayt3;
+  /**
+   * @brief Servo steps counter when the Delay_Req was sent.
+   */
+  uint32_t              delaysteps;
+} PTPSlave;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Converts a @p MACTimestamp in a PTP time.
+ *
+ * @param[in] tsp       pointer to a @p MACTimestamp structure
+ * @return              The time in nanoseconds.
+ *
+ * @api
+ */
+#define PTP_TIME(tsp)                                                       \
+  ((ptptime_t)(tsp)->seconds * 1000000000 + (ptptime_t)(tsp)->nanoseconds)
+
+/**
+ * @brief   Returns the servo state.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @return              The servo state.
+ *
+ * @api
+ */
+#define ptpsrvGetState(sp) ((sp)->state)
+
+/**
+ * @brief   Returns the last measured offset from the master.
+ *
+ * @param[in] sp        pointer to the @p PTPServo object
+ * @return              The offset in nanoseconds, positive if the local
+ *                      clock is ahead.
+ *
+ * @api
+ */
+#define ptpsrvGetOffset(sp) ((sp)->offset)
+
+/**
+ * @brief   Returns the slave servo.
+ *
+ * @param[in] slp       pointer to the @p PTPSlave object
+ * @return              The pointer to the @p PTPServo object.
+ *
+ * @api
+ */
+#define ptpslvGetServo(slp) (&(slp)->servo)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void ptpsrvObjectInit(PTPServo *sp, const PTPServoConfig *config);
+  void ptpsrvSync(PTPServo *sp, ptptime_t t1, ptptime_t t2);
+  void ptpsrvDelay(PTPServo *sp, ptptime_t t3, ptptime_t t4);
+  void ptpslvObjectInit(PTPSlave *slp, const PTPServoConfig *config,
+                        const uint8_t *clockid, uint8_t domain);
+  void ptpslvInput(PTPSlave *slp, const uint8_t *msg, size_t n,
+                   ptptime_t rxtime);
+  size_t ptpslvBuildDelayReq(PTPSlave *slp, uint8_t *buf);
+  void ptpslvDelayReqSent(PTPSlave *slp, ptptime_t t3);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PTP_H_ */
+
+/** @} */
@@ -0,0 +1,168 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ramflash.c
+ * @brief   RAM flash emulator code.
+ *
+ * @addtogroup ram_flash
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "ramflash.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Total size of the emulated device in bytes.
+ */
+#define rf_size(rfp) ((rfp)->config->sector_size * (rfp)->config->sectors)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Consumes the write budget.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] n         number of bytes to be written
+ * @return              The number of bytes that can actually be written
+ *                      before the emulated power failure.
+ */
+static size_t consume(RamFlash *rfp, size_t n) {
+
+  if (rfp->budget == RF_NO_FAIL)
+    return n;
+  if (n > rfp->budget)
+    n = rfp->budget;
+  rfp->budget -= n;
+  return n;
+}
+
+static bool_t rf_read(void *instance, uint32_t offset,
+                      uint8_t *buffer, size_t n) {
+  RamFlash *rfp = instance;
+
+  if ((offset > rf_size(rfp)) || (n > rf_size(rfp) - offset))
+    return CH_FAILED;
+  memcpy(buffer, rfp->config->buffer + offset, n);
+  rfp->stats.reads++;
+  rfp->stats.rdbytes += n;
+  return CH_SUCCESS;
+}
+
+static bool_t rf_program(void *instance, uint32_t offset,
+                         const uint8_t *buffer, size_t n) {
+  RamFlash *rfp = instance;
+  uint8_t *p;
+  size_t i, done;
+
+  if ((offset > rf_size(rfp)) || (n > rf_size(rfp) - offset) ||
+      ((offset | n) & (rfp->config->align - 1)))
+    return CH_FAILED;
+
+  /* Programming can only clear bits, locations not erased are refused
+     as most flash controllers do.*/
+  p = rfp->config->buffer + offset;
+  for (i = 0; i < n; i++) {
+    if ((p[i] & buffer[i]) != buffer[i]) {
+      rfp->stats.violations++;
+      return CH_FAILED;
+    }
+  }
+  done = consume(rfp, n);
+  for (i = 0; i < done; i++)
+    p[i] &= buffer[i];
+  rfp->stats.programs++;
+  rfp->stats.prbytes += done;
+  return done < n ? CH_FAILED : CH_SUCCESS;
+}
+
+static bool_t rf_erase(void *instance, uint32_t sector) {
+  RamFlash *rfp = instance;
+  size_t n = rfp->config->sector_size, done;
+
+  if (sector >= rfp->config->sectors)
+    return CH_FAILED;
+  done = consume(rfp, n);
+  if (done == 0)
+    return CH_FAILED;
+
+  /* An interrupted erase leaves the sector partially erased.*/
+  memset(rfp->config->buffer + (size_t)sector * n, FLASH_ERASED, done);
+  rfp->stats.erases++;
+  if (rfp->config->wear != NULL)
+    rfp->config->wear[sector]++;
+  return done < n ? CH_FAILED : CH_SUCCESS;
+}
+
+static bool_t rf_get_info(void *instance, FlashInfo *fip) {
+  RamFlash *rfp = instance;
+
+  fip->sector_size = rfp->config->sector_size;
+  fip->sectors     = rfp->config->sectors;
+  fip->align       = rfp->config->align;
+  return CH_SUCCESS;
+}
+
+static const struct RamFlashVMT vmt = {
+  rf_read, rf_program, rf_erase, rf_get_info
+};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM flash emulator object initialization.
+ * @note    The emulator is not thread safe, the accesses must be
+ *          serialized by the caller as for a real flash controller.
+ *
+ * @param[out] rfp      pointer to the @p RamFlash object to be initialized
+ * @param[in] config    pointer to the @p RamFlashConfig object, it must
+ *                      persist for the whole lifetime of the object
+ *
+ * @init
+ */
+void rfObjectInit(RamFlash *rfp, const RamFlashConfig *config) {
+
+  chDbgCheck((rfp != NULL) && (config != NULL) &&
+             (config->buffer != NULL) && (config->sectors > 0) &&
+             (config->align > 0) &&
+             ((config->align & (config->align - 1)) == 0) &&
+             ((config->sector_size % config->align) == 0), "rfObjectInit");
+
+  rfp->vmt    = &vmt;
+  rfp->config = config;
+  rfp->budget = RF_NO_FAIL;
+  rfResetStats(rfp);
+}
+
+/** @} */
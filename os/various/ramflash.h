@@ -0,0 +1,193 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    ramflash.h
+ * @brief   RAM flash emulator structures and macros.
+ *
+ * @addtogroup ram_flash
+ * @{
+ */
+
+#ifndef _RAMFLASH_H_
+#define _RAMFLASH_H_
+
+#include "flashdev.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Power failure injection disabled.
+ */
+#define RF_NO_FAIL              0xFFFFFFFF
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   RAM flash emulator configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Emulated flash array, its size must be
+   *          <tt>sector_size * sectors</tt> bytes.
+   * @note    The array is not modified on initialization, fill it with
+   *          @p FLASH_ERASED in order to emulate a blank device.
+   */
+  uint8_t               *buffer;
+  /**
+   * @brief   Sector size in bytes.
+   */
+  uint32_t              sector_size;
+  /**
+   * @brief   Number of sectors.
+   */
+  uint32_t              sectors;
+  /**
+   * @brief   Programming unit in bytes, must be a power of two.
+   */
+  uint32_t              align;
+  /**
+   * @brief   Per-sector erase counters array or @p NULL.
+   */
+  uint32_t              *wear;
+} RamFlashConfig;
+
+/**
+ * @brief   RAM flash emulator statistics.
+ */
+typedef struct {
+  uint32_t              reads;      /**< @brief Read operations.            */
+  uint32_t              programs;   /**< @brief Program operations.         */
+  uint32_t              erases;     /**< @brief Erase operations.           */
+  uint32_t              rdbytes;    /**< @brief Bytes read.                 */
+  uint32_t              prbytes;    /**< @brief Bytes programmed.           */
+  uint32_t              violations; /**< @brief Program operations refused
+                                                because the target was not
+                                                erased.                     */
+} RamFlashStats;
+
+/**
+ * @brief   @p RamFlash specific data.
+ */
+#define _ram_flash_data                                                     \
+  _base_flash_data                                                          \
+  /* Current configuration data.*/                                          \
+  const RamFlashConfig  *config;                                            \
+  /* Bytes that can still be written before the emulated power failure.*/   \
+  uint32_t              budget;                                             \
+  /* Statistics.*/                                                          \
+  RamFlashStats         stats;
+
+/**
+ * @brief   @p RamFlash virtual methods table.
+ */
+struct RamFlashVMT {
+  _base_flash_methods
+};
+
+/**
+ * @extends BaseFlash
+ *
+ * @brief   RAM flash emulator object.
+ * @details The object emulates a NOR flash in a RAM array: programming
+ *          can only clear bits and a whole sector must be erased before
+ *          being programmed again. A power failure can be injected after
+ *          a given amount of written bytes in order to test the handling
+ *          of interrupted operations.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct RamFlashVMT *vmt;
+  _ram_flash_data
+} RamFlash;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Schedules an emulated power failure.
+ * @details After @p n more bytes have been programmed or erased the
+ *          operation in progress is truncated and all the following
+ *          program and erase operations fail, the emulated power is
+ *          restored by invoking this macro with @p RF_NO_FAIL.
+ * @note    Erasing a sector counts as writing <tt>sector_size</tt> bytes.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @param[in] n         number of bytes or @p RF_NO_FAIL
+ *
+ * @api
+ */
+#define rfSetPowerFail(rfp, n) ((rfp)->budget = (n))
+
+/**
+ * @brief   Returns a pointer to the emulator statistics.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ * @return              Pointer to a @p RamFlashStats structure.
+ *
+ * @api
+ */
+#define rfGetStats(rfp) (&(rfp)->stats)
+
+/**
+ * @brief   Clears the emulator statistics.
+ *
+ * @param[in] rfp       pointer to the @p RamFlash object
+ *
+ * @api
+ */
+#define rfResetStats(rfp) {                                                 \
+  (rfp)->stats.reads      = 0;                                              \
+  (rfp)->stats.programs   = 0;                                              \
+  (rfp)->stats.erases     = 0;                                              \
+  (rfp)->stats.rdbytes    = 0;                                              \
+  (rfp)->stats.prbytes    = 0;                                              \
+  (rfp)->stats.violations = 0;                                              \
+}
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void rfObjectInit(RamFlash *rfp, const RamFlashConfig *config);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RAMFLASH_H_ */
+
+/** @} */
@@ -23,6 +23,7 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
 
 #include "ch.h"
 #include "hal.h"
@@ -106,12 +107,66 @@ static void cmd_systime(BaseSequentialStream *chp, int argc, char *argv[]) {
   chprintf(chp, "%lu\r\n", (unsigned long)chTimeNow());
 }
 
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+/*
+ * Ordering of the lock profiles, most contended first, ties are broken by
+ * address in order to have a strict ordering.
+ */
+static bool_t lp_before(LockProfile *lpp1, LockProfile *lpp2) {
+
+  if (lpp1->lp_contended != lpp2->lp_contended)
+    return lpp1->lp_contended > lpp2->lp_contended;
+  return lpp1 > lpp2;
+}
+
+static void cmd_locks(BaseSequentialStream *chp, int argc, char *argv[]) {
+  LockProfile *lpp, *top, *prev;
+  int n;
+
+  if (argc > 1) {
+    usage(chp, "locks [n]");
+    return;
+  }
+  n = argc > 0 ? atoi(argv[0]) : 10;
+  chprintf(chp, "name             locks   contended boosts wait avg/max    "
+                "hold avg/max\r\n");
+  prev = NULL;
+  while (n-- > 0) {
+    /* Selecting the next profile in contention order.*/
+    top = NULL;
+    for (lpp = chDbgGetFirstLockProfile(); lpp != NULL; lpp = lpp->lp_next) {
+      if ((prev != NULL) && !lp_before(prev, lpp))
+        continue;
+      if ((top == NULL) || lp_before(lpp, top))
+        top = lpp;
+    }
+    if (top == NULL)
+      break;
+    chprintf(chp, "%-16s %7lu %9lu %6lu %6lu/%-6lu %6lu/%lu\r\n",
+             top->lp_name != NULL ? top->lp_name : "-",
+             (unsigned long)top->lp_locks,
+             (unsigned long)top->lp_contended,
+             (unsigned long)top->lp_boosts,
+             (unsigned long)(top->lp_contended > 0 ?
+                             top->lp_wait_total / top->lp_contended : 0),
+             (unsigned long)top->lp_wait_max,
+             (unsigned long)(top->lp_locks > 0 ?
+                             top->lp_hold_total / top->lp_locks : 0),
+             (unsigned long)top->lp_hold_max);
+    prev = top;
+  }
+}
+#endif /* CH_DBG_LOCKS_PROFILING */
+
 /**
  * @brief   Array of the default commands.
  */
 static ShellCommand local_commands[] = {
   {"info", cmd_info},
   {"systime", cmd_systime},
+#if CH_DBG_LOCKS_PROFILING
+  {"locks", cmd_locks},
+#endif
   {NULL, NULL}
 };
 
@@ -0,0 +1,980 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    udpip.c
+ * @brief   Native UDP/IP stack code.
+ *
+ * @addtogroup udp_ip
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "udpip.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define ETH_HEADER_SIZE         14
+#define ETH_TYPE_IP             0x0800
+#define ETH_TYPE_ARP            0x0806
+
+#define ARP_SIZE                28
+#define ARP_OP_REQUEST          1
+#define ARP_OP_REPLY            2
+
+#define IP_HEADER_SIZE          20
+#define IP_PROTO_ICMP           1
+#define IP_PROTO_UDP            17
+
+#define ICMP_HEADER_SIZE        8
+#define ICMP_ECHO_REQUEST       8
+
+#define UDP_HEADER_SIZE         8
+
+/**
+ * @brief   Transmit descriptors wait time for the frames generated by the
+ *          stack itself.
+ */
+#define TX_TIMEOUT              MS2ST(100)
+
+/**
+ * @brief   Size of the headers buffer.
+ * @details The frames are built at offset 2 so the IP header is aligned,
+ *          the buffer holds the longest IP header and the following UDP
+ *          or ICMP header.
+ */
+#define HDR_WORDS               ((2 + ETH_HEADER_SIZE + 60 + 8 + 3) / 4)
+
+/**
+ * @brief   Increments a statistics counter.
+ * @details The counters are updated by the receive thread and by the
+ *          sending threads.
+ */
+#define STATS_INC(ipp, counter) {                                           \
+  chSysLock();                                                              \
+  (ipp)->stats.counter++;                                                   \
+  chSysUnlock();                                                            \
+}
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+static const uint8_t broadcast_ethaddr[6] = {0xFF, 0xFF, 0xFF,
+                                             0xFF, 0xFF, 0xFF};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint16_t get16(const uint8_t *p) {
+
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p) {
+
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief   Internet checksum partial sum.
+ * @details The data is summed 32 bits at time in native byte order with
+ *          end around carry, the folded result is the checksum in native
+ *          byte order (RFC 1071). Partial sums can be chained as long as
+ *          all the chunks except the last one have an even size.
+ *
+ * @param[in] sum       partial sum of the previous chunks or zero
+ * @param[in] p         pointer to the data, no alignment required
+ * @param[in] n         data size
+ * @return              The updated partial sum.
+ */
+static uint32_t csum_add(uint32_t sum, const uint8_t *p, size_t n) {
+  uint32_t w;
+  uint16_t h;
+
+  while (n >= 4) {
+    memcpy(&w, p, 4);
+    sum += w;
+    if (sum < w)
+      sum++;
+    p += 4;
+    n -= 4;
+  }
+  if (n >= 2) {
+    memcpy(&h, p, 2);
+    w = h;
+    sum += w;
+    if (sum < w)
+      sum++;
+    p += 2;
+    n -= 2;
+  }
+  if (n > 0) {
+    /* The odd byte is padded with a zero byte at the following address.*/
+    h = 0;
+    memcpy(&h, p, 1);
+    w = h;
+    sum += w;
+    if (sum < w)
+      sum++;
+  }
+  return sum;
+}
+
+/**
+ * @brief   Folds a partial sum into the checksum field value.
+ *
+ * @param[in] sum       partial sum
+ * @return              The checksum in native byte order, zero when
+ *                      verifying data that includes a valid checksum.
+ */
+static uint16_t csum_fold(uint32_t sum) {
+
+  sum = (sum >> 16) + (sum & 0xFFFF);
+  sum += sum >> 16;
+  return (uint16_t)~sum;
+}
+
+/**
+ * @brief   Partial sum of the UDP pseudo header.
+ */
+static uint32_t csum_pseudo(uint32_t src, uint32_t dst, uint16_t len) {
+  uint8_t ph[12];
+
+  put32(&ph[0], src);
+  put32(&ph[4], dst);
+  ph[8] = 0;
+  ph[9] = IP_PROTO_UDP;
+  put16(&ph[10], len);
+  return csum_add(0, ph, sizeof ph);
+}
+
+/**
+ * @brief   Fills an IPv4 header without options.
+ */
+static void ip_header(UdpIpStack *ipp, uint8_t *p, uint8_t proto,
+                      uint32_t dst, size_t len) {
+  uint16_t id, cs;
+
+  chSysLock();
+  id = ipp->ipid++;
+  chSysUnlock();
+
+  p[0] = 0x45;
+  p[1] = 0;
+  put16(&p[2], (uint16_t)(IP_HEADER_SIZE + len));
+  put16(&p[4], id);
+  put16(&p[6], 0x4000);                 /* Don't fragment.                  */
+  p[8] = UDPIP_TTL;
+  p[9] = proto;
+  p[10] = p[11] = 0;
+  put32(&p[12], ipp->config->address);
+  put32(&p[16], dst);
+  cs = csum_fold(csum_add(0, p, IP_HEADER_SIZE));
+  memcpy(&p[10], &cs, 2);
+}
+
+/**
+ * @brief   Looks up an address in the ARP cache.
+ * @note    Must be invoked with the stack mutex locked.
+ */
+static UdpIpArpEntry *arp_find(UdpIpStack *ipp, uint32_t address) {
+  unsigned i;
+
+  for (i = 0; i < UDPIP_ARP_ENTRIES; i++)
+    if (ipp->arp[i].address == address)
+      return &ipp->arp[i];
+  return NULL;
+}
+
+/**
+ * @brief   Looks up a valid address in the ARP cache.
+ * @details Expired entries are freed, the address is then resolved again.
+ * @note    Must be invoked with the stack mutex locked.
+ */
+static UdpIpArpEntry *arp_lookup(UdpIpStack *ipp, uint32_t address) {
+  UdpIpArpEntry *ep;
+
+  ep = arp_find(ipp, address);
+  if ((ep != NULL) &&
+      ((systime_t)(chTimeNow() - ep->time) > UDPIP_ARP_MAX_AGE)) {
+    ep->address = 0;
+    return NULL;
+  }
+  return ep;
+}
+
+/**
+ * @brief   Updates the ARP cache.
+ * @details An existing entry is always refreshed, a new entry replacing
+ *          the oldest one is created only if @p insert is @p TRUE.
+ * @note    Must be invoked with the stack mutex locked.
+ */
+static void arp_update(UdpIpStack *ipp, uint32_t address,
+                       const uint8_t *ethaddr, bool_t insert) {
+  UdpIpArpEntry *ep;
+  unsigned i;
+
+  if (address == 0)
+    return;
+  ep = arp_find(ipp, address);
+  if (ep == NULL) {
+    if (!insert)
+      return;
+    ep = &ipp->arp[0];
+    for (i = 1; (i < UDPIP_ARP_ENTRIES) && (ep->address != 0); i++) {
+      if ((ipp->arp[i].address == 0) ||
+          ((systime_t)(chTimeNow() - ipp->arp[i].time) >
+           (systime_t)(chTimeNow() - ep->time)))
+        ep = &ipp->arp[i];
+    }
+    ep->address = address;
+  }
+  memcpy(ep->ethaddr, ethaddr, 6);
+  ep->time = chTimeNow();
+  chCondBroadcast(&ipp->arpcv);
+}
+
+/**
+ * @brief   Transmits an ARP packet.
+ */
+static void arp_output(UdpIpStack *ipp, uint16_t op,
+                       const uint8_t *ethaddr, uint32_t address) {
+  MACTransmitDescriptor td;
+  uint8_t f[ETH_HEADER_SIZE + ARP_SIZE];
+
+  memcpy(&f[0], ethaddr, 6);
+  memcpy(&f[6], ipp->ethaddr, 6);
+  put16(&f[12], ETH_TYPE_ARP);
+  put16(&f[14], 1);                     /* Ethernet.                        */
+  put16(&f[16], ETH_TYPE_IP);
+  f[18] = 6;
+  f[19] = 4;
+  put16(&f[20], op);
+  memcpy(&f[22], ipp->ethaddr, 6);
+  put32(&f[28], ipp->config->address);
+  if (op == ARP_OP_REQUEST)
+    memset(&f[32], 0, 6);
+  else
+    memcpy(&f[32], ethaddr, 6);
+  put32(&f[38], address);
+
+  if (macWaitTransmitDescriptor(ipp->config->macp, &td,
+                                TX_TIMEOUT) != RDY_OK) {
+    STATS_INC(ipp, txerrors);
+    return;
+  }
+  macWriteTransmitDescriptor(&td, f, sizeof f);
+  macReleaseTransmitDescriptor(&td);
+  STATS_INC(ipp, txframes);
+}
+
+/**
+ * @brief   Resolves the MAC address of a destination.
+ * @details Addresses outside the local network are resolved to the
+ *          gateway MAC address.
+ *
+ * @param[in] ipp       pointer to the @p UdpIpStack object
+ * @param[in] address   destination address
+ * @param[out] ethaddr  MAC address
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE a single request is sent.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       the address has been resolved.
+ * @retval RDY_TIMEOUT  the address could not be resolved in time.
+ */
+static msg_t arp_resolve(UdpIpStack *ipp, uint32_t address,
+                         uint8_t *ethaddr, systime_t time) {
+  const UdpIpConfig *cfg = ipp->config;
+  UdpIpArpEntry *ep;
+  systime_t start, elapsed, wait;
+
+  /* Broadcast and multicast addresses are mapped directly.*/
+  if ((address == UDPIP_BROADCAST) ||
+      ((address | cfg->netmask) == UDPIP_BROADCAST)) {
+    memcpy(ethaddr, broadcast_ethaddr, 6);
+    return RDY_OK;
+  }
+  if ((address & 0xF0000000) == 0xE0000000) {
+    ethaddr[0] = 0x01;
+    ethaddr[1] = 0x00;
+    ethaddr[2] = 0x5E;
+    ethaddr[3] = (uint8_t)((address >> 16) & 0x7F);
+    ethaddr[4] = (uint8_t)(address >> 8);
+    ethaddr[5] = (uint8_t)address;
+    return RDY_OK;
+  }
+  if (((address ^ cfg->address) & cfg->netmask) != 0)
+    address = cfg->gateway;
+
+  start = chTimeNow();
+  chMtxLock(&ipp->mtx);
+  while ((ep = arp_lookup(ipp, address)) == NULL) {
+    chMtxUnlock();
+    STATS_INC(ipp, arpmisses);
+    arp_output(ipp, ARP_OP_REQUEST, broadcast_ethaddr, address);
+    elapsed = chTimeNow() - start;
+    if ((time != TIME_INFINITE) && (elapsed >= time))
+      return RDY_TIMEOUT;
+    wait = UDPIP_ARP_RETRY_TIME;
+    if ((time != TIME_INFINITE) && (time - elapsed < wait))
+      wait = time - elapsed;
+    chMtxLock(&ipp->mtx);
+    /* On timeout the mutex is not re-acquired.*/
+    if ((arp_lookup(ipp, address) == NULL) &&
+        (chCondWaitTimeout(&ipp->arpcv, wait) == RDY_TIMEOUT))
+      chMtxLock(&ipp->mtx);
+  }
+  memcpy(ethaddr, ep->ethaddr, 6);
+  chMtxUnlock();
+  return RDY_OK;
+}
+
+/**
+ * @brief   Processes a received ARP packet.
+ */
+static void arp_input(UdpIpStack *ipp, const uint8_t *p) {
+  uint32_t spa, tpa;
+  bool_t for_us;
+
+  if ((get16(&p[0]) != 1) || (get16(&p[2]) != ETH_TYPE_IP) ||
+      (p[4] != 6) || (p[5] != 4)) {
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+  spa = get32(&p[14]);
+  tpa = get32(&p[24]);
+  for_us = tpa == ipp->config->address;
+
+  /* The sender is learned if the packet is addressed to this interface,
+     an existing entry is refreshed anyway.*/
+  chMtxLock(&ipp->mtx);
+  arp_update(ipp, spa, &p[8], for_us);
+  chMtxUnlock();
+
+  if (for_us && (get16(&p[6]) == ARP_OP_REQUEST))
+    arp_output(ipp, ARP_OP_REPLY, &p[8], spa);
+}
+
+/**
+ * @brief   Answers an ICMP echo request.
+ * @details The reply is sent to the MAC address the request came from, the
+ *          payload is moved from the receive descriptor to the transmit
+ *          descriptor and the ICMP checksum is updated incrementally
+ *          (RFC 1624).
+ */
+static void icmp_input(UdpIpStack *ipp, MACReceiveDescriptor *rdp,
+                       uint8_t *f, size_t ihl, size_t len) {
+  MACTransmitDescriptor td;
+  uint8_t *ip = f + ETH_HEADER_SIZE;
+  uint8_t *icmp = ip + ihl;
+  uint32_t sum;
+  size_t n;
+
+  if ((len < ICMP_HEADER_SIZE) || (icmp[0] != ICMP_ECHO_REQUEST) ||
+      (icmp[1] != 0))
+    return;
+
+  if (macWaitTransmitDescriptor(ipp->config->macp, &td,
+                                TX_TIMEOUT) != RDY_OK) {
+    STATS_INC(ipp, txerrors);
+    return;
+  }
+
+  /* Ethernet header, the request source becomes the destination.*/
+  memcpy(&f[0], &f[6], 6);
+  memcpy(&f[6], ipp->ethaddr, 6);
+
+  /* The ICMP header is moved after an IP header without options.*/
+  icmp[0] = 0;
+  sum = (uint16_t)~get16(&icmp[2]) + (uint16_t)~(ICMP_ECHO_REQUEST << 8);
+  sum = (sum >> 16) + (sum & 0xFFFF);
+  put16(&icmp[2], (uint16_t)~(sum + (sum >> 16)));
+  memmove(ip + IP_HEADER_SIZE, icmp, ICMP_HEADER_SIZE);
+  ip_header(ipp, ip, IP_PROTO_ICMP, get32(&ip[12]), len);
+  macWriteTransmitDescriptor(&td, f,
+                             ETH_HEADER_SIZE + IP_HEADER_SIZE +
+                             ICMP_HEADER_SIZE);
+
+  /* Echo data.*/
+  len -= ICMP_HEADER_SIZE;
+  while (len > 0) {
+    n = macReadReceiveDescriptor(rdp, f, len < HDR_WORDS * 4 - 2 ?
+                                         len : HDR_WORDS * 4 - 2);
+    if (n == 0)
+      break;
+    macWriteTransmitDescriptor(&td, f, n);
+    len -= n;
+  }
+  macReleaseTransmitDescriptor(&td);
+  STATS_INC(ipp, txframes);
+  STATS_INC(ipp, echoes);
+}
+
+/**
+ * @brief   Delivers a received datagram to the bound socket.
+ * @details The payload is read from the receive descriptor directly into
+ *          the socket ring.
+ */
+static void udp_input(UdpIpStack *ipp, MACReceiveDescriptor *rdp,
+                      const uint8_t *ip, size_t ihl, size_t len) {
+  const uint8_t *udp = ip + ihl;
+  UdpSocket *sp;
+  UdpDatagram *dp;
+  uint16_t port, ulen, cs;
+  size_t n;
+  bool_t full;
+
+  if (len < UDP_HEADER_SIZE) {
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+  ulen = get16(&udp[4]);
+  if ((ulen < UDP_HEADER_SIZE) || (ulen > len) ||
+      (ulen - UDP_HEADER_SIZE > UDPIP_DATAGRAM_SIZE)) {
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+  n = ulen - UDP_HEADER_SIZE;
+  port = get16(&udp[2]);
+
+  /* The mutex keeps the socket bound during the delivery.*/
+  chMtxLock(&ipp->mtx);
+  for (sp = ipp->sockets; sp != NULL; sp = sp->next)
+    if (sp->port == port)
+      break;
+  if (sp == NULL) {
+    chMtxUnlock();
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+  chSysLock();
+  full = sp->count >= sp->size;
+  chSysUnlock();
+  if (full) {
+    chMtxUnlock();
+    STATS_INC(ipp, overruns);
+    return;
+  }
+
+  /* The slot is not visible to the reader until the ring counter is
+     updated.*/
+  dp = &sp->ring[sp->wrptr];
+  if (macReadReceiveDescriptor(rdp, dp->data, n) != n) {
+    chMtxUnlock();
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+  memcpy(&cs, &udp[6], 2);
+  if ((cs != 0) &&
+      (csum_fold(csum_add(csum_add(csum_pseudo(get32(&ip[12]),
+                                               get32(&ip[16]), ulen),
+                                   udp, UDP_HEADER_SIZE),
+                          dp->data, n)) != 0)) {
+    chMtxUnlock();
+    STATS_INC(ipp, csumerrors);
+    return;
+  }
+  dp->address = get32(&ip[12]);
+  dp->port    = get16(&udp[0]);
+  dp->size    = (uint16_t)n;
+
+  chSysLock();
+  sp->wrptr = (sp->wrptr + 1) % sp->size;
+  sp->count++;
+  chSemSignalI(&sp->sem);
+  chSchRescheduleS();
+  chSysUnlock();
+  chMtxUnlock();
+}
+
+/**
+ * @brief   Processes a received IPv4 packet.
+ */
+static void ip_input(UdpIpStack *ipp, MACReceiveDescriptor *rdp,
+                     uint8_t *f, size_t n) {
+  const UdpIpConfig *cfg = ipp->config;
+  uint8_t *ip = f + ETH_HEADER_SIZE;
+  size_t ihl, len;
+  uint32_t dst;
+
+  ihl = (size_t)(ip[0] & 0x0F) * 4;
+  len = get16(&ip[2]);
+  if (((ip[0] & 0xF0) != 0x40) || (ihl < IP_HEADER_SIZE) || (len < ihl) ||
+      (len > rdp->size - ETH_HEADER_SIZE) ||
+      ((get16(&ip[6]) & 0x3FFF) != 0)) {
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+
+  /* Options, the buffer also receives the following 8 bytes header.*/
+  if (ihl > IP_HEADER_SIZE) {
+    if (macReadReceiveDescriptor(rdp, f + n, ihl - IP_HEADER_SIZE) !=
+        ihl - IP_HEADER_SIZE) {
+      STATS_INC(ipp, rxdrops);
+      return;
+    }
+  }
+  if (csum_fold(csum_add(0, ip, ihl)) != 0) {
+    STATS_INC(ipp, csumerrors);
+    return;
+  }
+
+  dst = get32(&ip[16]);
+  if ((dst != cfg->address) && (dst != UDPIP_BROADCAST) &&
+      ((dst | cfg->netmask) != UDPIP_BROADCAST)) {
+    STATS_INC(ipp, rxdrops);
+    return;
+  }
+
+  switch (ip[9]) {
+  case IP_PROTO_UDP:
+    udp_input(ipp, rdp, ip, ihl, len - ihl);
+    break;
+  case IP_PROTO_ICMP:
+    if (dst == cfg->address)
+      icmp_input(ipp, rdp, f, ihl, len - ihl);
+    break;
+  default:
+    STATS_INC(ipp, rxdrops);
+  }
+}
+
+/**
+ * @brief   Receive thread.
+ */
+static msg_t rx_thread(void *arg) {
+  UdpIpStack *ipp = arg;
+  MACReceiveDescriptor rd;
+  uint32_t hdr[HDR_WORDS];
+  uint8_t *f = (uint8_t *)hdr + 2;
+  size_t n;
+
+  chRegSetThreadName("udpip");
+  while (TRUE) {
+    if (macWaitReceiveDescriptor(ipp->config->macp, &rd,
+                                 TIME_INFINITE) != RDY_OK)
+      continue;
+    STATS_INC(ipp, rxframes);
+
+    /* Ethernet header followed by an ARP packet or by an IP header without
+       options and the transport header.*/
+    n = macReadReceiveDescriptor(&rd, f, ETH_HEADER_SIZE + IP_HEADER_SIZE +
+                                         UDP_HEADER_SIZE);
+    if (n < ETH_HEADER_SIZE + ARP_SIZE) {
+      STATS_INC(ipp, rxdrops);
+    }
+    else {
+      switch (get16(&f[12])) {
+      case ETH_TYPE_IP:
+        ip_input(ipp, &rd, f, n);
+        break;
+      case ETH_TYPE_ARP:
+        arp_input(ipp, f + ETH_HEADER_SIZE);
+        break;
+      default:
+        STATS_INC(ipp, rxdrops);
+      }
+    }
+    macReleaseReceiveDescriptor(&rd);
+  }
+  return 0;
+}
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Release callback of the transmitted datagrams.
+ * @details The sending thread is woken up, the callback can be invoked by
+ *          any thread reclaiming the transmitted frames. If the wait has
+ *          been cancelled the record is returned to its pool.
+ */
+static void tx_release(void *arg) {
+  UdpIpTxWait *wp = arg;
+
+  chSysLock();
+  if (wp->thread == NULL)
+    chPoolFreeI(wp->pool, wp);
+  else {
+    wp->released = TRUE;
+    chEvtSignalI(wp->thread, UDPIP_TX_EVENT);
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+}
+#endif
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   UDP/IP stack object initialization.
+ *
+ * @param[out] ipp      pointer to the @p UdpIpStack object to be initialized
+ *
+ * @init
+ */
+void udpipObjectInit(UdpIpStack *ipp) {
+
+  chDbgCheck(ipp != NULL, "udpipObjectInit");
+
+  ipp->config  = NULL;
+  ipp->sockets = NULL;
+  ipp->ipid    = 0;
+  ipp->tp      = NULL;
+  memset(ipp->arp, 0, sizeof ipp->arp);
+  memset(&ipp->stats, 0, sizeof ipp->stats);
+#if MAC_USE_ZERO_COPY
+  chPoolInit(&ipp->txpool, sizeof (UdpIpTxWait), NULL);
+  chPoolLoadArray(&ipp->txpool, ipp->txwait, UDPIP_TX_WAITERS);
+#endif
+  chMtxInit(&ipp->mtx);
+  chCondInit(&ipp->arpcv);
+}
+
+/**
+ * @brief   Starts the UDP/IP stack.
+ * @details The MAC driver is started and the receive thread is created.
+ *
+ * @param[in] ipp       pointer to the @p UdpIpStack object
+ * @param[in] config    pointer to the @p UdpIpConfig object, it must
+ *                      persist for the whole lifetime of the stack
+ *
+ * @api
+ */
+void udpipStart(UdpIpStack *ipp, const UdpIpConfig *config) {
+
+  chDbgCheck((ipp != NULL) && (config != NULL) && (config->macp != NULL) &&
+             (config->mac_config != NULL) &&
+             (config->mac_config->mac_address != NULL), "udpipStart");
+  chDbgAssert(ipp->tp == NULL, "udpipStart(), #1", "already started");
+
+  ipp->config = config;
+  memcpy(ipp->ethaddr, config->mac_config->mac_address, 6);
+  macStart(config->macp, config->mac_config);
+  ipp->tp = chThdCreateStatic(ipp->wa, sizeof(ipp->wa),
+                              UDPIP_THREAD_PRIORITY, rx_thread, ipp);
+}
+
+/**
+ * @brief   UDP socket object initialization.
+ *
+ * @param[out] sp       pointer to the @p UdpSocket object to be initialized
+ * @param[in] ring      array of @p n datagrams used as receive ring, it can
+ *                      be @p NULL for sockets only used for transmission
+ * @param[in] n         number of datagrams in the receive ring
+ *
+ * @init
+ */
+void udpObjectInit(UdpSocket *sp, UdpDatagram *ring, unsigned n) {
+
+  chDbgCheck((sp != NULL) && ((ring != NULL) || (n == 0)), "udpObjectInit");
+
+  sp->next  = NULL;
+  sp->ipp   = NULL;
+  sp->port  = 0;
+  sp->ring  = ring;
+  sp->size  = n;
+  sp->count = 0;
+  sp->wrptr = 0;
+  sp->rdptr = 0;
+  chSemInit(&sp->sem, 0);
+}
+
+/**
+ * @brief   Binds a socket to a local port.
+ *
+ * @param[in] ipp       pointer to the @p UdpIpStack object
+ * @param[in] sp        pointer to the @p UdpSocket object
+ * @param[in] port      local port
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    the port is already in use.
+ *
+ * @api
+ */
+bool_t udpBind(UdpIpStack *ipp, UdpSocket *sp, uint16_t port) {
+  UdpSocket *p;
+
+  chDbgCheck((ipp != NULL) && (sp != NULL) && (port != 0), "udpBind");
+  chDbgAssert(sp->ipp == NULL, "udpBind(), #1", "already bound");
+
+  chMtxLock(&ipp->mtx);
+  for (p = ipp->sockets; p != NULL; p = p->next) {
+    if (p->port == port) {
+      chMtxUnlock();
+      return CH_FAILED;
+    }
+  }
+  sp->ipp      = ipp;
+  sp->port     = port;
+  sp->next     = ipp->sockets;
+  ipp->sockets = sp;
+  chMtxUnlock();
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Unbinds a socket.
+ * @details The datagrams already in the receive ring can still be read.
+ *
+ * @param[in] sp        pointer to the @p UdpSocket object
+ *
+ * @api
+ */
+void udpUnbind(UdpSocket *sp) {
+  UdpIpStack *ipp;
+  UdpSocket **pp;
+
+  chDbgCheck(sp != NULL, "udpUnbind");
+
+  ipp = sp->ipp;
+  if (ipp == NULL)
+    return;
+  chMtxLock(&ipp->mtx);
+  for (pp = &ipp->sockets; *pp != NULL; pp = &(*pp)->next) {
+    if (*pp == sp) {
+      *pp = sp->next;
+      break;
+    }
+  }
+  sp->ipp = NULL;
+  chMtxUnlock();
+}
+
+/**
+ * @brief   Sends a datagram.
+ * @details The payload is transmitted directly from @p buf when the MAC
+ *          driver supports the zero-copy API, the function returns after
+ *          the driver released the buffer. Multiple threads can send
+ *          concurrently on the same or on different sockets.
+ * @note    With the zero-copy MAC API the @p UDPIP_TX_EVENT event flags of
+ *          the invoking thread are used while waiting for the release.
+ *          If the release wait times out the driver could still read
+ *          @p buf until the frame is transmitted or the driver stopped.
+ *
+ * @param[in] sp        pointer to a bound @p UdpSocket object
+ * @param[in] address   destination address
+ * @param[in] port      destination port
+ * @param[in] buf       pointer to the payload
+ * @param[in] n         payload size, up to @p UDPIP_DATAGRAM_SIZE bytes
+ * @param[in] time      the number of ticks before the address resolution,
+ *                      the transmit descriptor wait or the release wait
+ *                      timeouts, the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       the datagram has been transmitted.
+ * @retval RDY_TIMEOUT  the destination is not resolved, the transmitter
+ *                      is busy or the datagram was not released in time.
+ * @retval RDY_RESET    the frame could not be queued by the MAC driver.
+ *
+ * @api
+ */
+msg_t udpSendTo(UdpSocket *sp, uint32_t address, uint16_t port,
+                const uint8_t *buf, size_t n, systime_t time) {
+  UdpIpStack *ipp;
+  uint32_t hdr[HDR_WORDS];
+  uint8_t *f = (uint8_t *)hdr + 2;
+  uint8_t *ip = f + ETH_HEADER_SIZE;
+  uint8_t *udp = ip + IP_HEADER_SIZE;
+  uint16_t cs = 0;
+  msg_t msg;
+#if MAC_USE_ZERO_COPY
+  UdpIpTxWait *wp;
+#endif
+
+  chDbgCheck((sp != NULL) && ((buf != NULL) || (n == 0)) &&
+             (n <= UDPIP_DATAGRAM_SIZE), "udpSendTo");
+  chDbgAssert(sp->ipp != NULL, "udpSendTo(), #1", "not bound");
+
+  ipp = sp->ipp;
+  msg = arp_resolve(ipp, address, f, time);
+  if (msg != RDY_OK)
+    return msg;
+
+  memcpy(&f[6], ipp->ethaddr, 6);
+  put16(&f[12], ETH_TYPE_IP);
+  ip_header(ipp, ip, IP_PROTO_UDP, address, UDP_HEADER_SIZE + n);
+  put16(&udp[0], sp->port);
+  put16(&udp[2], port);
+  put16(&udp[4], (uint16_t)(UDP_HEADER_SIZE + n));
+  udp[6] = udp[7] = 0;
+#if UDPIP_USE_CHECKSUM
+  cs = csum_fold(csum_add(csum_add(csum_pseudo(ipp->config->address,
+                                               address,
+                                               UDP_HEADER_SIZE + n),
+                                   udp, UDP_HEADER_SIZE),
+                          buf, n));
+  /* A computed zero is transmitted as all ones.*/
+  if (cs == 0)
+    cs = 0xFFFF;
+#endif
+  memcpy(&udp[6], &cs, 2);
+
+#if MAC_USE_ZERO_COPY
+  wp = chPoolAlloc(&ipp->txpool);
+  if (wp != NULL) {
+    MACDriver *macp = ipp->config->macp;
+    MACTransmitSegment seg[2];
+    EventListener el;
+    systime_t start, elapsed;
+
+    /* The headers are on the stack and are copied by the driver, the
+       payload is transmitted in place.*/
+    seg[0].buf   = f;
+    seg[0].size  = UDPIP_HEADERS_SIZE;
+    seg[0].copy  = TRUE;
+    seg[1].buf   = buf;
+    seg[1].size  = n;
+    seg[1].copy  = FALSE;
+    wp->thread   = chThdSelf();
+    wp->released = FALSE;
+    wp->pool     = &ipp->txpool;
+    chEvtRegisterMask(macGetTransmitEventSource(macp), &el, UDPIP_TX_EVENT);
+    msg = macTransmitSegments(macp, seg, n > 0 ? 2 : 1, tx_release, wp,
+                              time);
+    if (msg == RDY_OK) {
+      /* The frames are reclaimed after each transmission completion until
+         the datagram is released, possibly by another thread. The event
+         flags are latched so a completion or a release is never missed.*/
+      start = chTimeNow();
+      macReclaimTransmitSegments(macp);
+      while (!wp->released) {
+        elapsed = chTimeNow() - start;
+        if ((time != TIME_INFINITE) && (elapsed >= time))
+          break;
+        (void)chEvtWaitAnyTimeout(UDPIP_TX_EVENT, time == TIME_INFINITE ?
+                                                  TIME_INFINITE :
+                                                  time - elapsed);
+        macReclaimTransmitSegments(macp);
+      }
+
+      /* On timeout the wait is cancelled, the record is then returned to
+         the pool by the release callback.*/
+      chSysLock();
+      if (wp->released)
+        chPoolFreeI(&ipp->txpool, wp);
+      else {
+        wp->thread = NULL;
+        msg = RDY_TIMEOUT;
+      }
+      chSysUnlock();
+    }
+    else
+      chPoolFree(&ipp->txpool, wp);
+    chEvtUnregister(macGetTransmitEventSource(macp), &el);
+    chEvtGetAndClearEvents(UDPIP_TX_EVENT);
+  }
+  else
+#endif /* MAC_USE_ZERO_COPY */
+  {
+    MACTransmitDescriptor td;
+
+    msg = macWaitTransmitDescriptor(ipp->config->macp, &td, time);
+    if (msg == RDY_OK) {
+      macWriteTransmitDescriptor(&td, f, UDPIP_HEADERS_SIZE);
+      macWriteTransmitDescriptor(&td, (uint8_t *)buf, n);
+      macReleaseTransmitDescriptor(&td);
+    }
+  }
+  if (msg != RDY_OK) {
+    STATS_INC(ipp, txerrors);
+    return msg;
+  }
+  STATS_INC(ipp, txframes);
+  return RDY_OK;
+}
+
+/**
+ * @brief   Waits for a received datagram.
+ * @details The datagram stays in the socket receive ring until it is
+ *          released using @p udpReleaseDatagram().
+ * @note    A socket can only have one reader thread.
+ *
+ * @param[in] sp        pointer to the @p UdpSocket object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              Pointer to the received datagram.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+UdpDatagram *udpGetDatagram(UdpSocket *sp, systime_t time) {
+
+  chDbgCheck(sp != NULL, "udpGetDatagram");
+
+  if (chSemWaitTimeout(&sp->sem, time) != RDY_OK)
+    return NULL;
+  return &sp->ring[sp->rdptr];
+}
+
+/**
+ * @brief   Releases the datagram returned by @p udpGetDatagram().
+ * @details The ring slot becomes available for more datagrams.
+ *
+ * @param[in] sp        pointer to the @p UdpSocket object
+ *
+ * @api
+ */
+void udpReleaseDatagram(UdpSocket *sp) {
+
+  chDbgCheck(sp != NULL, "udpReleaseDatagram");
+
+  chSysLock();
+  chDbgAssert(sp->count > 0, "udpReleaseDatagram(), #1", "ring empty");
+  sp->rdptr = (sp->rdptr + 1) % sp->size;
+  sp->count--;
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_MAC */
+
+/** @} */
@@ -0,0 +1,425 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    udpip.h
+ * @brief   Native UDP/IP stack structures and macros.
+ *
+ * @addtogroup udp_ip
+ * @{
+ */
+
+#ifndef _UDPIP_H_
+#define _UDPIP_H_
+
+#include "hal.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the Ethernet, IPv4 and UDP headers of a datagram.
+ */
+#define UDPIP_HEADERS_SIZE      42
+
+/**
+ * @brief   Limited broadcast address.
+ */
+#define UDPIP_BROADCAST         0xFFFFFFFF
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   Maximum datagram payload size.
+ * @details It is the size of the sockets receive ring slots, larger
+ *          datagrams are discarded on reception and refused on
+ *          transmission.
+ */
+#if !defined(UDPIP_DATAGRAM_SIZE) || defined(__DOXYGEN__)
+#define UDPIP_DATAGRAM_SIZE         1472
+#endif
+
+/**
+ * @brief   Number of entries of the ARP cache.
+ */
+#if !defined(UDPIP_ARP_ENTRIES) || defined(__DOXYGEN__)
+#define UDPIP_ARP_ENTRIES           8
+#endif
+
+/**
+ * @brief   Interval between the ARP requests of an unresolved address.
+ */
+#if !defined(UDPIP_ARP_RETRY_TIME) || defined(__DOXYGEN__)
+#define UDPIP_ARP_RETRY_TIME        MS2ST(250)
+#endif
+
+/**
+ * @brief   Generation of the UDP checksum.
+ * @details If disabled the transmitted datagrams carry a zero checksum,
+ *          the received checksums are always verified.
+ */
+#if !defined(UDPIP_USE_CHECKSUM) || defined(__DOXYGEN__)
+#define UDPIP_USE_CHECKSUM          TRUE
+#endif
+
+/**
+ * @brief   Time to live of the transmitted packets.
+ */
+#if !defined(UDPIP_TTL) || defined(__DOXYGEN__)
+#define UDPIP_TTL                   64
+#endif
+
+/**
+ * @brief   ARP cache entries lifetime.
+ * @details An entry not refreshed within this time is resolved again on
+ *          the next transmission to its address.
+ */
+#if !defined(UDPIP_ARP_MAX_AGE) || defined(__DOXYGEN__)
+#define UDPIP_ARP_MAX_AGE           S2ST(300)
+#endif
+
+/**
+ * @brief   Receive thread priority.
+ */
+#if !defined(UDPIP_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define UDPIP_THREAD_PRIORITY       (NORMALPRIO + 1)
+#endif
+
+/**
+ * @brief   Receive thread stack size.
+ */
+#if !defined(UDPIP_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define UDPIP_THREAD_STACK_SIZE     512
+#endif
+
+/**
+ * @brief   Event flags used by the sending threads.
+ * @details With the zero-copy MAC API a sending thread waits on these
+ *          flags for the release of its datagram, they must not be used
+ *          by the application threads invoking @p udpSendTo().
+ */
+#if !defined(UDPIP_TX_EVENT) || defined(__DOXYGEN__)
+#define UDPIP_TX_EVENT              EVENT_MASK(31)
+#endif
+
+/**
+ * @brief   Number of datagrams transmitted in place at the same time.
+ * @details With the zero-copy MAC API each datagram waiting for its
+ *          release, or whose wait timed out, holds a record. When no
+ *          record is available the datagram is copied into a transmit
+ *          descriptor.
+ */
+#if !defined(UDPIP_TX_WAITERS) || defined(__DOXYGEN__)
+#define UDPIP_TX_WAITERS            4
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_USE_MUTEXES || !CH_USE_CONDVARS || !CH_USE_CONDVARS_TIMEOUT
+#error "UDP/IP requires CH_USE_MUTEXES, CH_USE_CONDVARS and "               \
+       "CH_USE_CONDVARS_TIMEOUT"
+#endif
+
+#if !CH_USE_SEMAPHORES
+#error "UDP/IP requires CH_USE_SEMAPHORES"
+#endif
+
+#if MAC_USE_ZERO_COPY && !MAC_USE_EVENTS
+#error "UDP/IP with MAC_USE_ZERO_COPY requires MAC_USE_EVENTS"
+#endif
+
+#if MAC_USE_ZERO_COPY && !CH_USE_MEMPOOLS
+#error "UDP/IP with MAC_USE_ZERO_COPY requires CH_USE_MEMPOOLS"
+#endif
+
+#if MAC_USE_ZERO_COPY && (UDPIP_TX_WAITERS < 1)
+#error "invalid UDPIP_TX_WAITERS value"
+#endif
+
+#if (UDPIP_DATAGRAM_SIZE < 1) || (UDPIP_DATAGRAM_SIZE > 1472)
+#error "invalid UDPIP_DATAGRAM_SIZE value"
+#endif
+
+#if UDPIP_ARP_ENTRIES < 1
+#error "UDPIP_ARP_ENTRIES must be at least 1"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Stack configuration structure.
+ * @note    The IPv4 addresses are in host byte order, see @p UDPIP_ADDR().
+ */
+typedef struct {
+  /**
+   * @brief MAC driver.
+   * @note  The driver cannot be shared with lwIP when its zero-copy
+   *        transmit path is enabled, the lwIP pbufs would be released
+   *        by the UDP/IP threads.
+   */
+  MACDriver             *macp;
+  /**
+   * @brief MAC driver configuration.
+   * @details The stack starts the MAC driver with this configuration, its
+   *          MAC address is the interface address and must be specified.
+   */
+  const MACConfig       *mac_config;
+  /**
+   * @brief Interface address.
+   */
+  uint32_t              address;
+  /**
+   * @brief Network mask.
+   */
+  uint32_t              netmask;
+  /**
+   * @brief Default gateway.
+   */
+  uint32_t              gateway;
+} UdpIpConfig;
+
+/**
+ * @brief   ARP cache entry.
+ */
+typedef struct {
+  uint32_t              address;    /**< @brief IPv4 address, zero if the
+                                                entry is free.              */
+  uint8_t               ethaddr[6]; /**< @brief MAC address.                */
+  systime_t             time;       /**< @brief Last update time, used for
+                                                aging and replacement.      */
+} UdpIpArpEntry;
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Wait record of a datagram transmitted in place.
+ */
+typedef struct {
+  Thread                *thread;    /**< @brief Sending thread, @p NULL if
+                                                the wait has been
+                                                cancelled.                  */
+  bool_t                released;   /**< @brief Released by the driver.     */
+  MemoryPool            *pool;      /**< @brief Pool the record belongs to. */
+} UdpIpTxWait;
+#endif
+
+/**
+ * @brief   Stack statistics.
+ */
+typedef struct {
+  uint32_t              rxframes;   /**< @brief Received frames.            */
+  uint32_t              rxdrops;    /**< @brief Received frames discarded,
+                                                malformed or without a
+                                                destination.                */
+  uint32_t              csumerrors; /**< @brief Received frames discarded
+                                                because of a checksum
+                                                error.                      */
+  uint32_t              overruns;   /**< @brief Datagrams lost because the
+                                                socket ring was full.       */
+  uint32_t              txframes;   /**< @brief Transmitted frames.         */
+  uint32_t              txerrors;   /**< @brief Frames that could not be
+                                                transmitted.                */
+  uint32_t              arpmisses;  /**< @brief ARP requests sent.          */
+  uint32_t              echoes;     /**< @brief Echo replies sent.          */
+} UdpIpStats;
+
+/**
+ * @brief   Type of a received datagram.
+ */
+typedef struct {
+  uint32_t              address;    /**< @brief Source address.             */
+  uint16_t              port;       /**< @brief Source port.                */
+  uint16_t              size;       /**< @brief Payload size.               */
+  uint8_t               data[UDPIP_DATAGRAM_SIZE];
+                                    /**< @brief Payload.                    */
+} UdpDatagram;
+
+/**
+ * @brief   Type of a UDP socket.
+ */
+typedef struct UdpSocket UdpSocket;
+
+/**
+ * @brief   Native UDP/IP stack object.
+ */
+typedef struct {
+  /**
+   * @brief Current configuration data.
+   */
+  const UdpIpConfig     *config;
+  /**
+   * @brief Interface MAC address.
+   */
+  uint8_t               ethaddr[6];
+  /**
+   * @brief Mutex protecting the sockets list and the ARP cache.
+   */
+  Mutex                 mtx;
+  /**
+   * @brief Condition signaled when the ARP cache is updated.
+   */
+  CondVar               arpcv;
+  /**
+   * @brief Bound sockets list.
+   */
+  UdpSocket             *sockets;
+  /**
+   * @brief ARP cache.
+   */
+  UdpIpArpEntry         arp[UDPIP_ARP_ENTRIES];
+  /**
+   * @brief Next IPv4 identification field.
+   */
+  uint16_t              ipid;
+  /**
+   * @brief Receive thread.
+   */
+  Thread                *tp;
+  /**
+   * @brief Receive thread working area.
+   */
+  WORKING_AREA(wa, UDPIP_THREAD_STACK_SIZE);
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+  /**
+   * @brief Pool of the transmit wait records.
+   */
+  MemoryPool            txpool;
+  /**
+   * @brief Transmit wait records.
+   */
+  UdpIpTxWait           txwait[UDPIP_TX_WAITERS];
+#endif
+  /**
+   * @brief Statistics.
+   * @note  The counters are updated from multiple threads within critical
+   *        zones.
+   */
+  UdpIpStats            stats;
+} UdpIpStack;
+
+/**
+ * @brief   Structure representing a UDP socket.
+ */
+struct UdpSocket {
+  /**
+   * @brief Next bound socket.
+   */
+  UdpSocket             *next;
+  /**
+   * @brief Stack the socket is bound to or @p NULL.
+   */
+  UdpIpStack            *ipp;
+  /**
+   * @brief Local port.
+   */
+  uint16_t              port;
+  /**
+   * @brief Receive ring.
+   */
+  UdpDatagram           *ring;
+  /**
+   * @brief Number of slots in the receive ring.
+   */
+  unsigned              size;
+  /**
+   * @brief Number of datagrams in the receive ring.
+   */
+  unsigned              count;
+  /**
+   * @brief Next slot to be filled.
+   */
+  unsigned              wrptr;
+  /**
+   * @brief Next slot to be read.
+   */
+  unsigned              rdptr;
+  /**
+   * @brief Counter of the datagrams in the receive ring.
+   */
+  Semaphore             sem;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Builds an IPv4 address in host byte order.
+ *
+ * @param[in] a         first byte of the dotted notation
+ * @param[in] b         second byte of the dotted notation
+ * @param[in] c         third byte of the dotted notation
+ * @param[in] d         fourth byte of the dotted notation
+ *
+ * @api
+ */
+#define UDPIP_ADDR(a, b, c, d)                                              \
+  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) |                          \
+   ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/**
+ * @brief   Returns a pointer to the stack statistics.
+ *
+ * @param[in] ipp       pointer to the @p UdpIpStack object
+ * @return              Pointer to a @p UdpIpStats structure.
+ *
+ * @api
+ */
+#define udpipGetStats(ipp) (&(ipp)->stats)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void udpipObjectInit(UdpIpStack *ipp);
+  void udpipStart(UdpIpStack *ipp, const UdpIpConfig *config);
+  void udpObjectInit(UdpSocket *sp, UdpDatagram *ring, unsigned n);
+  bool_t udpBind(UdpIpStack *ipp, UdpSocket *sp, uint16_t port);
+  void udpUnbind(UdpSocket *sp);
+  msg_t udpSendTo(UdpSocket *sp, uint32_t address, uint16_t port,
+                  const uint8_t *buf, size_t n, systime_t time);
+  UdpDatagram *udpGetDatagram(UdpSocket *sp, systime_t time);
+  void udpReleaseDatagram(UdpSocket *sp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_MAC */
+
+#endif /* _UDPIP_H_ */
+
+/** @} */
@@ -14,19 +14,56 @@
     limitations under the License.
 */
 
-/*-*
+/**
  * @file    usb_msc.c
  * @brief   USB Mass Storage Class code.
+ * @details The Bulk-Only transport is served by a worker thread, the data
+ *          phase of READ(10) and WRITE(10) commands is pipelined over
+ *          @p MSC_BUFFERS buffers so the block device accesses overlap
+ *          the USB transfers.
  *
  * @addtogroup USB_MSC
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 #include "hal.h"
 
 #include "usb_msc.h"
 
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of a data phase buffer in bytes.
+ */
+#define MSC_BUFFER_SIZE     (MSC_BUFFER_BLOCKS * MSC_BLOCK_SIZE)
+
+#if HAL_IMPLEMENTS_COUNTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Time stamp type used for the transfer reports.
+ */
+typedef halrtcnt_t msctime_t;
+
+/**
+ * @brief   Current time stamp.
+ */
+#define msc_now() halGetCounterValue()
+
+/**
+ * @brief   Microseconds elapsed since a time stamp.
+ */
+#define msc_elapsed(t) ((uint32_t)RTT2US(halGetCounterValue() - (t)))
+#else
+typedef systime_t msctime_t;
+#define msc_now() chTimeNow()
+#define msc_elapsed(t) ((uint32_t)(chTimeNow() - (t)) *                     \
+                        (1000000 / CH_FREQUENCY))
+#endif
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -65,27 +102,52 @@ static const uint8_t scsi_inquiry_data[] = {
 /**
  * @brief   Generic buffer.
  */
-uint8_t buf[16];
+static uint8_t buf[20];
 
-/*===========================================================================*/
-/* MMC interface code.                                                       */
-/*===========================================================================*/
+/**
+ * @brief   Data phase buffers.
+ */
+static uint32_t msc_buffers[MSC_BUFFERS][MSC_BUFFER_SIZE / sizeof (uint32_t)];
 
-/*===========================================================================*/
-/* SCSI emulation code.                                                      */
-/*===========================================================================*/
+/**
+ * @brief   Current configuration data.
+ */
+static const MSCConfig *msc_config;
 
-static uint8_t scsi_read_format_capacities(uint32_t *nblocks,
-                                           uint32_t *secsize) {
+/**
+ * @brief   Worker thread working area.
+ */
+static WORKING_AREA(msc_wa, MSC_THREAD_STACK_SIZE);
 
-  *nblocks = 1024;
-  *secsize = 512;
-  return 3; /* No Media.*/
-}
+/**
+ * @brief   Thread waiting for an endpoint event or @p NULL.
+ */
+static Thread *msc_thread;
 
-/*===========================================================================*/
-/* Mass Storage Class related code.                                          */
-/*===========================================================================*/
+/**
+ * @brief   IN endpoint transfer in progress.
+ */
+static bool_t msc_tx_busy;
+
+/**
+ * @brief   OUT endpoint transfer in progress.
+ */
+static bool_t msc_rx_busy;
+
+/**
+ * @brief   Size of the last OUT transfer.
+ */
+static size_t msc_rx_size;
+
+/**
+ * @brief   Current command aborted by a reset.
+ */
+static bool_t msc_aborted;
+
+/**
+ * @brief   Current sense key and additional sense code.
+ */
+static uint8_t msc_sense_key, msc_sense_asc;
 
 /**
  * @brief   MSC state machine current state.
@@ -102,72 +164,601 @@ static msccbw_t CBW;
  */
 static msccsw_t CSW;
 
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Reads a big endian 32 bits value.
+ */
+#define get_be32(p) (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) |  \
+                     ((uint32_t)(p)[2] << 8)  | ((uint32_t)(p)[3] << 0))
+
 /**
- * @brief   MSC state machine initialization.
+ * @brief   Reads a big endian 16 bits value.
+ */
+#define get_be16(p) (((uint32_t)(p)[0] << 8) | ((uint32_t)(p)[1] << 0))
+
+/**
+ * @brief   Writes a big endian 32 bits value.
+ */
+#define put_be32(p, v) {                                                    \
+  (p)[0] = (uint8_t)((v) >> 24);                                            \
+  (p)[1] = (uint8_t)((v) >> 16);                                            \
+  (p)[2] = (uint8_t)((v) >> 8);                                             \
+  (p)[3] = (uint8_t)((v) >> 0);                                             \
+}
+
+/**
+ * @brief   Wakes up the worker thread.
+ * @note    This function must be called from a locked state.
  *
- * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] msg       wakeup message
  */
-static void msc_reset(USBDriver *usbp) {
+static void msc_wakeup_i(msg_t msg) {
 
-  msc_state = MSC_IDLE;
-  chSysLockFromIsr();
-  usbStartReceiveI(usbp, MSC_DATA_OUT_EP, (uint8_t *)&CBW, sizeof CBW);
-  chSysUnlockFromIsr();
+  if (msc_thread != NULL) {
+    Thread *tp = msc_thread;
+    msc_thread = NULL;
+    tp->p_u.rdymsg = msg;
+    chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Aborts the current command.
+ * @note    This function must be called from a locked state.
+ */
+static void msc_abort_i(void) {
+
+  msc_aborted = TRUE;
+  msc_tx_busy = FALSE;
+  msc_rx_busy = FALSE;
+  msc_wakeup_i(RDY_RESET);
+}
+
+/**
+ * @brief   Waits for an endpoint event.
+ * @note    This function must be called from a locked state.
+ *
+ * @return              The wakeup message.
+ * @retval RDY_OK       endpoint event.
+ * @retval RDY_RESET    the command has been aborted.
+ */
+static msg_t msc_wait_s(void) {
+
+  if (msc_aborted)
+    return RDY_RESET;
+  msc_thread = chThdSelf();
+  chSchGoSleepS(THD_STATE_SUSPENDED);
+  return chThdSelf()->p_u.rdymsg;
+}
+
+/**
+ * @brief   Samples an endpoint busy flag.
+ *
+ * @param[in] flagp     pointer to the endpoint busy flag
+ * @param[out] busyp    sampled flag value
+ * @return              The command status.
+ * @retval RDY_OK       command in progress.
+ * @retval RDY_RESET    the command has been aborted.
+ */
+static msg_t msc_poll(const bool_t *flagp, bool_t *busyp) {
+  msg_t msg;
+
+  chSysLock();
+  *busyp = *flagp;
+  msg = msc_aborted ? RDY_RESET : RDY_OK;
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Starts a transmit operation on the IN endpoint.
+ *
+ * @param[in] p         pointer to the data
+ * @param[in] n         number of bytes
+ */
+static void msc_start_transmit(const uint8_t *p, size_t n) {
+  USBDriver *usbp = msc_config->usbp;
+
+  chSysLock();
+  if (msc_aborted || (usbGetDriverStateI(usbp) != USB_ACTIVE)) {
+    chSysUnlock();
+    return;
+  }
+  chSysUnlock();
+  usbPrepareTransmit(usbp, MSC_DATA_IN_EP, p, n);
+  chSysLock();
+  msc_tx_busy = TRUE;
+  usbStartTransmitI(usbp, MSC_DATA_IN_EP);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Starts a receive operation on the OUT endpoint.
+ *
+ * @param[out] p        pointer to the data buffer
+ * @param[in] n         number of bytes
+ */
+static void msc_start_receive(uint8_t *p, size_t n) {
+  USBDriver *usbp = msc_config->usbp;
+
+  chSysLock();
+  if (msc_aborted || (usbGetDriverStateI(usbp) != USB_ACTIVE)) {
+    chSysUnlock();
+    return;
+  }
+  chSysUnlock();
+  usbPrepareReceive(usbp, MSC_DATA_OUT_EP, p, n);
+  chSysLock();
+  msc_rx_busy = TRUE;
+  usbStartReceiveI(usbp, MSC_DATA_OUT_EP);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Waits for the IN endpoint transmit operation to finish.
+ *
+ * @return              The operation status.
+ * @retval RDY_OK       transmit finished.
+ * @retval RDY_RESET    the command has been aborted.
+ */
+static msg_t msc_wait_transmit(void) {
+  msg_t msg = RDY_OK;
+
+  chSysLock();
+  while (msc_tx_busy && (msg == RDY_OK))
+    msg = msc_wait_s();
+  if (msc_aborted)
+    msg = RDY_RESET;
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Waits for the OUT endpoint receive operation to finish.
+ *
+ * @return              The operation status.
+ * @retval RDY_OK       receive finished.
+ * @retval RDY_RESET    the command has been aborted.
+ */
+static msg_t msc_wait_receive(void) {
+  msg_t msg = RDY_OK;
+
+  chSysLock();
+  while (msc_rx_busy && (msg == RDY_OK))
+    msg = msc_wait_s();
+  if (msc_aborted)
+    msg = RDY_RESET;
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Sets the sense data of the current command.
+ *
+ * @param[in] key       sense key
+ * @param[in] asc       additional sense code
+ */
+static void msc_sense(uint8_t key, uint8_t asc) {
+
+  msc_sense_key = key;
+  msc_sense_asc = asc;
 }
 
-static void msc_transmit(USBDriver *usbp, const uint8_t *p, size_t n) {
+/**
+ * @brief   Transmits a short answer.
+ * @details The answer is truncated to the length requested by the host.
+ *
+ * @param[in] p         pointer to the data
+ * @param[in] n         number of bytes
+ * @return              The command status.
+ */
+static msg_t msc_transmit(const uint8_t *p, size_t n) {
 
   if (n > CBW.dCBWDataTransferLength)
     n = CBW.dCBWDataTransferLength;
   CSW.dCSWDataResidue = CBW.dCBWDataTransferLength - (uint32_t)n;
-  chSysLockFromIsr();
-  usbStartTransmitI(usbp, MSC_DATA_IN_EP, p, n);
-  chSysUnlockFromIsr();
+  msc_state = MSC_DATA_IN;
+  msc_start_transmit(p, n);
+  return msc_wait_transmit();
 }
 
-static void msc_sendstatus(USBDriver *usbp) {
+/**
+ * @brief   Completes the data phase without transferring data.
+ * @details Fill data is sent to the host or the host data is discarded so
+ *          the transfer length expected by the host is honored.
+ *
+ * @param[in] n         number of bytes
+ * @return              The command status.
+ */
+static msg_t msc_skip(uint32_t n) {
+  uint8_t *bp = (uint8_t *)msc_buffers[0];
+  bool_t in = (CBW.bmCBWFlags & 0x80) != 0;
+  msg_t msg = RDY_OK;
+
+  if (in) {
+    msc_state = MSC_DATA_IN;
+    memset(bp, 0, MSC_BUFFER_SIZE);
+  }
+  else
+    msc_state = MSC_DATA_OUT;
+  while ((n > 0) && (msg == RDY_OK)) {
+    size_t chunk = n < MSC_BUFFER_SIZE ? n : MSC_BUFFER_SIZE;
+
+    if (in) {
+      msc_start_transmit(bp, chunk);
+      msg = msc_wait_transmit();
+    }
+    else {
+      msc_start_receive(bp, chunk);
+      msg = msc_wait_receive();
+    }
+    n -= chunk;
+  }
+  return msg;
+}
 
-  msc_state = MSC_SENDING_CSW;
-  chSysLockFromIsr();
-  usbStartTransmitI(usbp, MSC_DATA_IN_EP, (uint8_t *)&CSW, sizeof CSW);
-  chSysUnlockFromIsr();
+/**
+ * @brief   Fails the current command.
+ *
+ * @param[in] key       sense key
+ * @param[in] asc       additional sense code
+ * @return              The command status.
+ */
+static msg_t msc_fail(uint8_t key, uint8_t asc) {
+
+  msc_sense(key, asc);
+  CSW.bCSWStatus = MSC_CSW_STATUS_FAILED;
+  CSW.dCSWDataResidue = CBW.dCBWDataTransferLength;
+  return msc_skip(CBW.dCBWDataTransferLength);
+}
+
+/**
+ * @brief   Returns the number of blocks in a data phase chunk.
+ *
+ * @param[in] xfp       pointer to the transfer descriptor
+ * @param[in] i         chunk index
+ */
+#define chunk_blocks(xfp, i)                                                \
+  ((xfp)->blocks - (i) * MSC_BUFFER_BLOCKS < MSC_BUFFER_BLOCKS ?            \
+   (xfp)->blocks - (i) * MSC_BUFFER_BLOCKS : MSC_BUFFER_BLOCKS)
+
+/**
+ * @brief   Returns the data phase buffer associated to a chunk.
+ *
+ * @param[in] i         chunk index
+ */
+#define chunk_buffer(i) ((uint8_t *)msc_buffers[(i) % MSC_BUFFERS])
+
+/**
+ * @brief   Pipelined READ(10) data phase.
+ * @details The next chunks are read from the block device while the
+ *          previous ones are being transmitted over the IN endpoint.
+ *
+ * @param[in,out] xfp   pointer to the transfer descriptor
+ * @return              The command status.
+ */
+static msg_t msc_read_pipe(msctransfer_t *xfp) {
+  BaseBlockDevice *bdp = msc_config->bdp;
+  uint32_t nchunks = (xfp->blocks + MSC_BUFFER_BLOCKS - 1) /
+                     MSC_BUFFER_BLOCKS;
+  uint32_t rd = 0, tx = 0;
+  bool_t busy;
+
+  msc_state = MSC_DATA_IN;
+  while (msc_poll(&msc_tx_busy, &busy) == RDY_OK) {
+    /* The next chunk is transmitted as soon as the endpoint is free.*/
+    if (!busy && (tx < rd)) {
+      msc_start_transmit(chunk_buffer(tx),
+                         chunk_blocks(xfp, tx) * MSC_BLOCK_SIZE);
+      tx++;
+      continue;
+    }
+
+    /* Reading ahead while there are free buffers, a buffer is in use
+       until its transmission is complete.*/
+    if ((rd < nchunks) && (rd - tx + (busy ? 1 : 0) < MSC_BUFFERS)) {
+      uint32_t n = chunk_blocks(xfp, rd);
+      msctime_t t = msc_now();
+
+      if ((xfp->status == MSC_CSW_STATUS_PASSED) &&
+          blkRead(bdp, xfp->startblk + rd * MSC_BUFFER_BLOCKS,
+                  chunk_buffer(rd), n)) {
+        msc_sense(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_READ_ERROR);
+        xfp->status = MSC_CSW_STATUS_FAILED;
+      }
+      xfp->devtime += msc_elapsed(t);
+
+      /* After an error the data phase is completed with fill data.*/
+      if (xfp->status != MSC_CSW_STATUS_PASSED)
+        memset(chunk_buffer(rd), 0, n * MSC_BLOCK_SIZE);
+      rd++;
+      continue;
+    }
+
+    if (!busy)
+      return RDY_OK;
+    msc_wait_transmit();
+  }
+  return RDY_RESET;
+}
+
+/**
+ * @brief   Pipelined WRITE(10) data phase.
+ * @details The next chunks are received over the OUT endpoint while the
+ *          previous ones are being written on the block device.
+ *
+ * @param[in,out] xfp   pointer to the transfer descriptor
+ * @return              The command status.
+ */
+static msg_t msc_write_pipe(msctransfer_t *xfp) {
+  BaseBlockDevice *bdp = msc_config->bdp;
+  uint32_t nchunks = (xfp->blocks + MSC_BUFFER_BLOCKS - 1) /
+                     MSC_BUFFER_BLOCKS;
+  uint32_t rx = 0, wr = 0;
+  bool_t busy;
+
+  msc_state = MSC_DATA_OUT;
+  while (msc_poll(&msc_rx_busy, &busy) == RDY_OK) {
+    /* The next chunk is received as soon as the endpoint is free and
+       a buffer is available.*/
+    if (!busy && (rx < nchunks) && (rx - wr < MSC_BUFFERS)) {
+      msc_start_receive(chunk_buffer(rx),
+                        chunk_blocks(xfp, rx) * MSC_BLOCK_SIZE);
+      rx++;
+      continue;
+    }
+
+    /* Writing the received chunks.*/
+    if (wr < rx - (busy ? 1 : 0)) {
+      msctime_t t = msc_now();
+
+      /* After an error the remaining data is discarded.*/
+      if ((xfp->status == MSC_CSW_STATUS_PASSED) &&
+          blkWrite(bdp, xfp->startblk + wr * MSC_BUFFER_BLOCKS,
+                   chunk_buffer(wr), chunk_blocks(xfp, wr))) {
+        msc_sense(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_WRITE_ERROR);
+        xfp->status = MSC_CSW_STATUS_FAILED;
+      }
+      xfp->devtime += msc_elapsed(t);
+      wr++;
+      continue;
+    }
+
+    if (!busy)
+      return RDY_OK;
+    msc_wait_receive();
+  }
+  return RDY_RESET;
+}
+
+/**
+ * @brief   READ(10) and WRITE(10) commands.
+ *
+ * @param[in] bdip      pointer to the device information or @p NULL if the
+ *                      device is not ready
+ * @return              The command status.
+ */
+static msg_t msc_read_write(const BlockDeviceInfo *bdip) {
+  bool_t write = CBW.CBWCB[0] == SCSI_WRITE10;
+  msctime_t start = msc_now();
+  msctransfer_t xfer;
+  msg_t msg;
+
+  xfer.opcode   = CBW.CBWCB[0];
+  xfer.status   = MSC_CSW_STATUS_PASSED;
+  xfer.startblk = get_be32(&CBW.CBWCB[2]);
+  xfer.blocks   = get_be16(&CBW.CBWCB[7]);
+  xfer.devtime  = 0;
+
+  if (bdip == NULL)
+    return msc_fail(SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+  if ((xfer.startblk >= bdip->blk_num) ||
+      (xfer.blocks > bdip->blk_num - xfer.startblk))
+    return msc_fail(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_LBA_OUT_OF_RANGE);
+
+  /* The host and device expectations must match, 6.7.*/
+  if ((CBW.dCBWDataTransferLength != xfer.blocks * MSC_BLOCK_SIZE) ||
+      (((CBW.bmCBWFlags & 0x80) != 0) == write)) {
+    CSW.bCSWStatus = MSC_CSW_STATUS_PHASE_ERROR;
+    CSW.dCSWDataResidue = CBW.dCBWDataTransferLength;
+    return msc_skip(CBW.dCBWDataTransferLength);
+  }
+  if (write && blkIsWriteProtected(msc_config->bdp))
+    return msc_fail(SCSI_SENSE_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED);
+
+  msg = write ? msc_write_pipe(&xfer) : msc_read_pipe(&xfer);
+  if (msg != RDY_OK)
+    return msg;
+  CSW.bCSWStatus = xfer.status;
+  CSW.dCSWDataResidue = 0;
+
+  if (msc_config->transfer_cb != NULL) {
+    xfer.time = msc_elapsed(start);
+    xfer.throughput = xfer.time > 0 ?
+                      (uint32_t)((uint64_t)xfer.blocks * MSC_BLOCK_SIZE *
+                                 1000000 / xfer.time) : 0;
+    msc_config->transfer_cb(&xfer);
+  }
+  return RDY_OK;
 }
 
-static bool_t msc_decode(USBDriver *usbp) {
-  uint32_t nblocks, secsize;
+/**
+ * @brief   SCSI command decoder.
+ *
+ * @return              The command status.
+ * @retval RDY_OK       command executed, the CSW is ready.
+ * @retval RDY_RESET    the command has been aborted.
+ */
+static msg_t msc_scsi(void) {
+  BaseBlockDevice *bdp = msc_config->bdp;
+  BlockDeviceInfo bdi;
+  bool_t ready;
+
+  ready = (blkGetDriverState(bdp) == BLK_READY) &&
+          (blkGetInfo(bdp, &bdi) == CH_SUCCESS) &&
+          (bdi.blk_size == MSC_BLOCK_SIZE);
+  CSW.bCSWStatus      = MSC_CSW_STATUS_PASSED;
+  CSW.dCSWDataResidue = CBW.dCBWDataTransferLength;
+  if (CBW.CBWCB[0] != SCSI_REQUEST_SENSE)
+    msc_sense(SCSI_SENSE_NO_SENSE, 0);
 
   switch (CBW.CBWCB[0]) {
-  case SCSI_REQUEST_SENSE:
+  case SCSI_TEST_UNIT_READY:
+    if (!ready)
+      return msc_fail(SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
     break;
+  case SCSI_REQUEST_SENSE:
+    memset(buf, 0, 18);
+    buf[0]  = 0x70;                 /* Current errors, fixed format.      */
+    buf[2]  = msc_sense_key;
+    buf[7]  = 18 - 8;               /* Additional sense length.           */
+    buf[12] = msc_sense_asc;
+    msc_sense(SCSI_SENSE_NO_SENSE, 0);
+    return msc_transmit(buf, 18);
   case SCSI_INQUIRY:
-    msc_transmit(usbp, (uint8_t *)&scsi_inquiry_data,
-                 sizeof scsi_inquiry_data);
-    CSW.bCSWStatus = MSC_CSW_STATUS_PASSED;
-    break;
+    return msc_transmit(scsi_inquiry_data, sizeof scsi_inquiry_data);
   case SCSI_READ_FORMAT_CAPACITIES:
-    buf[8]  = scsi_read_format_capacities(&nblocks, &secsize);
     buf[0]  = buf[1] = buf[2] = 0;
     buf[3]  = 8;
-    buf[4]  = (uint8_t)(nblocks >> 24);
-    buf[5]  = (uint8_t)(nblocks >> 16);
-    buf[6]  = (uint8_t)(nblocks >> 8);
-    buf[7]  = (uint8_t)(nblocks >> 0);
-    buf[9]  = (uint8_t)(secsize >> 16);
-    buf[10] = (uint8_t)(secsize >> 8);
-    buf[11] = (uint8_t)(secsize >> 0);
-    msc_transmit(usbp, buf, 12);
-    CSW.bCSWStatus = MSC_CSW_STATUS_PASSED;
+    put_be32(&buf[4], ready ? bdi.blk_num : 0);
+    buf[8]  = ready ? 2 : 3;        /* Formatted media or no media.       */
+    buf[9]  = (uint8_t)(MSC_BLOCK_SIZE >> 16);
+    buf[10] = (uint8_t)(MSC_BLOCK_SIZE >> 8);
+    buf[11] = (uint8_t)(MSC_BLOCK_SIZE >> 0);
+    return msc_transmit(buf, 12);
+  case SCSI_READ_CAPACITY10:
+    if (!ready)
+      return msc_fail(SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    put_be32(&buf[0], bdi.blk_num - 1);
+    put_be32(&buf[4], MSC_BLOCK_SIZE);
+    return msc_transmit(buf, 8);
+  case SCSI_MODE_SENSE6:
+    buf[0] = 3;                     /* Mode data length.                  */
+    buf[1] = 0;
+    buf[2] = blkIsWriteProtected(bdp) ? 0x80 : 0x00;
+    buf[3] = 0;
+    return msc_transmit(buf, 4);
+  case SCSI_ALLOW_MEDIUM_REMOVAL:
+  case SCSI_VERIFY10:
+    break;
+  case SCSI_START_STOP_UNIT:
+  case SCSI_SYNCHRONIZE_CACHE10:
+    if (ready && blkSync(bdp))
+      return msc_fail(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_WRITE_ERROR);
     break;
+  case SCSI_READ10:
+  case SCSI_WRITE10:
+    return msc_read_write(ready ? &bdi : NULL);
   default:
-    return TRUE;
+    return msc_fail(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_COMMAND);
   }
-  return FALSE;
+
+  /* Commands without data, the host could still expect data, 6.7.*/
+  return msc_skip(CBW.dCBWDataTransferLength);
+}
+
+/**
+ * @brief   MSC worker thread.
+ * @details The thread serves the Bulk-Only transport state machine, a
+ *          reset aborts the current command and restarts from the CBW
+ *          reception.
+ */
+static msg_t msc_worker(void *arg) {
+  USBDriver *usbp = msc_config->usbp;
+
+  (void)arg;
+  chRegSetThreadName("usb_msc");
+  while (TRUE) {
+    /* Waiting for the endpoints to be configured.*/
+    chSysLock();
+    msc_state = MSC_IDLE;
+    while (usbGetDriverStateI(usbp) != USB_ACTIVE) {
+      msc_aborted = FALSE;
+      msc_wait_s();
+    }
+    msc_aborted = FALSE;
+    chSysUnlock();
+
+    /* Command phase.*/
+    msc_start_receive((uint8_t *)&CBW, sizeof CBW);
+    if (msc_wait_receive() != RDY_OK)
+      continue;
+    if ((msc_rx_size != MSC_CBW_SIZE) ||
+        (CBW.dCBWSignature != MSC_CBW_SIGNATURE)) {
+      /* Invalid CBW, the endpoints are stalled until the host performs
+         a reset recovery, 6.6.1.*/
+      chSysLock();
+      msc_state = MSC_ERROR;
+      usbStallTransmitI(usbp, MSC_DATA_IN_EP);
+      usbStallReceiveI(usbp, MSC_DATA_OUT_EP);
+      while (msc_wait_s() == RDY_OK)
+        ;
+      chSysUnlock();
+      continue;
+    }
+
+    /* Data phase.*/
+    if (msc_scsi() != RDY_OK)
+      continue;
+
+    /* Status phase.*/
+    CSW.dCSWSignature = MSC_CSW_SIGNATURE;
+    CSW.dCSWTag       = CBW.dCBWTag;
+    msc_state = MSC_SENDING_CSW;
+    msc_start_transmit((uint8_t *)&CSW, MSC_CSW_SIZE);
+    msc_wait_transmit();
+  }
+  return 0;
 }
 
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
 
+/**
+ * @brief   Starts the mass storage service.
+ * @details The worker thread is created, the commands are served after
+ *          the USB configuration has been selected.
+ *
+ * @param[in] config    pointer to the @p MSCConfig object
+ *
+ * @api
+ */
+void mscStart(const MSCConfig *config) {
+
+  chDbgCheck((config != NULL) && (config->usbp != NULL) &&
+             (config->bdp != NULL), "mscStart");
+  chDbgAssert(msc_config == NULL, "mscStart(), #1", "already started");
+
+  msc_config  = config;
+  msc_thread  = NULL;
+  msc_tx_busy = FALSE;
+  msc_rx_busy = FALSE;
+  msc_aborted = FALSE;
+  msc_sense(SCSI_SENSE_NO_SENSE, 0);
+  chThdCreateStatic(msc_wa, sizeof msc_wa, MSC_THREAD_PRIORITY,
+                    msc_worker, NULL);
+}
+
+/**
+ * @brief   USB device configured handler.
+ * @details The application must invoke this function from the
+ *          @p USB_EVENT_CONFIGURED event handler after the endpoints
+ *          initialization.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @iclass
+ */
+void mscConfigureHookI(USBDriver *usbp) {
+
+  (void)usbp;
+  msc_abort_i();
+}
+
 /**
  * @brief   Default requests hook.
  * @details The application must use this function as callback for the
@@ -191,7 +782,9 @@ bool_t mscRequestsHook(USBDriver *usbp) {
       usbSetupTransfer(usbp, (uint8_t *)zerobuf, 1, NULL);
       return TRUE;
     case MSC_MASS_STORAGE_RESET_COMMAND:
-      msc_reset(usbp);
+      chSysLockFromIsr();
+      msc_abort_i();
+      chSysUnlockFromIsr();
       usbSetupTransfer(usbp, NULL, 0, NULL);
       return TRUE;
     default:
@@ -211,24 +804,12 @@ bool_t mscRequestsHook(USBDriver *usbp) {
  */
 void mscDataTransmitted(USBDriver *usbp, usbep_t ep) {
 
-  switch (msc_state) {
-  case MSC_DATA_IN:
-    CSW.dCSWSignature = MSC_CSW_SIGNATURE;
-    CSW.dCSWTag = CBW.dCBWTag;
-    chSysLockFromIsr();
-    usbStartTransmitI(usbp, ep, (uint8_t *)&CSW, sizeof CSW);
-    chSysUnlockFromIsr();
-    msc_state = MSC_SENDING_CSW;
-    break;
-  case MSC_SENDING_CSW:
-    chSysLockFromIsr();
-    usbStartReceiveI(usbp, MSC_DATA_OUT_EP, (uint8_t *)&CBW, sizeof CBW);
-    chSysUnlockFromIsr();
-    msc_state = MSC_IDLE;
-    break;
-  default:
-    ;
-  }
+  (void)usbp;
+  (void)ep;
+  chSysLockFromIsr();
+  msc_tx_busy = FALSE;
+  msc_wakeup_i(RDY_OK);
+  chSysUnlockFromIsr();
 }
 
 /**
@@ -240,60 +821,12 @@ void mscDataTransmitted(USBDriver *usbp, usbep_t ep) {
  * @param[in] ep        endpoint number
  */
 void mscDataReceived(USBDriver *usbp, usbep_t ep) {
-  size_t n;
-
-  n = usbGetReceiveTransactionSizeI(usbp, ep);
-  switch (msc_state) {
-  case MSC_IDLE:
-    if ((n != sizeof(msccbw_t)) || (CBW.dCBWSignature != MSC_CBW_SIGNATURE))
-      goto stall_out; /* 6.6.1 */
-
-    /* Decoding SCSI command.*/
-    if (msc_decode(usbp)) {
-      if (CBW.dCBWDataTransferLength == 0) {
-        CSW.bCSWStatus = MSC_CSW_STATUS_FAILED;
-        CSW.dCSWDataResidue = 0;
-        msc_sendstatus(usbp);
-        return;
-      }
-      goto stall_both;
-    }
 
-    /* Commands with zero transfer length, 5.1.*/
-    if (CBW.dCBWDataTransferLength == 0) {
-      msc_sendstatus(usbp);
-      return;
-    }
-
-    /* Transfer direction.*/
-    if (CBW.bmCBWFlags & 0x80) {
-      /* IN, Device to Host.*/
-      msc_state = MSC_DATA_IN;
-    }
-    else {
-      /* OUT, Host to Device.*/
-      msc_state = MSC_DATA_OUT;
-    }
-    break;
-  case MSC_DATA_OUT:
-    break;
-  default:
-    ;
-  }
-  return;
-stall_out:
-  msc_state = MSC_ERROR;
-  chSysLockFromIsr();
-  usbStallReceiveI(usbp, ep);
-  chSysUnlockFromIsr();
-  return;
-stall_both:
-  msc_state = MSC_ERROR;
   chSysLockFromIsr();
-  usbStallTransmitI(usbp, ep);
-  usbStallReceiveI(usbp, ep);
+  msc_rx_size = usbGetReceiveTransactionSizeI(usbp, ep);
+  msc_rx_busy = FALSE;
+  msc_wakeup_i(RDY_OK);
   chSysUnlockFromIsr();
-  return;
 }
 
 /** @} */
@@ -14,7 +14,7 @@
     limitations under the License.
 */
 
-/*-*
+/**
  * @file    usb_msc.h
  * @brief   USB Mass Storage Class header.
  *
@@ -39,6 +39,11 @@
 #define MSC_CSW_STATUS_FAILED           1
 #define MSC_CSW_STATUS_PHASE_ERROR      2
 
+#define MSC_CBW_SIZE                    31
+#define MSC_CSW_SIZE                    13
+
+#define MSC_BLOCK_SIZE                  512
+
 
 #define SCSI_FORMAT_UNIT            0x04
 #define SCSI_INQUIRY                0x12
@@ -67,9 +72,24 @@
 #define SCSI_VERIFY12               0xAF
 #define SCSI_VERIFY16               0x8F
 
+#define SCSI_SYNCHRONIZE_CACHE10    0x35
+
 #define SCSI_SEND_DIAGNOSTIC        0x1D
 #define SCSI_READ_FORMAT_CAPACITIES 0x23
 
+#define SCSI_SENSE_NO_SENSE         0x00
+#define SCSI_SENSE_NOT_READY        0x02
+#define SCSI_SENSE_MEDIUM_ERROR     0x03
+#define SCSI_SENSE_ILLEGAL_REQUEST  0x05
+#define SCSI_SENSE_DATA_PROTECT     0x07
+
+#define SCSI_ASC_WRITE_ERROR        0x0C
+#define SCSI_ASC_READ_ERROR         0x11
+#define SCSI_ASC_INVALID_COMMAND    0x20
+#define SCSI_ASC_LBA_OUT_OF_RANGE   0x21
+#define SCSI_ASC_WRITE_PROTECTED    0x27
+#define SCSI_ASC_MEDIUM_NOT_PRESENT 0x3A
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -88,10 +108,50 @@
 #define MSC_DATA_OUT_EP         2
 #endif
 
+/**
+ * @brief   Number of data phase buffers.
+ * @details The block device is accessed on a buffer while the previous
+ *          buffers are being transferred over the bulk endpoints, more
+ *          than two buffers allow to absorb latency variations of the
+ *          block device.
+ */
+#if !defined(MSC_BUFFERS) || defined(__DOXYGEN__)
+#define MSC_BUFFERS             2
+#endif
+
+/**
+ * @brief   Size of each data phase buffer in blocks.
+ */
+#if !defined(MSC_BUFFER_BLOCKS) || defined(__DOXYGEN__)
+#define MSC_BUFFER_BLOCKS       1
+#endif
+
+/**
+ * @brief   Priority of the MSC worker thread.
+ */
+#if !defined(MSC_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define MSC_THREAD_PRIORITY     NORMALPRIO
+#endif
+
+/**
+ * @brief   Stack size of the MSC worker thread.
+ */
+#if !defined(MSC_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define MSC_THREAD_STACK_SIZE   512
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if MSC_BUFFERS < 2
+#error "MSC_BUFFERS must be at least 2"
+#endif
+
+#if MSC_BUFFER_BLOCKS < 1
+#error "MSC_BUFFER_BLOCKS must be at least 1"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -140,6 +200,64 @@ typedef struct CBW msccbw_t;
  */
 typedef struct CSW msccsw_t;
 
+/**
+ * @brief   READ(10)/WRITE(10) transfer report.
+ */
+typedef struct {
+  /**
+   * @brief SCSI operation code.
+   */
+  uint8_t           opcode;
+  /**
+   * @brief Transfer status, one of the @p MSC_CSW_STATUS_xxx values.
+   */
+  uint8_t           status;
+  /**
+   * @brief First block.
+   */
+  uint32_t          startblk;
+  /**
+   * @brief Number of blocks.
+   */
+  uint32_t          blocks;
+  /**
+   * @brief Total transfer time in microseconds.
+   */
+  uint32_t          time;
+  /**
+   * @brief Time spent accessing the block device in microseconds.
+   */
+  uint32_t          devtime;
+  /**
+   * @brief Throughput in bytes per second.
+   */
+  uint32_t          throughput;
+} msctransfer_t;
+
+/**
+ * @brief   Transfer report callback type.
+ * @note    The callback is invoked from the MSC worker thread.
+ */
+typedef void (*msctransfercb_t)(const msctransfer_t *xfp);
+
+/**
+ * @brief   MSC configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief USB driver to use.
+   */
+  USBDriver         *usbp;
+  /**
+   * @brief Exported block device.
+   */
+  BaseBlockDevice   *bdp;
+  /**
+   * @brief Transfer report callback or @p NULL.
+   */
+  msctransfercb_t   transfer_cb;
+} MSCConfig;
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -151,6 +269,8 @@ typedef struct CSW msccsw_t;
 #ifdef __cplusplus
 extern "C" {
 #endif
+  void mscStart(const MSCConfig *config);
+  void mscConfigureHookI(USBDriver *usbp);
   bool_t mscRequestsHook(USBDriver *usbp);
   void mscDataTransmitted(USBDriver *usbp, usbep_t ep);
   void mscDataReceived(USBDriver *usbp, usbep_t ep);
@@ -10,6 +10,7 @@ TESTSRC = ${CHIBIOS}/test/test.c \
           ${CHIBIOS}/test/testpools.c \
           ${CHIBIOS}/test/testdyn.c \
           ${CHIBIOS}/test/testqueues.c \
+          ${CHIBIOS}/test/testwait.c \
           ${CHIBIOS}/test/testbmk.c
 
 # Required include directories
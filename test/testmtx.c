@@ -49,6 +49,10 @@
  * - @subpage test_mtx_006
  * - @subpage test_mtx_007
  * - @subpage test_mtx_008
+ * - @subpage test_mtx_009
+ * - @subpage test_mtx_010
+ * - @subpage test_mtx_011
+ * - @subpage test_mtx_012
  * .
  * @file testmtx.c
  * @brief Mutexes and CondVars test source file
@@ -612,6 +616,256 @@ ROMCONST struct testcase testmtx8 = {
   mtx8_execute
 };
 #endif /* CH_USE_CONDVARS */
+
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_009 Locks profiling
+ *
+ * <h2>Description</h2>
+ * A mutex is registered in the locks profiler then it is locked once without
+ * contention and once with a higher priority thread waiting on it.<br>
+ * The test expects the profile record to account the acquisitions, the
+ * contention, the priority boost and non-zero wait and hold times.
+ */
+
+static LockProfile lp1;
+
+static void mtx9_setup(void) {
+
+  chMtxInit(&m1);
+  chDbgProfileMutex(&m1, &lp1, "m1");
+}
+
+static msg_t thread13(void *p) {
+
+  (void)p;
+  chMtxLock(&m1);
+  chMtxUnlock();
+  return 0;
+}
+
+static void mtx9_execute(void) {
+
+  test_assert(1, chMtxTryLock(&m1), "already locked");
+  chMtxUnlock();
+  test_assert(2, (lp1.lp_locks == 1) && (lp1.lp_contended == 0),
+              "wrong acquisitions count");
+
+  chMtxLock(&m1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() + 1,
+                                 thread13, NULL);
+  chThdSleepMilliseconds(10);
+  chMtxUnlock();
+  test_wait_threads();
+  test_assert(3, (lp1.lp_locks == 3) && (lp1.lp_contended == 1),
+              "wrong acquisitions count");
+  test_assert(4, lp1.lp_boosts == 1, "wrong boosts count");
+  test_assert(5, (lp1.lp_wait_max > 0) && (lp1.lp_hold_max > 0),
+              "no time accounted");
+  test_assert(6, chDbgGetFirstLockProfile() != NULL, "not registered");
+}
+
+ROMCONST struct testcase testmtx9 = {
+  "Mutexes, locks profiling",
+  mtx9_setup,
+  NULL,
+  mtx9_execute
+};
+#endif /* CH_DBG_LOCKS_PROFILING */
+
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_010 Priority ceiling mutexes
+ *
+ * <h2>Description</h2>
+ * A priority ceiling mutex is locked by the test thread and two threads,
+ * with priorities higher than the test thread but lower than the ceiling,
+ * are created while the mutex is owned.<br>
+ * The test expects the test thread to run at the ceiling priority while
+ * owning the mutex, the other threads to not preempt it and the original
+ * priority to be restored when the mutex is released.
+ */
+
+static void mtx10_setup(void) {
+
+  chMtxInitCeiling(&m1, chThdGetPriority() + 3);
+}
+
+static void mtx10_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  chMtxLock(&m1);
+  test_assert(1, chThdGetPriority() == prio + 3, "wrong priority level");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread1, "B");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 2, thread1, "A");
+  test_emit_token('C');
+  chMtxUnlock();
+  test_assert(2, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+  test_assert_sequence(3, "CAB");
+
+  test_assert(4, chMtxTryLock(&m1), "already locked");
+  test_assert(5, chThdGetPriority() == prio + 3, "wrong priority level");
+  chMtxUnlock();
+  test_assert(6, chThdGetPriority() == prio, "wrong priority level");
+}
+
+ROMCONST struct testcase testmtx10 = {
+  "Mutexes, priority ceiling",
+  mtx10_setup,
+  NULL,
+  mtx10_execute
+};
+#endif /* CH_USE_MUTEXES_CEILING */
+
+#if CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_011 Recursive mutexes
+ *
+ * <h2>Description</h2>
+ * A recursive mutex is locked three times by the test thread then an higher
+ * priority thread tries to lock it. The test thread then performs the unlock
+ * operations, the test expects the priority boost to be kept and the mutex
+ * to be owned until the last unlock.<br>
+ * In the second part the recursive mutex is locked again while a normal
+ * mutex is on top of the owned mutexes stack, the test expects the unlocks
+ * to be performed in lock-reverse order and the normal mutex not to be
+ * lockable again by its owner.<br>
+ * In the third part the mutexes are locked, one of them recursively, and
+ * then released using @p chMtxUnlockAll(), the test expects both mutexes to
+ * be released and the recursion counter to restart from zero.
+ */
+
+static void mtx11_setup(void) {
+
+  chMtxInitRecursive(&m1);
+  chMtxInit(&m2);
+}
+
+static msg_t thread14(void *p) {
+
+  chMtxLock(&m2);
+  test_emit_token(*(char *)p);
+  chMtxUnlock();
+  return 0;
+}
+
+static void mtx11_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  chMtxLock(&m1);
+  test_assert(1, chMtxTryLock(&m1), "nested lock failed");
+  chMtxLock(&m1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread1, "A");
+  test_assert(2, chThdGetPriority() == prio + 1, "not boosted");
+  test_assert(3, chMtxUnlock() == &m1, "wrong mutex");
+  test_assert(4, chMtxUnlock() == &m1, "wrong mutex");
+  test_assert(5, m1.m_owner == chThdSelf(), "not owned");
+  test_assert(6, chThdGetPriority() == prio + 1, "boost lost");
+  test_assert_sequence(7, "");
+  test_assert(8, chMtxUnlock() == &m1, "wrong mutex");
+  test_assert(9, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+  test_assert_sequence(10, "A");
+
+  /* Nested lock of a mutex that is not on top of the stack.*/
+  chMtxLock(&m1);
+  chMtxLock(&m2);
+  test_assert(11, !chMtxTryLock(&m2), "normal mutex locked again");
+  chMtxLock(&m1);
+  test_assert(12, chMtxTryLock(&m1), "nested lock failed");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread14, "B");
+  test_assert(13, chThdGetPriority() == prio + 1, "not boosted");
+  chMtxUnlock();
+  chMtxUnlock();
+  test_assert(14, (m1.m_owner == chThdSelf()) && (m2.m_owner == chThdSelf()),
+              "released too early");
+  test_assert(15, chThdGetPriority() == prio + 1, "boost lost");
+  test_assert_sequence(16, "");
+  test_assert(17, chMtxUnlock() == &m2, "wrong mutex");
+  test_assert_sequence(18, "B");
+  test_assert(19, chThdGetPriority() == prio, "wrong priority level");
+  test_assert(20, m1.m_owner == chThdSelf(), "not owned");
+  test_assert(21, chMtxUnlock() == &m1, "wrong mutex");
+  test_assert(22, m1.m_owner == NULL, "still owned");
+  test_wait_threads();
+
+  chMtxLock(&m1);
+  chMtxLock(&m1);
+  chMtxLock(&m2);
+  chMtxUnlockAll();
+  test_assert(23, (m1.m_owner == NULL) && (m2.m_owner == NULL),
+              "still owned");
+  chMtxLock(&m1);
+  chMtxUnlock();
+  test_assert(24, m1.m_owner == NULL, "still owned");
+}
+
+ROMCONST struct testcase testmtx11 = {
+  "Mutexes, recursive locks",
+  mtx11_setup,
+  NULL,
+  mtx11_execute
+};
+#endif /* CH_USE_MUTEXES_RECURSIVE */
+
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_012 Priority inheritance and ceiling mixed
+ *
+ * <h2>Description</h2>
+ * The test thread locks a priority inheritance mutex and then a priority
+ * ceiling mutex, while owning both it sleeps allowing a thread with
+ * priority between its own and the ceiling to block on the first mutex.<br>
+ * The test expects the inherited priority to be kept when the ceiling
+ * mutex is released and the original priority to be restored when the
+ * inheritance mutex is released. The test is performed using both
+ * @p chMtxUnlock() and @p chMtxUnlockS().
+ */
+
+static void mtx12_setup(void) {
+
+  chMtxInit(&m1);
+  chMtxInitCeiling(&m2, chThdGetPriority() + 3);
+}
+
+static void mtx12_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  chMtxLock(&m1);
+  chMtxLock(&m2);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread1, "A");
+  chThdSleepMilliseconds(10);
+  test_assert(1, chThdGetPriority() == prio + 3, "wrong priority level");
+  chMtxUnlock();
+  test_assert(2, chThdGetPriority() == prio + 1, "boost lost");
+  chMtxUnlock();
+  test_assert(3, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+  test_assert_sequence(4, "A");
+
+  chMtxLock(&m1);
+  chMtxLock(&m2);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread1, "B");
+  chThdSleepMilliseconds(10);
+  chSysLock();
+  chMtxUnlockS();
+  chSchRescheduleS();
+  chSysUnlock();
+  test_assert(5, chThdGetPriority() == prio + 1, "boost lost");
+  chMtxUnlock();
+  test_assert(6, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+  test_assert_sequence(7, "B");
+}
+
+ROMCONST struct testcase testmtx12 = {
+  "Mutexes, priority inheritance and ceiling",
+  mtx12_setup,
+  NULL,
+  mtx12_execute
+};
+#endif /* CH_USE_MUTEXES_CEILING */
 #endif /* CH_USE_MUTEXES */
 
 /**
@@ -631,6 +885,18 @@ ROMCONST struct testcase * ROMCONST patternmtx[] = {
   &testmtx7,
   &testmtx8,
 #endif
+#if CH_DBG_LOCKS_PROFILING || defined(__DOXYGEN__)
+  &testmtx9,
+#endif
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+  &testmtx10,
+#endif
+#if CH_USE_MUTEXES_RECURSIVE || defined(__DOXYGEN__)
+  &testmtx11,
+#endif
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+  &testmtx12,
+#endif
 #endif
   NULL
 };
@@ -0,0 +1,313 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_wait Multiple objects wait test
+ *
+ * File: @ref testwait.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref waitmultiple
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref waitmultiple
+ * code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_WAITMULTIPLE
+ * - @p CH_USE_SEMAPHORES
+ * - @p CH_USE_MAILBOXES
+ * - @p CH_USE_QUEUES
+ * - @p CH_USE_EVENTS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_wait_001
+ * - @subpage test_wait_002
+ * - @subpage test_wait_003
+ * .
+ * @file testwait.c
+ * @brief Multiple objects wait test source file
+ * @file testwait.h
+ * @brief Multiple objects wait test header file
+ */
+
+#if (CH_USE_WAITMULTIPLE && CH_USE_SEMAPHORES && CH_USE_MAILBOXES &&        \
+     CH_USE_QUEUES && CH_USE_EVENTS) || defined(__DOXYGEN__)
+
+#define ALLOWED_DELAY MS2ST(5)
+#define WAIT_QUEUES_SIZE 4
+#define WAIT_MB_SIZE 4
+
+static SEMAPHORE_DECL(sem1, 0);
+static EVENTSOURCE_DECL(es1);
+static uint8_t iqbuf[WAIT_QUEUES_SIZE];
+static uint8_t oqbuf[WAIT_QUEUES_SIZE];
+static INPUTQUEUE_DECL(iq, iqbuf, WAIT_QUEUES_SIZE, NULL, NULL);
+static OUTPUTQUEUE_DECL(oq, oqbuf, WAIT_QUEUES_SIZE, NULL, NULL);
+static msg_t mbbuf[WAIT_MB_SIZE];
+static MAILBOX_DECL(mb1, mbbuf, WAIT_MB_SIZE);
+
+/*
+ * Note, the static initializers are not really required because the
+ * descriptors are explicitly initialized in each test case. It is done in
+ * order to test the macros.
+ */
+static WaitObject wobjs[5] = {
+  _WAITOBJECT_DATA(WAIT_SEMAPHORE, &sem1),
+  _WAITOBJECT_DATA(WAIT_INPUTQUEUE, &iq),
+  _WAITOBJECT_DATA(WAIT_OUTPUTQUEUE, &oq),
+  _WAITOBJECT_DATA(WAIT_MAILBOX, &mb1),
+  _WAITOBJECT_DATA(WAIT_EVENTSOURCE, &es1)
+};
+
+static void wait_setup(void) {
+  unsigned i;
+
+  chSemInit(&sem1, 0);
+  chEvtInit(&es1);
+  chIQInit(&iq, iqbuf, WAIT_QUEUES_SIZE, NULL, NULL);
+  chOQInit(&oq, oqbuf, WAIT_QUEUES_SIZE, NULL, NULL);
+  chMBInit(&mb1, mbbuf, WAIT_MB_SIZE);
+
+  /* The output queue is filled in order to make it not ready.*/
+  for (i = 0; i < WAIT_QUEUES_SIZE; i++)
+    chOQPut(&oq, 'A' + i);
+
+  chWaitObjectInit(&wobjs[0], WAIT_SEMAPHORE, &sem1);
+  chWaitObjectInit(&wobjs[1], WAIT_INPUTQUEUE, &iq);
+  chWaitObjectInit(&wobjs[2], WAIT_OUTPUTQUEUE, &oq);
+  chWaitObjectInit(&wobjs[3], WAIT_MAILBOX, &mb1);
+  chWaitObjectInit(&wobjs[4], WAIT_EVENTSOURCE, &es1);
+}
+
+static bool_t wait_detached(void) {
+
+  return (sem1.s_wlist == NULL) && (iq.q_wlist == NULL) &&
+         (oq.q_wlist == NULL) && (mb1.mb_fullsem.s_wlist == NULL) &&
+         (es1.es_wlist == NULL);
+}
+
+/**
+ * @page test_wait_001 Ready objects and timeouts
+ *
+ * <h2>Description</h2>
+ * The objects are made ready one at time without waiting, the test expects
+ * @p chWaitMultiple() to return immediately reporting the ready objects.
+ * Then the test verifies that the function times out with no ready objects,
+ * both immediately and after a delay.
+ */
+
+static void wait1_execute(void) {
+  eventmask_t m;
+  systime_t target_time;
+
+  m = chWaitMultiple(wobjs, 5, TIME_IMMEDIATE);
+  test_assert(1, m == 0, "spurious ready object");
+
+  chSemSignal(&sem1);
+  m = chWaitMultiple(wobjs, 5, TIME_INFINITE);
+  test_assert(2, m == 1, "semaphore not ready");
+  chSemWait(&sem1);
+
+  chSysLock();
+  chIQPutI(&iq, 'A');
+  chSysUnlock();
+  m = chWaitMultiple(wobjs, 5, TIME_INFINITE);
+  test_assert(3, m == 2, "input queue not ready");
+  chIQGet(&iq);
+
+  chSysLock();
+  chOQGetI(&oq);
+  chSysUnlock();
+  m = chWaitMultiple(wobjs, 5, TIME_INFINITE);
+  test_assert(4, m == 4, "output queue not ready");
+  chOQPut(&oq, 'A');
+
+  chMBPost(&mb1, 'A', TIME_INFINITE);
+  m = chWaitMultiple(wobjs, 5, TIME_INFINITE);
+  test_assert(5, m == 8, "mailbox not ready");
+  chMBReset(&mb1);
+
+  test_wait_tick();
+  target_time = chTimeNow() + MS2ST(10);
+  m = chWaitMultiple(wobjs, 5, MS2ST(10));
+  test_assert_time_window(6, target_time, target_time + ALLOWED_DELAY);
+  test_assert(7, m == 0, "spurious ready object");
+  test_assert(8, wait_detached(), "descriptors still attached");
+}
+
+ROMCONST struct testcase testwait1 = {
+  "Wait multiple, ready objects and timeouts",
+  wait_setup,
+  NULL,
+  wait1_execute
+};
+
+/**
+ * @page test_wait_002 Wait and wakeup
+ *
+ * <h2>Description</h2>
+ * A thread waits on all the objects, a lower priority thread makes one of the
+ * objects ready after a fixed delay. The test is repeated for each object
+ * type, the test expects the waiting thread to be awakened at the right time
+ * with only the right object reported as ready and all the descriptors
+ * detached from the objects.
+ */
+
+static msg_t thread(void *p) {
+
+  chThdSleepMilliseconds(50);
+  switch (*(char *)p) {
+  case 'S':
+    chSemSignal(&sem1);
+    break;
+  case 'I':
+    chSysLock();
+    chIQPutI(&iq, 'A');
+    chSchRescheduleS();
+    chSysUnlock();
+    break;
+  case 'O':
+    chSysLock();
+    chOQGetI(&oq);
+    chSchRescheduleS();
+    chSysUnlock();
+    break;
+  case 'M':
+    chMBPost(&mb1, 'A', TIME_INFINITE);
+    break;
+  case 'E':
+    chEvtBroadcast(&es1);
+    break;
+  }
+  return 0;
+}
+
+static void wait2_execute(void) {
+  static char objects[] = "SIOME";
+  eventmask_t m;
+  systime_t target_time;
+  unsigned i;
+
+  for (i = 0; i < sizeof(objects) - 1; i++) {
+    /* Objects reinitialized in order to consume the previous ready state.*/
+    wait_setup();
+    test_wait_tick();
+    target_time = chTimeNow() + MS2ST(50);
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() - 1,
+                                   thread, &objects[i]);
+    m = chWaitMultiple(wobjs, 5, TIME_INFINITE);
+    test_assert_time_window(i * 3 + 1, target_time,
+                            target_time + ALLOWED_DELAY);
+    test_assert(i * 3 + 2, m == ((eventmask_t)1 << i), "wrong ready mask");
+    test_assert(i * 3 + 3, wait_detached(), "descriptors still attached");
+    test_wait_threads();
+  }
+}
+
+ROMCONST struct testcase testwait2 = {
+  "Wait multiple, wait and wakeup",
+  NULL,
+  NULL,
+  wait2_execute
+};
+
+/**
+ * @page test_wait_003 Consumed wakeup
+ *
+ * <h2>Description</h2>
+ * A higher priority thread waits on all the objects, the semaphore is
+ * signaled and consumed again before the waiting thread is able to run. The
+ * test expects the thread to go back waiting, without and with a timeout,
+ * and to report the semaphore when it is signaled again or to time out at
+ * the originally specified time.
+ */
+
+static eventmask_t wait3_mask;
+
+static msg_t thread3(void *p) {
+
+  wait3_mask = chWaitMultiple(wobjs, 5, *(systime_t *)p);
+  return 0;
+}
+
+static void wait3_consume(void) {
+
+  chSysLock();
+  chSemSignalI(&sem1);
+  chSemFastWaitI(&sem1);
+  chSysUnlock();
+}
+
+static void wait3_execute(void) {
+  static systime_t time;
+  systime_t target_time;
+
+  time = TIME_INFINITE;
+  wait3_mask = (eventmask_t)-1;
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() + 1,
+                                 thread3, &time);
+  wait3_consume();
+  chThdSleepMilliseconds(10);
+  test_assert(1, wait3_mask == (eventmask_t)-1, "thread not waiting");
+  chSemSignal(&sem1);
+  test_assert(2, wait3_mask == 1, "wrong ready mask");
+  test_wait_threads();
+  test_assert(3, wait_detached(), "descriptors still attached");
+
+  wait_setup();
+  test_wait_tick();
+  time = MS2ST(50);
+  target_time = chTimeNow() + time;
+  wait3_mask = (eventmask_t)-1;
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() + 1,
+                                 thread3, &time);
+  chThdSleepMilliseconds(10);
+  wait3_consume();
+  test_wait_threads();
+  test_assert_time_window(4, target_time, target_time + ALLOWED_DELAY);
+  test_assert(5, wait3_mask == 0, "spurious ready object");
+  test_assert(6, wait_detached(), "descriptors still attached");
+}
+
+ROMCONST struct testcase testwait3 = {
+  "Wait multiple, consumed wakeup",
+  wait_setup,
+  NULL,
+  wait3_execute
+};
+#endif /* CH_USE_WAITMULTIPLE */
+
+/**
+ * @brief   Test sequence for multiple objects wait.
+ */
+ROMCONST struct testcase * ROMCONST patternwait[] = {
+#if (CH_USE_WAITMULTIPLE && CH_USE_SEMAPHORES && CH_USE_MAILBOXES &&        \
+     CH_USE_QUEUES && CH_USE_EVENTS) || defined(__DOXYGEN__)
+  &testwait1,
+  &testwait2,
+  &testwait3,
+#endif
+  NULL
+};
@@ -21,7 +21,8 @@
  * SDIO configuration.
  */
 static const SDCConfig sdccfg = {
-  0
+  SDC_MODE_4BIT,
+  SDC_CLK_50MHz
 };
 
 static uint8_t blkbuf[MMCSD_BLOCK_SIZE * 4 + 1];
@@ -20,6 +20,25 @@
 
 #include "usb_msc.h"
 
+/*===========================================================================*/
+/* Card related stuff.                                                       */
+/*===========================================================================*/
+
+/*
+ * MMC driver instance.
+ */
+MMCDriver MMCD1;
+
+/* Maximum speed SPI configuration (18MHz, CPHA=0, CPOL=0, MSb first).*/
+static SPIConfig hs_spicfg = {NULL, IOPORT2, GPIOB_SPI2NSS, 0};
+
+/* Low speed SPI configuration (281.250kHz, CPHA=0, CPOL=0, MSb first).*/
+static SPIConfig ls_spicfg = {NULL, IOPORT2, GPIOB_SPI2NSS,
+                              SPI_CR1_BR_2 | SPI_CR1_BR_1};
+
+/* MMC/SD over SPI driver configuration.*/
+static MMCConfig mmccfg = {&SPID2, &ls_spicfg, &hs_spicfg};
+
 /*===========================================================================*/
 /* USB related stuff.                                                        */
 /*===========================================================================*/
@@ -189,12 +208,15 @@ USBOutEndpointState ep2state;
  * EP1 initialization structure (IN only).
  */
 static const USBEndpointConfig ep1config = {
-  USB_EP_MODE_TYPE_BULK | USB_EP_MODE_TRANSACTION,
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
   mscDataTransmitted,
   NULL,
   0x0040,
   0x0000,
   &ep1state,
+  NULL,
+  1,
   NULL
 };
 
@@ -202,13 +224,16 @@ static const USBEndpointConfig ep1config = {
  * EP2 initialization structure (OUT only).
  */
 static const USBEndpointConfig ep2config = {
-  USB_EP_MODE_TYPE_BULK | USB_EP_MODE_TRANSACTION,
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
   NULL,
   mscDataReceived,
   0x0000,
   0x0040,
   NULL,
-  &ep2state
+  &ep2state,
+  1,
+  NULL
 };
 
 /*
@@ -228,6 +253,9 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
     chSysLockFromIsr();
     usbInitEndpointI(usbp, MSC_DATA_IN_EP, &ep1config);
     usbInitEndpointI(usbp, MSC_DATA_OUT_EP, &ep2config);
+
+    /* Resetting the state of the mass storage service.*/
+    mscConfigureHookI(usbp);
     chSysUnlockFromIsr();
     return;
   case USB_EVENT_SUSPEND:
@@ -241,7 +269,7 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
 }
 
 /*
- * Serial over USB driver configuration.
+ * USB driver configuration.
  */
 static const USBConfig usbcfg = {
   usb_event,
@@ -250,6 +278,26 @@ static const USBConfig usbcfg = {
   NULL
 };
 
+/*
+ * Last READ(10)/WRITE(10) transfer report, inspect it with the debugger in
+ * order to check the card throughput.
+ */
+static msctransfer_t last_transfer;
+
+static void transfer_report(const msctransfer_t *xfp) {
+
+  last_transfer = *xfp;
+}
+
+/*
+ * Mass storage configuration, the card is exported.
+ */
+static const MSCConfig msccfg = {
+  &USBD1,
+  (BaseBlockDevice *)&MMCD1,
+  transfer_report
+};
+
 /*===========================================================================*/
 /* Generic code.                                                             */
 /*===========================================================================*/
@@ -286,8 +334,18 @@ int main(void) {
   chSysInit();
 
   /*
-   * Activates the USB driver and then the USB bus pull-up on D+.
+   * Initializes the MMC driver to work with SPI2.
+   */
+  palSetPadMode(IOPORT2, GPIOB_SPI2NSS, PAL_MODE_OUTPUT_PUSHPULL);
+  palSetPad(IOPORT2, GPIOB_SPI2NSS);
+  mmcObjectInit(&MMCD1);
+  mmcStart(&MMCD1, &mmccfg);
+
+  /*
+   * Starts the mass storage service then activates the USB driver and the
+   * USB bus pull-up on D+.
    */
+  mscStart(&msccfg);
   usbStart(&USBD1, &usbcfg);
   palClearPad(GPIOC, GPIOC_USB_DISC);
 
@@ -303,9 +361,13 @@ int main(void) {
 
   /*
    * Normal main() thread activity, in this demo it does nothing except
-   * sleeping in a loop and check the button state.
+   * sleeping in a loop, connecting the card when inserted and check the
+   * button state.
    */
   while (TRUE) {
+    if ((blkGetDriverState(&MMCD1) != BLK_READY) &&
+        mmcIsCardInserted(&MMCD1))
+      mmcConnect(&MMCD1);
     if (palReadPad(IOPORT1, GPIOA_BUTTON))
       TestThread(&SD2);
     chThdSleepMilliseconds(1000);
@@ -168,7 +168,8 @@ void cmd_sdiotest(BaseSequentialStream *chp, int argc, char *argv[]){
  * SDIO configuration.
  */
 static const SDCConfig sdccfg = {
-  0
+  SDC_MODE_4BIT,
+  SDC_CLK_50MHz
 };
 
 /**